@@ -0,0 +1,209 @@
+// Microbenchmarks of the element-wise, GEMM and convolution kernels, single-threaded.
+//
+// Usage: onnx_kernel_benchmark [filter]
+//
+// Runs every benchmark whose name contains `filter` and prints, per benchmark, the best throughput over a few
+// repetitions in GFLOP/s (GOP/s for the integer GEMM). Element-wise and GEMM kernels are measured at every
+// instruction set up to the one of the CPU, which DUCKDB_ONNX_SIMD caps; convolutions run at that level only.
+
+#include "duckdb-onnx/core/cpu.hpp"
+#include "duckdb-onnx/core/kernels/element_wise.hpp"
+#include "duckdb-onnx/core/kernels/gemm.hpp"
+#include "duckdb-onnx/core/kernels/qgemm.hpp"
+#include "duckdb-onnx/core/ops/conv.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace duckdb_onnx;
+
+namespace {
+
+//! Repetitions measured for each benchmark, the best one being reported
+constexpr int REPETITIONS = 5;
+//! Least time one repetition runs for
+constexpr double MIN_SECONDS = 0.2;
+
+std::string filter;
+
+std::vector<float> random_floats(size_t n, uint32_t seed) {
+	std::vector<float> values(n);
+	for (auto &value : values) {
+		seed = seed * 1664525 + 1013904223;
+		value = static_cast<float>(seed >> 8) / static_cast<float>(1 << 24) * 2 - 1;
+	}
+	return values;
+}
+
+std::vector<uint8_t> random_bytes(size_t n, uint32_t seed) {
+	std::vector<uint8_t> values(n);
+	for (auto &value : values) {
+		seed = seed * 1664525 + 1013904223;
+		value = static_cast<uint8_t>(seed >> 24);
+	}
+	return values;
+}
+
+//! Time `body`, which performs `flops` operations per call, and print the best rate over the repetitions
+void run(const std::string &name, double flops, const std::function<void()> &body) {
+	if (name.find(filter) == std::string::npos) {
+		return;
+	}
+	body();
+	double best = 0;
+	for (int repetition = 0; repetition < REPETITIONS; repetition++) {
+		size_t calls = 0;
+		auto start = std::chrono::steady_clock::now();
+		double seconds = 0;
+		do {
+			body();
+			calls++;
+			seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		} while (seconds < MIN_SECONDS);
+		best = std::max(best, flops * static_cast<double>(calls) / seconds / 1e9);
+	}
+	std::printf("%-48s %10.2f\n", name.c_str(), best);
+	std::fflush(stdout);
+}
+
+std::vector<SimdLevel> levels() {
+	std::vector<SimdLevel> result;
+	for (auto level : {SimdLevel::Scalar, SimdLevel::Sse41, SimdLevel::Avx2, SimdLevel::Avx512}) {
+		if (level <= simd_level()) {
+			result.push_back(level);
+		}
+	}
+	return result;
+}
+
+void element_wise() {
+	// 16K floats per operand: the three arrays stay in L1/L2, so this measures the kernels rather than memory
+	const size_t n = 16 * 1024;
+	auto a = random_floats(n, 1);
+	auto b = random_floats(n, 2);
+	std::vector<float> out(n);
+	const std::pair<BinaryKind, const char *> binaries[] = {
+	    {BinaryKind::Add, "add"}, {BinaryKind::Mul, "mul"}, {BinaryKind::Div, "div"}, {BinaryKind::Max, "max"}};
+	const std::pair<UnaryKind, const char *> unaries[] = {
+	    {UnaryKind::Relu, "relu"}, {UnaryKind::Sigmoid, "sigmoid"}, {UnaryKind::Tanh, "tanh"}, {UnaryKind::Exp, "exp"}};
+	for (auto level : levels()) {
+		std::string suffix = std::string(" ") + simd_level_name(level);
+		for (auto &binary : binaries) {
+			auto kernel = binary_kernel_f32(binary.first, level);
+			run(std::string("elementwise/") + binary.second + suffix, n,
+			    [&]() { kernel(n, a.data(), 1, b.data(), 1, out.data()); });
+			run(std::string("elementwise/") + binary.second + "_scalar_b" + suffix, n,
+			    [&]() { kernel(n, a.data(), 1, b.data(), 0, out.data()); });
+		}
+		for (auto &unary : unaries) {
+			auto kernel = unary_kernel_f32(unary.first, level);
+			run(std::string("elementwise/") + unary.second + suffix, n, [&]() { kernel(n, a.data(), out.data()); });
+		}
+	}
+}
+
+struct GemmShape {
+	size_t m;
+	size_t n;
+	size_t k;
+};
+
+//! A single sample through a dense layer, a batch through it, and square products
+const GemmShape GEMM_SHAPES[] = {{1, 1024, 1024}, {64, 1024, 1024}, {256, 256, 256}, {1024, 1024, 1024}};
+
+std::string gemm_name(const char *kind, const GemmShape &shape, SimdLevel level) {
+	return std::string(kind) + "/" + std::to_string(shape.m) + "x" + std::to_string(shape.n) + "x" +
+	       std::to_string(shape.k) + " " + simd_level_name(level);
+}
+
+void gemm() {
+	for (auto &shape : GEMM_SHAPES) {
+		auto a = random_floats(shape.m * shape.k, 3);
+		auto b = random_floats(shape.k * shape.n, 4);
+		std::vector<float> c(shape.m * shape.n);
+		PackedMatrixF32 packed(shape.k, shape.n, b.data(), shape.n, 1);
+		for (auto level : levels()) {
+			auto &kernels = gemm_kernels_f32(level);
+			run(gemm_name("gemm_f32", shape, level), 2.0 * shape.m * shape.n * shape.k, [&]() {
+				gemm_f32(kernels, shape.m, a.data(), shape.k, 1, packed, c.data(), shape.n);
+			});
+		}
+	}
+}
+
+void qgemm() {
+	for (auto &shape : GEMM_SHAPES) {
+		auto a = random_bytes(shape.m * shape.k, 5);
+		auto b = random_bytes(shape.k * shape.n, 6);
+		std::vector<int32_t> c(shape.m * shape.n);
+		int32_t b_zero_point = 128;
+		PackedMatrixI8 packed;
+		packed.pack(shape.k, shape.n, b.data(), shape.n, 1, &b_zero_point, 0);
+		for (auto level : levels()) {
+			auto &kernels = gemm_kernels_i8(level);
+			run(gemm_name("gemm_i8", shape, level), 2.0 * shape.m * shape.n * shape.k, [&]() {
+				gemm_i8(kernels, shape.m, a.data(), shape.k, 1, 128, packed, c.data(), shape.n);
+			});
+		}
+	}
+}
+
+struct ConvShape {
+	const char *name;
+	int64_t channels;
+	int64_t size;
+	int64_t filters;
+	int64_t kernel;
+};
+
+//! The first layer of mnist-8.onnx, and a 3x3 layer in the middle of a ResNet
+const ConvShape CONV_SHAPES[] = {{"mnist_5x5", 1, 28, 8, 5}, {"resnet_3x3", 64, 56, 64, 3}};
+
+void conv() {
+	for (auto &shape : CONV_SHAPES) {
+		PatchSpec patch;
+		auto pad = shape.kernel / 2;
+		patch.pads = {pad, pad, pad, pad};
+		auto input = std::make_shared<Tensor>(Tensor::from_vec<float>(
+		    {1, shape.channels, shape.size, shape.size},
+		    random_floats(static_cast<size_t>(shape.channels * shape.size * shape.size), 7)));
+		auto filters = std::make_shared<Tensor>(Tensor::from_vec<float>(
+		    {shape.filters, shape.channels, shape.kernel, shape.kernel},
+		    random_floats(static_cast<size_t>(shape.filters * shape.channels * shape.kernel * shape.kernel), 8)));
+		ConvOp generic(patch, 1);
+		auto op = generic.codegen({nullptr, filters});
+		if (!op) {
+			std::fprintf(stderr, "conv/%s: the filters could not be packed\n", shape.name);
+			continue;
+		}
+		double flops = 2.0 * shape.filters * shape.size * shape.size * shape.channels * shape.kernel * shape.kernel;
+		run(std::string("conv/") + shape.name + " " + simd_level_name(simd_level()), flops, [&]() {
+			auto result = op->eval({TValue::Var(input), TValue::Const(filters)});
+			if (!result.is_ok()) {
+				std::fprintf(stderr, "conv/%s: %s\n", shape.name, result.error().what().c_str());
+				std::exit(1);
+			}
+		});
+	}
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+	if (argc > 1) {
+		filter = argv[1];
+	}
+	std::printf("%-48s %10s\n", "benchmark", "GFLOP/s");
+	element_wise();
+	gemm();
+	qgemm();
+	conv();
+	return 0;
+}
@@ -0,0 +1,77 @@
+#!/usr/bin/env python3
+
+# Converts the MNIST digits of unit_test/mnist/images to a CSV the benchmarks can read from SQL.
+# Each line holds the label (the part of the file name before '_') and the 784 pixels as a list literal.
+#
+# Usage: ./scripts/mnist_images_csv.py [image_dir] [out_csv]
+#
+# Only the 8-bit grayscale, non-interlaced PNGs of the data set are supported, so that no imaging library is needed.
+
+import os
+import struct
+import sys
+import zlib
+
+
+def read_png_gray8(path):
+    with open(path, 'rb') as f:
+        data = f.read()
+    if data[:8] != b'\x89PNG\r\n\x1a\n':
+        raise ValueError(f'{path}: not a PNG file')
+    pos = 8
+    idat = b''
+    width = height = None
+    while pos < len(data):
+        (length,) = struct.unpack('>I', data[pos : pos + 4])
+        kind = data[pos + 4 : pos + 8]
+        chunk = data[pos + 8 : pos + 8 + length]
+        pos += 12 + length
+        if kind == b'IHDR':
+            width, height, depth, color, _, _, interlace = struct.unpack('>IIBBBBB', chunk)
+            if depth != 8 or color != 0 or interlace != 0:
+                raise ValueError(f'{path}: only 8-bit grayscale, non-interlaced PNGs are supported')
+        elif kind == b'IDAT':
+            idat += chunk
+        elif kind == b'IEND':
+            break
+    raw = zlib.decompress(idat)
+    pixels = []
+    previous = [0] * width
+    for y in range(height):
+        line = raw[y * (width + 1) : (y + 1) * (width + 1)]
+        kind, line = line[0], list(line[1:])
+        for x in range(width):
+            left = line[x - 1] if x > 0 else 0
+            up = previous[x]
+            up_left = previous[x - 1] if x > 0 else 0
+            if kind == 1:
+                line[x] = (line[x] + left) & 0xFF
+            elif kind == 2:
+                line[x] = (line[x] + up) & 0xFF
+            elif kind == 3:
+                line[x] = (line[x] + (left + up) // 2) & 0xFF
+            elif kind == 4:
+                p = left + up - up_left
+                pa, pb, pc = abs(p - left), abs(p - up), abs(p - up_left)
+                predictor = left if pa <= pb and pa <= pc else (up if pb <= pc else up_left)
+                line[x] = (line[x] + predictor) & 0xFF
+        pixels.extend(line)
+        previous = line
+    return pixels
+
+
+def main():
+    image_dir = sys.argv[1] if len(sys.argv) > 1 else 'unit_test/mnist/images'
+    out_csv = sys.argv[2] if len(sys.argv) > 2 else 'benchmark/onnx/data/mnist_images.csv'
+    os.makedirs(os.path.dirname(out_csv), exist_ok=True)
+    with open(out_csv, 'w') as out:
+        out.write('label,pixels\n')
+        for name in sorted(os.listdir(image_dir)):
+            if not name.endswith('.png'):
+                continue
+            pixels = read_png_gray8(os.path.join(image_dir, name))
+            out.write(name.split('_')[0] + ',"[' + ', '.join(str(p) for p in pixels) + ']"\n')
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,57 @@
+#!/usr/bin/env python3
+
+# Runs the SQL benchmarks of benchmark/onnx with DuckDB's benchmark_runner and reports rows/sec.
+#
+# Usage: ./scripts/onnx_benchmark.py <benchmark_runner> [pattern]
+#
+# The runner comes from a build with BUILD_BENCHMARK=1. Each benchmark declares the rows one run scores in a
+# `# rows: N` header line; the reported rate is N over the median timing of the runner's repetitions.
+
+import glob
+import os
+import re
+import statistics
+import subprocess
+import sys
+
+
+def declared_rows(path):
+    with open(path) as f:
+        for line in f:
+            match = re.match(r'#\s*rows:\s*(\d+)', line)
+            if match:
+                return int(match.group(1))
+    return None
+
+
+def main():
+    if len(sys.argv) < 2:
+        print(f'Usage: {sys.argv[0]} <benchmark_runner> [pattern]', file=sys.stderr)
+        sys.exit(1)
+    runner = sys.argv[1]
+    pattern = sys.argv[2] if len(sys.argv) > 2 else ''
+    failed = False
+    print(f'{"benchmark":<48} {"median s":>10} {"rows/sec":>14}')
+    for path in sorted(glob.glob('benchmark/onnx/*.benchmark')):
+        if pattern not in path:
+            continue
+        result = subprocess.run([runner, path], capture_output=True, text=True)
+        timings = []
+        for line in result.stdout.splitlines():
+            fields = line.split('\t')
+            if len(fields) == 3 and fields[0] == path:
+                timings.append(float(fields[2]))
+        if result.returncode != 0 or not timings:
+            failed = True
+            print(f'{path}: benchmark failed', file=sys.stderr)
+            print(result.stdout + result.stderr, file=sys.stderr)
+            continue
+        median = statistics.median(timings)
+        rows = declared_rows(path)
+        rate = f'{rows / median:14.0f}' if rows else f'{"-":>14}'
+        print(f'{os.path.basename(path):<48} {median:10.3f} {rate}')
+    sys.exit(1 if failed else 0)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,62 @@
+#include "duckdb-onnx/core/arena.hpp"
+
+#include <algorithm>
+
+namespace duckdb_onnx {
+
+TensorArena::~TensorArena() {
+	for (auto &chunk : chunks_) {
+		aligned_free(chunk.data);
+	}
+}
+
+void *TensorArena::allocate(size_t size) {
+	size = std::max<size_t>((size + TENSOR_ALIGNMENT - 1) / TENSOR_ALIGNMENT * TENSOR_ALIGNMENT, TENSOR_ALIGNMENT);
+	while (current_ < chunks_.size() && chunks_[current_].size - offset_ < size) {
+		current_++;
+		offset_ = 0;
+	}
+	if (current_ == chunks_.size()) {
+		auto chunk_size = std::max(size, chunks_.empty() ? MIN_CHUNK_SIZE : chunks_.back().size * 2);
+		chunks_.push_back(Chunk {static_cast<char *>(aligned_malloc(chunk_size)), chunk_size});
+		offset_ = 0;
+	}
+	auto ptr = chunks_[current_].data + offset_;
+	offset_ += size;
+	used_ += size;
+	return ptr;
+}
+
+Tensor TensorArena::tensor(DatumType dt, ShapeVec shape) {
+	size_t len = 1;
+	for (auto dim : shape) {
+		len *= static_cast<size_t>(std::max<int64_t>(dim, 0));
+	}
+	auto size = len * datum_type_size(dt);
+	return Tensor::from_blob(dt, std::move(shape), Blob::borrow(allocate(size), size));
+}
+
+void TensorArena::reset() {
+	if (chunks_.size() > 1) {
+		// the last execution did not fit in one chunk: replace them with one large enough for it
+		auto size = capacity();
+		for (auto &chunk : chunks_) {
+			aligned_free(chunk.data);
+		}
+		chunks_.clear();
+		chunks_.push_back(Chunk {static_cast<char *>(aligned_malloc(size)), size});
+	}
+	current_ = 0;
+	offset_ = 0;
+	used_ = 0;
+}
+
+size_t TensorArena::capacity() const {
+	size_t size = 0;
+	for (auto &chunk : chunks_) {
+		size += chunk.size;
+	}
+	return size;
+}
+
+} // namespace duckdb_onnx
@@ -0,0 +1,64 @@
+#include "duckdb-onnx/core/cpu.hpp"
+
+#include <cstdlib>
+#include <cstring>
+
+namespace duckdb_onnx {
+
+static SimdLevel detect_simd_level() {
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx512f")) {
+		return SimdLevel::Avx512;
+	}
+	if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma") && __builtin_cpu_supports("f16c")) {
+		return SimdLevel::Avx2;
+	}
+	if (__builtin_cpu_supports("sse4.1")) {
+		return SimdLevel::Sse41;
+	}
+#endif
+	return SimdLevel::Scalar;
+}
+
+static SimdLevel simd_level_cap() {
+	auto env = std::getenv("DUCKDB_ONNX_SIMD");
+	if (!env) {
+		return SimdLevel::Avx512;
+	}
+	if (std::strcmp(env, "scalar") == 0) {
+		return SimdLevel::Scalar;
+	}
+	if (std::strcmp(env, "sse4") == 0) {
+		return SimdLevel::Sse41;
+	}
+	if (std::strcmp(env, "avx2") == 0) {
+		return SimdLevel::Avx2;
+	}
+	return SimdLevel::Avx512;
+}
+
+SimdLevel simd_level() {
+	static const SimdLevel level = [] {
+		auto detected = detect_simd_level();
+		auto cap = simd_level_cap();
+		return cap < detected ? cap : detected;
+	}();
+	return level;
+}
+
+const char *simd_level_name(SimdLevel level) {
+	switch (level) {
+	case SimdLevel::Scalar:
+		return "scalar";
+	case SimdLevel::Sse41:
+		return "sse4.1";
+	case SimdLevel::Avx2:
+		return "avx2";
+	case SimdLevel::Avx512:
+		return "avx512";
+	}
+	return "unknown";
+}
+
+} // namespace duckdb_onnx
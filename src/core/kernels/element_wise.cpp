@@ -0,0 +1,174 @@
+#include "duckdb-onnx/core/kernels/element_wise.hpp"
+
+#include "duckdb-onnx/core/half.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+
+namespace duckdb_onnx {
+
+namespace {
+
+template <BinaryKind K>
+float apply(float a, float b) {
+	switch (K) {
+	case BinaryKind::Add:
+		return a + b;
+	case BinaryKind::Sub:
+		return a - b;
+	case BinaryKind::Mul:
+		return a * b;
+	case BinaryKind::Div:
+		return a / b;
+	case BinaryKind::Max:
+		return a > b ? a : b;
+	case BinaryKind::Min:
+		return a < b ? a : b;
+	}
+	return 0;
+}
+
+template <UnaryKind K>
+float apply(float x) {
+	switch (K) {
+	case UnaryKind::Relu:
+		return x < 0 ? 0 : x;
+	case UnaryKind::Sigmoid:
+		return 1 / (1 + std::exp(-x));
+	case UnaryKind::Tanh:
+		return std::tanh(x);
+	case UnaryKind::Exp:
+		return std::exp(x);
+	}
+	return 0;
+}
+
+template <BinaryKind K>
+void binary_scalar(size_t n, const float *a, size_t a_step, const float *b, size_t b_step, float *out) {
+	if (n == 0) {
+		return;
+	}
+	if (a_step && b_step) {
+		for (size_t i = 0; i < n; i++) {
+			out[i] = apply<K>(a[i], b[i]);
+		}
+	} else if (a_step) {
+		auto rhs = *b;
+		for (size_t i = 0; i < n; i++) {
+			out[i] = apply<K>(a[i], rhs);
+		}
+	} else if (b_step) {
+		auto lhs = *a;
+		for (size_t i = 0; i < n; i++) {
+			out[i] = apply<K>(lhs, b[i]);
+		}
+	} else {
+		std::fill(out, out + n, apply<K>(*a, *b));
+	}
+}
+
+template <UnaryKind K>
+void unary_scalar(size_t n, const float *x, float *out) {
+	for (size_t i = 0; i < n; i++) {
+		out[i] = apply<K>(x[i]);
+	}
+}
+
+void clip_scalar(size_t n, const float *x, float lo, float hi, float *out) {
+	for (size_t i = 0; i < n; i++) {
+		out[i] = std::min(std::max(x[i], lo), hi);
+	}
+}
+
+void widen_f16_scalar(size_t n, const uint16_t *x, float *out) {
+	for (size_t i = 0; i < n; i++) {
+		out[i] = half_to_float(x[i]);
+	}
+}
+
+void widen_bf16_scalar(size_t n, const uint16_t *x, float *out) {
+	for (size_t i = 0; i < n; i++) {
+		out[i] = bf16_to_float(x[i]);
+	}
+}
+
+} // namespace
+
+BinaryKernelF32 binary_kernel_f32(BinaryKind kind, SimdLevel level) {
+	if (auto kernel = x86::binary_kernel_f32(kind, level)) {
+		return kernel;
+	}
+	switch (kind) {
+	case BinaryKind::Add:
+		return binary_scalar<BinaryKind::Add>;
+	case BinaryKind::Sub:
+		return binary_scalar<BinaryKind::Sub>;
+	case BinaryKind::Mul:
+		return binary_scalar<BinaryKind::Mul>;
+	case BinaryKind::Div:
+		return binary_scalar<BinaryKind::Div>;
+	case BinaryKind::Max:
+		return binary_scalar<BinaryKind::Max>;
+	case BinaryKind::Min:
+		return binary_scalar<BinaryKind::Min>;
+	}
+	return nullptr;
+}
+
+UnaryKernelF32 unary_kernel_f32(UnaryKind kind, SimdLevel level) {
+	if (auto kernel = x86::unary_kernel_f32(kind, level)) {
+		return kernel;
+	}
+	switch (kind) {
+	case UnaryKind::Relu:
+		return unary_scalar<UnaryKind::Relu>;
+	case UnaryKind::Sigmoid:
+		return unary_scalar<UnaryKind::Sigmoid>;
+	case UnaryKind::Tanh:
+		return unary_scalar<UnaryKind::Tanh>;
+	case UnaryKind::Exp:
+		return unary_scalar<UnaryKind::Exp>;
+	}
+	return nullptr;
+}
+
+ClipKernelF32 clip_kernel_f32(SimdLevel level) {
+	if (auto kernel = x86::clip_kernel_f32(level)) {
+		return kernel;
+	}
+	return clip_scalar;
+}
+
+WidenKernelF32 widen_kernel_f32(DatumType dt, SimdLevel level) {
+	if (auto kernel = x86::widen_kernel_f32(dt, level)) {
+		return kernel;
+	}
+	switch (dt) {
+	case DatumType::F16:
+		return widen_f16_scalar;
+	case DatumType::BF16:
+		return widen_bf16_scalar;
+	default:
+		throw std::invalid_argument(std::string("No widening kernel for ") + datum_type_name(dt));
+	}
+}
+
+BinaryKernelF32 binary_kernel_f32(BinaryKind kind) {
+	return binary_kernel_f32(kind, simd_level());
+}
+
+UnaryKernelF32 unary_kernel_f32(UnaryKind kind) {
+	return unary_kernel_f32(kind, simd_level());
+}
+
+ClipKernelF32 clip_kernel_f32() {
+	return clip_kernel_f32(simd_level());
+}
+
+WidenKernelF32 widen_kernel_f32(DatumType dt) {
+	return widen_kernel_f32(dt, simd_level());
+}
+
+} // namespace duckdb_onnx
@@ -0,0 +1,117 @@
+#include "duckdb-onnx/core/kernels/element_wise.hpp"
+#include "duckdb-onnx/core/half.hpp"
+#include "x86_isa.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+namespace duckdb_onnx {
+namespace x86 {
+
+#ifdef DUCKDB_ONNX_X86_KERNELS
+
+DUCKDB_ONNX_TARGET_REGION("sse4.1")
+namespace sse41 {
+namespace {
+
+#include "element_wise_simd.inc"
+
+} // namespace
+} // namespace sse41
+DUCKDB_ONNX_UNTARGET_REGION
+
+DUCKDB_ONNX_TARGET_REGION("avx2,fma,f16c")
+namespace avx2 {
+namespace {
+
+#include "element_wise_simd.inc"
+
+} // namespace
+} // namespace avx2
+DUCKDB_ONNX_UNTARGET_REGION
+
+DUCKDB_ONNX_TARGET_REGION("avx512f")
+namespace avx512 {
+namespace {
+
+#include "element_wise_simd.inc"
+
+} // namespace
+} // namespace avx512
+DUCKDB_ONNX_UNTARGET_REGION
+
+BinaryKernelF32 binary_kernel_f32(BinaryKind kind, SimdLevel level) {
+	switch (level) {
+	case SimdLevel::Avx512:
+		return avx512::binary_kernel(kind);
+	case SimdLevel::Avx2:
+		return avx2::binary_kernel(kind);
+	case SimdLevel::Sse41:
+		return sse41::binary_kernel(kind);
+	default:
+		return nullptr;
+	}
+}
+
+UnaryKernelF32 unary_kernel_f32(UnaryKind kind, SimdLevel level) {
+	switch (level) {
+	case SimdLevel::Avx512:
+		return avx512::unary_kernel(kind);
+	case SimdLevel::Avx2:
+		return avx2::unary_kernel(kind);
+	case SimdLevel::Sse41:
+		return sse41::unary_kernel(kind);
+	default:
+		return nullptr;
+	}
+}
+
+ClipKernelF32 clip_kernel_f32(SimdLevel level) {
+	switch (level) {
+	case SimdLevel::Avx512:
+		return avx512::clip;
+	case SimdLevel::Avx2:
+		return avx2::clip;
+	case SimdLevel::Sse41:
+		return sse41::clip;
+	default:
+		return nullptr;
+	}
+}
+
+WidenKernelF32 widen_kernel_f32(DatumType dt, SimdLevel level) {
+	switch (level) {
+	case SimdLevel::Avx512:
+		return avx512::widen_kernel(dt);
+	case SimdLevel::Avx2:
+		return avx2::widen_kernel(dt);
+	case SimdLevel::Sse41:
+		return sse41::widen_kernel(dt);
+	default:
+		return nullptr;
+	}
+}
+
+#else
+
+BinaryKernelF32 binary_kernel_f32(BinaryKind, SimdLevel) {
+	return nullptr;
+}
+
+UnaryKernelF32 unary_kernel_f32(UnaryKind, SimdLevel) {
+	return nullptr;
+}
+
+ClipKernelF32 clip_kernel_f32(SimdLevel) {
+	return nullptr;
+}
+
+WidenKernelF32 widen_kernel_f32(DatumType, SimdLevel) {
+	return nullptr;
+}
+
+#endif
+
+} // namespace x86
+} // namespace duckdb_onnx
@@ -0,0 +1,276 @@
+#include "duckdb-onnx/core/kernels/gemm.hpp"
+
+#include "duckdb-onnx/core/kernels/element_wise.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace duckdb_onnx {
+
+namespace scalar {
+namespace {
+
+struct Isa {
+	using V = float;
+	static constexpr size_t width = 1;
+
+	static inline V load(const float *p) {
+		return *p;
+	}
+	static inline void store(float *p, V v) {
+		*p = v;
+	}
+	static inline V set1(float v) {
+		return v;
+	}
+	static inline V zero() {
+		return 0;
+	}
+	static inline V add(V a, V b) {
+		return a + b;
+	}
+	static inline V fmadd(V a, V b, V c) {
+		return a * b + c;
+	}
+};
+
+static constexpr size_t MR = 4;
+#include "gemm_simd.inc"
+
+} // namespace
+} // namespace scalar
+
+const GemmKernelsF32 &gemm_kernels_f32(SimdLevel level) {
+	if (auto kernels = x86::gemm_kernels_f32(level)) {
+		return *kernels;
+	}
+	return scalar::kernels();
+}
+
+const GemmKernelsF32 &gemm_kernels_f32() {
+	return gemm_kernels_f32(simd_level());
+}
+
+void PackedMatrixF32::allocate(size_t k, size_t n, size_t width, DatumType dt) {
+	k_ = k;
+	n_ = n;
+	width_ = width;
+	datum_type_ = dt;
+	auto size = storage_size(k, n, width, dt);
+	if (storage_.size() < size || !storage_.data()) {
+		storage_ = Blob::allocate(std::max<size_t>(size, 1));
+	}
+}
+
+void PackedMatrixF32::assign(size_t k, size_t n, size_t width, DatumType dt, Blob storage) {
+	if (width == 0 || (dt != DatumType::F32 && dt != DatumType::F16 && dt != DatumType::BF16)) {
+		throw std::invalid_argument("Invalid packed matrix layout");
+	}
+	auto size = storage_size(k, n, width, dt);
+	if (storage.size() < size) {
+		throw std::invalid_argument("Packed matrix storage of " + std::to_string(storage.size()) +
+		                            " bytes, expected " + std::to_string(size));
+	}
+	k_ = k;
+	n_ = n;
+	width_ = width;
+	datum_type_ = dt;
+	storage_ = std::move(storage);
+}
+
+/// Copy the k x n matrix b into panels of `width` columns, zero past n
+template <typename T>
+static void pack_panels(size_t k, size_t n, const T *b, size_t row_stride, size_t col_stride, size_t width, T *dst) {
+	for (size_t p0 = 0; p0 < k; p0 += GEMM_KC) {
+		auto kc = std::min(GEMM_KC, k - p0);
+		for (size_t j0 = 0; j0 < n; j0 += width) {
+			auto cols = std::min(width, n - j0);
+			for (size_t p = p0; p < p0 + kc; p++) {
+				auto src = b + p * row_stride + j0 * col_stride;
+				if (col_stride == 1) {
+					std::memcpy(dst, src, cols * sizeof(T));
+				} else {
+					for (size_t j = 0; j < cols; j++) {
+						dst[j] = src[j * col_stride];
+					}
+				}
+				// zero bits are +0 in the 16-bit float types too
+				std::fill(dst + cols, dst + width, T(0));
+				dst += width;
+			}
+		}
+	}
+}
+
+void PackedMatrixF32::pack(size_t k, size_t n, const float *b, size_t row_stride, size_t col_stride, size_t width) {
+	allocate(k, n, width, DatumType::F32);
+	pack_panels(k, n, b, row_stride, col_stride, width, reinterpret_cast<float *>(storage_.data()));
+}
+
+void PackedMatrixF32::pack(size_t k, size_t n, const Tensor &b, size_t offset, size_t row_stride, size_t col_stride,
+                           size_t width) {
+	auto dt = b.datum_type();
+	if (dt == DatumType::F32) {
+		pack(k, n, b.as_ptr<float>() + offset, row_stride, col_stride, width);
+		return;
+	}
+	if (dt != DatumType::F16 && dt != DatumType::BF16) {
+		throw std::invalid_argument(std::string("Cannot pack a matrix of ") + datum_type_name(dt) + " for the GEMM");
+	}
+	allocate(k, n, width, dt);
+	pack_panels(k, n, static_cast<const uint16_t *>(b.raw_data()) + offset, row_stride, col_stride, width,
+	            reinterpret_cast<uint16_t *>(storage_.data()));
+}
+
+const float *PackedMatrixF32::panels_f32(size_t p0, size_t j, size_t count, float *buffer) const {
+	if (datum_type_ == DatumType::F32) {
+		return panel(p0, j);
+	}
+	auto len = std::min(GEMM_KC, k_ - p0) * count * width_;
+	widen_kernel_f32(datum_type_)(len, reinterpret_cast<const uint16_t *>(storage_.data()) + panel_offset(p0, j),
+	                              buffer);
+	return buffer;
+}
+
+namespace {
+
+/// Pack `rows` x `kc` values of A into panels of `mr` rows, each stored column
+/// by column, scaled by alpha
+void pack_a(size_t rows, size_t kc, const float *a, size_t row_stride, size_t col_stride, float alpha, size_t mr,
+            float *dst) {
+	for (size_t i0 = 0; i0 < rows; i0 += mr) {
+		auto panel_rows = std::min(mr, rows - i0);
+		for (size_t i = 0; i < panel_rows; i++) {
+			auto src = a + (i0 + i) * row_stride;
+			for (size_t p = 0; p < kc; p++) {
+				dst[p * mr + i] = src[p * col_stride] * alpha;
+			}
+		}
+		dst += kc * mr;
+	}
+}
+
+/// Per-thread buffer for the packed blocks of A
+float *pack_buffer(size_t len) {
+	thread_local class Blob buffer;
+	if (buffer.size() < len * sizeof(float)) {
+		buffer = Blob::allocate(len * sizeof(float));
+	}
+	return reinterpret_cast<float *>(buffer.data());
+}
+
+/// Per-thread buffer for a panel of B widened to F32, null when B holds F32
+float *panel_buffer(const PackedMatrixF32 &b) {
+	if (b.datum_type() == DatumType::F32) {
+		return nullptr;
+	}
+	thread_local class Blob buffer = Blob::allocate(GEMM_KC * GEMM_NR * sizeof(float));
+	return reinterpret_cast<float *>(buffer.data());
+}
+
+/// c (+)= a * b over the k block starting at `p0` and the panels of B in
+/// [panel_begin, panel_end), for `rows` rows of A packed in panels of
+/// `kernels.mr`
+void multiply_block(const GemmKernelsF32 &kernels, size_t p0, size_t rows, const float *packed_a,
+                    const PackedMatrixF32 &b, size_t panel_begin, size_t panel_end, float *c, size_t ldc,
+                    bool accumulate) {
+	auto mr = kernels.mr;
+	auto kc = std::min(GEMM_KC, b.k() - p0);
+	auto buffer = panel_buffer(b);
+	for (size_t j = panel_begin; j < panel_end; j++) {
+		// widened once for all the rows of the block
+		auto panel = b.panels_f32(p0, j, 1, buffer);
+		auto cols = std::min(GEMM_NR, b.n() - j * GEMM_NR);
+		for (size_t i = 0; i < rows; i += mr) {
+			auto kernel = kernels.by_rows[std::min(mr, rows - i)];
+			kernel(kc, packed_a + i * kc, panel, c + i * ldc + j * GEMM_NR, ldc, cols, accumulate);
+		}
+	}
+}
+
+/// c = 0 unless accumulating, for a product over an empty k
+void clear_output(size_t m, size_t n, float *c, size_t ldc, bool accumulate) {
+	if (!accumulate) {
+		for (size_t i = 0; i < m; i++) {
+			std::fill(c + i * ldc, c + i * ldc + n, 0.0f);
+		}
+	}
+}
+
+} // namespace
+
+void gemm_f32(const GemmKernelsF32 &kernels, size_t m, const float *a, size_t a_row_stride, size_t a_col_stride,
+              const PackedMatrixF32 &b, float *c, size_t ldc, float alpha, bool accumulate, TaskRunner *runner) {
+	auto n = b.n();
+	auto k = b.k();
+	if (m == 0 || n == 0) {
+		return;
+	}
+	if (k == 0) {
+		clear_output(m, n, c, ldc, accumulate);
+		return;
+	}
+
+	auto mr = kernels.mr;
+	auto mc = std::max<size_t>(GEMM_MC / mr, 1) * mr;
+	GemmTiles tiles(m, b.n(), k, b.panel_count(), mr, runner);
+	tiles.run(runner, [&](size_t tile) {
+		auto end = tiles.row_end(tile);
+		// each thread packs the rows of A of its tiles in its own buffer
+		auto packed_a = pack_buffer(mc * GEMM_KC);
+		// k blocks outermost: the packed block of A is reused over every panel of B,
+		// and each panel of B over every row panel of A
+		for (size_t p0 = 0; p0 < k; p0 += GEMM_KC) {
+			auto kc = std::min(GEMM_KC, k - p0);
+			for (size_t i0 = tiles.row_begin(tile); i0 < end; i0 += mc) {
+				auto rows = std::min(mc, end - i0);
+				pack_a(rows, kc, a + i0 * a_row_stride + p0 * a_col_stride, a_row_stride, a_col_stride, alpha, mr,
+				       packed_a);
+				multiply_block(kernels, p0, rows, packed_a, b, tiles.panel_begin(tile), tiles.panel_end(tile),
+				               c + i0 * ldc, ldc, accumulate || p0 > 0);
+			}
+		}
+	});
+}
+
+void gemm_f32(const GemmKernelsF32 &kernels, const PackedMatrixF32 &a, const PackedMatrixF32 &b, float *c, size_t ldc,
+              bool accumulate, TaskRunner *runner) {
+	if (a.width() != kernels.mr || b.width() != GEMM_NR || a.k() != b.k()) {
+		throw std::invalid_argument("Packed operands do not match the GEMM kernels");
+	}
+	auto m = a.n();
+	auto n = b.n();
+	auto k = b.k();
+	if (m == 0 || n == 0) {
+		return;
+	}
+	if (k == 0) {
+		clear_output(m, n, c, ldc, accumulate);
+		return;
+	}
+	auto mr = kernels.mr;
+	auto mc = std::max<size_t>(GEMM_MC / mr, 1) * mr;
+	GemmTiles tiles(m, b.n(), k, b.panel_count(), mr, runner);
+	tiles.run(runner, [&](size_t tile) {
+		auto end = tiles.row_end(tile);
+		auto buffer = a.datum_type() == DatumType::F32 ? nullptr : pack_buffer(mc * GEMM_KC);
+		for (size_t p0 = 0; p0 < k; p0 += GEMM_KC) {
+			for (size_t i0 = tiles.row_begin(tile); i0 < end; i0 += mc) {
+				auto rows = std::min(mc, end - i0);
+				auto packed_a = a.panels_f32(p0, i0 / mr, (rows + mr - 1) / mr, buffer);
+				multiply_block(kernels, p0, rows, packed_a, b, tiles.panel_begin(tile), tiles.panel_end(tile),
+				               c + i0 * ldc, ldc, accumulate || p0 > 0);
+			}
+		}
+	});
+}
+
+void gemm_f32(size_t m, const float *a, size_t a_row_stride, size_t a_col_stride, const PackedMatrixF32 &b, float *c,
+              size_t ldc, float alpha, bool accumulate, TaskRunner *runner) {
+	gemm_f32(gemm_kernels_f32(), m, a, a_row_stride, a_col_stride, b, c, ldc, alpha, accumulate, runner);
+}
+
+} // namespace duckdb_onnx
@@ -0,0 +1,72 @@
+#include "duckdb-onnx/core/kernels/gemm.hpp"
+#include "x86_isa.hpp"
+
+#include <utility>
+
+namespace duckdb_onnx {
+namespace x86 {
+
+#ifdef DUCKDB_ONNX_X86_KERNELS
+
+// MR is picked so that the MR x GEMM_NR accumulators, one row of B and the
+// broadcast element of A fit in the vector registers.
+
+DUCKDB_ONNX_TARGET_REGION("sse4.1")
+namespace sse41 {
+namespace {
+
+// 12 accumulators + 4 B vectors out of 16 registers
+static constexpr size_t MR = 3;
+#include "gemm_simd.inc"
+
+} // namespace
+} // namespace sse41
+DUCKDB_ONNX_UNTARGET_REGION
+
+DUCKDB_ONNX_TARGET_REGION("avx2,fma,f16c")
+namespace avx2 {
+namespace {
+
+// 12 accumulators + 2 B vectors + 1 broadcast out of 16 registers
+static constexpr size_t MR = 6;
+#include "gemm_simd.inc"
+
+} // namespace
+} // namespace avx2
+DUCKDB_ONNX_UNTARGET_REGION
+
+DUCKDB_ONNX_TARGET_REGION("avx512f")
+namespace avx512 {
+namespace {
+
+// 12 accumulators + 1 B vector + 1 broadcast out of 32 registers
+static constexpr size_t MR = 12;
+#include "gemm_simd.inc"
+
+} // namespace
+} // namespace avx512
+DUCKDB_ONNX_UNTARGET_REGION
+
+const GemmKernelsF32 *gemm_kernels_f32(SimdLevel level) {
+	switch (level) {
+	case SimdLevel::Avx512:
+		return &avx512::kernels();
+	case SimdLevel::Avx2:
+		return &avx2::kernels();
+	case SimdLevel::Sse41:
+		return &sse41::kernels();
+	default:
+		return nullptr;
+	}
+}
+
+#else
+
+const GemmKernelsF32 *gemm_kernels_f32(SimdLevel) {
+	return nullptr;
+}
+
+#endif
+
+} // namespace x86
+} // namespace duckdb_onnx
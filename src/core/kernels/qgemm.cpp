@@ -0,0 +1,246 @@
+#include "duckdb-onnx/core/kernels/qgemm.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace duckdb_onnx {
+
+namespace scalar {
+namespace {
+
+struct QIsa {
+	struct Pair {
+		int32_t first;
+		int32_t second;
+	};
+	using V = int32_t;
+	using B = Pair;
+	static constexpr size_t width = 1;
+
+	static inline B load_pairs(const int16_t *p) {
+		return {p[0], p[1]};
+	}
+	static inline Pair set1_pair(const int16_t *p) {
+		return {p[0], p[1]};
+	}
+	static inline V madd(Pair a, B b, V acc) {
+		return acc + a.first * b.first + a.second * b.second;
+	}
+	static inline V zero() {
+		return 0;
+	}
+	static inline V load(const int32_t *p) {
+		return *p;
+	}
+	static inline void store(int32_t *p, V v) {
+		*p = v;
+	}
+	static inline V add(V a, V b) {
+		return a + b;
+	}
+};
+
+static constexpr size_t MR = 4;
+#include "qgemm_simd.inc"
+
+} // namespace
+} // namespace scalar
+
+const GemmKernelsI8 &gemm_kernels_i8(SimdLevel level) {
+	if (auto kernels = x86::gemm_kernels_i8(level)) {
+		return *kernels;
+	}
+	return scalar::kernels();
+}
+
+const GemmKernelsI8 &gemm_kernels_i8() {
+	return gemm_kernels_i8(simd_level());
+}
+
+void PackedMatrixI8::resize(size_t k, size_t n, size_t width) {
+	k_ = k;
+	n_ = n;
+	width_ = width;
+	// only the last k block can have an odd number of rows, which is padded
+	auto size = (k + k % 2) * panel_count() * width * sizeof(int16_t);
+	if (storage_.size() < size || !storage_.data()) {
+		storage_ = Blob::allocate(std::max<size_t>(size, 1));
+	}
+}
+
+void PackedMatrixI8::assign(size_t k, size_t n, size_t width, Blob storage) {
+	if (width == 0) {
+		throw std::invalid_argument("Invalid packed matrix layout");
+	}
+	auto size = (k + k % 2) * ((n + width - 1) / width) * width * sizeof(int16_t);
+	if (storage.size() < size) {
+		throw std::invalid_argument("Packed matrix storage of " + std::to_string(storage.size()) +
+		                            " bytes, expected " + std::to_string(size));
+	}
+	k_ = k;
+	n_ = n;
+	width_ = width;
+	storage_ = std::move(storage);
+}
+
+template <typename T>
+void PackedMatrixI8::pack(size_t k, size_t n, const T *b, size_t row_stride, size_t col_stride,
+                          const int32_t *zero_points, size_t zero_point_stride, size_t width) {
+	resize(k, n, width);
+	for (size_t p0 = 0; p0 < k; p0 += GEMM_KC) {
+		auto kc = std::min(GEMM_KC, k - p0);
+		for (size_t j0 = 0; j0 < n; j0 += width) {
+			auto cols = std::min(width, n - j0);
+			auto dst = panel_mut(p0, j0 / width);
+			for (size_t p = 0; p < kc + kc % 2; p++) {
+				// row p goes to the first or second half of the pairs of row p / 2
+				auto row = dst + (p / 2) * 2 * width + p % 2;
+				auto src = b + (p0 + p) * row_stride + j0 * col_stride;
+				size_t j = 0;
+				for (; p < kc && j < cols; j++) {
+					row[j * 2] = static_cast<int16_t>(src[j * col_stride] - zero_points[(j0 + j) * zero_point_stride]);
+				}
+				for (; j < width; j++) {
+					row[j * 2] = 0;
+				}
+			}
+		}
+	}
+}
+
+template void PackedMatrixI8::pack<uint8_t>(size_t, size_t, const uint8_t *, size_t, size_t, const int32_t *, size_t,
+                                            size_t);
+template void PackedMatrixI8::pack<int8_t>(size_t, size_t, const int8_t *, size_t, size_t, const int32_t *, size_t,
+                                           size_t);
+
+namespace {
+
+/// Pack `rows` x `kc` values of A minus `zero_point` into panels of `mr`
+/// rows, each holding the interleaved pairs of k rows
+template <typename A>
+void pack_a(size_t rows, size_t kc, const A *a, size_t row_stride, size_t col_stride, int32_t zero_point, size_t mr,
+            int16_t *dst) {
+	auto pairs = (kc + 1) / 2;
+	for (size_t i0 = 0; i0 < rows; i0 += mr) {
+		auto panel_rows = std::min(mr, rows - i0);
+		for (size_t i = 0; i < panel_rows; i++) {
+			auto src = a + (i0 + i) * row_stride;
+			for (size_t p = 0; p < kc; p++) {
+				dst[((p / 2) * mr + i) * 2 + p % 2] = static_cast<int16_t>(src[p * col_stride] - zero_point);
+			}
+			if (kc % 2) {
+				dst[((kc / 2) * mr + i) * 2 + 1] = 0;
+			}
+		}
+		dst += pairs * mr * 2;
+	}
+}
+
+/// Per-thread buffer for the packed blocks of A
+int16_t *pack_buffer(size_t len) {
+	thread_local class Blob buffer;
+	if (buffer.size() < len * sizeof(int16_t)) {
+		buffer = Blob::allocate(len * sizeof(int16_t));
+	}
+	return reinterpret_cast<int16_t *>(buffer.data());
+}
+
+/// c (+)= a * b over the k block starting at `p0` and the panels of B in
+/// [panel_begin, panel_end), for `rows` rows of A packed in panels of
+/// `kernels.mr`
+void multiply_block(const GemmKernelsI8 &kernels, size_t p0, size_t rows, const int16_t *packed_a,
+                    const PackedMatrixI8 &b, size_t panel_begin, size_t panel_end, int32_t *c, size_t ldc,
+                    bool accumulate) {
+	auto mr = kernels.mr;
+	auto pairs = b.pairs(p0);
+	for (size_t j = panel_begin; j < panel_end; j++) {
+		auto panel = b.panel(p0, j);
+		auto cols = std::min(GEMM_NR, b.n() - j * GEMM_NR);
+		for (size_t i = 0; i < rows; i += mr) {
+			auto kernel = kernels.by_rows[std::min(mr, rows - i)];
+			kernel(pairs, packed_a + i * pairs * 2, panel, c + i * ldc + j * GEMM_NR, ldc, cols, accumulate);
+		}
+	}
+}
+
+/// c = 0 unless accumulating, for a product over an empty k
+void clear_output(size_t m, size_t n, int32_t *c, size_t ldc, bool accumulate) {
+	if (!accumulate) {
+		for (size_t i = 0; i < m; i++) {
+			std::fill(c + i * ldc, c + i * ldc + n, 0);
+		}
+	}
+}
+
+} // namespace
+
+template <typename A>
+void gemm_i8(const GemmKernelsI8 &kernels, size_t m, const A *a, size_t a_row_stride, size_t a_col_stride,
+             int32_t a_zero_point, const PackedMatrixI8 &b, int32_t *c, size_t ldc, bool accumulate,
+             TaskRunner *runner) {
+	auto n = b.n();
+	auto k = b.k();
+	if (m == 0 || n == 0) {
+		return;
+	}
+	if (k == 0) {
+		clear_output(m, n, c, ldc, accumulate);
+		return;
+	}
+	auto mr = kernels.mr;
+	auto mc = std::max<size_t>(GEMM_MC / mr, 1) * mr;
+	GemmTiles tiles(m, n, k, b.panel_count(), mr, runner);
+	tiles.run(runner, [&](size_t tile) {
+		auto end = tiles.row_end(tile);
+		auto packed_a = pack_buffer(mc * (GEMM_KC + 1));
+		for (size_t p0 = 0; p0 < k; p0 += GEMM_KC) {
+			auto kc = std::min(GEMM_KC, k - p0);
+			for (size_t i0 = tiles.row_begin(tile); i0 < end; i0 += mc) {
+				auto rows = std::min(mc, end - i0);
+				pack_a(rows, kc, a + i0 * a_row_stride + p0 * a_col_stride, a_row_stride, a_col_stride, a_zero_point,
+				       mr, packed_a);
+				multiply_block(kernels, p0, rows, packed_a, b, tiles.panel_begin(tile), tiles.panel_end(tile),
+				               c + i0 * ldc, ldc, accumulate || p0 > 0);
+			}
+		}
+	});
+}
+
+template void gemm_i8<uint8_t>(const GemmKernelsI8 &, size_t, const uint8_t *, size_t, size_t, int32_t,
+                               const PackedMatrixI8 &, int32_t *, size_t, bool, TaskRunner *);
+template void gemm_i8<int8_t>(const GemmKernelsI8 &, size_t, const int8_t *, size_t, size_t, int32_t,
+                              const PackedMatrixI8 &, int32_t *, size_t, bool, TaskRunner *);
+
+void gemm_i8(const GemmKernelsI8 &kernels, const PackedMatrixI8 &a, const PackedMatrixI8 &b, int32_t *c, size_t ldc,
+             bool accumulate, TaskRunner *runner) {
+	if (a.width() != kernels.mr || b.width() != GEMM_NR || a.k() != b.k()) {
+		throw std::invalid_argument("Packed operands do not match the GEMM kernels");
+	}
+	auto m = a.n();
+	auto n = b.n();
+	auto k = b.k();
+	if (m == 0 || n == 0) {
+		return;
+	}
+	if (k == 0) {
+		clear_output(m, n, c, ldc, accumulate);
+		return;
+	}
+	auto mr = kernels.mr;
+	auto mc = std::max<size_t>(GEMM_MC / mr, 1) * mr;
+	GemmTiles tiles(m, n, k, b.panel_count(), mr, runner);
+	tiles.run(runner, [&](size_t tile) {
+		auto end = tiles.row_end(tile);
+		for (size_t p0 = 0; p0 < k; p0 += GEMM_KC) {
+			for (size_t i0 = tiles.row_begin(tile); i0 < end; i0 += mc) {
+				multiply_block(kernels, p0, std::min(mc, end - i0), a.panel(p0, i0 / mr), b, tiles.panel_begin(tile),
+				               tiles.panel_end(tile), c + i0 * ldc, ldc, accumulate || p0 > 0);
+			}
+		}
+	});
+}
+
+} // namespace duckdb_onnx
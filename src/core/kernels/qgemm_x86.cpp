@@ -0,0 +1,121 @@
+#include "duckdb-onnx/core/kernels/qgemm.hpp"
+#include "x86_isa.hpp"
+
+#include <cstring>
+#include <utility>
+
+namespace duckdb_onnx {
+namespace x86 {
+
+#ifdef DUCKDB_ONNX_X86_KERNELS
+
+// Each step broadcasts one pair of 16-bit values of A and multiplies it with
+// pairs of B by pmaddwd, which sums both products into 32-bit lanes.
+
+DUCKDB_ONNX_TARGET_REGION("sse4.1")
+namespace sse41 {
+namespace {
+
+struct QIsa {
+	using V = __m128i;
+	using B = __m128i;
+	static constexpr size_t width = 4;
+
+	static inline B load_pairs(const int16_t *p) {
+		return _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+	}
+	static inline V set1_pair(const int16_t *p) {
+		int32_t pair;
+		std::memcpy(&pair, p, sizeof(pair));
+		return _mm_set1_epi32(pair);
+	}
+	static inline V madd(V a, B b, V acc) {
+		return _mm_add_epi32(acc, _mm_madd_epi16(a, b));
+	}
+	static inline V zero() {
+		return _mm_setzero_si128();
+	}
+	static inline V load(const int32_t *p) {
+		return _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+	}
+	static inline void store(int32_t *p, V v) {
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(p), v);
+	}
+	static inline V add(V a, V b) {
+		return _mm_add_epi32(a, b);
+	}
+};
+
+// 12 accumulators + 4 B vectors out of 16 registers
+static constexpr size_t MR = 3;
+#include "qgemm_simd.inc"
+
+} // namespace
+} // namespace sse41
+DUCKDB_ONNX_UNTARGET_REGION
+
+DUCKDB_ONNX_TARGET_REGION("avx2")
+namespace avx2 {
+namespace {
+
+struct QIsa {
+	using V = __m256i;
+	using B = __m256i;
+	static constexpr size_t width = 8;
+
+	static inline B load_pairs(const int16_t *p) {
+		return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+	}
+	static inline V set1_pair(const int16_t *p) {
+		int32_t pair;
+		std::memcpy(&pair, p, sizeof(pair));
+		return _mm256_set1_epi32(pair);
+	}
+	static inline V madd(V a, B b, V acc) {
+		return _mm256_add_epi32(acc, _mm256_madd_epi16(a, b));
+	}
+	static inline V zero() {
+		return _mm256_setzero_si256();
+	}
+	static inline V load(const int32_t *p) {
+		return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+	}
+	static inline void store(int32_t *p, V v) {
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(p), v);
+	}
+	static inline V add(V a, V b) {
+		return _mm256_add_epi32(a, b);
+	}
+};
+
+// 12 accumulators + 2 B vectors + 1 broadcast out of 16 registers
+static constexpr size_t MR = 6;
+#include "qgemm_simd.inc"
+
+} // namespace
+} // namespace avx2
+DUCKDB_ONNX_UNTARGET_REGION
+
+const GemmKernelsI8 *gemm_kernels_i8(SimdLevel level) {
+	switch (level) {
+	// the 512-bit pmaddwd is AVX-512BW, which SimdLevel::Avx512 does not imply
+	case SimdLevel::Avx512:
+	case SimdLevel::Avx2:
+		return &avx2::kernels();
+	case SimdLevel::Sse41:
+		return &sse41::kernels();
+	default:
+		return nullptr;
+	}
+}
+
+#else
+
+const GemmKernelsI8 *gemm_kernels_i8(SimdLevel) {
+	return nullptr;
+}
+
+#endif
+
+} // namespace x86
+} // namespace duckdb_onnx
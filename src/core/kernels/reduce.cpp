@@ -0,0 +1,60 @@
+#include "duckdb-onnx/core/kernels/reduce.hpp"
+
+#include "duckdb-onnx/core/kernels/element_wise.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace duckdb_onnx {
+
+void softmax_f32(size_t n, const float *x, float *out) {
+	if (n == 0) {
+		return;
+	}
+	auto sub = binary_kernel_f32(BinaryKind::Sub);
+	auto mul = binary_kernel_f32(BinaryKind::Mul);
+	auto exp = unary_kernel_f32(UnaryKind::Exp);
+	// shifted by the maximum so that exp cannot overflow
+	auto max = *std::max_element(x, x + n);
+	sub(n, x, 1, &max, 0, out);
+	exp(n, out, out);
+	float sum = 0;
+	for (size_t i = 0; i < n; i++) {
+		sum += out[i];
+	}
+	auto inverse = 1.0f / sum;
+	mul(n, out, 1, &inverse, 0, out);
+}
+
+size_t argmax_f32(size_t n, const float *x) {
+	size_t best = 0;
+	for (size_t i = 1; i < n; i++) {
+		if (x[i] > x[best] || (std::isnan(x[best]) && !std::isnan(x[i]))) {
+			best = i;
+		}
+	}
+	return best;
+}
+
+std::vector<uint32_t> top_k_f32(size_t n, const float *x, size_t k) {
+	std::vector<uint32_t> indices(n);
+	std::iota(indices.begin(), indices.end(), 0);
+	auto before = [x](uint32_t a, uint32_t b) {
+		bool a_nan = std::isnan(x[a]);
+		bool b_nan = std::isnan(x[b]);
+		if (a_nan != b_nan) {
+			return b_nan;
+		}
+		if (!a_nan && x[a] != x[b]) {
+			return x[a] > x[b];
+		}
+		return a < b;
+	};
+	k = std::min(k, n);
+	std::partial_sort(indices.begin(), indices.begin() + static_cast<std::ptrdiff_t>(k), indices.end(), before);
+	indices.resize(k);
+	return indices;
+}
+
+} // namespace duckdb_onnx
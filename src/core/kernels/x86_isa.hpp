@@ -0,0 +1,274 @@
+#pragma once
+
+// Vector traits of the x86 code paths, one `Isa` struct per instruction set.
+// Kernels using an `Isa` must be compiled in the same target region and are only
+// reached after `simd_level()` confirmed the CPU supports it.
+
+#include <cstddef>
+#include <cstdint>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define DUCKDB_ONNX_X86_KERNELS
+// GCC 12 reports the placeholders of its AVX-512 intrinsics, left undefined on purpose, as maybe uninitialized once
+// they are inlined (GCC bug 105593). Its diagnostics follow the location of the intrinsics, inside this include.
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ == 12
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#include <immintrin.h>
+#pragma GCC diagnostic pop
+#else
+#include <immintrin.h>
+#endif
+
+// Compile a region for another instruction set than the baseline
+#define DUCKDB_ONNX_STRINGIFY(...) #__VA_ARGS__
+#if defined(__clang__)
+#define DUCKDB_ONNX_TARGET_REGION(T)                                                                                   \
+	_Pragma(DUCKDB_ONNX_STRINGIFY(clang attribute push(__attribute__((target(T))), apply_to = function)))
+#define DUCKDB_ONNX_UNTARGET_REGION _Pragma("clang attribute pop")
+#else
+#define DUCKDB_ONNX_TARGET_REGION(T) _Pragma("GCC push_options") _Pragma(DUCKDB_ONNX_STRINGIFY(GCC target(T)))
+#define DUCKDB_ONNX_UNTARGET_REGION _Pragma("GCC pop_options")
+#endif
+
+namespace duckdb_onnx {
+namespace x86 {
+
+DUCKDB_ONNX_TARGET_REGION("sse4.1")
+namespace sse41 {
+namespace {
+
+struct Isa {
+	using V = __m128;
+	static constexpr size_t width = 4;
+
+	static inline V load(const float *p) {
+		return _mm_loadu_ps(p);
+	}
+	static inline void store(float *p, V v) {
+		_mm_storeu_ps(p, v);
+	}
+	static inline V set1(float v) {
+		return _mm_set1_ps(v);
+	}
+	static inline V zero() {
+		return _mm_setzero_ps();
+	}
+	static inline V add(V a, V b) {
+		return _mm_add_ps(a, b);
+	}
+	static inline V sub(V a, V b) {
+		return _mm_sub_ps(a, b);
+	}
+	static inline V mul(V a, V b) {
+		return _mm_mul_ps(a, b);
+	}
+	static inline V div(V a, V b) {
+		return _mm_div_ps(a, b);
+	}
+	/// b when either operand is NaN
+	static inline V min(V a, V b) {
+		return _mm_min_ps(a, b);
+	}
+	static inline V max(V a, V b) {
+		return _mm_max_ps(a, b);
+	}
+	/// a * b + c
+	static inline V fmadd(V a, V b, V c) {
+		return _mm_add_ps(_mm_mul_ps(a, b), c);
+	}
+	static inline V round(V a) {
+		return _mm_round_ps(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+	}
+	/// 2^n for integral n in [-126, 127]
+	static inline V pow2n(V n) {
+		return _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(_mm_cvtps_epi32(n), _mm_set1_epi32(127)), 23));
+	}
+	static inline V abs(V a) {
+		return _mm_and_ps(a, _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff)));
+	}
+	/// the sign bits of a
+	static inline V sign(V a) {
+		return _mm_and_ps(a, _mm_castsi128_ps(_mm_set1_epi32(static_cast<int32_t>(0x80000000u))));
+	}
+	static inline V or_(V a, V b) {
+		return _mm_or_ps(a, b);
+	}
+	/// a < b ? then : otherwise
+	static inline V if_less(V a, V b, V then, V otherwise) {
+		return _mm_blendv_ps(otherwise, then, _mm_cmplt_ps(a, b));
+	}
+	/// `width` F16 values widened. Without F16C: the exponent and mantissa
+	/// shifted into place are scaled by 2^112 to rebias the exponent, which
+	/// also normalizes subnormals, and infinities and NaNs get the top exponent.
+	static inline V load_f16(const uint16_t *p) {
+		auto half = _mm_cvtepu16_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(p)));
+		auto magnitude = _mm_slli_epi32(_mm_and_si128(half, _mm_set1_epi32(0x7fff)), 13);
+		auto value = _mm_mul_ps(_mm_castsi128_ps(magnitude), _mm_castsi128_ps(_mm_set1_epi32(0x77800000)));
+		auto special = _mm_cmpgt_epi32(magnitude, _mm_set1_epi32(0x0f7fffff));
+		value = _mm_or_ps(value, _mm_castsi128_ps(_mm_and_si128(special, _mm_set1_epi32(0x7f800000))));
+		return _mm_or_ps(value, _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(half, _mm_set1_epi32(0x8000)), 16)));
+	}
+	/// `width` BF16 values widened
+	static inline V load_bf16(const uint16_t *p) {
+		auto bits = _mm_cvtepu16_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(p)));
+		return _mm_castsi128_ps(_mm_slli_epi32(bits, 16));
+	}
+};
+
+} // namespace
+} // namespace sse41
+DUCKDB_ONNX_UNTARGET_REGION
+
+DUCKDB_ONNX_TARGET_REGION("avx2,fma,f16c")
+namespace avx2 {
+namespace {
+
+struct Isa {
+	using V = __m256;
+	static constexpr size_t width = 8;
+
+	static inline V load(const float *p) {
+		return _mm256_loadu_ps(p);
+	}
+	static inline void store(float *p, V v) {
+		_mm256_storeu_ps(p, v);
+	}
+	static inline V set1(float v) {
+		return _mm256_set1_ps(v);
+	}
+	static inline V zero() {
+		return _mm256_setzero_ps();
+	}
+	static inline V add(V a, V b) {
+		return _mm256_add_ps(a, b);
+	}
+	static inline V sub(V a, V b) {
+		return _mm256_sub_ps(a, b);
+	}
+	static inline V mul(V a, V b) {
+		return _mm256_mul_ps(a, b);
+	}
+	static inline V div(V a, V b) {
+		return _mm256_div_ps(a, b);
+	}
+	static inline V min(V a, V b) {
+		return _mm256_min_ps(a, b);
+	}
+	static inline V max(V a, V b) {
+		return _mm256_max_ps(a, b);
+	}
+	static inline V fmadd(V a, V b, V c) {
+		return _mm256_fmadd_ps(a, b, c);
+	}
+	static inline V round(V a) {
+		return _mm256_round_ps(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+	}
+	static inline V pow2n(V n) {
+		return _mm256_castsi256_ps(
+		    _mm256_slli_epi32(_mm256_add_epi32(_mm256_cvtps_epi32(n), _mm256_set1_epi32(127)), 23));
+	}
+	static inline V abs(V a) {
+		return _mm256_and_ps(a, _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff)));
+	}
+	static inline V sign(V a) {
+		return _mm256_and_ps(a, _mm256_castsi256_ps(_mm256_set1_epi32(static_cast<int32_t>(0x80000000u))));
+	}
+	static inline V or_(V a, V b) {
+		return _mm256_or_ps(a, b);
+	}
+	static inline V if_less(V a, V b, V then, V otherwise) {
+		return _mm256_blendv_ps(otherwise, then, _mm256_cmp_ps(a, b, _CMP_LT_OQ));
+	}
+	static inline V load_f16(const uint16_t *p) {
+		return _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p)));
+	}
+	static inline V load_bf16(const uint16_t *p) {
+		auto bits = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p)));
+		return _mm256_castsi256_ps(_mm256_slli_epi32(bits, 16));
+	}
+};
+
+} // namespace
+} // namespace avx2
+DUCKDB_ONNX_UNTARGET_REGION
+
+DUCKDB_ONNX_TARGET_REGION("avx512f")
+namespace avx512 {
+namespace {
+
+struct Isa {
+	using V = __m512;
+	static constexpr size_t width = 16;
+
+	static inline V load(const float *p) {
+		return _mm512_loadu_ps(p);
+	}
+	static inline void store(float *p, V v) {
+		_mm512_storeu_ps(p, v);
+	}
+	static inline V set1(float v) {
+		return _mm512_set1_ps(v);
+	}
+	static inline V zero() {
+		return _mm512_setzero_ps();
+	}
+	static inline V add(V a, V b) {
+		return _mm512_add_ps(a, b);
+	}
+	static inline V sub(V a, V b) {
+		return _mm512_sub_ps(a, b);
+	}
+	static inline V mul(V a, V b) {
+		return _mm512_mul_ps(a, b);
+	}
+	static inline V div(V a, V b) {
+		return _mm512_div_ps(a, b);
+	}
+	static inline V min(V a, V b) {
+		return _mm512_min_ps(a, b);
+	}
+	static inline V max(V a, V b) {
+		return _mm512_max_ps(a, b);
+	}
+	static inline V fmadd(V a, V b, V c) {
+		return _mm512_fmadd_ps(a, b, c);
+	}
+	static inline V round(V a) {
+		return _mm512_roundscale_ps(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+	}
+	static inline V pow2n(V n) {
+		return _mm512_castsi512_ps(
+		    _mm512_slli_epi32(_mm512_add_epi32(_mm512_cvtps_epi32(n), _mm512_set1_epi32(127)), 23));
+	}
+	// AVX-512F has no float bitwise ops (they are AVX-512DQ): go through the integer ones
+	static inline V abs(V a) {
+		return _mm512_castsi512_ps(_mm512_and_si512(_mm512_castps_si512(a), _mm512_set1_epi32(0x7fffffff)));
+	}
+	static inline V sign(V a) {
+		return _mm512_castsi512_ps(
+		    _mm512_and_si512(_mm512_castps_si512(a), _mm512_set1_epi32(static_cast<int32_t>(0x80000000u))));
+	}
+	static inline V or_(V a, V b) {
+		return _mm512_castsi512_ps(_mm512_or_si512(_mm512_castps_si512(a), _mm512_castps_si512(b)));
+	}
+	static inline V if_less(V a, V b, V then, V otherwise) {
+		return _mm512_mask_blend_ps(_mm512_cmp_ps_mask(a, b, _CMP_LT_OQ), otherwise, then);
+	}
+	static inline V load_f16(const uint16_t *p) {
+		return _mm512_cvtph_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(p)));
+	}
+	static inline V load_bf16(const uint16_t *p) {
+		auto bits = _mm512_cvtepu16_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(p)));
+		return _mm512_castsi512_ps(_mm512_slli_epi32(bits, 16));
+	}
+};
+
+} // namespace
+} // namespace avx512
+DUCKDB_ONNX_UNTARGET_REGION
+
+} // namespace x86
+} // namespace duckdb_onnx
+
+#endif
@@ -1,3 +1,8 @@
 #include "duckdb-onnx/core/model/graph.hpp"
+#include "duckdb-onnx/core/model/typed.hpp"
 
-namespace duckdb_onnx {}
\ No newline at end of file
+namespace duckdb_onnx {
+
+template class Graph<TypedFact, OpBox>;
+
+} // namespace duckdb_onnx
@@ -0,0 +1,90 @@
+#include "duckdb-onnx/core/model/tdim.hpp"
+
+namespace duckdb_onnx {
+
+TDim TDim::affine(int64_t coefficient, std::string symbol, int64_t offset) {
+	TDim dim(offset);
+	if (coefficient != 0) {
+		dim.coefficient_ = coefficient;
+		dim.symbol_ = std::move(symbol);
+	}
+	return dim;
+}
+
+std::optional<int64_t> TDim::eval(const SymbolValues &values) const {
+	if (!known_) {
+		return std::nullopt;
+	}
+	if (coefficient_ == 0) {
+		return offset_;
+	}
+	auto value = values.find(symbol_);
+	if (value == values.end()) {
+		return std::nullopt;
+	}
+	return coefficient_ * value->second + offset_;
+}
+
+TDim TDim::operator+(const TDim &other) const {
+	if (!known_ || !other.known_ || (coefficient_ && other.coefficient_ && symbol_ != other.symbol_)) {
+		return TDim();
+	}
+	return affine(coefficient_ + other.coefficient_, coefficient_ ? symbol_ : other.symbol_, offset_ + other.offset_);
+}
+
+TDim TDim::operator-(const TDim &other) const {
+	return *this + other * TDim(-1);
+}
+
+TDim TDim::operator*(const TDim &other) const {
+	if (!known_ || !other.known_ || (coefficient_ && other.coefficient_)) {
+		return TDim();
+	}
+	if (other.coefficient_) {
+		return other * *this;
+	}
+	return affine(coefficient_ * other.offset_, symbol_, offset_ * other.offset_);
+}
+
+TDim TDim::operator/(const TDim &other) const {
+	if (!known_ || !other.known_) {
+		return TDim();
+	}
+	if (other.coefficient_ == 0) {
+		auto divisor = other.offset_;
+		if (divisor == 0 || coefficient_ % divisor != 0 || offset_ % divisor != 0) {
+			return TDim();
+		}
+		return affine(coefficient_ / divisor, symbol_, offset_ / divisor);
+	}
+	// (k * a) N + (k * b) over a N + b is k
+	if (symbol_ != other.symbol_ || coefficient_ % other.coefficient_ != 0) {
+		return TDim();
+	}
+	auto quotient = coefficient_ / other.coefficient_;
+	if (offset_ != quotient * other.offset_) {
+		return TDim();
+	}
+	return TDim(quotient);
+}
+
+std::ostream &operator<<(std::ostream &os, const TDim &dim) {
+	if (!dim.known_) {
+		return os << "?";
+	}
+	if (dim.coefficient_ == 0) {
+		return os << dim.offset_;
+	}
+	if (dim.coefficient_ != 1) {
+		os << dim.coefficient_ << "*";
+	}
+	os << dim.symbol_;
+	if (dim.offset_ > 0) {
+		os << "+" << dim.offset_;
+	} else if (dim.offset_ < 0) {
+		os << dim.offset_;
+	}
+	return os;
+}
+
+} // namespace duckdb_onnx
@@ -0,0 +1,143 @@
+#include "duckdb-onnx/core/ops/batch_norm.h"
+
+#include "duckdb-onnx/core/plan_file.hpp"
+#include "duckdb-onnx/core/session.hpp"
+
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+
+namespace duckdb_onnx {
+
+std::vector<float> batch_norm_coefficients(const Tensor &scale, const Tensor &bias, const Tensor &mean,
+                                           const Tensor &var, float epsilon) {
+	auto channels = scale.len();
+	for (auto stat : {&scale, &bias, &mean, &var}) {
+		if (stat->datum_type() != DatumType::F32 || stat->len() != channels) {
+			std::ostringstream msg;
+			msg << "BatchNormalization expects F32 statistics of " << channels << " channels, got "
+			    << datum_type_name(stat->datum_type()) << " " << stat->shape();
+			throw std::runtime_error(msg.str());
+		}
+	}
+	std::vector<float> coefficients(2 * channels);
+	for (size_t c = 0; c < channels; c++) {
+		auto multiplier = scale.as_ptr<float>()[c] / std::sqrt(var.as_ptr<float>()[c] + epsilon);
+		coefficients[c] = multiplier;
+		coefficients[channels + c] = bias.as_ptr<float>()[c] - mean.as_ptr<float>()[c] * multiplier;
+	}
+	return coefficients;
+}
+
+std::vector<TValue> BatchNormOp::eval_impl(SessionState *session, std::vector<TValue> inputs) const {
+	if (inputs.size() != 5) {
+		throw std::runtime_error("BatchNormalization expects 5 inputs, got " + std::to_string(inputs.size()));
+	}
+	auto &x = *inputs[0];
+	if (x.datum_type() != DatumType::F32 || x.rank() < 2) {
+		std::ostringstream msg;
+		msg << "BatchNormalization expects an F32 [N, C, ...] input, got " << datum_type_name(x.datum_type()) << " "
+		    << x.shape();
+		throw std::runtime_error(msg.str());
+	}
+	auto channels = static_cast<size_t>(x.shape()[1]);
+	std::vector<float> local;
+	auto folded = coefficients.get();
+	if (!folded) {
+		local = batch_norm_coefficients(*inputs[1], *inputs[2], *inputs[3], *inputs[4], epsilon);
+		folded = &local;
+	}
+	if (folded->size() != 2 * channels) {
+		std::ostringstream msg;
+		msg << "BatchNormalization statistics have " << folded->size() / 2 << " channels, the input " << x.shape();
+		throw std::runtime_error(msg.str());
+	}
+	auto multipliers = folded->data();
+	auto offsets = multipliers + channels;
+
+	TValue result;
+	if (inputs[0].is_exclusive()) {
+		result = std::move(inputs[0]);
+	} else {
+		result = TValue::Var(output_tensor(session, 0, DatumType::F32, x.shape()));
+	}
+	// after an in-place move the input is the result itself
+	const Tensor *input = inputs[0].tensor_ ? inputs[0].tensor_.get() : result.tensor_.get();
+	auto src = input->as_ptr<float>();
+	auto dst = result.tensor_->as_ptr_mut<float>();
+	auto batch = static_cast<size_t>(x.shape()[0]);
+	auto inner = batch * channels != 0 ? input->len() / (batch * channels) : 0;
+	for (size_t n = 0; n < batch; n++) {
+		for (size_t c = 0; c < channels; c++) {
+			auto offset = (n * channels + c) * inner;
+			auto a = multipliers[c];
+			auto b = offsets[c];
+			for (size_t i = 0; i < inner; i++) {
+				dst[offset + i] = src[offset + i] * a + b;
+			}
+		}
+	}
+	std::vector<TValue> outputs;
+	outputs.push_back(std::move(result));
+	return outputs;
+}
+
+TractResult<std::vector<TValue>> BatchNormOp::eval(const std::vector<TValue> &inputs) const {
+	return try_catch([&]() { return eval_impl(nullptr, inputs); });
+}
+
+TractResult<std::vector<TValue>> BatchNormOp::eval_with_session(SessionState &session,
+                                                                std::vector<TValue> inputs) const {
+	return try_catch([&]() { return eval_impl(&session, std::move(inputs)); });
+}
+
+std::shared_ptr<Op> BatchNormOp::codegen(const std::vector<std::shared_ptr<Tensor>> &constants) const {
+	if (coefficients || constants.size() != 5) {
+		return nullptr;
+	}
+	for (size_t i = 1; i < 5; i++) {
+		if (!constants[i]) {
+			return nullptr;
+		}
+	}
+	auto op = std::make_shared<BatchNormOp>(*this);
+	try {
+		auto folded = batch_norm_coefficients(*constants[1], *constants[2], *constants[3], *constants[4], epsilon);
+		op->coefficients = std::make_shared<const std::vector<float>>(std::move(folded));
+	} catch (std::exception &) {
+		// mismatched statistics are reported when the op runs
+		return nullptr;
+	}
+	return op;
+}
+
+TractResult<std::vector<TypedFact>> BatchNormOp::output_facts(const std::vector<const TypedFact *> &inputs) const {
+	return same_as_input_facts(*this, inputs);
+}
+
+bool BatchNormOp::save(PlanWriter &writer) const {
+	writer.write_string("BatchNorm");
+	writer.write_f32(epsilon);
+	writer.write_bool(coefficients != nullptr);
+	if (coefficients) {
+		writer.write_u64(coefficients->size());
+		for (auto coefficient : *coefficients) {
+			writer.write_f32(coefficient);
+		}
+	}
+	return true;
+}
+
+std::shared_ptr<Op> BatchNormOp::load(PlanReader &reader) {
+	auto op = std::make_shared<BatchNormOp>(reader.read_f32());
+	if (reader.read_bool()) {
+		std::vector<float> values(reader.read_u64());
+		for (auto &value : values) {
+			value = reader.read_f32();
+		}
+		op->coefficients = std::make_shared<const std::vector<float>>(std::move(values));
+	}
+	return op;
+}
+
+} // namespace duckdb_onnx
@@ -0,0 +1,178 @@
+#include "duckdb-onnx/core/ops/binary.h"
+
+#include "duckdb-onnx/core/ops/broadcast.h"
+#include "duckdb-onnx/core/plan_file.hpp"
+#include "duckdb-onnx/core/session.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <type_traits>
+
+namespace duckdb_onnx {
+
+std::string BinaryOp::name() const {
+	switch (kind) {
+	case BinaryKind::Add:
+		return "Add";
+	case BinaryKind::Sub:
+		return "Sub";
+	case BinaryKind::Mul:
+		return "Mul";
+	case BinaryKind::Div:
+		return "Div";
+	case BinaryKind::Max:
+		return "Max";
+	case BinaryKind::Min:
+		return "Min";
+	}
+	return "Binary";
+}
+
+template <typename T>
+static T apply_scalar(BinaryKind kind, T a, T b) {
+	switch (kind) {
+	case BinaryKind::Add:
+		return static_cast<T>(a + b);
+	case BinaryKind::Sub:
+		return static_cast<T>(a - b);
+	case BinaryKind::Mul:
+		return static_cast<T>(a * b);
+	case BinaryKind::Div:
+		if (std::is_integral<T>::value && b == 0) {
+			throw std::runtime_error("Integer division by zero");
+		}
+		return static_cast<T>(a / b);
+	case BinaryKind::Max:
+		return a > b ? a : b;
+	case BinaryKind::Min:
+		return a < b ? a : b;
+	}
+	return a;
+}
+
+std::vector<TValue> BinaryOp::eval_impl(SessionState *session, std::vector<TValue> inputs) const {
+	if (inputs.size() != 2) {
+		throw std::runtime_error(name() + " expects 2 inputs, got " + std::to_string(inputs.size()));
+	}
+	auto dt = inputs[0]->datum_type();
+	if (inputs[1]->datum_type() != dt) {
+		throw std::runtime_error(name() + " operands have different types: " + datum_type_name(dt) + " and " +
+		                         datum_type_name(inputs[1]->datum_type()));
+	}
+	auto shape = broadcast_shapes(inputs[0]->shape(), inputs[1]->shape());
+
+	bool in_place = inputs[0].is_exclusive() && inputs[0]->shape() == shape;
+	// hold the inputs through shared pointers so that the output may replace the first one
+	auto a = inputs[0].tensor_;
+	auto b = inputs[1].tensor_;
+	TValue result = in_place ? std::move(inputs[0]) : TValue::Var(output_tensor(session, 0, dt, shape));
+	inputs.clear();
+	auto out = result.tensor_.get();
+	BinaryBroadcast broadcast(a->shape(), b->shape(), shape);
+
+	if (dt == DatumType::F32) {
+		auto kernel = binary_kernel_f32(kind);
+		auto a_data = a->as_ptr<float>();
+		auto b_data = b->as_ptr<float>();
+		auto out_data = out->as_ptr_mut<float>();
+		broadcast.for_each_run([&](size_t out_offset, size_t a_offset, size_t a_step, size_t b_offset, size_t b_step,
+		                           size_t len) {
+			kernel(len, a_data + a_offset, a_step, b_data + b_offset, b_step, out_data + out_offset);
+		});
+	} else {
+		dispatch_numbers(dt, [&](auto tag) {
+			using T = typename decltype(tag)::type;
+			auto a_data = a->template as_ptr<T>();
+			auto b_data = b->template as_ptr<T>();
+			auto out_data = out->template as_ptr_mut<T>();
+			auto op = kind;
+			broadcast.for_each_run([&](size_t out_offset, size_t a_offset, size_t a_step, size_t b_offset,
+			                           size_t b_step, size_t len) {
+				for (size_t i = 0; i < len; i++) {
+					out_data[out_offset + i] =
+					    apply_scalar<T>(op, a_data[a_offset + i * a_step], b_data[b_offset + i * b_step]);
+				}
+			});
+		});
+	}
+	std::vector<TValue> outputs;
+	outputs.push_back(std::move(result));
+	return outputs;
+}
+
+TractResult<std::vector<TValue>> BinaryOp::eval(const std::vector<TValue> &inputs) const {
+	return try_catch([&]() { return eval_impl(nullptr, inputs); });
+}
+
+TractResult<std::vector<TValue>> BinaryOp::eval_with_session(SessionState &session, std::vector<TValue> inputs) const {
+	return try_catch([&]() { return eval_impl(&session, std::move(inputs)); });
+}
+
+/// `a op b` over the elements of integer tensors computed from shapes, when
+/// the op is exact on them
+static std::optional<std::vector<TDim>> symbolic_binary(BinaryKind kind, const std::vector<TDim> &a,
+                                                        const std::vector<TDim> &b) {
+	auto len = std::max(a.size(), b.size());
+	if ((a.size() != len && a.size() != 1) || (b.size() != len && b.size() != 1)) {
+		return std::nullopt;
+	}
+	std::vector<TDim> result;
+	for (size_t i = 0; i < len; i++) {
+		auto &x = a[a.size() == 1 ? 0 : i];
+		auto &y = b[b.size() == 1 ? 0 : i];
+		switch (kind) {
+		case BinaryKind::Add:
+			result.push_back(x + y);
+			break;
+		case BinaryKind::Sub:
+			result.push_back(x - y);
+			break;
+		case BinaryKind::Mul:
+			result.push_back(x * y);
+			break;
+		case BinaryKind::Div:
+			result.push_back(x / y);
+			break;
+		case BinaryKind::Max:
+		case BinaryKind::Min:
+			if (!x.is_int() || !y.is_int()) {
+				return std::nullopt;
+			}
+			result.emplace_back(kind == BinaryKind::Max ? std::max(x.as_int(), y.as_int())
+			                                            : std::min(x.as_int(), y.as_int()));
+			break;
+		}
+	}
+	return result;
+}
+
+TractResult<std::vector<TypedFact>> BinaryOp::output_facts(const std::vector<const TypedFact *> &inputs) const {
+	return try_catch([&]() {
+		if (inputs.size() != 2) {
+			throw std::runtime_error(name() + " expects 2 inputs, got " + std::to_string(inputs.size()));
+		}
+		auto &a = *inputs[0];
+		auto &b = *inputs[1];
+		auto fact = TypedFact::unknown(a.datum_type);
+		if (a.rank_known && b.rank_known) {
+			fact = TypedFact(a.datum_type, broadcast_dims(a.shape, b.shape));
+		}
+		// shape arithmetic, such as a batch size times a number of channels
+		if (a.symbolic_value && b.symbolic_value && fact.rank_known && fact.shape.size() <= 1) {
+			fact.symbolic_value = symbolic_binary(kind, *a.symbolic_value, *b.symbolic_value);
+		}
+		return std::vector<TypedFact> {fact};
+	});
+}
+
+bool BinaryOp::save(PlanWriter &writer) const {
+	writer.write_string("Binary");
+	writer.write_u64(static_cast<uint64_t>(kind));
+	return true;
+}
+
+std::shared_ptr<Op> BinaryOp::load(PlanReader &reader) {
+	return std::make_shared<BinaryOp>(static_cast<BinaryKind>(reader.read_u64()));
+}
+
+} // namespace duckdb_onnx
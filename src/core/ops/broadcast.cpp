@@ -0,0 +1,93 @@
+#include "duckdb-onnx/core/ops/broadcast.h"
+
+#include <sstream>
+#include <stdexcept>
+
+namespace duckdb_onnx {
+
+ShapeVec broadcast_shapes(const ShapeVec &a, const ShapeVec &b) {
+	auto rank = std::max(a.size(), b.size());
+	ShapeVec out;
+	out.resize(rank, 1);
+	for (size_t i = 0; i < rank; i++) {
+		auto da = i < rank - a.size() ? 1 : a[i - (rank - a.size())];
+		auto db = i < rank - b.size() ? 1 : b[i - (rank - b.size())];
+		if (da != db && da != 1 && db != 1) {
+			std::ostringstream msg;
+			msg << "Cannot broadcast shapes " << a << " and " << b;
+			throw std::runtime_error(msg.str());
+		}
+		out[i] = da == 1 ? db : da;
+	}
+	return out;
+}
+
+std::vector<TDim> broadcast_dims(const std::vector<TDim> &a, const std::vector<TDim> &b) {
+	auto rank = std::max(a.size(), b.size());
+	std::vector<TDim> out;
+	for (size_t i = 0; i < rank; i++) {
+		auto da = i < rank - a.size() ? TDim(1) : a[i - (rank - a.size())];
+		auto db = i < rank - b.size() ? TDim(1) : b[i - (rank - b.size())];
+		if (da.is_int() && db.is_int() && da != db && da != TDim(1) && db != TDim(1)) {
+			std::ostringstream msg;
+			msg << "Cannot broadcast dimensions " << da << " and " << db;
+			throw std::runtime_error(msg.str());
+		}
+		if (da == TDim(1) || da == db) {
+			out.push_back(db);
+		} else if (db == TDim(1) || (da.is_int() && !db.is_int())) {
+			out.push_back(da);
+		} else if (db.is_int()) {
+			out.push_back(db);
+		} else {
+			out.emplace_back();
+		}
+	}
+	return out;
+}
+
+/// Element strides of `shape` right-aligned to `out`, 0 along broadcast dimensions
+static ShapeVec broadcast_strides(const ShapeVec &shape, const ShapeVec &out) {
+	ShapeVec strides;
+	strides.resize(out.size(), 0);
+	int64_t stride = 1;
+	for (size_t i = shape.size(); i-- > 0;) {
+		auto d = i + out.size() - shape.size();
+		strides[d] = shape[i] == 1 ? 0 : stride;
+		stride *= shape[i];
+	}
+	return strides;
+}
+
+BinaryBroadcast::BinaryBroadcast(const ShapeVec &a, const ShapeVec &b, const ShapeVec &out) {
+	auto a_strides = broadcast_strides(a, out);
+	auto b_strides = broadcast_strides(b, out);
+	for (size_t i = 0; i < out.size(); i++) {
+		total_ *= static_cast<size_t>(out[i]);
+		if (out[i] == 1) {
+			continue;
+		}
+		auto rank = dims_.size();
+		if (rank > 0 && a_strides_[rank - 1] == a_strides[i] * out[i] &&
+		    b_strides_[rank - 1] == b_strides[i] * out[i]) {
+			// contiguous with the previous dimension for both operands: merge them
+			dims_[rank - 1] *= out[i];
+			a_strides_[rank - 1] = a_strides[i];
+			b_strides_[rank - 1] = b_strides[i];
+			continue;
+		}
+		dims_.push_back(out[i]);
+		a_strides_.push_back(a_strides[i]);
+		b_strides_.push_back(b_strides[i]);
+	}
+	if (total_ == 0) {
+		dims_.clear();
+		a_strides_.clear();
+		b_strides_.clear();
+		dims_.push_back(0);
+		a_strides_.push_back(0);
+		b_strides_.push_back(0);
+	}
+}
+
+} // namespace duckdb_onnx
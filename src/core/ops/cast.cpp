@@ -0,0 +1,122 @@
+#include "duckdb-onnx/core/ops/cast.h"
+
+#include "duckdb-onnx/core/half.hpp"
+#include "duckdb-onnx/core/kernels/element_wise.hpp"
+#include "duckdb-onnx/core/plan_file.hpp"
+#include "duckdb-onnx/core/session.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace duckdb_onnx {
+
+void cast_elements(const Tensor &input, Tensor &output) {
+	auto len = input.len();
+	if (output.len() != len) {
+		throw std::runtime_error("Cast output has " + std::to_string(output.len()) + " elements, expected " +
+		                         std::to_string(len));
+	}
+	auto from = input.datum_type();
+	auto to = output.datum_type();
+	if (from == to) {
+		std::copy_n(static_cast<const char *>(input.raw_data()), len * datum_type_size(from),
+		            static_cast<char *>(output.raw_data_mut()));
+		return;
+	}
+	bool from_half = from == DatumType::F16 || from == DatumType::BF16;
+	bool to_half = to == DatumType::F16 || to == DatumType::BF16;
+	if (from_half && to == DatumType::F32) {
+		widen_kernel_f32(from)(len, static_cast<const uint16_t *>(input.raw_data()), output.as_ptr_mut<float>());
+		return;
+	}
+	auto narrow = to == DatumType::F16 ? float_to_half : float_to_bf16;
+	if (from_half) {
+		auto widen = from == DatumType::F16 ? half_to_float : bf16_to_float;
+		auto x = static_cast<const uint16_t *>(input.raw_data());
+		if (to_half) {
+			auto y = static_cast<uint16_t *>(output.raw_data_mut());
+			for (size_t i = 0; i < len; i++) {
+				y[i] = narrow(widen(x[i]));
+			}
+			return;
+		}
+		dispatch_copy(to, [&](auto to_tag) {
+			using To = typename decltype(to_tag)::type;
+			auto y = output.template as_ptr_mut<To>();
+			for (size_t i = 0; i < len; i++) {
+				y[i] = static_cast<To>(widen(x[i]));
+			}
+		});
+		return;
+	}
+	if (to_half) {
+		auto y = static_cast<uint16_t *>(output.raw_data_mut());
+		dispatch_copy(from, [&](auto from_tag) {
+			using From = typename decltype(from_tag)::type;
+			auto x = input.template as_ptr<From>();
+			for (size_t i = 0; i < len; i++) {
+				y[i] = narrow(static_cast<float>(x[i]));
+			}
+		});
+		return;
+	}
+	dispatch_copy(from, [&](auto from_tag) {
+		using From = typename decltype(from_tag)::type;
+		dispatch_copy(to, [&](auto to_tag) {
+			using To = typename decltype(to_tag)::type;
+			auto x = input.template as_ptr<From>();
+			auto y = output.template as_ptr_mut<To>();
+			for (size_t i = 0; i < len; i++) {
+				y[i] = static_cast<To>(x[i]);
+			}
+		});
+	});
+}
+
+std::vector<TValue> CastOp::eval_impl(SessionState *session, std::vector<TValue> inputs) const {
+	if (inputs.size() != 1) {
+		throw std::runtime_error("Cast expects 1 input, got " + std::to_string(inputs.size()));
+	}
+	auto &input = *inputs[0];
+	if (input.datum_type() == to) {
+		return inputs;
+	}
+	auto output = output_tensor(session, 0, to, input.shape());
+	cast_elements(input, output);
+	std::vector<TValue> outputs;
+	outputs.push_back(TValue::Var(std::move(output)));
+	return outputs;
+}
+
+TractResult<std::vector<TValue>> CastOp::eval(const std::vector<TValue> &inputs) const {
+	return try_catch([&]() { return eval_impl(nullptr, inputs); });
+}
+
+TractResult<std::vector<TValue>> CastOp::eval_with_session(SessionState &session, std::vector<TValue> inputs) const {
+	return try_catch([&]() { return eval_impl(&session, std::move(inputs)); });
+}
+
+TractResult<std::vector<TypedFact>> CastOp::output_facts(const std::vector<const TypedFact *> &inputs) const {
+	if (inputs.size() != 1) {
+		return Err<std::vector<TypedFact>>("Cast expects 1 input, got " + std::to_string(inputs.size()));
+	}
+	auto fact = inputs[0]->without_value();
+	fact.datum_type = to;
+	// integer casts keep the shape arithmetic
+	if (to == DatumType::I64 || to == DatumType::I32) {
+		fact.symbolic_value = inputs[0]->symbolic_value;
+	}
+	return Ok(std::vector<TypedFact> {fact});
+}
+
+bool CastOp::save(PlanWriter &writer) const {
+	writer.write_string("Cast");
+	writer.write_u64(static_cast<uint64_t>(to));
+	return true;
+}
+
+std::shared_ptr<Op> CastOp::load(PlanReader &reader) {
+	return std::make_shared<CastOp>(static_cast<DatumType>(reader.read_u64()));
+}
+
+} // namespace duckdb_onnx
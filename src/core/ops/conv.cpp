@@ -0,0 +1,300 @@
+#include "duckdb-onnx/core/ops/conv.h"
+
+#include "duckdb-onnx/core/plan_file.hpp"
+#include "duckdb-onnx/core/session.hpp"
+
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+
+namespace duckdb_onnx {
+
+/// Fewest patch values worth gathering in a task of their own
+static constexpr size_t PATCH_MIN_TASK_WORK = 1 << 16;
+/// Fewest multiply-adds worth a task of their own
+static constexpr size_t CONV_MIN_TASK_WORK = 1 << 20;
+
+/// Pack the matrix of the input patches of one group, whose row
+/// c * kh * kw + ky * kw + kx and column oy * ow + ox holds the pixel of
+/// channel c under kernel offset (ky, kx) of output pixel (oy, ox), zero in
+/// the padding. It is written straight into the GEMM panels, ranges of
+/// panels being filled concurrently on `runner`.
+static void pack_patches(const PatchGeometry &geo, size_t channels, const float *image, PackedMatrixF32 &columns,
+                         TaskRunner *runner) {
+	auto kh = static_cast<size_t>(geo.kernel[0]);
+	auto kw = static_cast<size_t>(geo.kernel[1]);
+	auto ih = geo.input[0];
+	auto iw = geo.input[1];
+	auto ow = static_cast<size_t>(geo.output[1]);
+	auto k = channels * kh * kw;
+	auto pixels = static_cast<size_t>(geo.output_len());
+	columns.resize(k, pixels);
+
+	// input coordinates under the top-left kernel offset of every output pixel
+	std::vector<int64_t> origin_y(pixels);
+	std::vector<int64_t> origin_x(pixels);
+	for (size_t j = 0; j < pixels; j++) {
+		origin_y[j] = geo.input_index(0, static_cast<int64_t>(j / ow), 0);
+		origin_x[j] = geo.input_index(1, static_cast<int64_t>(j % ow), 0);
+	}
+	auto parts = parallel_parts(runner, k * pixels, PATCH_MIN_TASK_WORK);
+	parallel_for(runner, columns.panel_count(), parts, [&](size_t begin, size_t end) {
+		for (size_t p0 = 0; p0 < k; p0 += GEMM_KC) {
+			auto kc = std::min(GEMM_KC, k - p0);
+			for (size_t panel = begin; panel < end; panel++) {
+				auto dst = columns.panel_mut(p0, panel);
+				auto j0 = panel * GEMM_NR;
+				auto cols = std::min(GEMM_NR, pixels - j0);
+				auto ys = origin_y.data() + j0;
+				auto xs = origin_x.data() + j0;
+				for (size_t p = p0; p < p0 + kc; p++, dst += GEMM_NR) {
+					auto plane = image + (p / (kh * kw)) * ih * iw;
+					auto dy = static_cast<int64_t>((p / kw) % kh) * geo.dilations[0];
+					auto dx = static_cast<int64_t>(p % kw) * geo.dilations[1];
+					for (size_t j = 0; j < cols; j++) {
+						auto y = ys[j] + dy;
+						auto x = xs[j] + dx;
+						dst[j] = y >= 0 && y < ih && x >= 0 && x < iw ? plane[y * iw + x] : 0.0f;
+					}
+					std::fill(dst + cols, dst + GEMM_NR, 0.0f);
+				}
+			}
+		}
+	});
+}
+
+/// F32 filters, or F16 and BF16 ones widened by the GEMM as it reads them
+static bool filters_type(DatumType dt) {
+	return dt == DatumType::F32 || dt == DatumType::F16 || dt == DatumType::BF16;
+}
+
+/// The filters of every group as GEMM left-hand sides: group g is the
+/// (m / group) x k matrix starting at filter g * m / group
+static std::vector<PackedMatrixF32> pack_filters(const Tensor &filters, int64_t group, size_t mr) {
+	auto m = static_cast<size_t>(filters.shape()[0] / group);
+	auto k = filters.len() / static_cast<size_t>(filters.shape()[0]);
+	std::vector<PackedMatrixF32> packed(static_cast<size_t>(group));
+	for (size_t g = 0; g < packed.size(); g++) {
+		// packed transposed: element (p, i) is filter i, weight p
+		packed[g].pack(k, m, filters, g * m * k, 1, k, mr);
+	}
+	return packed;
+}
+
+std::vector<TValue> ConvOp::eval_impl(SessionState *session, std::vector<TValue> inputs) const {
+	if (inputs.size() != 2 && inputs.size() != 3) {
+		throw std::runtime_error("Conv expects 2 or 3 inputs, got " + std::to_string(inputs.size()));
+	}
+	auto &x = *inputs[0];
+	auto &w = *inputs[1];
+	if (x.datum_type() != DatumType::F32 || !filters_type(w.datum_type())) {
+		throw std::runtime_error(std::string("Conv only supports F32, got ") + datum_type_name(x.datum_type()) +
+		                         " input and " + datum_type_name(w.datum_type()) + " filters");
+	}
+	if ((x.rank() != 3 && x.rank() != 4) || w.rank() != x.rank()) {
+		std::ostringstream msg;
+		msg << "Conv only supports 1-D and 2-D images, got input " << x.shape() << " and filters " << w.shape();
+		throw std::runtime_error(msg.str());
+	}
+	auto batch = static_cast<size_t>(x.shape()[0]);
+	auto channels = x.shape()[1];
+	auto filters = w.shape()[0];
+	auto group_channels = w.shape()[1];
+	if (group <= 0 || channels != group_channels * group || filters % group != 0) {
+		std::ostringstream msg;
+		msg << "Conv filters " << w.shape() << " do not match input " << x.shape() << " with " << group << " groups";
+		throw std::runtime_error(msg.str());
+	}
+	const float *bias = nullptr;
+	if (inputs.size() == 3) {
+		auto &b = *inputs[2];
+		if (b.datum_type() != DatumType::F32 || b.len() != static_cast<size_t>(filters)) {
+			std::ostringstream msg;
+			msg << "Conv bias of shape " << b.shape() << " does not match " << filters << " filters";
+			throw std::runtime_error(msg.str());
+		}
+		bias = b.as_ptr<float>();
+	}
+
+	ShapeVec spatial(x.shape().begin() + 2, x.shape().end());
+	ShapeVec kernel(w.shape().begin() + 2, w.shape().end());
+	auto geo = patch.geometry(spatial, kernel);
+	ShapeVec shape {x.shape()[0], filters};
+	if (x.rank() == 4) {
+		shape.push_back(geo.output[0]);
+	}
+	shape.push_back(geo.output[1]);
+	TValue result = TValue::Var(output_tensor(session, 0, DatumType::F32, shape));
+	auto out = result.tensor_->as_ptr_mut<float>();
+
+	auto &kernels = gemm_kernels_f32();
+	std::vector<PackedMatrixF32> local;
+	auto packed = packed_filters.get();
+	if (!packed || packed->empty() || (*packed)[0].width() != kernels.mr) {
+		local = pack_filters(w, group, kernels.mr);
+		packed = &local;
+	}
+
+	auto m = static_cast<size_t>(filters / group);
+	auto k = static_cast<size_t>(group_channels * geo.kernel[0] * geo.kernel[1]);
+	auto image_len = static_cast<size_t>(geo.input[0] * geo.input[1]);
+	auto pixels = static_cast<size_t>(geo.output_len());
+	// a 1x1 kernel over the unpadded image reads the input as it is
+	bool pointwise = geo.kernel[0] == 1 && geo.kernel[1] == 1 && geo.strides[0] == 1 && geo.strides[1] == 1 &&
+	                 geo.pad_begin[0] == 0 && geo.pad_begin[1] == 0 && pixels == image_len;
+	// the epilogue runs on each group of rows right after its GEMM, unless its constants need broadcasting
+	bool fused = epilogue && epilogue->runs_f32(*result);
+	auto runner = session ? session->runner : nullptr;
+	auto images = batch * static_cast<size_t>(group);
+	auto parts = parallel_parts(runner, images * m * k * pixels, CONV_MIN_TASK_WORK);
+	// whole images per task when there are enough of them to go around, the inside of each image otherwise
+	auto image_parts = images >= parts ? parts : 1;
+	auto image_runner = image_parts > 1 ? nullptr : runner;
+	auto conv_images = [&](size_t begin, size_t end, PackedMatrixF32 &columns) {
+		for (size_t i = begin; i < end; i++) {
+			auto n = i / static_cast<size_t>(group);
+			auto g = i % static_cast<size_t>(group);
+			auto image = x.as_ptr<float>() + (n * channels + g * group_channels) * image_len;
+			auto c = out + (n * filters + g * m) * pixels;
+			if (bias) {
+				for (size_t r = 0; r < m; r++) {
+					std::fill(c + r * pixels, c + (r + 1) * pixels, bias[g * m + r]);
+				}
+			}
+			if (pointwise) {
+				columns.pack(k, pixels, image, pixels, 1);
+			} else {
+				pack_patches(geo, static_cast<size_t>(group_channels), image, columns, image_runner);
+			}
+			gemm_f32(kernels, (*packed)[g], columns, c, pixels, bias != nullptr, image_runner);
+			if (fused) {
+				epilogue->apply_f32(m * pixels, c, c);
+			}
+		}
+	};
+	// one im2col buffer per task, taken from the arena within a plan and released once the products are done
+	std::vector<PackedMatrixF32> scratch(image_parts);
+	TensorArena::Mark mark {};
+	if (session) {
+		mark = session->arena.mark();
+		auto size = PackedMatrixF32::storage_size(k, pixels, GEMM_NR, DatumType::F32);
+		for (auto &columns : scratch) {
+			columns.assign(k, pixels, GEMM_NR, DatumType::F32, Blob::borrow(session->arena.allocate(size), size));
+		}
+	}
+	parallel_for(runner, image_parts, image_parts, [&](size_t part_begin, size_t part_end) {
+		for (size_t part = part_begin; part < part_end; part++) {
+			conv_images(part * images / image_parts, (part + 1) * images / image_parts, scratch[part]);
+		}
+	});
+	if (session) {
+		session->arena.rewind(mark);
+	}
+	if (epilogue && !fused) {
+		result = epilogue->eval(std::move(result));
+	}
+	std::vector<TValue> outputs;
+	outputs.push_back(std::move(result));
+	return outputs;
+}
+
+TractResult<std::vector<TValue>> ConvOp::eval(const std::vector<TValue> &inputs) const {
+	return try_catch([&]() { return eval_impl(nullptr, inputs); });
+}
+
+TractResult<std::vector<TValue>> ConvOp::eval_with_session(SessionState &session, std::vector<TValue> inputs) const {
+	return try_catch([&]() { return eval_impl(&session, std::move(inputs)); });
+}
+
+std::shared_ptr<Op> ConvOp::codegen(const std::vector<std::shared_ptr<Tensor>> &constants) const {
+	if (packed_filters || constants.size() < 2 || !constants[1]) {
+		return nullptr;
+	}
+	auto &w = *constants[1];
+	if (!filters_type(w.datum_type()) || w.rank() < 3 || group <= 0 || w.shape()[0] % group != 0) {
+		return nullptr;
+	}
+	auto op = std::make_shared<ConvOp>(*this);
+	op->packed_filters =
+	    std::make_shared<const std::vector<PackedMatrixF32>>(pack_filters(w, group, gemm_kernels_f32().mr));
+	return op;
+}
+
+uint64_t ConvOp::flops(const std::vector<ShapeVec> &inputs, const std::vector<ShapeVec> &outputs) const {
+	// each output element is a dot product of one filter with a patch
+	if (inputs.size() < 2 || inputs[1].empty() || inputs[1][0] <= 0 || outputs.empty()) {
+		return 0;
+	}
+	auto filter_len = shape_volume(inputs[1]) / static_cast<uint64_t>(inputs[1][0]);
+	auto volume = shape_volume(outputs[0]);
+	return 2 * volume * filter_len + (epilogue ? epilogue->steps().size() * volume : 0);
+}
+
+size_t ConvOp::memory_usage() const {
+	size_t bytes = 0;
+	if (packed_filters) {
+		for (auto &packed : *packed_filters) {
+			bytes += packed.heap_bytes();
+		}
+	}
+	return bytes;
+}
+
+TractResult<std::vector<TypedFact>> ConvOp::output_facts(const std::vector<const TypedFact *> &inputs) const {
+	return try_catch([&]() {
+		if (inputs.size() != 2 && inputs.size() != 3) {
+			throw std::runtime_error("Conv expects 2 or 3 inputs, got " + std::to_string(inputs.size()));
+		}
+		auto &x = *inputs[0];
+		auto &w = *inputs[1];
+		auto fact = TypedFact::unknown(DatumType::F32);
+		if (x.rank_known && w.rank_known && w.shape.size() >= 2) {
+			std::vector<TDim> kernel(w.shape.begin() + 2, w.shape.end());
+			fact = TypedFact(DatumType::F32, patch.output_shape(x.shape, w.shape[0], kernel));
+			auto &channels = x.shape[1];
+			if (channels.is_int() && w.shape[1].is_int() && channels.as_int() != w.shape[1].as_int() * group) {
+				std::ostringstream msg;
+				msg << "Conv filters of " << w.shape[1] << " channels do not match an input of " << channels
+				    << " channels with " << group << " groups";
+				throw std::runtime_error(msg.str());
+			}
+		}
+		return std::vector<TypedFact> {epilogue ? epilogue->output_fact(fact) : fact};
+	});
+}
+
+bool ConvOp::save(PlanWriter &writer) const {
+	writer.write_string("Conv");
+	patch.save(writer);
+	writer.write_i64(group);
+	writer.write_bool(packed_filters != nullptr);
+	if (packed_filters) {
+		writer.write_u64(packed_filters->size());
+		for (auto &packed : *packed_filters) {
+			writer.write_packed(packed);
+		}
+	}
+	writer.write_bool(epilogue != nullptr);
+	if (epilogue) {
+		epilogue->save(writer);
+	}
+	return true;
+}
+
+std::shared_ptr<Op> ConvOp::load(PlanReader &reader) {
+	auto patch = PatchSpec::load(reader);
+	auto op = std::make_shared<ConvOp>(std::move(patch), reader.read_i64());
+	if (reader.read_bool()) {
+		std::vector<PackedMatrixF32> filters(reader.read_u64());
+		for (auto &packed : filters) {
+			packed = reader.read_packed_f32();
+		}
+		op->packed_filters = std::make_shared<const std::vector<PackedMatrixF32>>(std::move(filters));
+	}
+	if (reader.read_bool()) {
+		op->epilogue = std::make_shared<const ElementwiseChain>(ElementwiseChain::load(reader));
+	}
+	return op;
+}
+
+} // namespace duckdb_onnx
@@ -0,0 +1,230 @@
+#include "duckdb-onnx/core/ops/fused.h"
+
+#include "duckdb-onnx/core/ops/binary.h"
+#include "duckdb-onnx/core/ops/broadcast.h"
+#include "duckdb-onnx/core/ops/unary.h"
+#include "duckdb-onnx/core/plan_file.hpp"
+#include "duckdb-onnx/core/session.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+namespace duckdb_onnx {
+
+/// Floats processed by each step before the next one runs: small enough
+/// for the block to stay in L1 between steps
+static constexpr size_t CHAIN_BLOCK = 1024;
+
+bool ElementwiseChain::fusible(const Op &op, const Tensor *operand) {
+	if (dynamic_cast<const UnaryOp *>(&op)) {
+		return !operand;
+	}
+	if (auto clip = dynamic_cast<const ClipOp *>(&op)) {
+		return !operand && clip->min_input < 0 && clip->max_input < 0;
+	}
+	if (dynamic_cast<const BinaryOp *>(&op)) {
+		return operand && operand->len() == 1;
+	}
+	return false;
+}
+
+void ElementwiseChain::push(Step step) {
+	if (!step.op || !fusible(*step.op, step.operand.get())) {
+		throw std::invalid_argument("Op cannot join an element-wise chain");
+	}
+	Kernel kernel {};
+	kernel.f32 = true;
+	if (auto unary = dynamic_cast<const UnaryOp *>(step.op.get())) {
+		kernel.kind = StepKind::Unary;
+		kernel.unary = unary->kind;
+	} else if (auto clip = dynamic_cast<const ClipOp *>(step.op.get())) {
+		kernel.kind = StepKind::Clip;
+		kernel.lo = static_cast<float>(std::max<double>(clip->min, -std::numeric_limits<float>::infinity()));
+		kernel.hi = static_cast<float>(std::min<double>(clip->max, std::numeric_limits<float>::infinity()));
+	} else {
+		kernel.kind = StepKind::Binary;
+		kernel.binary = dynamic_cast<const BinaryOp &>(*step.op).kind;
+		kernel.f32 = step.operand->datum_type() == DatumType::F32;
+		kernel.scalar = kernel.f32 ? *step.operand->as_ptr<float>() : 0.0f;
+		kernel.scalar_first = step.operand_first;
+		operand_rank_ = std::max(operand_rank_, step.operand->rank());
+	}
+	kernels_.push_back(kernel);
+	steps_.push_back(std::move(step));
+}
+
+bool ElementwiseChain::runs_f32(const Tensor &input) const {
+	if (input.datum_type() != DatumType::F32 || input.rank() < operand_rank_) {
+		return false;
+	}
+	return std::all_of(kernels_.begin(), kernels_.end(), [](const Kernel &kernel) { return kernel.f32; });
+}
+
+void ElementwiseChain::apply_f32(size_t n, const float *x, float *y) const {
+	for (size_t begin = 0; begin < n; begin += CHAIN_BLOCK) {
+		auto len = std::min(CHAIN_BLOCK, n - begin);
+		const float *in = x + begin;
+		auto out = y + begin;
+		for (auto &kernel : kernels_) {
+			switch (kernel.kind) {
+			case StepKind::Unary:
+				unary_kernel_f32(kernel.unary)(len, in, out);
+				break;
+			case StepKind::Clip:
+				clip_kernel_f32()(len, in, kernel.lo, kernel.hi, out);
+				break;
+			case StepKind::Binary:
+				if (kernel.scalar_first) {
+					binary_kernel_f32(kernel.binary)(len, &kernel.scalar, 0, in, 1, out);
+				} else {
+					binary_kernel_f32(kernel.binary)(len, in, 1, &kernel.scalar, 0, out);
+				}
+				break;
+			}
+			// the following steps work in place on the block
+			in = out;
+		}
+	}
+}
+
+TValue ElementwiseChain::eval(TValue input) const {
+	for (auto &step : steps_) {
+		std::vector<TValue> inputs;
+		if (step.operand && step.operand_first) {
+			inputs.push_back(TValue::Const(step.operand));
+		}
+		inputs.push_back(std::move(input));
+		if (step.operand && !step.operand_first) {
+			inputs.push_back(TValue::Const(step.operand));
+		}
+		auto outputs = step.op->eval(inputs);
+		if (outputs.is_err()) {
+			throw std::runtime_error(outputs.error().what());
+		}
+		input = std::move(outputs.value_move()[0]);
+	}
+	return input;
+}
+
+TypedFact ElementwiseChain::output_fact(const TypedFact &input) const {
+	auto fact = input.without_value();
+	for (auto &step : steps_) {
+		if (step.operand && fact.rank_known) {
+			fact.shape = broadcast_dims(fact.shape, TypedFact::from_const(step.operand).shape);
+		}
+	}
+	return fact;
+}
+
+bool ElementwiseChain::operator==(const ElementwiseChain &other) const {
+	if (steps_.size() != other.steps_.size()) {
+		return false;
+	}
+	for (size_t i = 0; i < steps_.size(); i++) {
+		auto &a = steps_[i];
+		auto &b = other.steps_[i];
+		if (!a.op->same_as(b.op.get()) || a.operand != b.operand || a.operand_first != b.operand_first) {
+			return false;
+		}
+	}
+	return true;
+}
+
+uint64_t FusedElementwiseOp::flops(const std::vector<ShapeVec> &inputs, const std::vector<ShapeVec> &outputs) const {
+	return outputs.empty() ? 0 : chain.steps().size() * shape_volume(outputs[0]);
+}
+
+Validation FusedElementwiseOp::validation() const {
+	auto validation = Validation::Accurate;
+	for (auto &step : chain.steps()) {
+		validation = std::min(validation, step.op->validation());
+	}
+	return validation;
+}
+
+std::ostream &operator<<(std::ostream &os, const ElementwiseChain &chain) {
+	for (size_t i = 0; i < chain.steps_.size(); i++) {
+		os << (i ? ", " : "") << chain.steps_[i].op->name();
+	}
+	return os;
+}
+
+void FusedElementwiseOp::debug_print(std::ostream &os) const {
+	os << "FusedElementwise(" << chain << ")";
+}
+
+std::vector<TValue> FusedElementwiseOp::eval_impl(SessionState *session, std::vector<TValue> inputs) const {
+	if (inputs.size() != 1) {
+		throw std::runtime_error("FusedElementwise expects 1 input, got " + std::to_string(inputs.size()));
+	}
+	std::vector<TValue> outputs;
+	if (!chain.runs_f32(*inputs[0])) {
+		outputs.push_back(chain.eval(std::move(inputs[0])));
+		return outputs;
+	}
+	TValue result;
+	if (inputs[0].is_exclusive()) {
+		result = std::move(inputs[0]);
+	} else {
+		result = TValue::Var(output_tensor(session, 0, DatumType::F32, inputs[0]->shape()));
+	}
+	// after an in-place move the input is the result itself
+	const Tensor *input = inputs[0].tensor_ ? inputs[0].tensor_.get() : result.tensor_.get();
+	chain.apply_f32(input->len(), input->as_ptr<float>(), result.tensor_->as_ptr_mut<float>());
+	outputs.push_back(std::move(result));
+	return outputs;
+}
+
+TractResult<std::vector<TValue>> FusedElementwiseOp::eval(const std::vector<TValue> &inputs) const {
+	return try_catch([&]() { return eval_impl(nullptr, inputs); });
+}
+
+TractResult<std::vector<TValue>> FusedElementwiseOp::eval_with_session(SessionState &session,
+                                                                      std::vector<TValue> inputs) const {
+	return try_catch([&]() { return eval_impl(&session, std::move(inputs)); });
+}
+
+TractResult<std::vector<TypedFact>>
+FusedElementwiseOp::output_facts(const std::vector<const TypedFact *> &inputs) const {
+	return try_catch([&]() {
+		if (inputs.size() != 1) {
+			throw std::runtime_error("FusedElementwise expects 1 input, got " + std::to_string(inputs.size()));
+		}
+		return std::vector<TypedFact> {chain.output_fact(*inputs[0])};
+	});
+}
+
+void ElementwiseChain::save(PlanWriter &writer) const {
+	writer.write_u64(steps_.size());
+	for (auto &step : steps_) {
+		writer.write_op(*step.op);
+		writer.write_tensor(step.operand);
+		writer.write_bool(step.operand_first);
+	}
+}
+
+ElementwiseChain ElementwiseChain::load(PlanReader &reader) {
+	ElementwiseChain chain;
+	auto count = reader.read_u64();
+	for (uint64_t i = 0; i < count; i++) {
+		Step step;
+		step.op = reader.read_op();
+		step.operand = reader.read_tensor();
+		step.operand_first = reader.read_bool();
+		chain.push(std::move(step));
+	}
+	return chain;
+}
+
+bool FusedElementwiseOp::save(PlanWriter &writer) const {
+	writer.write_string("FusedElementwise");
+	chain.save(writer);
+	return true;
+}
+
+std::shared_ptr<Op> FusedElementwiseOp::load(PlanReader &reader) {
+	return std::make_shared<FusedElementwiseOp>(ElementwiseChain::load(reader));
+}
+
+} // namespace duckdb_onnx
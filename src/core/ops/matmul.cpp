@@ -0,0 +1,466 @@
+#include "duckdb-onnx/core/ops/matmul.h"
+
+#include "duckdb-onnx/core/ops/broadcast.h"
+#include "duckdb-onnx/core/plan_file.hpp"
+#include "duckdb-onnx/core/session.hpp"
+
+#include <sstream>
+#include <stdexcept>
+
+namespace duckdb_onnx {
+
+/// c = a * b for an m x k `a` and a k x n `b` whose element (i, j) is at
+/// i * row_stride + j * col_stride; `c` is row-major.
+template <typename T>
+static void matmul_naive(size_t m, size_t k, size_t n, const T *a, size_t a_row_stride, size_t a_col_stride,
+                         const T *b, size_t b_row_stride, size_t b_col_stride, T *c) {
+	for (size_t i = 0; i < m; i++) {
+		auto row = c + i * n;
+		std::fill(row, row + n, T(0));
+		for (size_t p = 0; p < k; p++) {
+			auto lhs = a[i * a_row_stride + p * a_col_stride];
+			for (size_t j = 0; j < n; j++) {
+				row[j] = static_cast<T>(row[j] + lhs * b[p * b_row_stride + j * b_col_stride]);
+			}
+		}
+	}
+}
+
+static void check_same_type(const std::string &op, const Tensor &a, const Tensor &b) {
+	if (a.datum_type() != b.datum_type()) {
+		throw std::runtime_error(op + " operands have different types: " + datum_type_name(a.datum_type()) + " and " +
+		                         datum_type_name(b.datum_type()));
+	}
+}
+
+/// The weights `b` of a product of `a` have its type, or are F16 or BF16
+/// weights of an F32 product, widened by the GEMM as it reads them
+static void check_weights_type(const std::string &op, const Tensor &a, const Tensor &b) {
+	if (a.datum_type() == DatumType::F32 && (b.datum_type() == DatumType::F16 || b.datum_type() == DatumType::BF16)) {
+		return;
+	}
+	check_same_type(op, a, b);
+}
+
+/// Apply the fused element-wise ops of `epilogue`, if any, to `result`
+static void apply_epilogue(const ElementwiseChain *epilogue, TValue &result) {
+	if (!epilogue) {
+		return;
+	}
+	if (epilogue->runs_f32(*result)) {
+		auto data = result.tensor_->as_ptr_mut<float>();
+		epilogue->apply_f32(result->len(), data, data);
+	} else {
+		result = epilogue->eval(std::move(result));
+	}
+}
+
+std::vector<TValue> MatMulOp::eval_impl(SessionState *session, std::vector<TValue> inputs) const {
+	if (inputs.size() != 2 && inputs.size() != 3) {
+		throw std::runtime_error("MatMul expects 2 or 3 inputs, got " + std::to_string(inputs.size()));
+	}
+	auto &a = *inputs[0];
+	auto &b = *inputs[1];
+	check_weights_type(name(), a, b);
+	if (a.rank() == 0 || b.rank() == 0) {
+		throw std::runtime_error("MatMul operands must have at least one dimension");
+	}
+	// 1-D operands are promoted to a row (left) or a column (right) vector
+	auto a_shape = a.shape();
+	auto b_shape = b.shape();
+	bool a_vector = a_shape.size() == 1;
+	bool b_vector = b_shape.size() == 1;
+	if (a_vector) {
+		a_shape.insert(a_shape.begin(), 1);
+	}
+	if (b_vector) {
+		b_shape.push_back(1);
+	}
+	auto m = static_cast<size_t>(a_shape[a_shape.size() - 2]);
+	auto k = static_cast<size_t>(a_shape.back());
+	auto n = static_cast<size_t>(b_shape.back());
+	if (static_cast<size_t>(b_shape[b_shape.size() - 2]) != k) {
+		std::ostringstream msg;
+		msg << "MatMul inner dimensions do not match: " << a.shape() << " and " << b.shape();
+		throw std::runtime_error(msg.str());
+	}
+	ShapeVec a_batch(a_shape.begin(), a_shape.end() - 2);
+	ShapeVec b_batch(b_shape.begin(), b_shape.end() - 2);
+	auto batch = broadcast_shapes(a_batch, b_batch);
+	auto shape = batch;
+	if (!a_vector) {
+		shape.push_back(static_cast<int64_t>(m));
+	}
+	if (!b_vector) {
+		shape.push_back(static_cast<int64_t>(n));
+	}
+	const Tensor *bias = inputs.size() == 3 ? inputs[2].tensor_.get() : nullptr;
+	if (bias) {
+		check_same_type(name(), a, *bias);
+		if (bias->rank() != 1 || static_cast<size_t>(bias->shape()[0]) != n || b_vector) {
+			std::ostringstream msg;
+			msg << "MatMul bias of shape " << bias->shape() << " does not match the output " << shape;
+			throw std::runtime_error(msg.str());
+		}
+	}
+	auto dt = a.datum_type();
+	TValue result = TValue::Var(output_tensor(session, 0, dt, shape));
+	auto out = result.tensor_.get();
+	auto rows = n ? out->len() / n : 0;
+	bool bias_added = false;
+	auto runner = session ? session->runner : nullptr;
+
+	if (dt == DatumType::F32) {
+		auto a_data = a.as_ptr<float>();
+		auto out_data = out->as_ptr_mut<float>();
+		if (b_batch.empty()) {
+			// a single right-hand side: the batch of A folds into the rows of one product
+			PackedMatrixF32 local;
+			auto packed = packed_b.get();
+			if (!packed) {
+				local.pack(k, n, b, 0, n, 1);
+				packed = &local;
+			}
+			// the output starts as the bias, which the product is then added to
+			if (bias) {
+				for (size_t i = 0; i < rows; i++) {
+					std::copy(bias->as_ptr<float>(), bias->as_ptr<float>() + n, out_data + i * n);
+				}
+				bias_added = true;
+			} else if (k == 0) {
+				std::fill(out_data, out_data + out->len(), 0.0f);
+			}
+			gemm_f32(rows, a_data, k, 1, *packed, out_data, n, 1.0f, bias_added, runner);
+		} else {
+			PackedMatrixF32 packed;
+			size_t packed_from = SIZE_MAX;
+			BinaryBroadcast(a_batch, b_batch, batch)
+			    .for_each_run([&](size_t out_offset, size_t a_offset, size_t a_step, size_t b_offset, size_t b_step,
+			                      size_t len) {
+				    for (size_t i = 0; i < len; i++) {
+					    auto rhs = (b_offset + i * b_step) * k * n;
+					    // consecutive products often share a broadcast right-hand side
+					    if (rhs != packed_from) {
+						    packed.pack(k, n, b, rhs, n, 1);
+						    packed_from = rhs;
+					    }
+					    gemm_f32(m, a_data + (a_offset + i * a_step) * m * k, k, 1, packed,
+					             out_data + (out_offset + i) * m * n, n, 1.0f, false, runner);
+				    }
+			    });
+		}
+	} else {
+		dispatch_numbers(dt, [&](auto tag) {
+			using T = typename decltype(tag)::type;
+			auto a_data = a.template as_ptr<T>();
+			auto b_data = b.template as_ptr<T>();
+			auto out_data = out->template as_ptr_mut<T>();
+			BinaryBroadcast(a_batch, b_batch, batch)
+			    .for_each_run([&](size_t out_offset, size_t a_offset, size_t a_step, size_t b_offset, size_t b_step,
+			                      size_t len) {
+				    for (size_t i = 0; i < len; i++) {
+					    matmul_naive<T>(m, k, n, a_data + (a_offset + i * a_step) * m * k, k, 1,
+					                    b_data + (b_offset + i * b_step) * k * n, n, 1,
+					                    out_data + (out_offset + i) * m * n);
+				    }
+			    });
+		});
+	}
+	if (bias && !bias_added) {
+		dispatch_numbers(dt, [&](auto tag) {
+			using T = typename decltype(tag)::type;
+			auto bias_data = bias->template as_ptr<T>();
+			auto out_data = out->template as_ptr_mut<T>();
+			for (size_t i = 0; i < rows; i++) {
+				for (size_t j = 0; j < n; j++) {
+					out_data[i * n + j] = static_cast<T>(out_data[i * n + j] + bias_data[j]);
+				}
+			}
+		});
+	}
+	apply_epilogue(epilogue.get(), result);
+	std::vector<TValue> outputs;
+	outputs.push_back(std::move(result));
+	return outputs;
+}
+
+TractResult<std::vector<TValue>> MatMulOp::eval(const std::vector<TValue> &inputs) const {
+	return try_catch([&]() { return eval_impl(nullptr, inputs); });
+}
+
+TractResult<std::vector<TValue>> MatMulOp::eval_with_session(SessionState &session, std::vector<TValue> inputs) const {
+	return try_catch([&]() { return eval_impl(&session, std::move(inputs)); });
+}
+
+/// Whether constant weights can be packed for the F32 GEMM
+static bool packable(const Tensor &b) {
+	return b.datum_type() == DatumType::F32 || b.datum_type() == DatumType::F16 || b.datum_type() == DatumType::BF16;
+}
+
+uint64_t MatMulOp::flops(const std::vector<ShapeVec> &inputs, const std::vector<ShapeVec> &outputs) const {
+	auto k = inputs.empty() || inputs[0].empty() ? 0 : inputs[0][inputs[0].size() - 1];
+	auto volume = outputs.empty() ? 0 : shape_volume(outputs[0]);
+	return 2 * volume * static_cast<uint64_t>(k) + (epilogue ? epilogue->steps().size() * volume : 0);
+}
+
+std::shared_ptr<Op> MatMulOp::codegen(const std::vector<std::shared_ptr<Tensor>> &constants) const {
+	if (packed_b || constants.size() < 2 || !constants[1]) {
+		return nullptr;
+	}
+	auto &b = *constants[1];
+	if (!packable(b) || b.rank() != 2) {
+		return nullptr;
+	}
+	auto k = static_cast<size_t>(b.shape()[0]);
+	auto n = static_cast<size_t>(b.shape()[1]);
+	auto packed = std::make_shared<PackedMatrixF32>();
+	packed->pack(k, n, b, 0, n, 1);
+	auto op = std::make_shared<MatMulOp>(*this);
+	op->packed_b = std::move(packed);
+	return op;
+}
+
+std::vector<TValue> GemmOp::eval_impl(SessionState *session, std::vector<TValue> inputs) const {
+	if (inputs.size() != 2 && inputs.size() != 3) {
+		throw std::runtime_error("Gemm expects 2 or 3 inputs, got " + std::to_string(inputs.size()));
+	}
+	auto &a = *inputs[0];
+	auto &b = *inputs[1];
+	check_weights_type(name(), a, b);
+	if (a.rank() != 2 || b.rank() != 2) {
+		std::ostringstream msg;
+		msg << "Gemm expects 2-D A and B, got " << a.shape() << " and " << b.shape();
+		throw std::runtime_error(msg.str());
+	}
+	auto m = static_cast<size_t>(a.shape()[trans_a ? 1 : 0]);
+	auto k = static_cast<size_t>(a.shape()[trans_a ? 0 : 1]);
+	auto n = static_cast<size_t>(b.shape()[trans_b ? 0 : 1]);
+	if (static_cast<size_t>(b.shape()[trans_b ? 1 : 0]) != k) {
+		std::ostringstream msg;
+		msg << "Gemm inner dimensions do not match: " << a.shape() << (trans_a ? "'" : "") << " and " << b.shape()
+		    << (trans_b ? "'" : "");
+		throw std::runtime_error(msg.str());
+	}
+	// element (i, p) of A' and (p, j) of B'
+	auto a_row_stride = trans_a ? 1 : k;
+	auto a_col_stride = trans_a ? m : 1;
+	auto b_row_stride = trans_b ? 1 : n;
+	auto b_col_stride = trans_b ? k : 1;
+
+	auto dt = a.datum_type();
+	TValue result = TValue::Var(output_tensor(session, 0, dt, ShapeVec {int64_t(m), int64_t(n)}));
+	auto out = result.tensor_.get();
+
+	// the output starts as beta * C, which the product is then added to
+	const Tensor *c = inputs.size() == 3 && beta != 0 ? inputs[2].tensor_.get() : nullptr;
+	size_t c_rows = 1;
+	size_t c_cols = 1;
+	if (c) {
+		check_same_type(name(), a, *c);
+		auto &c_shape = c->shape();
+		c_rows = c_shape.size() == 2 ? static_cast<size_t>(c_shape[0]) : 1;
+		c_cols = c_shape.empty() ? 1 : static_cast<size_t>(c_shape.back());
+		if (c_shape.size() > 2 || (c_rows != 1 && c_rows != m) || (c_cols != 1 && c_cols != n)) {
+			std::ostringstream msg;
+			msg << "Gemm C of shape " << c_shape << " does not broadcast to [" << m << "," << n << "]";
+			throw std::runtime_error(msg.str());
+		}
+	}
+
+	dispatch_numbers(dt, [&](auto tag) {
+		using T = typename decltype(tag)::type;
+		auto out_data = out->template as_ptr_mut<T>();
+		if (c) {
+			auto c_data = c->template as_ptr<T>();
+			for (size_t i = 0; i < m; i++) {
+				for (size_t j = 0; j < n; j++) {
+					out_data[i * n + j] =
+					    static_cast<T>(beta * c_data[(c_rows == 1 ? 0 : i) * c_cols + (c_cols == 1 ? 0 : j)]);
+				}
+			}
+		}
+	});
+
+	if (dt == DatumType::F32) {
+		PackedMatrixF32 local;
+		auto packed = packed_b.get();
+		if (!packed) {
+			local.pack(k, n, b, 0, b_row_stride, b_col_stride);
+			packed = &local;
+		}
+		gemm_f32(m, a.as_ptr<float>(), a_row_stride, a_col_stride, *packed, out->as_ptr_mut<float>(), n, alpha,
+		         c != nullptr, session ? session->runner : nullptr);
+	} else {
+		dispatch_numbers(dt, [&](auto tag) {
+			using T = typename decltype(tag)::type;
+			std::vector<T> product(m * n);
+			matmul_naive<T>(m, k, n, a.template as_ptr<T>(), a_row_stride, a_col_stride, b.template as_ptr<T>(),
+			                b_row_stride, b_col_stride, product.data());
+			auto out_data = out->template as_ptr_mut<T>();
+			for (size_t i = 0; i < m * n; i++) {
+				out_data[i] = static_cast<T>(alpha * product[i] + (c ? out_data[i] : T(0)));
+			}
+		});
+	}
+	apply_epilogue(epilogue.get(), result);
+	std::vector<TValue> outputs;
+	outputs.push_back(std::move(result));
+	return outputs;
+}
+
+TractResult<std::vector<TValue>> GemmOp::eval(const std::vector<TValue> &inputs) const {
+	return try_catch([&]() { return eval_impl(nullptr, inputs); });
+}
+
+TractResult<std::vector<TValue>> GemmOp::eval_with_session(SessionState &session, std::vector<TValue> inputs) const {
+	return try_catch([&]() { return eval_impl(&session, std::move(inputs)); });
+}
+
+uint64_t GemmOp::flops(const std::vector<ShapeVec> &inputs, const std::vector<ShapeVec> &outputs) const {
+	auto k = inputs.empty() || inputs[0].size() != 2 ? 0 : inputs[0][trans_a ? 0 : 1];
+	auto volume = outputs.empty() ? 0 : shape_volume(outputs[0]);
+	return 2 * volume * static_cast<uint64_t>(k) + (epilogue ? epilogue->steps().size() * volume : 0);
+}
+
+std::shared_ptr<Op> GemmOp::codegen(const std::vector<std::shared_ptr<Tensor>> &constants) const {
+	if (packed_b || constants.size() < 2 || !constants[1]) {
+		return nullptr;
+	}
+	auto &b = *constants[1];
+	if (!packable(b) || b.rank() != 2) {
+		return nullptr;
+	}
+	auto k = static_cast<size_t>(b.shape()[trans_b ? 1 : 0]);
+	auto n = static_cast<size_t>(b.shape()[trans_b ? 0 : 1]);
+	auto packed = std::make_shared<PackedMatrixF32>();
+	packed->pack(k, n, b, 0, trans_b ? 1 : n, trans_b ? k : 1);
+	auto op = std::make_shared<GemmOp>(*this);
+	op->packed_b = std::move(packed);
+	return op;
+}
+
+TractResult<std::vector<TypedFact>> MatMulOp::output_facts(const std::vector<const TypedFact *> &inputs) const {
+	return try_catch([&]() {
+		if (inputs.size() != 2 && inputs.size() != 3) {
+			throw std::runtime_error("MatMul expects 2 or 3 inputs, got " + std::to_string(inputs.size()));
+		}
+		auto &a = *inputs[0];
+		auto &b = *inputs[1];
+		auto fact = TypedFact::unknown(a.datum_type);
+		if (a.rank_known && b.rank_known) {
+			if (a.shape.empty() || b.shape.empty()) {
+				throw std::runtime_error("MatMul operands must have at least one dimension");
+			}
+			auto a_shape = a.shape;
+			auto b_shape = b.shape;
+			bool a_vector = a_shape.size() == 1;
+			bool b_vector = b_shape.size() == 1;
+			if (a_vector) {
+				a_shape.insert(a_shape.begin(), TDim(1));
+			}
+			if (b_vector) {
+				b_shape.push_back(TDim(1));
+			}
+			auto &k = a_shape.back();
+			auto &b_k = b_shape[b_shape.size() - 2];
+			if (k.is_int() && b_k.is_int() && k != b_k) {
+				std::ostringstream msg;
+				msg << "MatMul inner dimensions do not match: " << k << " and " << b_k;
+				throw std::runtime_error(msg.str());
+			}
+			auto shape = broadcast_dims(std::vector<TDim>(a_shape.begin(), a_shape.end() - 2),
+			                            std::vector<TDim>(b_shape.begin(), b_shape.end() - 2));
+			if (!a_vector) {
+				shape.push_back(a_shape[a_shape.size() - 2]);
+			}
+			if (!b_vector) {
+				shape.push_back(b_shape.back());
+			}
+			fact = TypedFact(a.datum_type, std::move(shape));
+		}
+		return std::vector<TypedFact> {epilogue ? epilogue->output_fact(fact) : fact};
+	});
+}
+
+TractResult<std::vector<TypedFact>> GemmOp::output_facts(const std::vector<const TypedFact *> &inputs) const {
+	return try_catch([&]() {
+		if (inputs.size() != 2 && inputs.size() != 3) {
+			throw std::runtime_error("Gemm expects 2 or 3 inputs, got " + std::to_string(inputs.size()));
+		}
+		auto &a = *inputs[0];
+		auto &b = *inputs[1];
+		auto fact = TypedFact::unknown(a.datum_type);
+		if (a.rank_known && b.rank_known) {
+			if (a.shape.size() != 2 || b.shape.size() != 2) {
+				throw std::runtime_error("Gemm expects 2-D A and B");
+			}
+			auto &k = a.shape[trans_a ? 0 : 1];
+			auto &b_k = b.shape[trans_b ? 1 : 0];
+			if (k.is_int() && b_k.is_int() && k != b_k) {
+				std::ostringstream msg;
+				msg << "Gemm inner dimensions do not match: " << k << " and " << b_k;
+				throw std::runtime_error(msg.str());
+			}
+			fact = TypedFact(a.datum_type, std::vector<TDim> {a.shape[trans_a ? 1 : 0], b.shape[trans_b ? 0 : 1]});
+		}
+		return std::vector<TypedFact> {epilogue ? epilogue->output_fact(fact) : fact};
+	});
+}
+
+bool MatMulOp::save(PlanWriter &writer) const {
+	writer.write_string("MatMul");
+	writer.write_bool(packed_b != nullptr);
+	if (packed_b) {
+		writer.write_packed(*packed_b);
+	}
+	writer.write_bool(epilogue != nullptr);
+	if (epilogue) {
+		epilogue->save(writer);
+	}
+	return true;
+}
+
+std::shared_ptr<Op> MatMulOp::load(PlanReader &reader) {
+	auto op = std::make_shared<MatMulOp>();
+	if (reader.read_bool()) {
+		op->packed_b = std::make_shared<const PackedMatrixF32>(reader.read_packed_f32());
+	}
+	if (reader.read_bool()) {
+		op->epilogue = std::make_shared<const ElementwiseChain>(ElementwiseChain::load(reader));
+	}
+	return op;
+}
+
+bool GemmOp::save(PlanWriter &writer) const {
+	writer.write_string("Gemm");
+	writer.write_f32(alpha);
+	writer.write_f32(beta);
+	writer.write_bool(trans_a);
+	writer.write_bool(trans_b);
+	writer.write_bool(packed_b != nullptr);
+	if (packed_b) {
+		writer.write_packed(*packed_b);
+	}
+	writer.write_bool(epilogue != nullptr);
+	if (epilogue) {
+		epilogue->save(writer);
+	}
+	return true;
+}
+
+std::shared_ptr<Op> GemmOp::load(PlanReader &reader) {
+	auto alpha = reader.read_f32();
+	auto beta = reader.read_f32();
+	auto trans_a = reader.read_bool();
+	auto trans_b = reader.read_bool();
+	auto op = std::make_shared<GemmOp>(alpha, beta, trans_a, trans_b);
+	if (reader.read_bool()) {
+		op->packed_b = std::make_shared<const PackedMatrixF32>(reader.read_packed_f32());
+	}
+	if (reader.read_bool()) {
+		op->epilogue = std::make_shared<const ElementwiseChain>(ElementwiseChain::load(reader));
+	}
+	return op;
+}
+
+} // namespace duckdb_onnx
@@ -1,7 +1,28 @@
 #include "duckdb-onnx/core/ops/ops.h"
 
-
 namespace duckdb_onnx {
 
+TractResult<std::vector<TypedFact>> same_as_input_facts(const Op &op, const std::vector<const TypedFact *> &inputs) {
+	if (inputs.empty()) {
+		return Err<std::vector<TypedFact>>(op.name() + " expects an input");
+	}
+	return Ok(std::vector<TypedFact> {inputs[0]->without_value()});
+}
+
+uint64_t shape_volume(const ShapeVec &shape) {
+	uint64_t volume = 1;
+	for (auto dim : shape) {
+		volume *= static_cast<uint64_t>(dim < 0 ? 0 : dim);
+	}
+	return volume;
+}
+
+uint64_t Op::flops(const std::vector<ShapeVec> &inputs, const std::vector<ShapeVec> &outputs) const {
+	uint64_t flops = 0;
+	for (auto &shape : outputs) {
+		flops += shape_volume(shape);
+	}
+	return flops;
+}
 
-}
\ No newline at end of file
+} // namespace duckdb_onnx
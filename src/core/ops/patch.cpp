@@ -0,0 +1,137 @@
+#include "duckdb-onnx/core/ops/patch.h"
+
+#include "duckdb-onnx/core/plan_file.hpp"
+
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+namespace duckdb_onnx {
+
+PatchGeometry PatchSpec::geometry(const ShapeVec &input, const ShapeVec &kernel) const {
+	auto rank = input.size();
+	if (rank != kernel.size() || rank < 1 || rank > 2) {
+		std::ostringstream msg;
+		msg << "Only 1-D and 2-D windows are supported, got input " << input << " and kernel " << kernel;
+		throw std::runtime_error(msg.str());
+	}
+	auto check_len = [&](const ShapeVec &values, size_t expected, const char *name) {
+		if (!values.empty() && values.size() != expected) {
+			std::ostringstream msg;
+			msg << "Expected " << expected << " " << name << ", got " << values;
+			throw std::runtime_error(msg.str());
+		}
+	};
+	check_len(strides, rank, "strides");
+	check_len(dilations, rank, "dilations");
+	check_len(pads, 2 * rank, "pads");
+
+	PatchGeometry geo;
+	// a 1-D window is a 2-D one of height 1
+	auto offset = 2 - rank;
+	for (size_t axis = 0; axis < 2; axis++) {
+		geo.input[axis] = 1;
+		geo.kernel[axis] = 1;
+		geo.strides[axis] = 1;
+		geo.dilations[axis] = 1;
+		geo.pad_begin[axis] = 0;
+		geo.pad_end[axis] = 0;
+		if (axis < offset) {
+			geo.output[axis] = 1;
+			continue;
+		}
+		auto i = axis - offset;
+		auto in = geo.input[axis] = input[i];
+		geo.kernel[axis] = kernel[i];
+		auto stride = geo.strides[axis] = strides.empty() ? 1 : strides[i];
+		geo.dilations[axis] = dilations.empty() ? 1 : dilations[i];
+		if (stride <= 0 || geo.dilations[axis] <= 0 || geo.kernel[axis] <= 0) {
+			throw std::runtime_error("Window kernel, strides and dilations must be positive");
+		}
+		auto extent = (geo.kernel[axis] - 1) * geo.dilations[axis] + 1;
+
+		int64_t out = 0;
+		switch (padding) {
+		case PaddingMode::Explicit: {
+			auto begin = pads.empty() ? 0 : pads[i];
+			auto end = pads.empty() ? 0 : pads[i + rank];
+			auto span = in + begin + end - extent;
+			if (span < 0) {
+				out = 0;
+				break;
+			}
+			out = (ceil_mode ? (span + stride - 1) / stride : span / stride) + 1;
+			// with ceil_mode, the last window must start inside the input or its leading padding
+			if (ceil_mode && (out - 1) * stride >= in + begin) {
+				out--;
+			}
+			geo.pad_begin[axis] = begin;
+			geo.pad_end[axis] = end;
+			break;
+		}
+		case PaddingMode::Valid:
+			out = in < extent ? 0 : (in - extent) / stride + 1;
+			break;
+		case PaddingMode::SameUpper:
+		case PaddingMode::SameLower: {
+			out = (in + stride - 1) / stride;
+			auto total = std::max<int64_t>(0, (out - 1) * stride + extent - in);
+			auto small = total / 2;
+			geo.pad_begin[axis] = padding == PaddingMode::SameUpper ? small : total - small;
+			geo.pad_end[axis] = total - geo.pad_begin[axis];
+			break;
+		}
+		}
+		if (out <= 0) {
+			std::ostringstream msg;
+			msg << "Window " << kernel << " does not fit in input " << input;
+			throw std::runtime_error(msg.str());
+		}
+		geo.output[axis] = out;
+	}
+	return geo;
+}
+
+std::vector<TDim> PatchSpec::output_shape(const std::vector<TDim> &input, const TDim &channels,
+                                          const std::vector<TDim> &kernel) const {
+	if (input.size() < 3 || input.size() > 4 || kernel.size() != input.size() - 2) {
+		throw std::runtime_error("Only 1-D and 2-D windows are supported, got an input of rank " +
+		                         std::to_string(input.size()));
+	}
+	std::vector<TDim> output {input[0], channels};
+	ShapeVec spatial;
+	ShapeVec window;
+	for (size_t i = 0; i < kernel.size(); i++) {
+		if (!input[i + 2].is_int() || !kernel[i].is_int()) {
+			output.resize(input.size(), TDim());
+			return output;
+		}
+		spatial.push_back(input[i + 2].as_int());
+		window.push_back(kernel[i].as_int());
+	}
+	auto geo = geometry(spatial, window);
+	for (size_t axis = 2 - kernel.size(); axis < 2; axis++) {
+		output.emplace_back(geo.output[axis]);
+	}
+	return output;
+}
+
+void PatchSpec::save(PlanWriter &writer) const {
+	writer.write_shape(strides);
+	writer.write_shape(dilations);
+	writer.write_shape(pads);
+	writer.write_u64(static_cast<uint64_t>(padding));
+	writer.write_bool(ceil_mode);
+}
+
+PatchSpec PatchSpec::load(PlanReader &reader) {
+	PatchSpec patch;
+	patch.strides = reader.read_shape();
+	patch.dilations = reader.read_shape();
+	patch.pads = reader.read_shape();
+	patch.padding = static_cast<PaddingMode>(reader.read_u64());
+	patch.ceil_mode = reader.read_bool();
+	return patch;
+}
+
+} // namespace duckdb_onnx
@@ -0,0 +1,254 @@
+#include "duckdb-onnx/core/ops/pool.h"
+
+#include "duckdb-onnx/core/kernels/element_wise.hpp"
+#include "duckdb-onnx/core/plan_file.hpp"
+#include "duckdb-onnx/core/session.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
+namespace duckdb_onnx {
+
+static int64_t div_floor(int64_t a, int64_t b) {
+	return a >= 0 ? a / b : -((-a + b - 1) / b);
+}
+
+static int64_t div_ceil(int64_t a, int64_t b) {
+	return -div_floor(-a, b);
+}
+
+/// Range [begin, end) of the outputs along `axis` whose kernel offset `k`
+/// reads inside the image
+static std::pair<int64_t, int64_t> inner_outputs(const PatchGeometry &geo, size_t axis, int64_t k) {
+	auto shift = geo.pad_begin[axis] - k * geo.dilations[axis];
+	auto begin = std::max<int64_t>(div_ceil(shift, geo.strides[axis]), 0);
+	auto end = std::min<int64_t>(div_floor(geo.input[axis] - 1 + shift, geo.strides[axis]) + 1, geo.output[axis]);
+	return {begin, std::max(begin, end)};
+}
+
+/// Pixels averaged by every output along `axis`
+static std::vector<float> window_counts(const PatchGeometry &geo, size_t axis, bool count_include_pad) {
+	std::vector<float> counts(static_cast<size_t>(geo.output[axis]), 0.0f);
+	auto lo = count_include_pad ? -geo.pad_begin[axis] : 0;
+	auto hi = geo.input[axis] + (count_include_pad ? geo.pad_end[axis] : 0);
+	for (int64_t o = 0; o < geo.output[axis]; o++) {
+		for (int64_t k = 0; k < geo.kernel[axis]; k++) {
+			auto i = geo.input_index(axis, o, k);
+			counts[o] += i >= lo && i < hi ? 1.0f : 0.0f;
+		}
+	}
+	return counts;
+}
+
+static void check_image(const std::string &op, const Tensor &x) {
+	if (x.datum_type() != DatumType::F32) {
+		throw std::runtime_error(op + " only supports F32, got " + datum_type_name(x.datum_type()));
+	}
+	if (x.rank() != 3 && x.rank() != 4) {
+		std::ostringstream msg;
+		msg << op << " only supports 1-D and 2-D images, got " << x.shape();
+		throw std::runtime_error(msg.str());
+	}
+}
+
+std::vector<TValue> PoolOp::eval_impl(SessionState *session, std::vector<TValue> inputs) const {
+	if (inputs.size() != 1) {
+		throw std::runtime_error(name() + " expects 1 input, got " + std::to_string(inputs.size()));
+	}
+	auto &x = *inputs[0];
+	check_image(name(), x);
+	ShapeVec spatial(x.shape().begin() + 2, x.shape().end());
+	auto geo = patch.geometry(spatial, kernel);
+	ShapeVec shape {x.shape()[0], x.shape()[1]};
+	if (x.rank() == 4) {
+		shape.push_back(geo.output[0]);
+	}
+	shape.push_back(geo.output[1]);
+	TValue result = TValue::Var(output_tensor(session, 0, DatumType::F32, shape));
+	auto out = result.tensor_->as_ptr_mut<float>();
+
+	auto ih = static_cast<size_t>(geo.input[0]);
+	auto iw = static_cast<size_t>(geo.input[1]);
+	auto oh = static_cast<size_t>(geo.output[0]);
+	auto ow = static_cast<size_t>(geo.output[1]);
+	bool max = kind == PoolKind::Max;
+	auto reduce = binary_kernel_f32(max ? BinaryKind::Max : BinaryKind::Add);
+	auto scale = binary_kernel_f32(BinaryKind::Mul);
+	auto identity = max ? -std::numeric_limits<float>::infinity() : 0.0f;
+	std::vector<float> inverse_counts_h;
+	std::vector<float> inverse_counts_w;
+	if (!max) {
+		inverse_counts_h = window_counts(geo, 0, count_include_pad);
+		inverse_counts_w = window_counts(geo, 1, count_include_pad);
+		for (auto *counts : {&inverse_counts_h, &inverse_counts_w}) {
+			for (auto &count : *counts) {
+				count = 1.0f / count;
+			}
+		}
+	}
+	std::vector<std::pair<int64_t, int64_t>> columns;
+	for (int64_t k = 0; k < geo.kernel[1]; k++) {
+		columns.push_back(inner_outputs(geo, 1, k));
+	}
+
+	// every input row reduced along the width
+	std::vector<float> rows(ih * ow);
+	auto planes = static_cast<size_t>(x.shape()[0] * x.shape()[1]);
+	for (size_t plane = 0; plane < planes; plane++) {
+		auto image = x.as_ptr<float>() + plane * ih * iw;
+		for (size_t y = 0; y < ih; y++) {
+			auto row = rows.data() + y * ow;
+			std::fill(row, row + ow, identity);
+			for (int64_t k = 0; k < geo.kernel[1]; k++) {
+				auto begin = columns[k].first;
+				auto end = columns[k].second;
+				if (begin == end) {
+					continue;
+				}
+				auto src = image + y * iw + geo.input_index(1, begin, k);
+				auto len = static_cast<size_t>(end - begin);
+				if (geo.strides[1] == 1) {
+					reduce(len, row + begin, 1, src, 1, row + begin);
+				} else {
+					auto stride = static_cast<size_t>(geo.strides[1]);
+					for (size_t i = 0; i < len; i++) {
+						auto &acc = row[begin + i];
+						auto v = src[i * stride];
+						acc = max ? (acc > v ? acc : v) : acc + v;
+					}
+				}
+			}
+		}
+		auto dst = out + plane * oh * ow;
+		for (size_t oy = 0; oy < oh; oy++) {
+			auto row = dst + oy * ow;
+			std::fill(row, row + ow, identity);
+			for (int64_t k = 0; k < geo.kernel[0]; k++) {
+				auto y = geo.input_index(0, static_cast<int64_t>(oy), k);
+				if (y >= 0 && y < geo.input[0]) {
+					reduce(ow, row, 1, rows.data() + y * ow, 1, row);
+				}
+			}
+			if (!max) {
+				scale(ow, row, 1, inverse_counts_w.data(), 1, row);
+				scale(ow, row, 1, inverse_counts_h.data() + oy, 0, row);
+			}
+		}
+	}
+	std::vector<TValue> outputs;
+	outputs.push_back(std::move(result));
+	return outputs;
+}
+
+TractResult<std::vector<TValue>> PoolOp::eval(const std::vector<TValue> &inputs) const {
+	return try_catch([&]() { return eval_impl(nullptr, inputs); });
+}
+
+TractResult<std::vector<TValue>> PoolOp::eval_with_session(SessionState &session, std::vector<TValue> inputs) const {
+	return try_catch([&]() { return eval_impl(&session, std::move(inputs)); });
+}
+
+std::vector<TValue> GlobalPoolOp::eval_impl(SessionState *session, std::vector<TValue> inputs) const {
+	if (inputs.size() != 1) {
+		throw std::runtime_error(name() + " expects 1 input, got " + std::to_string(inputs.size()));
+	}
+	auto &x = *inputs[0];
+	if (x.datum_type() != DatumType::F32 || x.rank() < 3) {
+		std::ostringstream msg;
+		msg << name() << " expects an F32 image, got " << datum_type_name(x.datum_type()) << " " << x.shape();
+		throw std::runtime_error(msg.str());
+	}
+	ShapeVec shape(x.shape().begin(), x.shape().begin() + 2);
+	for (size_t i = 2; i < x.rank(); i++) {
+		shape.push_back(1);
+	}
+	TValue result = TValue::Var(output_tensor(session, 0, DatumType::F32, shape));
+	auto out = result.tensor_->as_ptr_mut<float>();
+	auto planes = static_cast<size_t>(x.shape()[0] * x.shape()[1]);
+	auto len = planes ? x.len() / planes : 0;
+	for (size_t plane = 0; plane < planes; plane++) {
+		auto src = x.as_ptr<float>() + plane * len;
+		if (kind == PoolKind::Max) {
+			auto acc = -std::numeric_limits<float>::infinity();
+			for (size_t i = 0; i < len; i++) {
+				acc = acc > src[i] ? acc : src[i];
+			}
+			out[plane] = acc;
+		} else {
+			double acc = 0;
+			for (size_t i = 0; i < len; i++) {
+				acc += src[i];
+			}
+			out[plane] = static_cast<float>(acc / static_cast<double>(len));
+		}
+	}
+	std::vector<TValue> outputs;
+	outputs.push_back(std::move(result));
+	return outputs;
+}
+
+TractResult<std::vector<TValue>> GlobalPoolOp::eval(const std::vector<TValue> &inputs) const {
+	return try_catch([&]() { return eval_impl(nullptr, inputs); });
+}
+
+TractResult<std::vector<TValue>> GlobalPoolOp::eval_with_session(SessionState &session,
+                                                                 std::vector<TValue> inputs) const {
+	return try_catch([&]() { return eval_impl(&session, std::move(inputs)); });
+}
+
+TractResult<std::vector<TypedFact>> PoolOp::output_facts(const std::vector<const TypedFact *> &inputs) const {
+	return try_catch([&]() {
+		if (inputs.size() != 1) {
+			throw std::runtime_error(name() + " expects 1 input, got " + std::to_string(inputs.size()));
+		}
+		auto &x = *inputs[0];
+		if (!x.rank_known) {
+			return std::vector<TypedFact> {TypedFact::unknown(DatumType::F32)};
+		}
+		std::vector<TDim> window(kernel.begin(), kernel.end());
+		return std::vector<TypedFact> {TypedFact(DatumType::F32, patch.output_shape(x.shape, x.shape[1], window))};
+	});
+}
+
+TractResult<std::vector<TypedFact>> GlobalPoolOp::output_facts(const std::vector<const TypedFact *> &inputs) const {
+	return try_catch([&]() {
+		if (inputs.size() != 1) {
+			throw std::runtime_error(name() + " expects 1 input, got " + std::to_string(inputs.size()));
+		}
+		auto fact = inputs[0]->without_value();
+		for (size_t i = 2; i < fact.shape.size(); i++) {
+			fact.shape[i] = 1;
+		}
+		return std::vector<TypedFact> {fact};
+	});
+}
+
+bool PoolOp::save(PlanWriter &writer) const {
+	writer.write_string("Pool");
+	writer.write_u64(static_cast<uint64_t>(kind));
+	writer.write_shape(kernel);
+	patch.save(writer);
+	writer.write_bool(count_include_pad);
+	return true;
+}
+
+std::shared_ptr<Op> PoolOp::load(PlanReader &reader) {
+	auto kind = static_cast<PoolKind>(reader.read_u64());
+	auto kernel = reader.read_shape();
+	auto patch = PatchSpec::load(reader);
+	return std::make_shared<PoolOp>(kind, std::move(kernel), std::move(patch), reader.read_bool());
+}
+
+bool GlobalPoolOp::save(PlanWriter &writer) const {
+	writer.write_string("GlobalPool");
+	writer.write_u64(static_cast<uint64_t>(kind));
+	return true;
+}
+
+std::shared_ptr<Op> GlobalPoolOp::load(PlanReader &reader) {
+	return std::make_shared<GlobalPoolOp>(static_cast<PoolKind>(reader.read_u64()));
+}
+
+} // namespace duckdb_onnx
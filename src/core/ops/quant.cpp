@@ -0,0 +1,770 @@
+#include "duckdb-onnx/core/ops/quant.h"
+
+#include "duckdb-onnx/core/ops/broadcast.h"
+#include "duckdb-onnx/core/ops/matmul.h"
+#include "duckdb-onnx/core/plan_file.hpp"
+#include "duckdb-onnx/core/session.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
+namespace duckdb_onnx {
+
+/// Fewest patch values worth gathering in a task of their own
+static constexpr size_t PATCH_MIN_TASK_WORK = 1 << 16;
+/// Fewest multiply-adds worth a task of their own
+static constexpr size_t CONV_MIN_TASK_WORK = 1 << 20;
+
+/// Call `f(TypeTag<T>())` with uint8_t or int8_t, the types of quantized tensors
+template <typename F>
+static void dispatch_8bit(const std::string &op, DatumType dt, F &&f) {
+	if (dt == DatumType::U8) {
+		f(TypeTag<uint8_t>());
+	} else if (dt == DatumType::I8) {
+		f(TypeTag<int8_t>());
+	} else {
+		throw std::runtime_error(op + " expects UINT8 or INT8 tensors, got " + datum_type_name(dt));
+	}
+}
+
+/// `value` rounded half to even, then clamped to the range of T
+template <typename T>
+static T saturate(float value) {
+	value = std::nearbyint(value);
+	if (!(value > static_cast<float>(std::numeric_limits<T>::lowest()))) {
+		return std::numeric_limits<T>::lowest();
+	}
+	if (value >= static_cast<float>(std::numeric_limits<T>::max())) {
+		return std::numeric_limits<T>::max();
+	}
+	return static_cast<T>(value);
+}
+
+/// The elements of an F32 scale input, of which there must be one or `count`
+static std::vector<float> scale_values(const std::string &op, const char *what, const Tensor &scale, size_t count) {
+	if (scale.datum_type() != DatumType::F32 || scale.rank() > 1 || (scale.len() != 1 && scale.len() != count)) {
+		std::ostringstream msg;
+		msg << op << " " << what << " must be an F32 scalar or have " << count << " elements, got "
+		    << datum_type_name(scale.datum_type()) << " of shape " << scale.shape();
+		throw std::runtime_error(msg.str());
+	}
+	auto data = scale.as_ptr<float>();
+	return std::vector<float>(data, data + scale.len());
+}
+
+/// The elements of an integer zero point input, of which there must be one
+/// or `count`, and a single zero when the input is omitted
+static std::vector<int32_t> zero_point_values(const std::string &op, const char *what, const Tensor *zero_point,
+                                              size_t count) {
+	if (!zero_point) {
+		return {0};
+	}
+	auto dt = zero_point->datum_type();
+	if ((dt != DatumType::U8 && dt != DatumType::I8 && dt != DatumType::I32) || zero_point->rank() > 1 ||
+	    (zero_point->len() != 1 && zero_point->len() != count)) {
+		std::ostringstream msg;
+		msg << op << " " << what << " must be an integer scalar or have " << count << " elements, got "
+		    << datum_type_name(dt) << " of shape " << zero_point->shape();
+		throw std::runtime_error(msg.str());
+	}
+	std::vector<int32_t> values(zero_point->len());
+	dispatch_numbers(dt, [&](auto tag) {
+		using T = typename decltype(tag)::type;
+		auto data = zero_point->template as_ptr<T>();
+		for (size_t i = 0; i < values.size(); i++) {
+			values[i] = static_cast<int32_t>(data[i]);
+		}
+	});
+	return values;
+}
+
+/// Scales and zero points of a tensor of shape `shape`, each one value or one
+/// per index along `axis`, with the layout of the elements sharing them: the
+/// element at flat index (o * dim + c) * inner + i has the parameters of c.
+struct LinearQuantization {
+	std::vector<float> scales;
+	std::vector<int32_t> zero_points;
+	size_t dim = 1;
+	size_t inner = 1;
+
+	LinearQuantization(const std::string &op, const ShapeVec &shape, int64_t axis, const Tensor &scale,
+	                   const Tensor *zero_point) {
+		if (scale.len() > 1 || (zero_point && zero_point->len() > 1)) {
+			auto rank = static_cast<int64_t>(shape.size());
+			if (axis < -rank || axis >= rank) {
+				throw std::runtime_error(op + " axis " + std::to_string(axis) + " is out of range for rank " +
+				                         std::to_string(rank));
+			}
+			axis = axis < 0 ? axis + rank : axis;
+			dim = static_cast<size_t>(shape[static_cast<size_t>(axis)]);
+			for (auto d = static_cast<size_t>(axis) + 1; d < shape.size(); d++) {
+				inner *= static_cast<size_t>(shape[d]);
+			}
+		}
+		scales = scale_values(op, "scale", scale, dim);
+		zero_points = zero_point_values(op, "zero point", zero_point, dim);
+	}
+
+	float scale(size_t c) const {
+		return scales[scales.size() == 1 ? 0 : c];
+	}
+	int32_t zero_point(size_t c) const {
+		return zero_points[zero_points.size() == 1 ? 0 : c];
+	}
+
+	/// Call `f(begin, end, c)` for each run of elements [begin, end) of a
+	/// tensor of `len` elements sharing parameters c
+	template <typename F>
+	void for_each_run(size_t len, F &&f) const {
+		auto block = dim * inner;
+		for (size_t o = 0; block && o < len; o += block) {
+			for (size_t c = 0; c < dim; c++) {
+				f(o + c * inner, o + (c + 1) * inner, c);
+			}
+		}
+	}
+};
+
+std::vector<TValue> QuantizeLinearOp::eval_impl(SessionState *session, std::vector<TValue> inputs) const {
+	if (inputs.size() != 2 && inputs.size() != 3) {
+		throw std::runtime_error("QuantizeLinear expects 2 or 3 inputs, got " + std::to_string(inputs.size()));
+	}
+	auto &x = *inputs[0];
+	if (x.datum_type() != DatumType::F32) {
+		throw std::runtime_error(std::string("QuantizeLinear expects an F32 input, got ") +
+		                         datum_type_name(x.datum_type()));
+	}
+	const Tensor *zero_point = inputs.size() == 3 ? inputs[2].tensor_.get() : nullptr;
+	auto dt = zero_point ? zero_point->datum_type() : DatumType::U8;
+	LinearQuantization params(name(), x.shape(), axis, *inputs[1], zero_point);
+	auto output = output_tensor(session, 0, dt, x.shape());
+	dispatch_8bit(name(), dt, [&](auto tag) {
+		using T = typename decltype(tag)::type;
+		auto src = x.as_ptr<float>();
+		auto dst = output.template as_ptr_mut<T>();
+		params.for_each_run(x.len(), [&](size_t begin, size_t end, size_t c) {
+			auto scale = params.scale(c);
+			auto zp = static_cast<float>(params.zero_point(c));
+			for (size_t i = begin; i < end; i++) {
+				dst[i] = saturate<T>(std::nearbyint(src[i] / scale) + zp);
+			}
+		});
+	});
+	std::vector<TValue> outputs;
+	outputs.push_back(TValue::Var(std::move(output)));
+	return outputs;
+}
+
+TractResult<std::vector<TValue>> QuantizeLinearOp::eval(const std::vector<TValue> &inputs) const {
+	return try_catch([&]() { return eval_impl(nullptr, inputs); });
+}
+
+TractResult<std::vector<TValue>> QuantizeLinearOp::eval_with_session(SessionState &session,
+                                                                     std::vector<TValue> inputs) const {
+	return try_catch([&]() { return eval_impl(&session, std::move(inputs)); });
+}
+
+TractResult<std::vector<TypedFact>> QuantizeLinearOp::output_facts(const std::vector<const TypedFact *> &inputs) const {
+	if (inputs.size() != 2 && inputs.size() != 3) {
+		return Err<std::vector<TypedFact>>("QuantizeLinear expects 2 or 3 inputs, got " +
+		                                   std::to_string(inputs.size()));
+	}
+	auto fact = inputs[0]->without_value();
+	fact.datum_type = inputs.size() == 3 ? inputs[2]->datum_type : DatumType::U8;
+	return Ok(std::vector<TypedFact> {fact});
+}
+
+std::vector<TValue> DequantizeLinearOp::eval_impl(SessionState *session, std::vector<TValue> inputs) const {
+	if (inputs.size() != 2 && inputs.size() != 3) {
+		throw std::runtime_error("DequantizeLinear expects 2 or 3 inputs, got " + std::to_string(inputs.size()));
+	}
+	auto &x = *inputs[0];
+	auto dt = x.datum_type();
+	if (dt != DatumType::U8 && dt != DatumType::I8 && dt != DatumType::I32) {
+		throw std::runtime_error(std::string("DequantizeLinear expects a UINT8, INT8 or INT32 input, got ") +
+		                         datum_type_name(dt));
+	}
+	const Tensor *zero_point = inputs.size() == 3 ? inputs[2].tensor_.get() : nullptr;
+	LinearQuantization params(name(), x.shape(), axis, *inputs[1], zero_point);
+	auto output = output_tensor(session, 0, DatumType::F32, x.shape());
+	dispatch_numbers(dt, [&](auto tag) {
+		using T = typename decltype(tag)::type;
+		auto src = x.template as_ptr<T>();
+		auto dst = output.as_ptr_mut<float>();
+		params.for_each_run(x.len(), [&](size_t begin, size_t end, size_t c) {
+			auto scale = params.scale(c);
+			auto zp = params.zero_point(c);
+			for (size_t i = begin; i < end; i++) {
+				dst[i] = static_cast<float>(static_cast<int64_t>(src[i]) - zp) * scale;
+			}
+		});
+	});
+	std::vector<TValue> outputs;
+	outputs.push_back(TValue::Var(std::move(output)));
+	return outputs;
+}
+
+TractResult<std::vector<TValue>> DequantizeLinearOp::eval(const std::vector<TValue> &inputs) const {
+	return try_catch([&]() { return eval_impl(nullptr, inputs); });
+}
+
+TractResult<std::vector<TValue>> DequantizeLinearOp::eval_with_session(SessionState &session,
+                                                                       std::vector<TValue> inputs) const {
+	return try_catch([&]() { return eval_impl(&session, std::move(inputs)); });
+}
+
+TractResult<std::vector<TypedFact>>
+DequantizeLinearOp::output_facts(const std::vector<const TypedFact *> &inputs) const {
+	if (inputs.size() != 2 && inputs.size() != 3) {
+		return Err<std::vector<TypedFact>>("DequantizeLinear expects 2 or 3 inputs, got " +
+		                                   std::to_string(inputs.size()));
+	}
+	auto fact = inputs[0]->without_value();
+	fact.datum_type = DatumType::F32;
+	return Ok(std::vector<TypedFact> {fact});
+}
+
+/// Requantize `rows` x `n` accumulators, rows `ldc` apart, into the 8-bit
+/// output: y = saturate(round(acc * multiplier) + zero_point), with one
+/// multiplier per column or a single one
+template <typename T>
+static void requantize_rows(size_t rows, size_t n, const int32_t *acc, size_t ldc,
+                            const std::vector<float> &multipliers, int32_t zero_point, T *y) {
+	auto zp = static_cast<float>(zero_point);
+	for (size_t i = 0; i < rows; i++) {
+		auto row = acc + i * ldc;
+		auto out = y + i * n;
+		if (multipliers.size() == 1) {
+			auto multiplier = multipliers[0];
+			for (size_t j = 0; j < n; j++) {
+				out[j] = saturate<T>(std::nearbyint(static_cast<float>(row[j]) * multiplier) + zp);
+			}
+		} else {
+			for (size_t j = 0; j < n; j++) {
+				out[j] = saturate<T>(std::nearbyint(static_cast<float>(row[j]) * multipliers[j]) + zp);
+			}
+		}
+	}
+}
+
+std::vector<TValue> QMatMulOp::eval_impl(SessionState *session, std::vector<TValue> inputs) const {
+	if (requantize ? inputs.size() != 8 : (inputs.size() < 2 || inputs.size() > 4)) {
+		throw std::runtime_error(name() + (requantize ? " expects 8 inputs, got " : " expects 2 to 4 inputs, got ") +
+		                         std::to_string(inputs.size()));
+	}
+	auto input = [&](int index) -> const Tensor * {
+		if (index < 0 || static_cast<size_t>(index) >= inputs.size()) {
+			return nullptr;
+		}
+		return inputs[static_cast<size_t>(index)].tensor_.get();
+	};
+	auto &a = *inputs[0];
+	auto &b = *inputs[requantize ? 3 : 1];
+	if (a.rank() == 0 || b.rank() == 0) {
+		throw std::runtime_error(name() + " operands must have at least one dimension");
+	}
+	// 1-D operands are promoted to a row (left) or a column (right) vector
+	auto a_shape = a.shape();
+	auto b_shape = b.shape();
+	bool a_vector = a_shape.size() == 1;
+	bool b_vector = b_shape.size() == 1;
+	if (a_vector) {
+		a_shape.insert(a_shape.begin(), 1);
+	}
+	if (b_vector) {
+		b_shape.push_back(1);
+	}
+	auto m = static_cast<size_t>(a_shape[a_shape.size() - 2]);
+	auto k = static_cast<size_t>(a_shape.back());
+	auto n = static_cast<size_t>(b_shape.back());
+	if (static_cast<size_t>(b_shape[b_shape.size() - 2]) != k) {
+		std::ostringstream msg;
+		msg << name() << " inner dimensions do not match: " << a.shape() << " and " << b.shape();
+		throw std::runtime_error(msg.str());
+	}
+	ShapeVec a_batch(a_shape.begin(), a_shape.end() - 2);
+	ShapeVec b_batch(b_shape.begin(), b_shape.end() - 2);
+	auto batch = broadcast_shapes(a_batch, b_batch);
+	auto shape = batch;
+	if (!a_vector) {
+		shape.push_back(static_cast<int64_t>(m));
+	}
+	if (!b_vector) {
+		shape.push_back(static_cast<int64_t>(n));
+	}
+
+	auto a_zero_point = zero_point_values(name(), "A zero point", input(a_zero_point_input), 1)[0];
+	auto b_zero_points = zero_point_values(name(), "B zero point", input(b_zero_point_input), n);
+	std::vector<float> multipliers;
+	int32_t y_zero_point = 0;
+	auto dt = DatumType::I32;
+	if (requantize) {
+		auto a_scale = scale_values(name(), "A scale", *inputs[1], 1)[0];
+		auto b_scales = scale_values(name(), "B scale", *inputs[4], n);
+		auto y_scale = scale_values(name(), "Y scale", *inputs[6], 1)[0];
+		for (auto b_scale : b_scales) {
+			multipliers.push_back(a_scale * b_scale / y_scale);
+		}
+		y_zero_point = zero_point_values(name(), "Y zero point", inputs[7].tensor_.get(), 1)[0];
+		dt = inputs[7]->datum_type();
+	}
+	TValue result = TValue::Var(output_tensor(session, 0, dt, shape));
+	auto out = result.tensor_.get();
+	auto runner = session ? session->runner : nullptr;
+	auto &kernels = gemm_kernels_i8();
+
+	// accumulators go straight to an INT32 output, through a buffer otherwise
+	std::vector<int32_t> buffer;
+	auto accumulators = [&](size_t offset, size_t len) {
+		if (!requantize) {
+			return out->as_ptr_mut<int32_t>() + offset;
+		}
+		buffer.resize(len);
+		return buffer.data();
+	};
+	auto finish = [&](size_t offset, size_t rows, const int32_t *acc) {
+		if (requantize) {
+			dispatch_8bit(name(), dt, [&](auto tag) {
+				using T = typename decltype(tag)::type;
+				requantize_rows<T>(rows, n, acc, n, multipliers, y_zero_point, out->template as_ptr_mut<T>() + offset);
+			});
+		}
+	};
+
+	dispatch_8bit(name(), a.datum_type(), [&](auto a_tag) {
+		using A = typename decltype(a_tag)::type;
+		auto a_data = a.template as_ptr<A>();
+		dispatch_8bit(name(), b.datum_type(), [&](auto b_tag) {
+			using B = typename decltype(b_tag)::type;
+			auto b_data = b.template as_ptr<B>();
+			size_t zp_stride = b_zero_points.size() == 1 ? 0 : 1;
+			if (b_batch.empty()) {
+				// a single right-hand side: the batch of A folds into the rows of one product
+				PackedMatrixI8 local;
+				auto packed = packed_b.get();
+				if (!packed) {
+					local.pack(k, n, b_data, n, 1, b_zero_points.data(), zp_stride);
+					packed = &local;
+				}
+				auto rows = n ? out->len() / n : 0;
+				auto acc = accumulators(0, rows * n);
+				gemm_i8(kernels, rows, a_data, k, 1, a_zero_point, *packed, acc, n, false, runner);
+				finish(0, rows, acc);
+				return;
+			}
+			PackedMatrixI8 packed;
+			const B *packed_from = nullptr;
+			BinaryBroadcast(a_batch, b_batch, batch)
+			    .for_each_run([&](size_t out_offset, size_t a_offset, size_t a_step, size_t b_offset, size_t b_step,
+			                      size_t len) {
+				    for (size_t i = 0; i < len; i++) {
+					    auto rhs = b_data + (b_offset + i * b_step) * k * n;
+					    // consecutive products often share a broadcast right-hand side
+					    if (rhs != packed_from) {
+						    packed.pack(k, n, rhs, n, 1, b_zero_points.data(), zp_stride);
+						    packed_from = rhs;
+					    }
+					    auto offset = (out_offset + i) * m * n;
+					    auto acc = accumulators(offset, m * n);
+					    gemm_i8(kernels, m, a_data + (a_offset + i * a_step) * m * k, k, 1, a_zero_point, packed, acc,
+					            n, false, runner);
+					    finish(offset, m, acc);
+				    }
+			    });
+		});
+	});
+	std::vector<TValue> outputs;
+	outputs.push_back(std::move(result));
+	return outputs;
+}
+
+TractResult<std::vector<TValue>> QMatMulOp::eval(const std::vector<TValue> &inputs) const {
+	return try_catch([&]() { return eval_impl(nullptr, inputs); });
+}
+
+TractResult<std::vector<TValue>> QMatMulOp::eval_with_session(SessionState &session, std::vector<TValue> inputs) const {
+	return try_catch([&]() { return eval_impl(&session, std::move(inputs)); });
+}
+
+uint64_t QMatMulOp::flops(const std::vector<ShapeVec> &inputs, const std::vector<ShapeVec> &outputs) const {
+	auto k = inputs.empty() || inputs[0].empty() ? 0 : inputs[0][inputs[0].size() - 1];
+	return outputs.empty() ? 0 : 2 * shape_volume(outputs[0]) * static_cast<uint64_t>(k);
+}
+
+std::shared_ptr<Op> QMatMulOp::codegen(const std::vector<std::shared_ptr<Tensor>> &constants) const {
+	auto b_input = static_cast<size_t>(requantize ? 3 : 1);
+	if (packed_b || constants.size() <= b_input || !constants[b_input]) {
+		return nullptr;
+	}
+	// the zero points of B are subtracted while packing, so they must be known too
+	std::shared_ptr<Tensor> zero_point;
+	if (b_zero_point_input >= 0) {
+		auto index = static_cast<size_t>(b_zero_point_input);
+		if (index >= constants.size() || !constants[index]) {
+			return nullptr;
+		}
+		zero_point = constants[index];
+	}
+	auto &b = *constants[b_input];
+	if ((b.datum_type() != DatumType::U8 && b.datum_type() != DatumType::I8) || b.rank() != 2) {
+		return nullptr;
+	}
+	auto k = static_cast<size_t>(b.shape()[0]);
+	auto n = static_cast<size_t>(b.shape()[1]);
+	auto packed = std::make_shared<PackedMatrixI8>();
+	try {
+		auto zero_points = zero_point_values(name(), "B zero point", zero_point.get(), n);
+		size_t zp_stride = zero_points.size() == 1 ? 0 : 1;
+		dispatch_8bit(name(), b.datum_type(), [&](auto tag) {
+			using B = typename decltype(tag)::type;
+			packed->pack(k, n, b.template as_ptr<B>(), n, 1, zero_points.data(), zp_stride);
+		});
+	} catch (std::exception &) {
+		// left to fail at run time, with the error of the op
+		return nullptr;
+	}
+	auto op = std::make_shared<QMatMulOp>(*this);
+	op->packed_b = std::move(packed);
+	return op;
+}
+
+TractResult<std::vector<TypedFact>> QMatMulOp::output_facts(const std::vector<const TypedFact *> &inputs) const {
+	if (requantize ? inputs.size() != 8 : (inputs.size() < 2 || inputs.size() > 4)) {
+		return Err<std::vector<TypedFact>>(name() + (requantize ? " expects 8 inputs, got "
+		                                                        : " expects 2 to 4 inputs, got ") +
+		                                   std::to_string(inputs.size()));
+	}
+	// the shape is the one of a plain matrix product
+	auto facts = MatMulOp().output_facts({inputs[0], inputs[requantize ? 3 : 1]});
+	if (facts.is_ok()) {
+		facts.value()[0].datum_type = requantize ? inputs[7]->datum_type : DatumType::I32;
+	}
+	return facts;
+}
+
+/// Pack the matrix of the input patches of one group, minus the zero point
+/// of the input, in the layout of ConvOp's patches: zero in the padding,
+/// which thus reads as the zero point.
+template <typename T>
+static void pack_patches(const PatchGeometry &geo, size_t channels, const T *image, int32_t zero_point,
+                         PackedMatrixI8 &columns, TaskRunner *runner) {
+	auto kh = static_cast<size_t>(geo.kernel[0]);
+	auto kw = static_cast<size_t>(geo.kernel[1]);
+	auto ih = geo.input[0];
+	auto iw = geo.input[1];
+	auto ow = static_cast<size_t>(geo.output[1]);
+	auto k = channels * kh * kw;
+	auto pixels = static_cast<size_t>(geo.output_len());
+	columns.resize(k, pixels);
+
+	// input coordinates under the top-left kernel offset of every output pixel
+	std::vector<int64_t> origin_y(pixels);
+	std::vector<int64_t> origin_x(pixels);
+	for (size_t j = 0; j < pixels; j++) {
+		origin_y[j] = geo.input_index(0, static_cast<int64_t>(j / ow), 0);
+		origin_x[j] = geo.input_index(1, static_cast<int64_t>(j % ow), 0);
+	}
+	auto parts = parallel_parts(runner, k * pixels, PATCH_MIN_TASK_WORK);
+	parallel_for(runner, columns.panel_count(), parts, [&](size_t begin, size_t end) {
+		for (size_t p0 = 0; p0 < k; p0 += GEMM_KC) {
+			auto kc = std::min(GEMM_KC, k - p0);
+			for (size_t panel = begin; panel < end; panel++) {
+				auto dst = columns.panel_mut(p0, panel);
+				auto j0 = panel * GEMM_NR;
+				auto cols = std::min(GEMM_NR, pixels - j0);
+				auto ys = origin_y.data() + j0;
+				auto xs = origin_x.data() + j0;
+				for (size_t q = 0; q < kc + kc % 2; q++) {
+					// row q goes to the first or second half of the pairs of row q / 2
+					auto row = dst + (q / 2) * 2 * GEMM_NR + q % 2;
+					size_t j = 0;
+					if (q < kc) {
+						auto p = p0 + q;
+						auto plane = image + (p / (kh * kw)) * ih * iw;
+						auto dy = static_cast<int64_t>((p / kw) % kh) * geo.dilations[0];
+						auto dx = static_cast<int64_t>(p % kw) * geo.dilations[1];
+						for (; j < cols; j++) {
+							auto y = ys[j] + dy;
+							auto x = xs[j] + dx;
+							row[j * 2] = y >= 0 && y < ih && x >= 0 && x < iw
+							                 ? static_cast<int16_t>(plane[y * iw + x] - zero_point)
+							                 : int16_t(0);
+						}
+					}
+					for (; j < GEMM_NR; j++) {
+						row[j * 2] = 0;
+					}
+				}
+			}
+		}
+	});
+}
+
+/// The filters of every group, minus their zero points, as GEMM left-hand
+/// sides packed transposed (see ConvOp)
+static std::vector<PackedMatrixI8> pack_filters(const Tensor &filters, const Tensor *zero_point, int64_t group,
+                                                size_t mr) {
+	auto count = static_cast<size_t>(filters.shape()[0]);
+	auto m = count / static_cast<size_t>(group);
+	auto k = filters.len() / count;
+	auto zero_points = zero_point_values("QLinearConv", "filter zero point", zero_point, count);
+	size_t zp_stride = zero_points.size() == 1 ? 0 : 1;
+	std::vector<PackedMatrixI8> packed(static_cast<size_t>(group));
+	dispatch_8bit("QLinearConv", filters.datum_type(), [&](auto tag) {
+		using W = typename decltype(tag)::type;
+		for (size_t g = 0; g < packed.size(); g++) {
+			// element (p, i) is filter i, weight p
+			packed[g].pack(k, m, filters.template as_ptr<W>() + g * m * k, 1, k,
+			               zero_points.data() + g * m * zp_stride, zp_stride, mr);
+		}
+	});
+	return packed;
+}
+
+std::vector<TValue> QLinearConvOp::eval_impl(SessionState *session, std::vector<TValue> inputs) const {
+	if (inputs.size() != 8 && inputs.size() != 9) {
+		throw std::runtime_error("QLinearConv expects 8 or 9 inputs, got " + std::to_string(inputs.size()));
+	}
+	auto &x = *inputs[0];
+	auto &w = *inputs[3];
+	if ((x.rank() != 3 && x.rank() != 4) || w.rank() != x.rank()) {
+		std::ostringstream msg;
+		msg << "QLinearConv only supports 1-D and 2-D images, got input " << x.shape() << " and filters "
+		    << w.shape();
+		throw std::runtime_error(msg.str());
+	}
+	auto batch = static_cast<size_t>(x.shape()[0]);
+	auto channels = x.shape()[1];
+	auto filters = w.shape()[0];
+	auto group_channels = w.shape()[1];
+	if (group <= 0 || channels != group_channels * group || filters % group != 0) {
+		std::ostringstream msg;
+		msg << "QLinearConv filters " << w.shape() << " do not match input " << x.shape() << " with " << group
+		    << " groups";
+		throw std::runtime_error(msg.str());
+	}
+	auto x_zero_point = zero_point_values(name(), "input zero point", inputs[2].tensor_.get(), 1)[0];
+	auto x_scale = scale_values(name(), "input scale", *inputs[1], 1)[0];
+	auto w_scales = scale_values(name(), "filter scale", *inputs[4], static_cast<size_t>(filters));
+	auto y_scale = scale_values(name(), "output scale", *inputs[6], 1)[0];
+	auto y_zero_point = zero_point_values(name(), "output zero point", inputs[7].tensor_.get(), 1)[0];
+	const int32_t *bias = nullptr;
+	if (inputs.size() == 9) {
+		auto &b = *inputs[8];
+		if (b.datum_type() != DatumType::I32 || b.len() != static_cast<size_t>(filters)) {
+			std::ostringstream msg;
+			msg << "QLinearConv bias of type " << datum_type_name(b.datum_type()) << " and shape " << b.shape()
+			    << " does not match " << filters << " filters";
+			throw std::runtime_error(msg.str());
+		}
+		bias = b.as_ptr<int32_t>();
+	}
+
+	ShapeVec spatial(x.shape().begin() + 2, x.shape().end());
+	ShapeVec kernel(w.shape().begin() + 2, w.shape().end());
+	auto geo = patch.geometry(spatial, kernel);
+	ShapeVec shape {x.shape()[0], filters};
+	if (x.rank() == 4) {
+		shape.push_back(geo.output[0]);
+	}
+	shape.push_back(geo.output[1]);
+	auto dt = inputs[7]->datum_type();
+	TValue result = TValue::Var(output_tensor(session, 0, dt, shape));
+
+	auto &kernels = gemm_kernels_i8();
+	std::vector<PackedMatrixI8> local;
+	auto packed = packed_filters.get();
+	if (!packed || packed->empty() || (*packed)[0].width() != kernels.mr) {
+		local = pack_filters(w, inputs[5].tensor_.get(), group, kernels.mr);
+		packed = &local;
+	}
+
+	auto m = static_cast<size_t>(filters / group);
+	auto k = static_cast<size_t>(group_channels * geo.kernel[0] * geo.kernel[1]);
+	auto image_len = static_cast<size_t>(geo.input[0] * geo.input[1]);
+	auto pixels = static_cast<size_t>(geo.output_len());
+	// a 1x1 kernel over the unpadded image reads the input as it is
+	bool pointwise = geo.kernel[0] == 1 && geo.kernel[1] == 1 && geo.strides[0] == 1 && geo.strides[1] == 1 &&
+	                 geo.pad_begin[0] == 0 && geo.pad_begin[1] == 0 && pixels == image_len;
+	auto runner = session ? session->runner : nullptr;
+	auto images = batch * static_cast<size_t>(group);
+	auto parts = parallel_parts(runner, images * m * k * pixels, CONV_MIN_TASK_WORK);
+	// whole images per task when there are enough of them to go around, the inside of each image otherwise
+	auto image_parts = images >= parts ? parts : 1;
+	auto image_runner = image_parts > 1 ? nullptr : runner;
+	dispatch_8bit(name(), x.datum_type(), [&](auto x_tag) {
+		using X = typename decltype(x_tag)::type;
+		dispatch_8bit(name(), dt, [&](auto y_tag) {
+			using Y = typename decltype(y_tag)::type;
+			auto out = result.tensor_->template as_ptr_mut<Y>();
+			parallel_for(runner, images, image_parts, [&](size_t begin, size_t end) {
+				PackedMatrixI8 columns;
+				std::vector<int32_t> acc(m * pixels);
+				std::vector<float> multiplier(1);
+				for (size_t i = begin; i < end; i++) {
+					auto n = i / static_cast<size_t>(group);
+					auto g = i % static_cast<size_t>(group);
+					auto image = x.template as_ptr<X>() + (n * channels + g * group_channels) * image_len;
+					if (bias) {
+						for (size_t r = 0; r < m; r++) {
+							std::fill(acc.begin() + r * pixels, acc.begin() + (r + 1) * pixels, bias[g * m + r]);
+						}
+					}
+					if (pointwise) {
+						columns.pack(k, pixels, image, pixels, 1, &x_zero_point, 0);
+					} else {
+						pack_patches(geo, static_cast<size_t>(group_channels), image, x_zero_point, columns,
+						             image_runner);
+					}
+					gemm_i8(kernels, (*packed)[g], columns, acc.data(), pixels, bias != nullptr, image_runner);
+					auto c = out + (n * filters + g * m) * pixels;
+					for (size_t r = 0; r < m; r++) {
+						multiplier[0] = x_scale * w_scales[w_scales.size() == 1 ? 0 : g * m + r] / y_scale;
+						requantize_rows<Y>(1, pixels, acc.data() + r * pixels, pixels, multiplier, y_zero_point,
+						                   c + r * pixels);
+					}
+				}
+			});
+		});
+	});
+	std::vector<TValue> outputs;
+	outputs.push_back(std::move(result));
+	return outputs;
+}
+
+TractResult<std::vector<TValue>> QLinearConvOp::eval(const std::vector<TValue> &inputs) const {
+	return try_catch([&]() { return eval_impl(nullptr, inputs); });
+}
+
+TractResult<std::vector<TValue>> QLinearConvOp::eval_with_session(SessionState &session,
+                                                                  std::vector<TValue> inputs) const {
+	return try_catch([&]() { return eval_impl(&session, std::move(inputs)); });
+}
+
+std::shared_ptr<Op> QLinearConvOp::codegen(const std::vector<std::shared_ptr<Tensor>> &constants) const {
+	// the zero points of the filters are subtracted while packing, so they must be known too
+	if (packed_filters || constants.size() < 8 || !constants[3] || !constants[5]) {
+		return nullptr;
+	}
+	auto &w = *constants[3];
+	if (w.rank() < 3 || group <= 0 || w.shape()[0] % group != 0) {
+		return nullptr;
+	}
+	auto op = std::make_shared<QLinearConvOp>(*this);
+	try {
+		op->packed_filters = std::make_shared<const std::vector<PackedMatrixI8>>(
+		    pack_filters(w, constants[5].get(), group, gemm_kernels_i8().mr));
+	} catch (std::exception &) {
+		// left to fail at run time, with the error of the op
+		return nullptr;
+	}
+	return op;
+}
+
+uint64_t QLinearConvOp::flops(const std::vector<ShapeVec> &inputs, const std::vector<ShapeVec> &outputs) const {
+	if (inputs.size() < 4 || inputs[3].empty() || inputs[3][0] <= 0 || outputs.empty()) {
+		return 0;
+	}
+	return 2 * shape_volume(outputs[0]) * (shape_volume(inputs[3]) / static_cast<uint64_t>(inputs[3][0]));
+}
+
+size_t QLinearConvOp::memory_usage() const {
+	size_t bytes = 0;
+	if (packed_filters) {
+		for (auto &packed : *packed_filters) {
+			bytes += packed.heap_bytes();
+		}
+	}
+	return bytes;
+}
+
+TractResult<std::vector<TypedFact>> QLinearConvOp::output_facts(const std::vector<const TypedFact *> &inputs) const {
+	return try_catch([&]() {
+		if (inputs.size() != 8 && inputs.size() != 9) {
+			throw std::runtime_error("QLinearConv expects 8 or 9 inputs, got " + std::to_string(inputs.size()));
+		}
+		auto &x = *inputs[0];
+		auto &w = *inputs[3];
+		auto dt = inputs[7]->datum_type;
+		if (x.rank_known && w.rank_known && w.shape.size() >= 2) {
+			std::vector<TDim> kernel(w.shape.begin() + 2, w.shape.end());
+			return std::vector<TypedFact> {TypedFact(dt, patch.output_shape(x.shape, w.shape[0], kernel))};
+		}
+		return std::vector<TypedFact> {TypedFact::unknown(dt)};
+	});
+}
+
+bool QuantizeLinearOp::save(PlanWriter &writer) const {
+	writer.write_string("QuantizeLinear");
+	writer.write_i64(axis);
+	return true;
+}
+
+std::shared_ptr<Op> QuantizeLinearOp::load(PlanReader &reader) {
+	return std::make_shared<QuantizeLinearOp>(reader.read_i64());
+}
+
+bool DequantizeLinearOp::save(PlanWriter &writer) const {
+	writer.write_string("DequantizeLinear");
+	writer.write_i64(axis);
+	return true;
+}
+
+std::shared_ptr<Op> DequantizeLinearOp::load(PlanReader &reader) {
+	return std::make_shared<DequantizeLinearOp>(reader.read_i64());
+}
+
+bool QMatMulOp::save(PlanWriter &writer) const {
+	writer.write_string("QMatMul");
+	writer.write_bool(requantize);
+	writer.write_i64(a_zero_point_input);
+	writer.write_i64(b_zero_point_input);
+	writer.write_bool(packed_b != nullptr);
+	if (packed_b) {
+		writer.write_packed(*packed_b);
+	}
+	return true;
+}
+
+std::shared_ptr<Op> QMatMulOp::load(PlanReader &reader) {
+	auto requantize = reader.read_bool();
+	auto a_zero_point_input = static_cast<int>(reader.read_i64());
+	auto b_zero_point_input = static_cast<int>(reader.read_i64());
+	auto op = std::make_shared<QMatMulOp>(requantize, a_zero_point_input, b_zero_point_input);
+	if (reader.read_bool()) {
+		op->packed_b = std::make_shared<const PackedMatrixI8>(reader.read_packed_i8());
+	}
+	return op;
+}
+
+bool QLinearConvOp::save(PlanWriter &writer) const {
+	writer.write_string("QLinearConv");
+	patch.save(writer);
+	writer.write_i64(group);
+	writer.write_bool(packed_filters != nullptr);
+	if (packed_filters) {
+		writer.write_u64(packed_filters->size());
+		for (auto &packed : *packed_filters) {
+			writer.write_packed(packed);
+		}
+	}
+	return true;
+}
+
+std::shared_ptr<Op> QLinearConvOp::load(PlanReader &reader) {
+	auto patch = PatchSpec::load(reader);
+	auto op = std::make_shared<QLinearConvOp>(std::move(patch), reader.read_i64());
+	if (reader.read_bool()) {
+		std::vector<PackedMatrixI8> filters(reader.read_u64());
+		for (auto &packed : filters) {
+			packed = reader.read_packed_i8();
+		}
+		op->packed_filters = std::make_shared<const std::vector<PackedMatrixI8>>(std::move(filters));
+	}
+	return op;
+}
+
+} // namespace duckdb_onnx
@@ -0,0 +1,379 @@
+#include "duckdb-onnx/core/ops/reshape.h"
+
+#include "duckdb-onnx/core/plan_file.hpp"
+#include "duckdb-onnx/core/session.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+
+namespace duckdb_onnx {
+
+/// `input` with a new shape. An exclusive input is reshaped in place and a
+/// constant is viewed, since neither can change under the result; anything
+/// else is copied.
+static TValue reshaped(SessionState *session, TValue &input, ShapeVec shape) {
+	if (input.is_exclusive()) {
+		auto value = std::move(input);
+		value.as_mut()->set_shape(std::move(shape));
+		return value;
+	}
+	auto dt = input->datum_type();
+	if (input.as_arc_tensor()) {
+		auto view = Tensor::from_blob(dt, shape, input->blob());
+		return TValue::Const(std::make_shared<Tensor>(std::move(view)));
+	}
+	auto out = output_tensor(session, 0, dt, std::move(shape));
+	if (out.len() != input->len()) {
+		throw std::runtime_error("Cannot reshape tensor: element count mismatch");
+	}
+	std::memmove(out.raw_data_mut(), input->raw_data(), input->byte_len());
+	return TValue::Var(std::move(out));
+}
+
+std::vector<TValue> ReshapeOp::eval_impl(SessionState *session, std::vector<TValue> inputs) const {
+	auto expected = shape ? 1 : 2;
+	if (inputs.size() != static_cast<size_t>(expected)) {
+		throw std::runtime_error("Reshape expects " + std::to_string(expected) + " inputs, got " +
+		                         std::to_string(inputs.size()));
+	}
+	auto &input_shape = inputs[0]->shape();
+	ShapeVec target;
+	if (shape) {
+		target = *shape;
+	} else {
+		auto &spec = *inputs[1];
+		if (spec.datum_type() != DatumType::I64 || spec.rank() != 1) {
+			throw std::runtime_error("Reshape shape must be a 1-D I64 tensor");
+		}
+		target = ShapeVec(spec.as_ptr<int64_t>(), spec.as_ptr<int64_t>() + spec.len());
+	}
+
+	int inferred = -1;
+	int64_t known = 1;
+	for (size_t i = 0; i < target.size(); i++) {
+		if (target[i] == 0 && !allow_zero) {
+			if (i >= input_shape.size()) {
+				throw std::runtime_error("Reshape copies a dimension the input does not have");
+			}
+			target[i] = input_shape[i];
+		}
+		if (target[i] == -1) {
+			if (inferred >= 0) {
+				throw std::runtime_error("Reshape shape has more than one -1");
+			}
+			inferred = static_cast<int>(i);
+		} else if (target[i] < 0) {
+			throw std::runtime_error("Reshape shape has a negative dimension");
+		} else {
+			known *= target[i];
+		}
+	}
+	auto len = static_cast<int64_t>(inputs[0]->len());
+	if (inferred >= 0) {
+		target[inferred] = known == 0 ? 0 : len / known;
+		known *= target[inferred];
+	}
+	if (known != len) {
+		std::ostringstream msg;
+		msg << "Cannot reshape " << input_shape << " to " << target;
+		throw std::runtime_error(msg.str());
+	}
+	std::vector<TValue> outputs;
+	outputs.push_back(reshaped(session, inputs[0], std::move(target)));
+	return outputs;
+}
+
+TractResult<std::vector<TValue>> ReshapeOp::eval(const std::vector<TValue> &inputs) const {
+	return try_catch([&]() { return eval_impl(nullptr, inputs); });
+}
+
+TractResult<std::vector<TValue>> ReshapeOp::eval_with_session(SessionState &session, std::vector<TValue> inputs) const {
+	return try_catch([&]() { return eval_impl(&session, std::move(inputs)); });
+}
+
+std::vector<TValue> FlattenOp::eval_impl(SessionState *session, std::vector<TValue> inputs) const {
+	if (inputs.size() != 1) {
+		throw std::runtime_error("Flatten expects 1 input, got " + std::to_string(inputs.size()));
+	}
+	auto &input_shape = inputs[0]->shape();
+	auto rank = static_cast<int64_t>(input_shape.size());
+	auto split = axis < 0 ? axis + rank : axis;
+	if (split < 0 || split > rank) {
+		std::ostringstream msg;
+		msg << "Flatten axis " << axis << " is out of range for " << input_shape;
+		throw std::runtime_error(msg.str());
+	}
+	ShapeVec shape {1, 1};
+	for (int64_t i = 0; i < rank; i++) {
+		shape[i < split ? 0 : 1] *= input_shape[i];
+	}
+	std::vector<TValue> outputs;
+	outputs.push_back(reshaped(session, inputs[0], std::move(shape)));
+	return outputs;
+}
+
+TractResult<std::vector<TValue>> FlattenOp::eval(const std::vector<TValue> &inputs) const {
+	return try_catch([&]() { return eval_impl(nullptr, inputs); });
+}
+
+TractResult<std::vector<TValue>> FlattenOp::eval_with_session(SessionState &session, std::vector<TValue> inputs) const {
+	return try_catch([&]() { return eval_impl(&session, std::move(inputs)); });
+}
+
+/// `axes` as non-negative indices into a shape of rank `rank`, sorted
+static std::vector<int64_t> normalize_axes(const std::string &op, const ShapeVec &axes, int64_t rank) {
+	std::vector<int64_t> result;
+	for (auto axis : axes) {
+		auto resolved = axis < 0 ? axis + rank : axis;
+		if (resolved < 0 || resolved >= rank || std::count(result.begin(), result.end(), resolved)) {
+			std::ostringstream msg;
+			msg << op << " axes " << axes << " are invalid for rank " << rank;
+			throw std::runtime_error(msg.str());
+		}
+		result.push_back(resolved);
+	}
+	std::sort(result.begin(), result.end());
+	return result;
+}
+
+std::vector<TValue> SqueezeOp::eval_impl(SessionState *session, std::vector<TValue> inputs) const {
+	if (inputs.empty() || inputs.size() > 2) {
+		throw std::runtime_error(name() + " expects 1 or 2 inputs, got " + std::to_string(inputs.size()));
+	}
+	auto selected = axes;
+	if (axes_input && inputs.size() == 2) {
+		auto &spec = *inputs[1];
+		if (spec.datum_type() != DatumType::I64 || spec.rank() > 1) {
+			throw std::runtime_error(name() + " axes must be a 1-D I64 tensor");
+		}
+		selected = ShapeVec(spec.as_ptr<int64_t>(), spec.as_ptr<int64_t>() + spec.len());
+	} else if (unsqueeze && axes_input) {
+		throw std::runtime_error("Unsqueeze expects its axes as input 1");
+	}
+	auto &input_shape = inputs[0]->shape();
+	auto rank = static_cast<int64_t>(input_shape.size());
+	ShapeVec shape;
+	if (unsqueeze) {
+		auto inserted = normalize_axes(name(), selected, rank + static_cast<int64_t>(selected.size()));
+		size_t next = 0;
+		for (int64_t i = 0; i < rank + static_cast<int64_t>(inserted.size()); i++) {
+			if (std::binary_search(inserted.begin(), inserted.end(), i)) {
+				shape.push_back(1);
+			} else {
+				shape.push_back(input_shape[next++]);
+			}
+		}
+	} else {
+		auto removed = normalize_axes(name(), selected, rank);
+		for (int64_t i = 0; i < rank; i++) {
+			bool listed = std::binary_search(removed.begin(), removed.end(), i);
+			if (listed && input_shape[i] != 1) {
+				std::ostringstream msg;
+				msg << "Cannot squeeze dimension " << i << " of " << input_shape;
+				throw std::runtime_error(msg.str());
+			}
+			if (!listed && (!removed.empty() || input_shape[i] != 1)) {
+				shape.push_back(input_shape[i]);
+			}
+		}
+	}
+	inputs.resize(1);
+	std::vector<TValue> outputs;
+	outputs.push_back(reshaped(session, inputs[0], std::move(shape)));
+	return outputs;
+}
+
+TractResult<std::vector<TValue>> SqueezeOp::eval(const std::vector<TValue> &inputs) const {
+	return try_catch([&]() { return eval_impl(nullptr, inputs); });
+}
+
+TractResult<std::vector<TValue>> SqueezeOp::eval_with_session(SessionState &session, std::vector<TValue> inputs) const {
+	return try_catch([&]() { return eval_impl(&session, std::move(inputs)); });
+}
+
+/// The elements of a rank 0 or 1 fact if they are all integers
+static std::optional<ShapeVec> int_value(const TypedFact &fact) {
+	if (!fact.symbolic_value) {
+		return std::nullopt;
+	}
+	ShapeVec values;
+	for (auto &dim : *fact.symbolic_value) {
+		if (!dim.is_int()) {
+			return std::nullopt;
+		}
+		values.push_back(dim.as_int());
+	}
+	return values;
+}
+
+/// `fact` reshaped to `shape`, keeping the elements of a small integer tensor
+static TypedFact reshaped_fact(const TypedFact &fact, std::vector<TDim> shape) {
+	TypedFact result(fact.datum_type, std::move(shape));
+	if (result.shape.size() <= 1) {
+		result.symbolic_value = fact.symbolic_value;
+	}
+	return result;
+}
+
+TractResult<std::vector<TypedFact>> ReshapeOp::output_facts(const std::vector<const TypedFact *> &inputs) const {
+	return try_catch([&]() {
+		auto expected = shape ? 1 : 2;
+		if (inputs.size() != static_cast<size_t>(expected)) {
+			throw std::runtime_error("Reshape expects " + std::to_string(expected) + " inputs, got " +
+			                         std::to_string(inputs.size()));
+		}
+		auto &input = *inputs[0];
+		std::vector<TDim> target;
+		if (shape) {
+			target.assign(shape->begin(), shape->end());
+		} else if (inputs[1]->symbolic_value) {
+			target = *inputs[1]->symbolic_value;
+		} else {
+			// only the rank is known, from the length of the shape input
+			auto fact = TypedFact::unknown(input.datum_type);
+			auto &spec = *inputs[1];
+			if (spec.rank_known && spec.shape.size() == 1 && spec.shape[0].is_int()) {
+				fact = TypedFact(input.datum_type, std::vector<TDim>(spec.shape[0].as_int(), TDim()));
+			}
+			return std::vector<TypedFact> {fact};
+		}
+
+		int inferred = -1;
+		TDim known(1);
+		for (size_t i = 0; i < target.size(); i++) {
+			if (target[i] == TDim(0) && !allow_zero) {
+				target[i] = input.rank_known && i < input.shape.size() ? input.shape[i] : TDim();
+			}
+			if (target[i] == TDim(-1)) {
+				if (inferred >= 0) {
+					throw std::runtime_error("Reshape shape has more than one -1");
+				}
+				inferred = static_cast<int>(i);
+			} else {
+				known = known * target[i];
+			}
+		}
+		if (inferred >= 0) {
+			target[inferred] = input.len() / known;
+		} else if (input.shape_is_concrete() && known.is_int() && known != input.len()) {
+			std::ostringstream msg;
+			msg << "Cannot reshape a tensor of " << input.len() << " elements to " << known << " elements";
+			throw std::runtime_error(msg.str());
+		}
+		return std::vector<TypedFact> {reshaped_fact(input, std::move(target))};
+	});
+}
+
+TractResult<std::vector<TypedFact>> FlattenOp::output_facts(const std::vector<const TypedFact *> &inputs) const {
+	return try_catch([&]() {
+		if (inputs.size() != 1) {
+			throw std::runtime_error("Flatten expects 1 input, got " + std::to_string(inputs.size()));
+		}
+		auto &input = *inputs[0];
+		auto fact = TypedFact::unknown(input.datum_type);
+		if (input.rank_known) {
+			auto rank = static_cast<int64_t>(input.shape.size());
+			auto split = axis < 0 ? axis + rank : axis;
+			if (split < 0 || split > rank) {
+				throw std::runtime_error("Flatten axis " + std::to_string(axis) + " is out of range for rank " +
+				                         std::to_string(rank));
+			}
+			std::vector<TDim> shape {TDim(1), TDim(1)};
+			for (int64_t i = 0; i < rank; i++) {
+				shape[i < split ? 0 : 1] = shape[i < split ? 0 : 1] * input.shape[i];
+			}
+			fact = TypedFact(input.datum_type, std::move(shape));
+		}
+		return std::vector<TypedFact> {fact};
+	});
+}
+
+TractResult<std::vector<TypedFact>> SqueezeOp::output_facts(const std::vector<const TypedFact *> &inputs) const {
+	return try_catch([&]() {
+		if (inputs.empty() || inputs.size() > 2) {
+			throw std::runtime_error(name() + " expects 1 or 2 inputs, got " + std::to_string(inputs.size()));
+		}
+		auto &input = *inputs[0];
+		auto unknown = TypedFact::unknown(input.datum_type);
+		auto selected = axes;
+		if (axes_input && inputs.size() == 2) {
+			auto values = int_value(*inputs[1]);
+			if (!values) {
+				return std::vector<TypedFact> {unknown};
+			}
+			selected = *values;
+		}
+		if (!input.rank_known) {
+			return std::vector<TypedFact> {unknown};
+		}
+		auto rank = static_cast<int64_t>(input.shape.size());
+		std::vector<TDim> shape;
+		if (unsqueeze) {
+			auto inserted = normalize_axes(name(), selected, rank + static_cast<int64_t>(selected.size()));
+			size_t next = 0;
+			for (int64_t i = 0; i < rank + static_cast<int64_t>(inserted.size()); i++) {
+				shape.push_back(std::binary_search(inserted.begin(), inserted.end(), i) ? TDim(1)
+				                                                                         : input.shape[next++]);
+			}
+		} else {
+			auto removed = normalize_axes(name(), selected, rank);
+			for (int64_t i = 0; i < rank; i++) {
+				auto &dim = input.shape[i];
+				if (removed.empty() && !dim.is_int()) {
+					// whether it is 1 is only known when the model runs
+					return std::vector<TypedFact> {unknown};
+				}
+				if (!std::binary_search(removed.begin(), removed.end(), i) && (!removed.empty() || dim != TDim(1))) {
+					shape.push_back(dim);
+				}
+			}
+		}
+		return std::vector<TypedFact> {reshaped_fact(input, std::move(shape))};
+	});
+}
+
+bool ReshapeOp::save(PlanWriter &writer) const {
+	writer.write_string("Reshape");
+	writer.write_bool(allow_zero);
+	writer.write_bool(shape.has_value());
+	if (shape) {
+		writer.write_shape(*shape);
+	}
+	return true;
+}
+
+std::shared_ptr<Op> ReshapeOp::load(PlanReader &reader) {
+	auto op = std::make_shared<ReshapeOp>(reader.read_bool());
+	if (reader.read_bool()) {
+		op->shape = reader.read_shape();
+	}
+	return op;
+}
+
+bool FlattenOp::save(PlanWriter &writer) const {
+	writer.write_string("Flatten");
+	writer.write_i64(axis);
+	return true;
+}
+
+std::shared_ptr<Op> FlattenOp::load(PlanReader &reader) {
+	return std::make_shared<FlattenOp>(reader.read_i64());
+}
+
+bool SqueezeOp::save(PlanWriter &writer) const {
+	writer.write_string("Squeeze");
+	writer.write_bool(unsqueeze);
+	writer.write_shape(axes);
+	writer.write_bool(axes_input);
+	return true;
+}
+
+std::shared_ptr<Op> SqueezeOp::load(PlanReader &reader) {
+	auto unsqueeze = reader.read_bool();
+	auto axes = reader.read_shape();
+	return std::make_shared<SqueezeOp>(unsqueeze, std::move(axes), reader.read_bool());
+}
+
+} // namespace duckdb_onnx
@@ -0,0 +1,272 @@
+#include "duckdb-onnx/core/ops/shape.h"
+
+#include "duckdb-onnx/core/plan_file.hpp"
+#include "duckdb-onnx/core/session.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+
+namespace duckdb_onnx {
+
+/// `axis` as an index into a shape of rank `rank`
+static size_t resolve_axis(const std::string &op, int64_t axis, size_t rank) {
+	auto resolved = axis < 0 ? axis + static_cast<int64_t>(rank) : axis;
+	if (resolved < 0 || resolved >= static_cast<int64_t>(rank)) {
+		throw std::runtime_error(op + " axis " + std::to_string(axis) + " is out of range for rank " +
+		                         std::to_string(rank));
+	}
+	return static_cast<size_t>(resolved);
+}
+
+Tensor ShapeOp::shape_of(const ShapeVec &shape) const {
+	auto rank = static_cast<int64_t>(shape.size());
+	auto clamp = [&](int64_t bound) { return std::min(std::max(bound < 0 ? bound + rank : bound, int64_t(0)), rank); };
+	auto begin = clamp(start);
+	auto stop = std::max(begin, clamp(end));
+	auto tensor = Tensor::uninitialized(DatumType::I64, ShapeVec {stop - begin});
+	std::copy(shape.begin() + begin, shape.begin() + stop, tensor.as_ptr_mut<int64_t>());
+	return tensor;
+}
+
+TractResult<std::vector<TypedFact>> ShapeOp::output_facts(const std::vector<const TypedFact *> &inputs) const {
+	return try_catch([&]() {
+		if (inputs.size() != 1) {
+			throw std::runtime_error("Shape expects 1 input, got " + std::to_string(inputs.size()));
+		}
+		auto &input = *inputs[0];
+		if (!input.rank_known) {
+			return std::vector<TypedFact> {TypedFact(DatumType::I64, std::vector<TDim> {TDim()})};
+		}
+		auto rank = static_cast<int64_t>(input.shape.size());
+		auto clamp = [&](int64_t bound) {
+			return std::min(std::max(bound < 0 ? bound + rank : bound, int64_t(0)), rank);
+		};
+		auto begin = clamp(start);
+		auto stop = std::max(begin, clamp(end));
+		TypedFact fact(DatumType::I64, std::vector<TDim> {stop - begin});
+		fact.symbolic_value = std::vector<TDim>(input.shape.begin() + begin, input.shape.begin() + stop);
+		return std::vector<TypedFact> {fact};
+	});
+}
+
+TractResult<std::vector<TValue>> ShapeOp::eval(const std::vector<TValue> &inputs) const {
+	return try_catch([&]() {
+		if (inputs.size() != 1) {
+			throw std::runtime_error("Shape expects 1 input, got " + std::to_string(inputs.size()));
+		}
+		return std::vector<TValue> {TValue::Var(shape_of(inputs[0]->shape()))};
+	});
+}
+
+std::vector<TValue> GatherOp::eval_impl(SessionState *session, std::vector<TValue> inputs) const {
+	if (inputs.size() != 2) {
+		throw std::runtime_error("Gather expects 2 inputs, got " + std::to_string(inputs.size()));
+	}
+	auto &data = *inputs[0];
+	auto &indices = *inputs[1];
+	if (indices.datum_type() != DatumType::I64 && indices.datum_type() != DatumType::I32) {
+		throw std::runtime_error(std::string("Gather indices must be I32 or I64, got ") +
+		                         datum_type_name(indices.datum_type()));
+	}
+	auto &data_shape = data.shape();
+	auto gathered = resolve_axis(name(), axis, data.rank());
+	ShapeVec shape(data_shape.begin(), data_shape.begin() + gathered);
+	for (auto dim : indices.shape()) {
+		shape.push_back(dim);
+	}
+	for (size_t i = gathered + 1; i < data.rank(); i++) {
+		shape.push_back(data_shape[i]);
+	}
+	TValue result = TValue::Var(output_tensor(session, 0, data.datum_type(), shape));
+
+	size_t outer = 1;
+	for (size_t i = 0; i < gathered; i++) {
+		outer *= static_cast<size_t>(data_shape[i]);
+	}
+	auto dim = data_shape[gathered];
+	auto inner = data.len() / std::max<size_t>(outer * static_cast<size_t>(dim), 1);
+	auto slice = inner * datum_type_size(data.datum_type());
+	auto src = static_cast<const char *>(data.raw_data());
+	auto dst = static_cast<char *>(result.tensor_->raw_data_mut());
+	for (size_t i = 0; i < indices.len(); i++) {
+		auto index = indices.datum_type() == DatumType::I64 ? indices.as_ptr<int64_t>()[i]
+		                                                     : static_cast<int64_t>(indices.as_ptr<int32_t>()[i]);
+		if (index < -dim || index >= dim) {
+			std::ostringstream msg;
+			msg << "Gather index " << index << " is out of range for " << data_shape;
+			throw std::runtime_error(msg.str());
+		}
+		auto position = static_cast<size_t>(index < 0 ? index + dim : index);
+		for (size_t o = 0; o < outer; o++) {
+			std::memcpy(dst + (o * indices.len() + i) * slice, src + (o * dim + position) * slice, slice);
+		}
+	}
+	std::vector<TValue> outputs;
+	outputs.push_back(std::move(result));
+	return outputs;
+}
+
+TractResult<std::vector<TValue>> GatherOp::eval(const std::vector<TValue> &inputs) const {
+	return try_catch([&]() { return eval_impl(nullptr, inputs); });
+}
+
+TractResult<std::vector<TValue>> GatherOp::eval_with_session(SessionState &session, std::vector<TValue> inputs) const {
+	return try_catch([&]() { return eval_impl(&session, std::move(inputs)); });
+}
+
+std::vector<TValue> ConcatOp::eval_impl(SessionState *session, std::vector<TValue> inputs) const {
+	if (inputs.empty()) {
+		throw std::runtime_error("Concat expects at least 1 input");
+	}
+	auto &first = *inputs[0];
+	auto joined = resolve_axis(name(), axis, first.rank());
+	auto shape = first.shape();
+	shape[joined] = 0;
+	for (auto &input : inputs) {
+		auto &input_shape = input->shape();
+		bool compatible = input->datum_type() == first.datum_type() && input_shape.size() == shape.size();
+		for (size_t i = 0; compatible && i < shape.size(); i++) {
+			compatible = i == joined || input_shape[i] == shape[i];
+		}
+		if (!compatible) {
+			std::ostringstream msg;
+			msg << "Concat inputs " << first.shape() << " and " << input_shape << " do not match along axis " << axis;
+			throw std::runtime_error(msg.str());
+		}
+		shape[joined] += input_shape[joined];
+	}
+	TValue result = TValue::Var(output_tensor(session, 0, first.datum_type(), shape));
+
+	size_t outer = 1;
+	for (size_t i = 0; i < joined; i++) {
+		outer *= static_cast<size_t>(shape[i]);
+	}
+	auto out_row = outer ? result.tensor_->byte_len() / outer : 0;
+	auto dst = static_cast<char *>(result.tensor_->raw_data_mut());
+	size_t offset = 0;
+	for (auto &input : inputs) {
+		auto row = outer ? input->byte_len() / outer : 0;
+		auto src = static_cast<const char *>(input->raw_data());
+		for (size_t o = 0; o < outer; o++) {
+			std::memcpy(dst + o * out_row + offset, src + o * row, row);
+		}
+		offset += row;
+	}
+	std::vector<TValue> outputs;
+	outputs.push_back(std::move(result));
+	return outputs;
+}
+
+TractResult<std::vector<TValue>> ConcatOp::eval(const std::vector<TValue> &inputs) const {
+	return try_catch([&]() { return eval_impl(nullptr, inputs); });
+}
+
+TractResult<std::vector<TValue>> ConcatOp::eval_with_session(SessionState &session, std::vector<TValue> inputs) const {
+	return try_catch([&]() { return eval_impl(&session, std::move(inputs)); });
+}
+
+TractResult<std::vector<TypedFact>> GatherOp::output_facts(const std::vector<const TypedFact *> &inputs) const {
+	return try_catch([&]() {
+		if (inputs.size() != 2) {
+			throw std::runtime_error("Gather expects 2 inputs, got " + std::to_string(inputs.size()));
+		}
+		auto &data = *inputs[0];
+		auto &indices = *inputs[1];
+		auto fact = TypedFact::unknown(data.datum_type);
+		if (!data.rank_known || !indices.rank_known) {
+			return std::vector<TypedFact> {fact};
+		}
+		auto gathered = resolve_axis(name(), axis, data.shape.size());
+		std::vector<TDim> shape(data.shape.begin(), data.shape.begin() + gathered);
+		shape.insert(shape.end(), indices.shape.begin(), indices.shape.end());
+		shape.insert(shape.end(), data.shape.begin() + gathered + 1, data.shape.end());
+		fact = TypedFact(data.datum_type, std::move(shape));
+		// picking dimensions out of a Shape, e.g. the batch size
+		if (data.symbolic_value && data.shape.size() == 1 && indices.symbolic_value && fact.shape.size() <= 1) {
+			auto &values = *data.symbolic_value;
+			auto len = static_cast<int64_t>(values.size());
+			std::vector<TDim> picked;
+			for (auto &index : *indices.symbolic_value) {
+				auto position = index.is_int() && index.as_int() < 0 ? index.as_int() + len : index.as_int();
+				if (!index.is_int() || position < 0 || position >= len) {
+					return std::vector<TypedFact> {fact};
+				}
+				picked.push_back(values[position]);
+			}
+			fact.symbolic_value = std::move(picked);
+		}
+		return std::vector<TypedFact> {fact};
+	});
+}
+
+TractResult<std::vector<TypedFact>> ConcatOp::output_facts(const std::vector<const TypedFact *> &inputs) const {
+	return try_catch([&]() {
+		if (inputs.empty()) {
+			throw std::runtime_error("Concat expects at least 1 input");
+		}
+		auto &first = *inputs[0];
+		auto fact = TypedFact::unknown(first.datum_type);
+		if (!first.rank_known) {
+			return std::vector<TypedFact> {fact};
+		}
+		auto joined = resolve_axis(name(), axis, first.shape.size());
+		auto shape = first.shape;
+		shape[joined] = 0;
+		std::optional<std::vector<TDim>> value = std::vector<TDim>();
+		for (auto input : inputs) {
+			if (!input->rank_known) {
+				return std::vector<TypedFact> {TypedFact::unknown(first.datum_type)};
+			}
+			if (input->shape.size() != shape.size()) {
+				std::ostringstream msg;
+				msg << "Concat inputs " << first << " and " << *input << " do not match along axis " << axis;
+				throw std::runtime_error(msg.str());
+			}
+			shape[joined] = shape[joined] + input->shape[joined];
+			if (value && input->symbolic_value && shape.size() == 1) {
+				value->insert(value->end(), input->symbolic_value->begin(), input->symbolic_value->end());
+			} else {
+				value.reset();
+			}
+		}
+		fact = TypedFact(first.datum_type, std::move(shape));
+		fact.symbolic_value = std::move(value);
+		return std::vector<TypedFact> {fact};
+	});
+}
+
+bool ShapeOp::save(PlanWriter &writer) const {
+	writer.write_string("Shape");
+	writer.write_i64(start);
+	writer.write_i64(end);
+	return true;
+}
+
+std::shared_ptr<Op> ShapeOp::load(PlanReader &reader) {
+	auto start = reader.read_i64();
+	return std::make_shared<ShapeOp>(start, reader.read_i64());
+}
+
+bool GatherOp::save(PlanWriter &writer) const {
+	writer.write_string("Gather");
+	writer.write_i64(axis);
+	return true;
+}
+
+std::shared_ptr<Op> GatherOp::load(PlanReader &reader) {
+	return std::make_shared<GatherOp>(reader.read_i64());
+}
+
+bool ConcatOp::save(PlanWriter &writer) const {
+	writer.write_string("Concat");
+	writer.write_i64(axis);
+	return true;
+}
+
+std::shared_ptr<Op> ConcatOp::load(PlanReader &reader) {
+	return std::make_shared<ConcatOp>(reader.read_i64());
+}
+
+} // namespace duckdb_onnx
@@ -0,0 +1,135 @@
+#include "duckdb-onnx/core/ops/softmax.h"
+
+#include "duckdb-onnx/core/kernels/element_wise.hpp"
+#include "duckdb-onnx/core/kernels/reduce.hpp"
+#include "duckdb-onnx/core/plan_file.hpp"
+#include "duckdb-onnx/core/session.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+
+namespace duckdb_onnx {
+
+std::vector<TValue> SoftmaxOp::eval_impl(SessionState *session, std::vector<TValue> inputs) const {
+	if (inputs.size() != 1) {
+		throw std::runtime_error(name() + " expects 1 input, got " + std::to_string(inputs.size()));
+	}
+	auto &x = *inputs[0];
+	if (x.datum_type() != DatumType::F32) {
+		throw std::runtime_error(name() + " only supports F32, got " + datum_type_name(x.datum_type()));
+	}
+	auto rank = static_cast<int64_t>(x.rank());
+	auto resolved = axis < 0 ? axis + rank : axis;
+	if (resolved < 0 || resolved >= std::max<int64_t>(rank, 1)) {
+		std::ostringstream msg;
+		msg << name() << " axis " << axis << " is out of range for " << x.shape();
+		throw std::runtime_error(msg.str());
+	}
+	// the input as [outer, dim, inner], normalized along dim
+	size_t outer = 1;
+	size_t dim = 1;
+	size_t inner = 1;
+	for (int64_t i = 0; i < rank; i++) {
+		auto d = static_cast<size_t>(x.shape()[i]);
+		if (i < resolved) {
+			outer *= d;
+		} else if (i == resolved || coerce_2d) {
+			dim *= d;
+		} else {
+			inner *= d;
+		}
+	}
+
+	TValue result;
+	if (inputs[0].is_exclusive()) {
+		result = std::move(inputs[0]);
+	} else {
+		result = TValue::Var(output_tensor(session, 0, DatumType::F32, x.shape()));
+	}
+	// after an in-place move the input is the result itself
+	const Tensor *input = inputs[0].tensor_ ? inputs[0].tensor_.get() : result.tensor_.get();
+	auto src = input->as_ptr<float>();
+	auto dst = result.tensor_->as_ptr_mut<float>();
+	if (x.len() == 0) {
+		std::vector<TValue> outputs;
+		outputs.push_back(std::move(result));
+		return outputs;
+	}
+
+	if (inner == 1 && !log) {
+		// contiguous rows, normalized with the kernels
+		for (size_t row = 0; row < outer; row++) {
+			softmax_f32(dim, src + row * dim, dst + row * dim);
+		}
+	} else if (inner == 1) {
+		// contiguous rows: shift by the maximum, exponentiate and subtract the log of the sum with the kernels
+		auto sub = binary_kernel_f32(BinaryKind::Sub);
+		auto exp = unary_kernel_f32(UnaryKind::Exp);
+		std::vector<float> exps(dim);
+		for (size_t row = 0; row < outer; row++) {
+			auto in = src + row * dim;
+			auto out = dst + row * dim;
+			auto max = *std::max_element(in, in + dim);
+			sub(dim, in, 1, &max, 0, out);
+			exp(dim, out, exps.data());
+			float sum = 0;
+			for (size_t i = 0; i < dim; i++) {
+				sum += exps[i];
+			}
+			auto log_sum = std::log(sum);
+			sub(dim, out, 1, &log_sum, 0, out);
+		}
+	} else {
+		for (size_t row = 0; row < outer; row++) {
+			for (size_t j = 0; j < inner; j++) {
+				auto in = src + row * dim * inner + j;
+				auto out = dst + row * dim * inner + j;
+				auto max = in[0];
+				for (size_t i = 1; i < dim; i++) {
+					max = std::max(max, in[i * inner]);
+				}
+				float sum = 0;
+				for (size_t i = 0; i < dim; i++) {
+					sum += std::exp(in[i * inner] - max);
+				}
+				for (size_t i = 0; i < dim; i++) {
+					auto shifted = in[i * inner] - max;
+					out[i * inner] = log ? shifted - std::log(sum) : std::exp(shifted) / sum;
+				}
+			}
+		}
+	}
+	std::vector<TValue> outputs;
+	outputs.push_back(std::move(result));
+	return outputs;
+}
+
+TractResult<std::vector<TValue>> SoftmaxOp::eval(const std::vector<TValue> &inputs) const {
+	return try_catch([&]() { return eval_impl(nullptr, inputs); });
+}
+
+TractResult<std::vector<TValue>> SoftmaxOp::eval_with_session(SessionState &session, std::vector<TValue> inputs) const {
+	return try_catch([&]() { return eval_impl(&session, std::move(inputs)); });
+}
+
+TractResult<std::vector<TypedFact>> SoftmaxOp::output_facts(const std::vector<const TypedFact *> &inputs) const {
+	return same_as_input_facts(*this, inputs);
+}
+
+bool SoftmaxOp::save(PlanWriter &writer) const {
+	writer.write_string("Softmax");
+	writer.write_bool(log);
+	writer.write_i64(axis);
+	writer.write_bool(coerce_2d);
+	return true;
+}
+
+std::shared_ptr<Op> SoftmaxOp::load(PlanReader &reader) {
+	auto log = reader.read_bool();
+	auto axis = reader.read_i64();
+	return std::make_shared<SoftmaxOp>(log, axis, reader.read_bool());
+}
+
+} // namespace duckdb_onnx
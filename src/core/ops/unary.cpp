@@ -0,0 +1,183 @@
+#include "duckdb-onnx/core/ops/unary.h"
+
+#include "duckdb-onnx/core/plan_file.hpp"
+#include "duckdb-onnx/core/session.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <type_traits>
+
+namespace duckdb_onnx {
+
+/// The input itself when it is exclusive, or a new output tensor of the same type and shape
+static TValue unary_output(SessionState *session, TValue &input) {
+	if (input.is_exclusive()) {
+		return std::move(input);
+	}
+	return TValue::Var(output_tensor(session, 0, input->datum_type(), input->shape()));
+}
+
+std::string UnaryOp::name() const {
+	switch (kind) {
+	case UnaryKind::Relu:
+		return "Relu";
+	case UnaryKind::Sigmoid:
+		return "Sigmoid";
+	case UnaryKind::Tanh:
+		return "Tanh";
+	case UnaryKind::Exp:
+		return "Exp";
+	}
+	return "Unary";
+}
+
+std::vector<TValue> UnaryOp::eval_impl(SessionState *session, std::vector<TValue> inputs) const {
+	if (inputs.size() != 1) {
+		throw std::runtime_error(name() + " expects 1 input, got " + std::to_string(inputs.size()));
+	}
+	auto result = unary_output(session, inputs[0]);
+	// after an in-place move the input is the result itself
+	const Tensor *input = inputs[0].tensor_ ? inputs[0].tensor_.get() : result.tensor_.get();
+	auto out = result.tensor_.get();
+	auto dt = input->datum_type();
+
+	if (dt == DatumType::F32) {
+		unary_kernel_f32(kind)(input->len(), input->as_ptr<float>(), out->as_ptr_mut<float>());
+	} else {
+		dispatch_numbers(dt, [&](auto tag) {
+			using T = typename decltype(tag)::type;
+			if (!std::is_floating_point<T>::value && kind != UnaryKind::Relu) {
+				throw std::runtime_error(name() + " does not support " + datum_type_name(dt));
+			}
+			auto x = input->template as_ptr<T>();
+			auto y = out->template as_ptr_mut<T>();
+			for (size_t i = 0; i < input->len(); i++) {
+				switch (kind) {
+				case UnaryKind::Relu:
+					y[i] = x[i] < T(0) ? T(0) : x[i];
+					break;
+				case UnaryKind::Sigmoid:
+					y[i] = static_cast<T>(1 / (1 + std::exp(-static_cast<double>(x[i]))));
+					break;
+				case UnaryKind::Tanh:
+					y[i] = static_cast<T>(std::tanh(static_cast<double>(x[i])));
+					break;
+				case UnaryKind::Exp:
+					y[i] = static_cast<T>(std::exp(static_cast<double>(x[i])));
+					break;
+				}
+			}
+		});
+	}
+	std::vector<TValue> outputs;
+	outputs.push_back(std::move(result));
+	return outputs;
+}
+
+TractResult<std::vector<TValue>> UnaryOp::eval(const std::vector<TValue> &inputs) const {
+	return try_catch([&]() { return eval_impl(nullptr, inputs); });
+}
+
+TractResult<std::vector<TValue>> UnaryOp::eval_with_session(SessionState &session, std::vector<TValue> inputs) const {
+	return try_catch([&]() { return eval_impl(&session, std::move(inputs)); });
+}
+
+/// Value of a scalar bound input, converted to double
+static double scalar_bound(const Tensor &tensor) {
+	if (tensor.len() != 1) {
+		throw std::runtime_error("Clip bounds must be scalars");
+	}
+	return dispatch_numbers(tensor.datum_type(), [&](auto tag) {
+		using T = typename decltype(tag)::type;
+		return static_cast<double>(*tensor.template as_ptr<T>());
+	});
+}
+
+std::vector<TValue> ClipOp::eval_impl(SessionState *session, std::vector<TValue> inputs) const {
+	if (inputs.empty()) {
+		throw std::runtime_error("Clip expects an input");
+	}
+	auto lo = min;
+	auto hi = max;
+	if (min_input >= 0 && static_cast<size_t>(min_input) < inputs.size()) {
+		lo = scalar_bound(*inputs[min_input]);
+	}
+	if (max_input >= 0 && static_cast<size_t>(max_input) < inputs.size()) {
+		hi = scalar_bound(*inputs[max_input]);
+	}
+	inputs.resize(1);
+	auto result = unary_output(session, inputs[0]);
+	// after an in-place move the input is the result itself
+	const Tensor *input = inputs[0].tensor_ ? inputs[0].tensor_.get() : result.tensor_.get();
+	auto out = result.tensor_.get();
+	auto dt = input->datum_type();
+
+	if (dt == DatumType::F32) {
+		// the bounds saturate to the float range
+		auto flo = static_cast<float>(std::max<double>(lo, -std::numeric_limits<float>::infinity()));
+		auto fhi = static_cast<float>(std::min<double>(hi, std::numeric_limits<float>::infinity()));
+		clip_kernel_f32()(input->len(), input->as_ptr<float>(), flo, fhi, out->as_ptr_mut<float>());
+	} else {
+		dispatch_numbers(dt, [&](auto tag) {
+			using T = typename decltype(tag)::type;
+			auto tlo = lo <= static_cast<double>(std::numeric_limits<T>::lowest()) ? std::numeric_limits<T>::lowest()
+			                                                                       : static_cast<T>(lo);
+			auto thi = hi >= static_cast<double>(std::numeric_limits<T>::max()) ? std::numeric_limits<T>::max()
+			                                                                    : static_cast<T>(hi);
+			auto x = input->template as_ptr<T>();
+			auto y = out->template as_ptr_mut<T>();
+			for (size_t i = 0; i < input->len(); i++) {
+				y[i] = std::min(std::max(x[i], tlo), thi);
+			}
+		});
+	}
+	std::vector<TValue> outputs;
+	outputs.push_back(std::move(result));
+	return outputs;
+}
+
+TractResult<std::vector<TValue>> ClipOp::eval(const std::vector<TValue> &inputs) const {
+	return try_catch([&]() { return eval_impl(nullptr, inputs); });
+}
+
+TractResult<std::vector<TValue>> ClipOp::eval_with_session(SessionState &session, std::vector<TValue> inputs) const {
+	return try_catch([&]() { return eval_impl(&session, std::move(inputs)); });
+}
+
+TractResult<std::vector<TypedFact>> UnaryOp::output_facts(const std::vector<const TypedFact *> &inputs) const {
+	return same_as_input_facts(*this, inputs);
+}
+
+TractResult<std::vector<TypedFact>> ClipOp::output_facts(const std::vector<const TypedFact *> &inputs) const {
+	return same_as_input_facts(*this, inputs);
+}
+
+bool UnaryOp::save(PlanWriter &writer) const {
+	writer.write_string("Unary");
+	writer.write_u64(static_cast<uint64_t>(kind));
+	return true;
+}
+
+std::shared_ptr<Op> UnaryOp::load(PlanReader &reader) {
+	return std::make_shared<UnaryOp>(static_cast<UnaryKind>(reader.read_u64()));
+}
+
+bool ClipOp::save(PlanWriter &writer) const {
+	writer.write_string("Clip");
+	writer.write_f64(min);
+	writer.write_f64(max);
+	writer.write_i64(min_input);
+	writer.write_i64(max_input);
+	return true;
+}
+
+std::shared_ptr<Op> ClipOp::load(PlanReader &reader) {
+	auto min = reader.read_f64();
+	auto max = reader.read_f64();
+	auto min_input = static_cast<int>(reader.read_i64());
+	auto max_input = static_cast<int>(reader.read_i64());
+	return std::make_shared<ClipOp>(min, max, min_input, max_input);
+}
+
+} // namespace duckdb_onnx
@@ -0,0 +1,846 @@
+#include "duckdb-onnx/core/optim.hpp"
+
+#include "duckdb-onnx/core/ops/batch_norm.h"
+#include "duckdb-onnx/core/ops/binary.h"
+#include "duckdb-onnx/core/ops/cast.h"
+#include "duckdb-onnx/core/ops/conv.h"
+#include "duckdb-onnx/core/ops/fused.h"
+#include "duckdb-onnx/core/ops/identity.h"
+#include "duckdb-onnx/core/ops/konst.h"
+#include "duckdb-onnx/core/ops/matmul.h"
+#include "duckdb-onnx/core/ops/quant.h"
+#include "duckdb-onnx/core/ops/reshape.h"
+#include "duckdb-onnx/core/ops/shape.h"
+#include "duckdb-onnx/core/ops/softmax.h"
+#include "duckdb-onnx/core/ops/source.h"
+#include "duckdb-onnx/core/ops/unary.h"
+
+#include <algorithm>
+#include <map>
+#include <optional>
+#include <stdexcept>
+
+namespace duckdb_onnx {
+
+/// The value of `outlet` when it is produced by a ConstOp, else null
+static std::shared_ptr<Tensor> const_value(const TypedModel &model, OutletId outlet) {
+	auto konst = model.nodes[outlet.node].op.as<ConstOp>();
+	return konst ? konst->value : nullptr;
+}
+
+static bool is_model_output(const TypedModel &model, OutletId outlet) {
+	return std::find(model.outputs.begin(), model.outputs.end(), outlet) != model.outputs.end();
+}
+
+/// Whether `outlet` feeds exactly one input and is not a model output, so
+/// that its producer can be merged into that consumer
+static bool single_use(const TypedModel &model, OutletId outlet) {
+	return model.nodes[outlet.node].outputs[outlet.slot].successors.size() == 1 && !is_model_output(model, outlet);
+}
+
+/// Whether readers of `from` can read `to` instead. Two model outputs, or a
+/// model output and a model input, must stay distinct outlets.
+static bool replaceable(const TypedModel &model, OutletId from, OutletId to) {
+	if (!is_model_output(model, from)) {
+		return true;
+	}
+	auto inputs = model.inputs;
+	return !is_model_output(model, to) && std::find(inputs.begin(), inputs.end(), to) == inputs.end() &&
+	       !const_value(model, to);
+}
+
+/// Make every reader of `from`, including the model outputs, read `to`
+static void rewire(TypedModel &model, OutletId from, OutletId to) {
+	auto successors = model.nodes[from.node].outputs[from.slot].successors;
+	for (auto &inlet : successors) {
+		model.add_edge(to, inlet);
+	}
+	for (auto &output : model.outputs) {
+		if (output == from) {
+			output = to;
+			// the name of a model output wins over the name of the intermediate value taking its place
+			auto label = model.outlet_labels.find(from);
+			if (label != model.outlet_labels.end()) {
+				model.set_outlet_label(to, label->second);
+			}
+		}
+	}
+}
+
+static OutletId add_const(TypedModel &model, std::string name, std::shared_ptr<Tensor> value) {
+	auto fact = TypedFact::from_const(value);
+	return OutletId(model.add_node(std::move(name), OpBox(std::make_shared<ConstOp>(std::move(value))), {fact}), 0);
+}
+
+/// Drop the nodes that no model output depends on, keeping the model inputs,
+/// and renumber the others in their original order
+static void eliminate_dead_nodes(TypedModel &model) {
+	std::vector<bool> live(model.nodes.size(), false);
+	for (auto id : model.eval_order()) {
+		live[id] = true;
+	}
+	for (auto &input : model.inputs) {
+		live[input.node] = true;
+	}
+	std::vector<size_t> new_id(model.nodes.size(), SIZE_MAX);
+	std::vector<TypedNode> nodes;
+	for (size_t id = 0; id < model.nodes.size(); id++) {
+		if (live[id]) {
+			new_id[id] = nodes.size();
+			nodes.push_back(std::move(model.nodes[id]));
+		}
+	}
+	for (auto &node : nodes) {
+		node.id = new_id[node.id];
+		for (auto &input : node.inputs) {
+			input.node = new_id[input.node];
+		}
+		for (auto &outlet : node.outputs) {
+			std::vector<InletId> successors;
+			for (auto &inlet : outlet.successors) {
+				if (live[inlet.node]) {
+					successors.emplace_back(new_id[inlet.node], inlet.slot);
+				}
+			}
+			outlet.successors = std::move(successors);
+		}
+	}
+	model.nodes = std::move(nodes);
+	for (auto &input : model.inputs) {
+		input.node = new_id[input.node];
+	}
+	for (auto &output : model.outputs) {
+		output.node = new_id[output.node];
+	}
+	std::unordered_map<OutletId, std::string> labels;
+	for (auto &label : model.outlet_labels) {
+		if (live[label.first.node]) {
+			labels[OutletId(new_id[label.first.node], label.first.slot)] = label.second;
+		}
+	}
+	model.outlet_labels = std::move(labels);
+}
+
+static void remove_identities(TypedModel &model) {
+	for (auto id : model.eval_order()) {
+		auto &node = model.nodes[id];
+		if (!node.op.as<IdentityOp>() || node.inputs.size() != 1 || node.outputs.size() != 1) {
+			continue;
+		}
+		if (replaceable(model, OutletId(id, 0), node.inputs[0])) {
+			rewire(model, OutletId(id, 0), node.inputs[0]);
+		}
+	}
+}
+
+/// Let MatMul, Gemm and Conv read constant F16 and BF16 weights as they are
+/// rather than through a Cast to F32, which folding would turn into a copy
+/// twice their size: the GEMM widens them panel by panel as it reads them.
+static void read_half_weights(TypedModel &model) {
+	for (auto id : model.eval_order()) {
+		auto &node = model.nodes[id];
+		bool weighted = node.op.as<MatMulOp>() || node.op.as<GemmOp>() || node.op.as<ConvOp>();
+		if (!weighted || node.inputs.size() < 2 || model.outlet_fact(node.inputs[0]).datum_type != DatumType::F32) {
+			continue;
+		}
+		auto &cast = model.nodes[node.inputs[1].node];
+		auto cast_op = cast.op.as<CastOp>();
+		if (!cast_op || cast_op->to != DatumType::F32 || cast.inputs.size() != 1) {
+			continue;
+		}
+		auto weights = const_value(model, cast.inputs[0]);
+		if (weights && (weights->datum_type() == DatumType::F16 || weights->datum_type() == DatumType::BF16)) {
+			model.add_edge(cast.inputs[0], InletId(id, 1));
+		}
+	}
+}
+
+/// Evaluate once the nodes whose inputs are all constants
+static void fold_constants(TypedModel &model) {
+	for (auto id : model.eval_order()) {
+		auto &node = model.nodes[id];
+		if (node.inputs.empty() || node.op.as<ConstOp>() || node.op.as<SourceOp>() ||
+		    node.op->validation() == Validation::Random) {
+			continue;
+		}
+		std::vector<TValue> inputs;
+		for (auto &input : node.inputs) {
+			auto value = const_value(model, input);
+			if (!value) {
+				break;
+			}
+			inputs.push_back(TValue::Const(value));
+		}
+		if (inputs.size() != node.inputs.size()) {
+			continue;
+		}
+		// failures are left for the op to report when the model runs
+		auto outputs = node.op->eval(inputs);
+		if (outputs.is_err() || outputs.value().size() != node.outputs.size()) {
+			continue;
+		}
+		auto values = outputs.value_move();
+		auto name = node.name;
+		for (size_t slot = 0; slot < values.size(); slot++) {
+			auto konst = add_const(model, slot ? name + "." + std::to_string(slot) : name, values[slot].tensor_);
+			rewire(model, OutletId(id, slot), konst);
+		}
+	}
+}
+
+/// Merge nodes computing the same op of the same inputs
+static void eliminate_common_subexpressions(TypedModel &model) {
+	std::map<std::vector<OutletId>, std::vector<size_t>> by_inputs;
+	for (auto id : model.eval_order()) {
+		auto &node = model.nodes[id];
+		if (node.inputs.empty() || node.op->validation() == Validation::Random) {
+			continue;
+		}
+		auto &candidates = by_inputs[node.inputs];
+		bool merged = false;
+		for (auto other : candidates) {
+			auto &kept = model.nodes[other];
+			if (kept.outputs.size() != node.outputs.size() || !node.op->same_as(kept.op.get())) {
+				continue;
+			}
+			bool all_replaceable = true;
+			for (size_t slot = 0; slot < node.outputs.size(); slot++) {
+				all_replaceable &= replaceable(model, OutletId(id, slot), OutletId(other, slot));
+			}
+			if (!all_replaceable) {
+				continue;
+			}
+			for (size_t slot = 0; slot < node.outputs.size(); slot++) {
+				rewire(model, OutletId(id, slot), OutletId(other, slot));
+			}
+			merged = true;
+			break;
+		}
+		if (!merged) {
+			candidates.push_back(id);
+		}
+	}
+}
+
+/// Fold the addition of a constant with one value per output channel (or a
+/// single value), as exported for Conv without bias, into the Conv bias
+static void fuse_conv_bias(TypedModel &model) {
+	for (auto id : model.eval_order()) {
+		auto &add = model.nodes[id];
+		auto add_op = add.op.as<BinaryOp>();
+		if (!add_op || add_op->kind != BinaryKind::Add || add.inputs.size() != 2) {
+			continue;
+		}
+		for (size_t side = 0; side < 2; side++) {
+			auto conv_out = add.inputs[side];
+			auto addend = const_value(model, add.inputs[1 - side]);
+			auto &conv = model.nodes[conv_out.node];
+			auto conv_op = conv.op.as<ConvOp>();
+			if (!conv_op || conv_op->epilogue || !addend || addend->datum_type() != DatumType::F32 ||
+			    !single_use(model, conv_out)) {
+				continue;
+			}
+			auto filters = conv.inputs.size() >= 2 ? const_value(model, conv.inputs[1]) : nullptr;
+			auto bias = conv.inputs.size() == 3 ? const_value(model, conv.inputs[2]) : nullptr;
+			if (!filters || filters->rank() < 3 || (conv.inputs.size() == 3 && !bias)) {
+				continue;
+			}
+			// the addend must broadcast along every axis of the output but the channels
+			auto rank = filters->rank();
+			auto channels = static_cast<size_t>(filters->shape()[0]);
+			bool per_channel = addend->rank() <= rank;
+			for (size_t i = 0; i < addend->rank() && per_channel; i++) {
+				auto dim = addend->shape()[i];
+				per_channel = dim == 1 || (i + rank - addend->rank() == 1 && static_cast<size_t>(dim) == channels);
+			}
+			if (!per_channel || (bias && (bias->datum_type() != DatumType::F32 || bias->len() != channels))) {
+				continue;
+			}
+			auto summed = std::make_shared<Tensor>(
+			    Tensor::uninitialized(DatumType::F32, ShapeVec {static_cast<int64_t>(channels)}));
+			for (size_t c = 0; c < channels; c++) {
+				auto b = bias ? bias->as_ptr<float>()[c] : 0.0f;
+				summed->as_ptr_mut<float>()[c] = b + addend->as_ptr<float>()[addend->len() == 1 ? 0 : c];
+			}
+			auto bias_outlet = add_const(model, model.nodes[conv_out.node].name + ".bias", summed);
+			model.add_edge(bias_outlet, InletId(conv_out.node, 2));
+			rewire(model, OutletId(id, 0), conv_out);
+			break;
+		}
+	}
+}
+
+/// Fold a BatchNormalization with constant statistics into the filters and
+/// bias of the Conv feeding it: W'[oc] = W[oc] * a[oc], b'[oc] = b[oc] * a[oc] + c[oc]
+static void fold_batch_norms(TypedModel &model) {
+	for (auto id : model.eval_order()) {
+		auto &norm = model.nodes[id];
+		auto norm_op = norm.op.as<BatchNormOp>();
+		if (!norm_op || norm.inputs.size() != 5) {
+			continue;
+		}
+		auto conv_out = norm.inputs[0];
+		auto conv_op = model.nodes[conv_out.node].op.as<ConvOp>();
+		if (!conv_op || conv_op->epilogue || !single_use(model, conv_out)) {
+			continue;
+		}
+		auto &conv = model.nodes[conv_out.node];
+		auto filters = conv.inputs.size() >= 2 ? const_value(model, conv.inputs[1]) : nullptr;
+		auto bias = conv.inputs.size() == 3 ? const_value(model, conv.inputs[2]) : nullptr;
+		auto filters_type = filters ? filters->datum_type() : DatumType::F32;
+		if (!filters || filters->rank() < 1 ||
+		    (filters_type != DatumType::F32 && filters_type != DatumType::F16 && filters_type != DatumType::BF16) ||
+		    (conv.inputs.size() == 3 && (!bias || bias->datum_type() != DatumType::F32))) {
+			continue;
+		}
+		std::shared_ptr<Tensor> stats[4];
+		for (size_t i = 0; i < 4; i++) {
+			stats[i] = const_value(model, norm.inputs[i + 1]);
+		}
+		if (!stats[0] || !stats[1] || !stats[2] || !stats[3]) {
+			continue;
+		}
+		auto channels = static_cast<size_t>(filters->shape()[0]);
+		std::vector<float> coefficients;
+		try {
+			coefficients = batch_norm_coefficients(*stats[0], *stats[1], *stats[2], *stats[3], norm_op->epsilon);
+		} catch (std::exception &) {
+			continue;
+		}
+		if (coefficients.size() != 2 * channels || (bias && bias->len() != channels)) {
+			continue;
+		}
+		// 16-bit filters are scaled in F32, then rounded back to their type
+		if (filters_type != DatumType::F32) {
+			auto widened = std::make_shared<Tensor>(Tensor::uninitialized(DatumType::F32, filters->shape()));
+			cast_elements(*filters, *widened);
+			filters = widened;
+		}
+		auto folded_filters = std::make_shared<Tensor>(Tensor::uninitialized(DatumType::F32, filters->shape()));
+		auto per_channel = channels ? filters->len() / channels : 0;
+		auto folded_bias = std::make_shared<Tensor>(
+		    Tensor::uninitialized(DatumType::F32, ShapeVec {static_cast<int64_t>(channels)}));
+		for (size_t c = 0; c < channels; c++) {
+			auto multiplier = coefficients[c];
+			auto src = filters->as_ptr<float>() + c * per_channel;
+			auto dst = folded_filters->as_ptr_mut<float>() + c * per_channel;
+			for (size_t i = 0; i < per_channel; i++) {
+				dst[i] = src[i] * multiplier;
+			}
+			auto b = bias ? bias->as_ptr<float>()[c] : 0.0f;
+			folded_bias->as_ptr_mut<float>()[c] = b * multiplier + coefficients[channels + c];
+		}
+		if (filters_type != DatumType::F32) {
+			auto narrowed = std::make_shared<Tensor>(Tensor::uninitialized(filters_type, filters->shape()));
+			cast_elements(*folded_filters, *narrowed);
+			folded_filters = narrowed;
+		}
+		auto conv_id = conv_out.node;
+		auto name = model.nodes[conv_id].name;
+		auto filters_outlet = add_const(model, name + ".filters", folded_filters);
+		auto bias_outlet = add_const(model, name + ".bias", folded_bias);
+		model.add_edge(filters_outlet, InletId(conv_id, 1));
+		model.add_edge(bias_outlet, InletId(conv_id, 2));
+		rewire(model, OutletId(id, 0), conv_out);
+	}
+}
+
+/// Turn MatMul(A, B) + c, with a constant 2-D B and a constant c of one value
+/// per column, into MatMul(A, B, c) which starts its output from the bias.
+/// A [1, n] c qualifies when the product is known to have 2 dimensions or more.
+static void fuse_matmul_bias(TypedModel &model) {
+	for (auto id : model.eval_order()) {
+		auto &add = model.nodes[id];
+		auto add_op = add.op.as<BinaryOp>();
+		if (!add_op || add_op->kind != BinaryKind::Add || add.inputs.size() != 2) {
+			continue;
+		}
+		for (size_t side = 0; side < 2; side++) {
+			auto product = add.inputs[side];
+			auto bias = const_value(model, add.inputs[1 - side]);
+			auto &matmul = model.nodes[product.node];
+			auto matmul_op = matmul.op.as<MatMulOp>();
+			if (!matmul_op || matmul_op->epilogue || matmul.inputs.size() != 2 || !bias ||
+			    !single_use(model, product)) {
+				continue;
+			}
+			auto weights = const_value(model, matmul.inputs[1]);
+			auto &fact = model.outlet_fact(product);
+			bool row = bias->rank() == 2 && bias->shape()[0] == 1 && fact.rank_known && fact.shape.size() >= 2;
+			if (!weights || weights->rank() != 2 || (bias->rank() != 1 && !row) ||
+			    bias->datum_type() != fact.datum_type || bias->shape().back() != weights->shape()[1]) {
+				continue;
+			}
+			auto bias_outlet = add.inputs[1 - side];
+			if (row) {
+				auto vector = Tensor::from_blob(bias->datum_type(), ShapeVec {bias->shape()[1]}, bias->blob());
+				bias_outlet = add_const(model, model.nodes[bias_outlet.node].name + ".row",
+				                        std::make_shared<Tensor>(std::move(vector)));
+			}
+			model.add_edge(bias_outlet, InletId(product.node, 2));
+			rewire(model, OutletId(id, 0), product);
+			break;
+		}
+	}
+}
+
+/// The step `node` performs as part of an element-wise chain, and the
+/// computed input it reads; false when it cannot join one
+static bool chain_step(const TypedModel &model, const TypedNode &node, OutletId &data,
+                       ElementwiseChain::Step &step) {
+	if (node.outputs.size() != 1 || node.inputs.empty()) {
+		return false;
+	}
+	if (node.op.as<UnaryOp>() && node.inputs.size() == 1) {
+		step.op = std::shared_ptr<Op>(node.op->clone());
+	} else if (auto clip = node.op.as<ClipOp>()) {
+		// bounds read from constant inputs become fixed
+		double bounds[2] = {clip->min, clip->max};
+		int bound_inputs[2] = {clip->min_input, clip->max_input};
+		for (size_t i = 0; i < 2; i++) {
+			if (bound_inputs[i] < 0 || static_cast<size_t>(bound_inputs[i]) >= node.inputs.size()) {
+				continue;
+			}
+			auto bound = const_value(model, node.inputs[bound_inputs[i]]);
+			if (!bound || bound->datum_type() != DatumType::F32 || bound->len() != 1) {
+				return false;
+			}
+			bounds[i] = *bound->as_ptr<float>();
+		}
+		step.op = std::make_shared<ClipOp>(bounds[0], bounds[1]);
+	} else if (node.op.as<BinaryOp>() && node.inputs.size() == 2) {
+		auto first = const_value(model, node.inputs[0]);
+		auto second = const_value(model, node.inputs[1]);
+		if ((first != nullptr) == (second != nullptr)) {
+			return false;
+		}
+		step.op = std::shared_ptr<Op>(node.op->clone());
+		step.operand = first ? first : second;
+		step.operand_first = first != nullptr;
+		data = node.inputs[first ? 1 : 0];
+		return ElementwiseChain::fusible(*step.op, step.operand.get());
+	} else {
+		return false;
+	}
+	data = node.inputs[0];
+	return !const_value(model, data) && ElementwiseChain::fusible(*step.op, nullptr);
+}
+
+/// The chain of element-wise nodes reading `from` one after the other, each
+/// the only reader of the previous one. Returns the output of the last one.
+static OutletId follow_chain(const TypedModel &model, OutletId from, ElementwiseChain &chain,
+                             std::vector<size_t> &members) {
+	while (single_use(model, from)) {
+		auto next = model.nodes[from.node].outputs[from.slot].successors[0].node;
+		OutletId data;
+		ElementwiseChain::Step step;
+		if (!chain_step(model, model.nodes[next], data, step) || data != from) {
+			break;
+		}
+		chain.push(std::move(step));
+		members.push_back(next);
+		from = OutletId(next, 0);
+	}
+	return from;
+}
+
+/// Let Conv, MatMul and Gemm apply the element-wise ops following them on
+/// their output while it is still in cache
+static void fuse_epilogues(TypedModel &model) {
+	for (auto id : model.eval_order()) {
+		auto &node = model.nodes[id];
+		if (node.outputs.size() != 1) {
+			continue;
+		}
+		auto conv = node.op.as<ConvOp>();
+		auto matmul = node.op.as<MatMulOp>();
+		auto gemm = node.op.as<GemmOp>();
+		if (!(conv && !conv->epilogue) && !(matmul && !matmul->epilogue) && !(gemm && !gemm->epilogue)) {
+			continue;
+		}
+		ElementwiseChain chain;
+		std::vector<size_t> members;
+		auto last = follow_chain(model, OutletId(id, 0), chain, members);
+		if (chain.empty()) {
+			continue;
+		}
+		auto epilogue = std::make_shared<const ElementwiseChain>(std::move(chain));
+		auto op = model.nodes[id].op.as_mut();
+		if (auto fused_conv = dynamic_cast<ConvOp *>(op)) {
+			fused_conv->epilogue = epilogue;
+		} else if (auto fused_matmul = dynamic_cast<MatMulOp *>(op)) {
+			fused_matmul->epilogue = epilogue;
+		} else {
+			dynamic_cast<GemmOp &>(*op).epilogue = epilogue;
+		}
+		rewire(model, last, OutletId(id, 0));
+	}
+}
+
+/// Replace runs of two or more element-wise nodes by one FusedElementwiseOp
+static void fuse_elementwise_chains(TypedModel &model) {
+	std::vector<bool> fused(model.nodes.size(), false);
+	for (auto id : model.eval_order()) {
+		if (fused[id]) {
+			continue;
+		}
+		OutletId data;
+		ElementwiseChain::Step step;
+		if (!chain_step(model, model.nodes[id], data, step)) {
+			continue;
+		}
+		ElementwiseChain chain;
+		chain.push(std::move(step));
+		std::vector<size_t> members;
+		auto last = follow_chain(model, OutletId(id, 0), chain, members);
+		if (members.empty()) {
+			continue;
+		}
+		for (auto member : members) {
+			fused[member] = true;
+		}
+		auto name = model.nodes[last.node].name;
+		auto fact = model.outlet_fact(last);
+		auto node = model.add_node(name, OpBox(std::make_shared<FusedElementwiseOp>(std::move(chain))), {fact});
+		model.add_edge(data, InletId(node, 0));
+		rewire(model, last, OutletId(node, 0));
+	}
+}
+
+void optimize(TypedModel &model) {
+	// each pass leaves the nodes it replaced unreachable; they are dropped
+	// before the next one so that successor counts are accurate
+	for (auto pass : {remove_identities, read_half_weights, fold_constants, eliminate_common_subexpressions,
+	                  fuse_conv_bias, fold_batch_norms, fuse_matmul_bias, fuse_epilogues, fuse_elementwise_chains}) {
+		pass(model);
+		eliminate_dead_nodes(model);
+	}
+}
+
+void select_outputs(TypedModel &model, std::vector<OutletId> outputs) {
+	model.outputs = std::move(outputs);
+	eliminate_dead_nodes(model);
+}
+
+/// `inferred`, with the dimensions it leaves unknown taken from `declared`
+static TypedFact merge_facts(TypedFact inferred, const TypedFact &declared) {
+	if (!inferred.rank_known) {
+		return declared;
+	}
+	if (declared.rank_known && declared.shape.size() == inferred.shape.size()) {
+		for (size_t i = 0; i < inferred.shape.size(); i++) {
+			if (!inferred.shape[i].known()) {
+				inferred.shape[i] = declared.shape[i];
+			}
+		}
+	}
+	return inferred;
+}
+
+void infer_facts(TypedModel &model) {
+	for (auto id : model.eval_order()) {
+		auto &node = model.nodes[id];
+		if (node.op.as<SourceOp>() || node.op.as<ConstOp>()) {
+			continue;
+		}
+		std::vector<const TypedFact *> inputs;
+		for (auto &input : node.inputs) {
+			inputs.push_back(&model.outlet_fact(input));
+		}
+		auto facts = node.op->output_facts(inputs);
+		if (facts.is_err()) {
+			throw std::runtime_error("Cannot infer the output of node " + node.name + " (" + node.op->name() +
+			                         "): " + facts.error().what());
+		}
+		auto inferred = facts.value_move();
+		// ops that infer nothing keep the facts declared by the model
+		if (inferred.size() != node.outputs.size()) {
+			continue;
+		}
+		for (size_t slot = 0; slot < inferred.size(); slot++) {
+			node.outputs[slot].fact = merge_facts(std::move(inferred[slot]), node.outputs[slot].fact);
+		}
+	}
+}
+
+std::vector<TypedFact> infer_output_facts(const TypedModel &model, const std::vector<TypedFact> &inputs) {
+	if (inputs.size() != model.inputs.size()) {
+		throw std::invalid_argument("Expected facts for " + std::to_string(model.inputs.size()) + " inputs, got " +
+		                            std::to_string(inputs.size()));
+	}
+	TypedModel copy(model);
+	for (size_t i = 0; i < inputs.size(); i++) {
+		copy.outlet_fact_mut(copy.inputs[i]) = inputs[i];
+	}
+	infer_facts(copy);
+	std::vector<TypedFact> outputs;
+	for (auto &output : copy.outputs) {
+		outputs.push_back(copy.outlet_fact(output));
+	}
+	return outputs;
+}
+
+/// Whether `axis`, possibly negative, is the first axis of a shape of rank `rank`
+static bool is_leading_axis(int64_t axis, size_t rank) {
+	return axis == 0 || axis == -static_cast<int64_t>(rank);
+}
+
+/// Whether the matrix product or convolution `node` computes each sample from the same sample of its inputs, given
+/// which of its inputs `reads_samples`. The filters of a convolution and a right-hand side matrix are contracted along
+/// their leading dimension; a right-hand side stack of matrices is not, when the left-hand side is constant or a stack
+/// of the same rank.
+template <class READS_SAMPLES>
+static bool products_keep_samples(const TypedModel &model, const TypedNode &node, const READS_SAMPLES &reads_samples) {
+	size_t rhs;
+	if (node.op.as<MatMulOp>() || node.op.as<GemmOp>()) {
+		rhs = 1;
+	} else if (auto qmatmul = node.op.as<QMatMulOp>()) {
+		rhs = qmatmul->requantize ? 3 : 1;
+	} else if (node.op.as<ConvOp>()) {
+		return node.inputs.size() < 2 || !reads_samples(node.inputs[1]);
+	} else if (node.op.as<QLinearConvOp>()) {
+		return node.inputs.size() < 4 || !reads_samples(node.inputs[3]);
+	} else {
+		return true;
+	}
+	if (node.inputs.size() <= rhs || !reads_samples(node.inputs[rhs])) {
+		return true;
+	}
+	auto &b = model.outlet_fact(node.inputs[rhs]);
+	if (node.op.as<GemmOp>() || !b.rank_known || b.shape.size() < 3) {
+		return false;
+	}
+	if (!reads_samples(node.inputs[0])) {
+		return true;
+	}
+	auto &a = model.outlet_fact(node.inputs[0]);
+	return a.rank_known && a.shape.size() == b.shape.size();
+}
+
+std::optional<std::vector<std::vector<int64_t>>>
+batch_output_shapes(const TypedModel &model, const std::vector<std::vector<int64_t>> &sample_shapes) {
+	if (sample_shapes.size() != model.inputs.size()) {
+		return std::nullopt;
+	}
+	// a symbol no model declares: an output only gets it from what its ops infer, never from a declared fact
+	auto batch = TDim::symbol("__batch");
+	std::vector<TypedFact> inputs;
+	for (size_t i = 0; i < sample_shapes.size(); i++) {
+		auto &declared = model.outlet_fact(model.inputs[i]);
+		auto &shape = sample_shapes[i];
+		if (shape.empty() || shape[0] != 1 || !declared.rank_known || declared.shape.size() != shape.size() ||
+		    (declared.shape[0].is_int() && declared.shape[0].as_int() != 1)) {
+			return std::nullopt;
+		}
+		std::vector<TDim> dims {batch};
+		dims.insert(dims.end(), shape.begin() + 1, shape.end());
+		inputs.emplace_back(declared.datum_type, std::move(dims));
+	}
+	TypedModel batched(model);
+	for (size_t i = 0; i < inputs.size(); i++) {
+		batched.outlet_fact_mut(batched.inputs[i]) = inputs[i];
+	}
+	try {
+		infer_facts(batched);
+	} catch (std::exception &) {
+		// a batch the ops reject: the samples run one at a time, and report the error if it is theirs
+		return std::nullopt;
+	}
+	// every tensor computed from the inputs keeps the batch as leading dimension, so that sample i only ever reads
+	// row i of the tensors before it; shape computations and constants are not per sample
+	std::vector<bool> per_sample(batched.nodes.size(), false);
+	for (auto &input : batched.inputs) {
+		per_sample[input.node] = true;
+	}
+	auto reads_samples = [&](OutletId outlet) {
+		auto &fact = batched.outlet_fact(outlet);
+		return per_sample[outlet.node] && !fact.konst && !fact.symbolic_value;
+	};
+	for (auto id : batched.eval_order()) {
+		auto &node = batched.nodes[id];
+		for (auto &input : node.inputs) {
+			per_sample[id] = per_sample[id] || reads_samples(input);
+		}
+		if (!per_sample[id]) {
+			continue;
+		}
+		for (size_t slot = 0; slot < node.outputs.size(); slot++) {
+			auto &fact = node.outputs[slot].fact;
+			if (reads_samples(OutletId(id, slot)) &&
+			    (!fact.rank_known || fact.shape.empty() || fact.shape[0] != batch)) {
+				return std::nullopt;
+			}
+		}
+		// ops that keep the shape but combine the values along the leading dimension
+		auto softmax = node.op.as<SoftmaxOp>();
+		if (softmax && is_leading_axis(softmax->axis, node.outputs[0].fact.shape.size())) {
+			return std::nullopt;
+		}
+		auto gather = node.op.as<GatherOp>();
+		if (gather && reads_samples(node.inputs[0]) &&
+		    is_leading_axis(gather->axis, batched.outlet_fact(node.inputs[0]).shape.size())) {
+			return std::nullopt;
+		}
+		// products that contract the leading dimension of an operand, as Gemm(X, X, transB=1) multiplies every
+		// sample with all the others
+		if (!products_keep_samples(batched, node, reads_samples)) {
+			return std::nullopt;
+		}
+	}
+	std::vector<std::vector<int64_t>> result;
+	for (auto &output_id : batched.outputs) {
+		auto &output = batched.outlet_fact(output_id);
+		if (!output.rank_known || output.shape.empty() || output.shape[0] != batch) {
+			return std::nullopt;
+		}
+		std::vector<int64_t> shape {1};
+		for (size_t axis = 1; axis < output.shape.size(); axis++) {
+			if (!output.shape[axis].is_int()) {
+				return std::nullopt;
+			}
+			shape.push_back(output.shape[axis].as_int());
+		}
+		result.push_back(std::move(shape));
+	}
+	return result;
+}
+
+bool batch_outputs_match(const std::vector<TValue> &outputs, size_t batch_size,
+                         const std::vector<std::vector<int64_t>> &sample_shapes) {
+	if (outputs.size() != sample_shapes.size()) {
+		return false;
+	}
+	for (size_t i = 0; i < outputs.size(); i++) {
+		auto &shape = outputs[i]->shape();
+		auto &sample_shape = sample_shapes[i];
+		if (shape.size() != sample_shape.size() || shape[0] != static_cast<int64_t>(batch_size) ||
+		    !std::equal(shape.begin() + 1, shape.end(), sample_shape.begin() + 1)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/// The integer elements of `fact`, when it is a small integer tensor whose
+/// value does not depend on a symbol
+static std::shared_ptr<Tensor> concrete_value(const TypedFact &fact) {
+	if (!fact.symbolic_value || !fact.rank_known || fact.shape.size() > 1 ||
+	    (fact.datum_type != DatumType::I64 && fact.datum_type != DatumType::I32)) {
+		return nullptr;
+	}
+	std::vector<int64_t> values;
+	for (auto &dim : *fact.symbolic_value) {
+		if (!dim.is_int()) {
+			return nullptr;
+		}
+		values.push_back(dim.as_int());
+	}
+	ShapeVec shape;
+	if (fact.shape.size() == 1) {
+		shape.push_back(static_cast<int64_t>(values.size()));
+	} else if (values.size() != 1) {
+		return nullptr;
+	}
+	if (fact.datum_type == DatumType::I64) {
+		return std::make_shared<Tensor>(Tensor::from_vec(shape, values));
+	}
+	return std::make_shared<Tensor>(Tensor::from_vec(shape, std::vector<int32_t>(values.begin(), values.end())));
+}
+
+/// A fixed Reshape target equivalent to the symbolic `target` for an input
+/// of shape `input`: symbolic dimensions the input has at the same position
+/// are copied (0) and one other may be inferred (-1)
+static std::optional<ShapeVec> static_reshape_target(const std::vector<TDim> &target, const TypedFact &input) {
+	ShapeVec result;
+	bool inferred = false;
+	for (auto &dim : target) {
+		if (dim.is_int()) {
+			inferred |= dim.as_int() == -1;
+		}
+	}
+	for (size_t i = 0; i < target.size(); i++) {
+		auto &dim = target[i];
+		if (dim.is_int()) {
+			result.push_back(dim.as_int());
+		} else if (input.rank_known && i < input.shape.size() && input.shape[i] == dim) {
+			result.push_back(0);
+		} else if (!inferred) {
+			result.push_back(-1);
+			inferred = true;
+		} else {
+			return std::nullopt;
+		}
+	}
+	return result;
+}
+
+std::shared_ptr<TypedModel> specialize(const TypedModel &model) {
+	auto specialized = std::make_shared<TypedModel>(model);
+	auto &graph = *specialized;
+	bool changed = false;
+	for (auto id : graph.eval_order()) {
+		if (graph.nodes[id].op.as<ConstOp>() || graph.nodes[id].op.as<SourceOp>()) {
+			continue;
+		}
+		auto name = graph.nodes[id].name;
+		for (size_t slot = 0; slot < graph.nodes[id].outputs.size(); slot++) {
+			auto value = concrete_value(graph.nodes[id].outputs[slot].fact);
+			if (value && !is_model_output(graph, OutletId(id, slot))) {
+				auto konst = add_const(graph, slot ? name + "." + std::to_string(slot) : name, std::move(value));
+				rewire(graph, OutletId(id, slot), konst);
+				changed = true;
+			}
+		}
+		// a target computed from the input shape, such as [N, -1]
+		auto reshape = graph.nodes[id].op.as<ReshapeOp>();
+		if (!reshape || reshape->shape || graph.nodes[id].inputs.size() != 2) {
+			continue;
+		}
+		auto data = graph.nodes[id].inputs[0];
+		auto &spec = graph.outlet_fact(graph.nodes[id].inputs[1]);
+		if (!spec.symbolic_value || concrete_value(spec)) {
+			continue;
+		}
+		auto target = static_reshape_target(*spec.symbolic_value, graph.outlet_fact(data));
+		if (!target || (reshape->allow_zero && std::count(target->begin(), target->end(), 0))) {
+			continue;
+		}
+		auto fact = graph.nodes[id].outputs[0].fact;
+		auto node = graph.add_node(name, OpBox(std::make_shared<ReshapeOp>(std::move(*target))), {fact});
+		graph.add_edge(data, InletId(node, 0));
+		rewire(graph, OutletId(id, 0), OutletId(node, 0));
+		changed = true;
+	}
+	if (!changed) {
+		return nullptr;
+	}
+	eliminate_dead_nodes(graph);
+	for (auto pass : {fold_constants, eliminate_common_subexpressions}) {
+		pass(graph);
+		eliminate_dead_nodes(graph);
+	}
+	return specialized;
+}
+
+void codegen(TypedModel &model) {
+	for (auto &node : model.nodes) {
+		if (!node.op) {
+			continue;
+		}
+		std::vector<std::shared_ptr<Tensor>> constants;
+		bool has_constant = false;
+		for (auto &input : node.inputs) {
+			auto konst = model.nodes[input.node].op.as<ConstOp>();
+			constants.push_back(konst ? konst->value : nullptr);
+			has_constant |= konst != nullptr;
+		}
+		if (!has_constant) {
+			continue;
+		}
+		if (auto op = node.op->codegen(constants)) {
+			node.op = OpBox(std::move(op));
+		}
+	}
+}
+
+} // namespace duckdb_onnx
@@ -0,0 +1,25 @@
+#include "duckdb-onnx/core/parallel.hpp"
+
+#include <algorithm>
+
+namespace duckdb_onnx {
+
+size_t parallel_parts(const TaskRunner *runner, size_t work, size_t min_work) {
+	if (!runner) {
+		return 1;
+	}
+	return std::max<size_t>(1, std::min(runner->thread_count(), work / std::max<size_t>(min_work, 1)));
+}
+
+void parallel_for(TaskRunner *runner, size_t count, size_t parts, const std::function<void(size_t, size_t)> &task) {
+	parts = std::min(parts, count);
+	if (!runner || parts <= 1) {
+		if (count) {
+			task(0, count);
+		}
+		return;
+	}
+	runner->run(parts, [&](size_t part) { task(part * count / parts, (part + 1) * count / parts); });
+}
+
+} // namespace duckdb_onnx
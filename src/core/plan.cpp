@@ -0,0 +1,615 @@
+#include "duckdb-onnx/core/plan.hpp"
+
+#include "duckdb-onnx/core/ops/konst.h"
+#include "duckdb-onnx/core/ops/source.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace duckdb_onnx {
+
+/// Size of the tensors of `fact`, possibly in terms of symbols
+static TDim fact_bytes(const TypedFact &fact) {
+	return fact.len() * TDim(static_cast<int64_t>(datum_type_size(fact.datum_type)));
+}
+
+TractResult<std::shared_ptr<SimplePlan>> SimplePlan::build(std::shared_ptr<const TypedModel> model,
+                                                           std::shared_ptr<const TypedModel> specialized) {
+	return try_catch([&]() {
+		std::shared_ptr<SimplePlan> plan(new SimplePlan());
+		plan->model_ = model;
+		if (specialized) {
+			auto result = build(std::move(specialized));
+			if (result.is_err()) {
+				throw std::runtime_error("Specialized plan: " + result.error().what());
+			}
+			plan->specialized_ = result.value_move();
+		}
+		auto order = model->eval_order();
+
+		// one slot per outlet; inputs first so that unused inputs still get one
+		std::vector<size_t> first_slot(model->nodes.size(), SIZE_MAX);
+		auto assign = [&](size_t node) {
+			if (first_slot[node] == SIZE_MAX) {
+				first_slot[node] = plan->slot_count_;
+				plan->slot_count_ += model->nodes[node].outputs.size();
+			}
+		};
+		for (auto &input : model->inputs) {
+			assign(input.node);
+		}
+		for (auto node : order) {
+			assign(node);
+		}
+		auto slot_of = [&](OutletId outlet) { return first_slot[outlet.node] + outlet.slot; };
+
+		for (auto &input : model->inputs) {
+			plan->input_slots_.push_back(slot_of(input));
+		}
+		for (auto &output : model->outputs) {
+			plan->output_slots_.push_back(slot_of(output));
+		}
+
+		std::vector<bool> pinned(plan->slot_count_, false);
+		for (auto slot : plan->output_slots_) {
+			pinned[slot] = true;
+		}
+		for (auto node_id : order) {
+			auto &node = model->nodes[node_id];
+			if (node.op.as<SourceOp>()) {
+				continue;
+			}
+			if (auto konst = node.op.as<ConstOp>()) {
+				plan->constants_.emplace_back(slot_of(OutletId(node_id, 0)), TValue::Const(konst->value));
+				pinned[slot_of(OutletId(node_id, 0))] = true;
+				continue;
+			}
+			Step step;
+			step.node = node_id;
+			step.op = node.op.get();
+			for (auto &input : node.inputs) {
+				step.inputs.push_back(slot_of(input));
+			}
+			step.outputs_begin = first_slot[node_id];
+			step.output_count = node.outputs.size();
+			plan->steps_.push_back(std::move(step));
+		}
+
+		// liveness: the last step reading each slot, from the successors of its outlet
+		std::vector<size_t> step_of(model->nodes.size(), SIZE_MAX);
+		for (size_t i = 0; i < plan->steps_.size(); i++) {
+			step_of[plan->steps_[i].node] = i;
+		}
+		std::vector<size_t> last_use(plan->slot_count_, SIZE_MAX);
+		for (size_t node_id = 0; node_id < model->nodes.size(); node_id++) {
+			if (first_slot[node_id] == SIZE_MAX) {
+				continue;
+			}
+			auto &outputs = model->nodes[node_id].outputs;
+			for (size_t slot = 0; slot < outputs.size(); slot++) {
+				for (auto &successor : outputs[slot].successors) {
+					auto step = step_of[successor.node];
+					auto &last = last_use[first_slot[node_id] + slot];
+					if (step != SIZE_MAX && (last == SIZE_MAX || step > last)) {
+						last = step;
+					}
+				}
+			}
+		}
+
+		// dependencies between steps, from the steps reading each slot and the step computing it
+		auto &steps = plan->steps_;
+		std::vector<size_t> producer(plan->slot_count_, SIZE_MAX);
+		std::vector<std::vector<size_t>> readers(plan->slot_count_);
+		for (size_t i = 0; i < steps.size(); i++) {
+			for (size_t output = 0; output < steps[i].output_count; output++) {
+				producer[steps[i].outputs_begin + output] = i;
+			}
+			for (auto slot : steps[i].inputs) {
+				if (readers[slot].empty() || readers[slot].back() != i) {
+					readers[slot].push_back(i);
+				}
+			}
+		}
+		// ancestors[i] has bit j set when step j runs before step i in any order respecting the dependencies
+		auto words = (steps.size() + 63) / 64;
+		std::vector<std::vector<uint64_t>> ancestors(steps.size(), std::vector<uint64_t>(words, 0));
+		auto is_ancestor = [&](size_t j, size_t i) { return (ancestors[i][j / 64] >> (j % 64)) & 1; };
+		// steps of one level never depend on each other: the largest level bounds the useful threads
+		std::vector<size_t> level(steps.size(), 0);
+		std::vector<size_t> level_width;
+		for (size_t i = 0; i < steps.size(); i++) {
+			std::vector<size_t> predecessors;
+			for (auto slot : steps[i].inputs) {
+				if (producer[slot] != SIZE_MAX) {
+					predecessors.push_back(producer[slot]);
+				}
+			}
+			std::sort(predecessors.begin(), predecessors.end());
+			predecessors.erase(std::unique(predecessors.begin(), predecessors.end()), predecessors.end());
+			steps[i].predecessors = predecessors.size();
+			for (auto j : predecessors) {
+				steps[j].successors.push_back(i);
+				ancestors[i][j / 64] |= uint64_t(1) << (j % 64);
+				for (size_t w = 0; w < words; w++) {
+					ancestors[i][w] |= ancestors[j][w];
+				}
+				level[i] = std::max(level[i], level[j] + 1);
+			}
+			if (level[i] >= level_width.size()) {
+				level_width.resize(level[i] + 1, 0);
+			}
+			plan->width_ = std::max(plan->width_, ++level_width[level[i]]);
+		}
+
+		// assign the outputs of every step to workspace buffers, reusing the buffers of dead values
+		std::vector<size_t> slot_buffer(plan->slot_count_, SIZE_MAX);
+		std::vector<size_t> buffer_refs;
+		std::vector<size_t> free_buffers;
+		// the steps that used the values released from each buffer: they must all run before its next use
+		std::vector<std::vector<size_t>> buffer_users;
+		auto release = [&](size_t slot) {
+			auto buffer = slot_buffer[slot];
+			if (buffer == SIZE_MAX) {
+				return;
+			}
+			const auto &users = readers[slot].empty() ? std::vector<size_t> {producer[slot]} : readers[slot];
+			buffer_users[buffer].insert(buffer_users[buffer].end(), users.begin(), users.end());
+			if (--buffer_refs[buffer] == 0) {
+				free_buffers.push_back(buffer);
+			}
+		};
+		for (size_t i = 0; i < plan->steps_.size(); i++) {
+			auto &step = plan->steps_[i];
+			auto inplace = step.op->inplace_input();
+			for (size_t output = 0; output < step.output_count; output++) {
+				auto slot = step.outputs_begin + output;
+				size_t buffer = SIZE_MAX;
+				bool joined = false;
+				if (output == 0 && inplace >= 0 && static_cast<size_t>(inplace) < step.inputs.size()) {
+					// the output may live in the storage of this input: keep its buffer for as long as the output
+					auto input = step.inputs[inplace];
+					if (slot_buffer[input] != SIZE_MAX && !pinned[input] && last_use[input] == i) {
+						buffer = slot_buffer[input];
+						joined = true;
+					}
+				}
+				if (buffer == SIZE_MAX) {
+					// only reuse a buffer whose previous values are dead whichever branch runs first
+					auto free = std::find_if(free_buffers.rbegin(), free_buffers.rend(), [&](size_t candidate) {
+						auto &users = buffer_users[candidate];
+						auto done = [&](size_t user) { return is_ancestor(user, i); };
+						return std::all_of(users.begin(), users.end(), done);
+					});
+					if (free == free_buffers.rend()) {
+						buffer = buffer_refs.size();
+						buffer_refs.push_back(0);
+						buffer_users.emplace_back();
+						plan->buffer_sizes_.push_back(0);
+						plan->buffer_dims_.emplace_back();
+					} else {
+						buffer = *free;
+						free_buffers.erase(std::next(free).base());
+						buffer_users[buffer].clear();
+					}
+				}
+				slot_buffer[slot] = buffer;
+				buffer_refs[buffer]++;
+				// an op that could not run in place falls back to the arena rather than clobbering its input
+				step.output_buffers.push_back(joined ? SIZE_MAX : buffer);
+				auto &fact = model->nodes[step.node].outputs[output].fact;
+				auto bytes = fact_bytes(fact);
+				if (bytes.is_int() && static_cast<size_t>(bytes.as_int()) > plan->buffer_sizes_[buffer]) {
+					plan->buffer_sizes_[buffer] = static_cast<size_t>(bytes.as_int());
+				} else if (!bytes.is_int() && bytes.known()) {
+					plan->buffer_dims_[buffer].push_back(bytes);
+				}
+			}
+
+			for (size_t k = 0; k < step.inputs.size(); k++) {
+				auto slot = step.inputs[k];
+				bool last_read = !pinned[slot] && last_use[slot] == i &&
+				                 std::find(step.inputs.begin() + k + 1, step.inputs.end(), slot) == step.inputs.end();
+				// hand the value over on its last read so that the op may reuse it
+				step.move_inputs.push_back(last_read);
+				if (last_read) {
+					step.flush.push_back(slot);
+					release(slot);
+				}
+			}
+			for (size_t output = 0; output < step.output_count; output++) {
+				auto slot = step.outputs_begin + output;
+				if (!pinned[slot] && last_use[slot] == SIZE_MAX) {
+					// nobody reads this output
+					step.flush.push_back(slot);
+					release(slot);
+				}
+			}
+		}
+		plan->slot_readers_.resize(plan->slot_count_);
+		for (size_t slot = 0; slot < plan->slot_count_; slot++) {
+			plan->slot_readers_[slot] = pinned[slot] ? SIZE_MAX : readers[slot].size();
+		}
+		return plan;
+	});
+}
+
+TractResult<std::vector<TValue>> SimplePlan::run(std::vector<TValue> inputs) const {
+	SimpleState state(shared_from_this());
+	auto result = state.run(std::move(inputs));
+	if (result.is_err()) {
+		return result;
+	}
+	// the outputs must not outlive the state's arena: copy the ones stored in it
+	auto outputs = result.value_move();
+	for (auto &output : outputs) {
+		if (output->is_borrowed()) {
+			auto copy = Tensor::uninitialized(output->datum_type(), output->shape());
+			std::memcpy(copy.raw_data_mut(), output->raw_data(), output->byte_len());
+			output = TValue::Var(std::move(copy));
+		}
+	}
+	return Ok(std::move(outputs));
+}
+
+std::optional<SymbolValues> SimplePlan::bind_symbols(const std::vector<TValue> &inputs) const {
+	if (inputs.size() != model_->inputs.size()) {
+		return std::nullopt;
+	}
+	SymbolValues symbols;
+	for (size_t i = 0; i < inputs.size(); i++) {
+		auto &fact = model_->outlet_fact(model_->inputs[i]);
+		auto &shape = inputs[i]->shape();
+		if (inputs[i]->datum_type() != fact.datum_type || (fact.rank_known && fact.shape.size() != shape.size())) {
+			return std::nullopt;
+		}
+		for (size_t axis = 0; fact.rank_known && axis < shape.size(); axis++) {
+			auto &dim = fact.shape[axis];
+			// a plain symbol takes the dimension it stands for
+			auto &symbol = dim.symbol_name();
+			if (!symbol.empty() && !symbols.count(symbol) && dim == TDim::symbol(symbol)) {
+				symbols[symbol] = shape[axis];
+			}
+			auto value = dim.eval(symbols);
+			if (dim.known() && (!value || *value != shape[axis])) {
+				return std::nullopt;
+			}
+		}
+	}
+	return symbols;
+}
+
+SimpleState::SimpleState(std::shared_ptr<const SimplePlan> plan) : plan_(std::move(plan)) {
+	session_.init_workspace(plan_->buffer_sizes_);
+}
+
+TractResult<std::vector<TValue>> SimpleState::run(std::vector<TValue> inputs) {
+	auto &plan = *plan_;
+	if (inputs.size() != plan.input_slots_.size()) {
+		return Err<std::vector<TValue>>("Model expects " + std::to_string(plan.input_slots_.size()) +
+		                                " input(s), got " + std::to_string(inputs.size()));
+	}
+	auto symbols = plan.bind_symbols(inputs);
+	if (symbols && plan.specialized_) {
+		if (!specialized_) {
+			specialized_.reset(new SimpleState(plan.specialized_));
+		}
+		specialized_->session_.runner = session_.runner;
+		if (specialized_->profile_ != profile_) {
+			specialized_->set_profile(profile_);
+		}
+		return specialized_->run(std::move(inputs));
+	}
+	if (symbols && *symbols != symbols_) {
+		// size the buffers of values whose shape depends on the symbols before running
+		for (size_t buffer = 0; buffer < plan.buffer_dims_.size(); buffer++) {
+			size_t bytes = 0;
+			for (auto &dim : plan.buffer_dims_[buffer]) {
+				auto value = dim.eval(*symbols);
+				bytes = value ? std::max(bytes, static_cast<size_t>(*value)) : bytes;
+			}
+			if (bytes) {
+				session_.workspace_buffer(buffer, bytes);
+			}
+		}
+		symbols_ = std::move(*symbols);
+	}
+	// the outputs of the previous run are released along with the arenas
+	session_.arena.reset();
+	for (auto &lane : lanes_) {
+		lane->arena.reset();
+	}
+	values_.assign(plan.slot_count_, TValue());
+	for (auto &konst : plan.constants_) {
+		values_[konst.first] = konst.second;
+	}
+	for (size_t i = 0; i < inputs.size(); i++) {
+		// memory we do not own, such as DuckDB vectors, must never be modified in place
+		if (inputs[i].is_var_ && inputs[i]->is_borrowed()) {
+			inputs[i] = TValue::Const(std::move(inputs[i].tensor_));
+		}
+		values_[plan.input_slots_[i]] = std::move(inputs[i]);
+	}
+
+	auto runner = session_.runner;
+	auto lanes = runner ? std::min(runner->thread_count(), plan.width_) : 1;
+	auto result = lanes > 1 ? run_steps_concurrently(lanes) : run_steps();
+	if (result.is_err()) {
+		values_.clear();
+	}
+	return result;
+}
+
+void SimpleState::set_profile(std::shared_ptr<PlanProfile> profile) {
+	profile_ = std::move(profile);
+	profile_entries_.clear();
+	if (profile_) {
+		for (auto &step : plan_->steps_) {
+			profile_entries_.push_back(profile_->entry(plan_->model_->nodes[step.node].name, step.op->name()));
+		}
+	}
+	if (specialized_) {
+		specialized_->set_profile(profile_);
+	}
+}
+
+TractResult<std::vector<TValue>> SimpleState::eval_step(const SimplePlan::Step &step, SessionState &session,
+                                                        std::vector<TValue> args) {
+	std::vector<ShapeVec> input_shapes;
+	std::chrono::steady_clock::time_point start;
+	if (profile_) {
+		for (auto &arg : args) {
+			input_shapes.push_back(arg->shape());
+		}
+		start = std::chrono::steady_clock::now();
+	}
+	session.output_buffers_ = &step.output_buffers;
+	auto result = step.op->eval_with_session(session, std::move(args));
+	session.output_buffers_ = nullptr;
+	auto &node = plan_->model_->nodes[step.node];
+	if (profile_ && result.is_ok()) {
+		auto nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+		std::vector<ShapeVec> output_shapes;
+		uint64_t output_bytes = 0;
+		std::string shapes;
+		for (auto &output : result.value()) {
+			output_shapes.push_back(output->shape());
+			output_bytes += output->byte_len();
+			shapes += (shapes.empty() ? "" : ", ") + shape_string(output->shape());
+		}
+		profile_->record(profile_entries_[&step - plan_->steps_.data()], static_cast<uint64_t>(nanos.count()),
+		                 step.op->flops(input_shapes, output_shapes), output_bytes, std::move(shapes));
+	}
+	if (result.is_err()) {
+		return Err<std::vector<TValue>>("Error while evaluating node " + node.name + " (" + step.op->name() +
+		                                "): " + result.error().what());
+	}
+	if (result.value().size() != step.output_count) {
+		return Err<std::vector<TValue>>("Node " + node.name + " produced " + std::to_string(result.value().size()) +
+		                                " output(s), expected " + std::to_string(step.output_count));
+	}
+	return result;
+}
+
+TractResult<std::vector<TValue>> SimpleState::run_steps() {
+	for (auto &step : plan_->steps_) {
+		std::vector<TValue> args;
+		args.reserve(step.inputs.size());
+		for (size_t k = 0; k < step.inputs.size(); k++) {
+			if (step.move_inputs[k]) {
+				args.push_back(std::move(values_[step.inputs[k]]));
+			} else {
+				args.push_back(values_[step.inputs[k]]);
+			}
+		}
+		auto result = eval_step(step, session_, std::move(args));
+		if (result.is_err()) {
+			return result;
+		}
+		auto outputs = result.value_move();
+		for (size_t i = 0; i < outputs.size(); i++) {
+			values_[step.outputs_begin + i] = std::move(outputs[i]);
+		}
+		for (auto slot : step.flush) {
+			values_[slot] = TValue();
+		}
+	}
+	return Ok(take_outputs());
+}
+
+namespace {
+
+/// Ready steps of one lane of a concurrent execution. The lane itself takes
+/// the newest, thieves the oldest.
+struct LaneQueue {
+	std::mutex lock;
+	std::deque<size_t> steps;
+};
+
+} // namespace
+
+TractResult<std::vector<TValue>> SimpleState::run_steps_concurrently(size_t lanes) {
+	auto &plan = *plan_;
+	while (lanes_.size() + 1 < lanes) {
+		lanes_.emplace_back(new SessionState());
+		lanes_.back()->owner_ = &session_;
+	}
+	for (auto &lane : lanes_) {
+		lane->runner = session_.runner;
+	}
+
+	// steps whose inputs are not all computed yet, and readers of each slot that did not finish
+	std::vector<std::atomic<size_t>> waiting(plan.steps_.size());
+	for (size_t i = 0; i < plan.steps_.size(); i++) {
+		waiting[i] = plan.steps_[i].predecessors;
+	}
+	std::vector<std::atomic<size_t>> unread(plan.slot_count_);
+	for (size_t slot = 0; slot < plan.slot_count_; slot++) {
+		unread[slot] = plan.slot_readers_[slot];
+	}
+	std::vector<LaneQueue> queues(lanes);
+	// queued and running steps, updated under the lock of a queue so that they never both read 0 while steps remain
+	std::atomic<size_t> queued {0};
+	std::atomic<size_t> running {0};
+	std::mutex idle_lock;
+	std::condition_variable idle;
+	std::atomic<bool> failed {false};
+	std::string error;
+
+	auto push = [&](size_t lane, size_t step) {
+		{
+			std::lock_guard<std::mutex> guard(queues[lane].lock);
+			queues[lane].steps.push_back(step);
+			queued++;
+		}
+		std::lock_guard<std::mutex> guard(idle_lock);
+		idle.notify_one();
+	};
+	auto pop = [&](size_t lane, size_t &step) {
+		for (size_t n = 0; n < lanes; n++) {
+			auto &queue = queues[(lane + n) % lanes];
+			std::lock_guard<std::mutex> guard(queue.lock);
+			if (queue.steps.empty()) {
+				continue;
+			}
+			if (n == 0) {
+				step = queue.steps.back();
+				queue.steps.pop_back();
+			} else {
+				step = queue.steps.front();
+				queue.steps.pop_front();
+			}
+			running++;
+			queued--;
+			return true;
+		}
+		return false;
+	};
+	auto execute = [&](size_t index, size_t lane) {
+		auto &step = plan.steps_[index];
+		std::vector<TValue> args;
+		args.reserve(step.inputs.size());
+		for (size_t k = 0; k < step.inputs.size(); k++) {
+			auto slot = step.inputs[k];
+			// the value is handed over once every other reader finished with it
+			bool last_read = plan.slot_readers_[slot] != SIZE_MAX && unread[slot] == 1 &&
+			                 std::find(step.inputs.begin() + k + 1, step.inputs.end(), slot) == step.inputs.end();
+			if (last_read) {
+				args.push_back(std::move(values_[slot]));
+			} else {
+				args.push_back(values_[slot]);
+			}
+		}
+		auto result = eval_step(step, lane == 0 ? session_ : *lanes_[lane - 1], std::move(args));
+		if (result.is_err()) {
+			std::lock_guard<std::mutex> guard(idle_lock);
+			if (!failed) {
+				error = result.error().what();
+				failed = true;
+			}
+			return;
+		}
+		auto outputs = result.value_move();
+		for (size_t i = 0; i < outputs.size(); i++) {
+			auto slot = step.outputs_begin + i;
+			// outputs nobody reads are dropped right away
+			if (plan.slot_readers_[slot] != 0) {
+				values_[slot] = std::move(outputs[i]);
+			}
+		}
+		for (size_t k = 0; k < step.inputs.size(); k++) {
+			auto slot = step.inputs[k];
+			if (plan.slot_readers_[slot] != SIZE_MAX &&
+			    std::find(step.inputs.begin(), step.inputs.begin() + k, slot) == step.inputs.begin() + k &&
+			    --unread[slot] == 0) {
+				values_[slot] = TValue();
+			}
+		}
+		for (auto successor : step.successors) {
+			if (--waiting[successor] == 0) {
+				push(lane, successor);
+			}
+		}
+	};
+
+	size_t initial = 0;
+	for (size_t i = 0; i < plan.steps_.size(); i++) {
+		if (plan.steps_[i].predecessors == 0) {
+			push(initial++ % lanes, i);
+		}
+	}
+	session_.runner->run(lanes, [&](size_t lane) {
+		size_t step;
+		while (true) {
+			if (!pop(lane, step)) {
+				// wait for a running step to make others ready; once none runs nor is queued, all are done
+				std::unique_lock<std::mutex> guard(idle_lock);
+				idle.wait(guard, [&] { return queued > 0 || running == 0; });
+				if (queued == 0 && running == 0) {
+					return;
+				}
+				continue;
+			}
+			// after a failure the queued steps are dropped
+			if (!failed) {
+				execute(step, lane);
+			}
+			if (--running == 0) {
+				std::lock_guard<std::mutex> guard(idle_lock);
+				idle.notify_all();
+			}
+		}
+	});
+	if (failed) {
+		return Err<std::vector<TValue>>(error);
+	}
+	return Ok(take_outputs());
+}
+
+std::vector<TValue> SimpleState::take_outputs() {
+	std::vector<TValue> outputs;
+	for (auto slot : plan_->output_slots_) {
+		outputs.push_back(values_[slot]);
+	}
+	values_.clear();
+	return outputs;
+}
+
+size_t SimplePlan::memory_usage() const {
+	std::unordered_set<const void *> seen;
+	return memory_usage(seen);
+}
+
+size_t SimplePlan::memory_usage(std::unordered_set<const void *> &seen) const {
+	size_t usage = 0;
+	add_memory_usage(seen, usage);
+	return usage;
+}
+
+void SimplePlan::add_memory_usage(std::unordered_set<const void *> &seen, size_t &usage) const {
+	usage += sizeof(SimplePlan) + steps_.size() * sizeof(Step);
+	for (auto &step : steps_) {
+		if (seen.insert(step.op).second) {
+			usage += step.op->memory_usage();
+		}
+	}
+	for (auto &konst : constants_) {
+		// mapped constants live in the OS page cache, not in our heap
+		if (!konst.second->blob().is_view() && seen.insert(konst.second->raw_data()).second) {
+			usage += konst.second->byte_len();
+		}
+	}
+	if (specialized_) {
+		specialized_->add_memory_usage(seen, usage);
+	}
+}
+
+} // namespace duckdb_onnx
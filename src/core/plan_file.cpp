@@ -0,0 +1,665 @@
+#include "duckdb-onnx/core/plan_file.hpp"
+
+#include "duckdb-onnx/core/ops/batch_norm.h"
+#include "duckdb-onnx/core/ops/binary.h"
+#include "duckdb-onnx/core/ops/cast.h"
+#include "duckdb-onnx/core/ops/conv.h"
+#include "duckdb-onnx/core/ops/fused.h"
+#include "duckdb-onnx/core/ops/identity.h"
+#include "duckdb-onnx/core/ops/konst.h"
+#include "duckdb-onnx/core/ops/matmul.h"
+#include "duckdb-onnx/core/ops/pool.h"
+#include "duckdb-onnx/core/ops/quant.h"
+#include "duckdb-onnx/core/ops/reshape.h"
+#include "duckdb-onnx/core/ops/shape.h"
+#include "duckdb-onnx/core/ops/softmax.h"
+#include "duckdb-onnx/core/ops/source.h"
+#include "duckdb-onnx/core/ops/unary.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+
+namespace duckdb_onnx {
+
+static constexpr char PLAN_MAGIC[8] = {'O', 'N', 'N', 'X', 'P', 'L', 'A', 'N'};
+/// Bumped whenever the layout of the file or the serialization of an op changes
+static constexpr uint64_t PLAN_FORMAT_VERSION = 2;
+/// Magic, then the version, the key, the kernel geometry and the section
+/// offsets as 64-bit words
+static constexpr size_t PLAN_HEADER_SIZE = sizeof(PLAN_MAGIC) + 11 * sizeof(uint64_t);
+/// Reference to a tensor or op that is defined right after it
+static constexpr uint64_t NEW_ENTRY = UINT64_MAX;
+
+uint64_t hash_bytes(const void *data, size_t size) {
+	auto bytes = static_cast<const unsigned char *>(data);
+	uint64_t hash = 0xcbf29ce484222325ULL ^ size;
+	size_t i = 0;
+	for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+		uint64_t word;
+		std::memcpy(&word, bytes + i, sizeof(word));
+		hash = ((hash << 31 | hash >> 33) ^ word) * 0x9e3779b97f4a7c15ULL;
+	}
+	for (; i < size; i++) {
+		hash = ((hash << 31 | hash >> 33) ^ bytes[i]) * 0x9e3779b97f4a7c15ULL;
+	}
+	// final avalanche, so that every input bit reaches every output bit
+	hash ^= hash >> 33;
+	hash *= 0xff51afd7ed558ccdULL;
+	hash ^= hash >> 33;
+	hash *= 0xc4ceb9fe1a85ec53ULL;
+	hash ^= hash >> 33;
+	return hash;
+}
+
+PlanFileKey PlanFileKey::for_model(const void *data, size_t size) {
+	PlanFileKey key;
+	key.model_hash = hash_bytes(data, size);
+	key.simd = simd_level();
+	return key;
+}
+
+PlanFileDependency PlanFileDependency::for_file(const std::string &path) {
+	PlanFileDependency dependency;
+	dependency.path = path;
+	dependency.size = std::filesystem::file_size(path);
+	dependency.mtime = static_cast<int64_t>(std::filesystem::last_write_time(path).time_since_epoch().count());
+	return dependency;
+}
+
+std::string PlanFileKey::file_name() const {
+	char hash[17];
+	std::snprintf(hash, sizeof(hash), "%016llx", static_cast<unsigned long long>(model_hash));
+	return std::string(hash) + "-" + simd_level_name(simd) + ".onnxplan";
+}
+
+/// The header words after the magic, in file order
+static std::vector<uint64_t> header_words(const PlanFileKey &key, uint64_t metadata_size, uint64_t data_offset,
+                                          uint64_t data_size) {
+	return {PLAN_FORMAT_VERSION,
+	        key.model_hash,
+	        static_cast<uint64_t>(key.simd),
+	        GEMM_NR,
+	        GEMM_KC,
+	        gemm_kernels_f32(key.simd).mr,
+	        gemm_kernels_i8(key.simd).mr,
+	        sizeof(size_t),
+	        metadata_size,
+	        data_offset,
+	        data_size};
+}
+
+static size_t align_up(size_t offset) {
+	return (offset + TENSOR_ALIGNMENT - 1) / TENSOR_ALIGNMENT * TENSOR_ALIGNMENT;
+}
+
+void PlanWriter::write_u64(uint64_t value) {
+	metadata_.append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+void PlanWriter::write_i64(int64_t value) {
+	write_u64(static_cast<uint64_t>(value));
+}
+
+void PlanWriter::write_bool(bool value) {
+	write_u64(value ? 1 : 0);
+}
+
+void PlanWriter::write_f32(float value) {
+	uint32_t bits;
+	std::memcpy(&bits, &value, sizeof(bits));
+	write_u64(bits);
+}
+
+void PlanWriter::write_f64(double value) {
+	uint64_t bits;
+	std::memcpy(&bits, &value, sizeof(bits));
+	write_u64(bits);
+}
+
+void PlanWriter::write_string(const std::string &value) {
+	write_u64(value.size());
+	metadata_.append(value);
+}
+
+void PlanWriter::write_shape(const ShapeVec &shape) {
+	write_u64(shape.size());
+	for (auto dim : shape) {
+		write_i64(dim);
+	}
+}
+
+void PlanWriter::write_dim(const TDim &dim) {
+	write_bool(dim.known());
+	if (dim.known()) {
+		write_i64(dim.coefficient());
+		write_string(dim.symbol_name());
+		write_i64(dim.offset());
+	}
+}
+
+void PlanWriter::write_fact(const TypedFact &fact) {
+	write_u64(static_cast<uint64_t>(fact.datum_type));
+	write_bool(fact.rank_known);
+	write_u64(fact.shape.size());
+	for (auto &dim : fact.shape) {
+		write_dim(dim);
+	}
+	write_tensor(fact.konst);
+	write_bool(fact.symbolic_value.has_value());
+	if (fact.symbolic_value) {
+		write_u64(fact.symbolic_value->size());
+		for (auto &dim : *fact.symbolic_value) {
+			write_dim(dim);
+		}
+	}
+}
+
+uint64_t PlanWriter::write_data(const void *data, size_t size) {
+	data_.resize(align_up(data_.size()), '\0');
+	auto offset = data_.size();
+	data_.append(static_cast<const char *>(data), size);
+	return offset;
+}
+
+void PlanWriter::write_tensor(const std::shared_ptr<Tensor> &tensor) {
+	if (!tensor) {
+		write_u64(0);
+		return;
+	}
+	auto known = tensors_.find(tensor.get());
+	if (known != tensors_.end()) {
+		write_u64(known->second);
+		return;
+	}
+	if (datum_type_size(tensor->datum_type()) == 0) {
+		throw std::runtime_error(std::string("Tensors of type ") + datum_type_name(tensor->datum_type()) +
+		                         " cannot be saved in a plan file");
+	}
+	write_u64(NEW_ENTRY);
+	write_u64(static_cast<uint64_t>(tensor->datum_type()));
+	write_shape(tensor->shape());
+	write_u64(write_data(tensor->raw_data(), tensor->byte_len()));
+	tensors_.emplace(tensor.get(), tensors_.size() + 1);
+}
+
+void PlanWriter::write_packed(const PackedMatrixF32 &matrix) {
+	write_u64(matrix.k());
+	write_u64(matrix.n());
+	write_u64(matrix.width());
+	write_u64(static_cast<uint64_t>(matrix.datum_type()));
+	write_u64(matrix.byte_len());
+	write_u64(write_data(matrix.storage().data(), matrix.byte_len()));
+}
+
+void PlanWriter::write_packed(const PackedMatrixI8 &matrix) {
+	write_u64(matrix.k());
+	write_u64(matrix.n());
+	write_u64(matrix.width());
+	write_u64(matrix.byte_len());
+	write_u64(write_data(matrix.storage().data(), matrix.byte_len()));
+}
+
+void PlanWriter::write_op(const Op &op) {
+	auto known = ops_.find(&op);
+	if (known != ops_.end()) {
+		write_u64(known->second);
+		return;
+	}
+	write_u64(NEW_ENTRY);
+	if (!op.save(*this)) {
+		throw std::runtime_error("Op " + op.name() + " cannot be saved in a plan file");
+	}
+	// numbered once saved, so that the ops it contains come first, as when reading
+	ops_.emplace(&op, ops_.size() + 1);
+}
+
+void PlanWriter::write_model(const TypedModel &model) {
+	write_u64(model.nodes.size());
+	for (auto &node : model.nodes) {
+		if (!node.op) {
+			throw std::runtime_error("Node " + node.name + " has no op");
+		}
+		write_string(node.name);
+		write_op(*node.op);
+		write_u64(node.inputs.size());
+		for (auto &input : node.inputs) {
+			write_u64(input.node);
+			write_u64(input.slot);
+		}
+		write_u64(node.outputs.size());
+		for (auto &output : node.outputs) {
+			write_fact(output.fact);
+		}
+	}
+	for (auto outlets : {&model.inputs, &model.outputs}) {
+		write_u64(outlets->size());
+		for (auto &outlet : *outlets) {
+			write_u64(outlet.node);
+			write_u64(outlet.slot);
+		}
+	}
+	std::vector<std::pair<OutletId, std::string>> labels(model.outlet_labels.begin(), model.outlet_labels.end());
+	std::sort(labels.begin(), labels.end());
+	write_u64(labels.size());
+	for (auto &label : labels) {
+		write_u64(label.first.node);
+		write_u64(label.first.slot);
+		write_string(label.second);
+	}
+	std::vector<std::pair<std::string, std::shared_ptr<Tensor>>> properties(model.properties.begin(),
+	                                                                         model.properties.end());
+	std::sort(properties.begin(), properties.end(),
+	          [](const std::pair<std::string, std::shared_ptr<Tensor>> &a,
+	             const std::pair<std::string, std::shared_ptr<Tensor>> &b) { return a.first < b.first; });
+	write_u64(properties.size());
+	for (auto &property : properties) {
+		write_string(property.first);
+		write_tensor(property.second);
+	}
+}
+
+void PlanWriter::finish(const PlanFileKey &key, const PlanFileSink &write) const {
+	auto data_offset = align_up(PLAN_HEADER_SIZE + metadata_.size());
+	std::string header(PLAN_MAGIC, sizeof(PLAN_MAGIC));
+	for (auto word : header_words(key, metadata_.size(), data_offset, data_.size())) {
+		header.append(reinterpret_cast<const char *>(&word), sizeof(word));
+	}
+	write(header.data(), header.size());
+	write(metadata_.data(), metadata_.size());
+	std::string padding(data_offset - PLAN_HEADER_SIZE - metadata_.size(), '\0');
+	write(padding.data(), padding.size());
+	write(data_.data(), data_.size());
+}
+
+PlanReader::PlanReader(const std::string &path, const PlanFileKey &key) : map_(MemoryMap::open(path)) {
+	metadata_end_ = PLAN_HEADER_SIZE;
+	auto magic = take(sizeof(PLAN_MAGIC));
+	if (std::memcmp(magic, PLAN_MAGIC, sizeof(PLAN_MAGIC)) != 0) {
+		throw std::runtime_error("not a plan file");
+	}
+	if (read_u64() != PLAN_FORMAT_VERSION) {
+		throw std::runtime_error("written by another version of the format");
+	}
+	if (read_u64() != key.model_hash) {
+		throw std::runtime_error("written for another model");
+	}
+	if (read_u64() != static_cast<uint64_t>(key.simd)) {
+		throw std::runtime_error("written for another instruction set");
+	}
+	// then the kernel geometry and word size of the build that wrote it
+	auto expected = header_words(key, 0, 0, 0);
+	for (size_t i = 3; i < 8; i++) {
+		if (read_u64() != expected[i]) {
+			throw std::runtime_error("written for other kernels");
+		}
+	}
+	auto metadata_size = read_u64();
+	data_offset_ = read_u64();
+	data_size_ = read_u64();
+	if (metadata_size > map_->size() - PLAN_HEADER_SIZE || data_offset_ % TENSOR_ALIGNMENT != 0 ||
+	    data_offset_ < PLAN_HEADER_SIZE + metadata_size || data_offset_ > map_->size() ||
+	    data_size_ > map_->size() - data_offset_) {
+		throw std::runtime_error("truncated or corrupt plan file");
+	}
+	metadata_end_ = PLAN_HEADER_SIZE + metadata_size;
+}
+
+const char *PlanReader::take(size_t size) {
+	if (metadata_end_ > map_->size() || size > metadata_end_ - position_) {
+		throw std::runtime_error("truncated or corrupt plan file");
+	}
+	auto data = map_->data() + position_;
+	position_ += size;
+	return data;
+}
+
+uint64_t PlanReader::read_u64() {
+	uint64_t value;
+	std::memcpy(&value, take(sizeof(value)), sizeof(value));
+	return value;
+}
+
+int64_t PlanReader::read_i64() {
+	return static_cast<int64_t>(read_u64());
+}
+
+bool PlanReader::read_bool() {
+	return read_u64() != 0;
+}
+
+float PlanReader::read_f32() {
+	auto bits = static_cast<uint32_t>(read_u64());
+	float value;
+	std::memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+double PlanReader::read_f64() {
+	auto bits = read_u64();
+	double value;
+	std::memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+std::string PlanReader::read_string() {
+	auto size = read_u64();
+	auto data = take(size);
+	return std::string(data, size);
+}
+
+ShapeVec PlanReader::read_shape() {
+	ShapeVec shape;
+	auto rank = read_u64();
+	for (uint64_t i = 0; i < rank; i++) {
+		shape.push_back(read_i64());
+	}
+	return shape;
+}
+
+TDim PlanReader::read_dim() {
+	if (!read_bool()) {
+		return TDim();
+	}
+	auto coefficient = read_i64();
+	auto symbol = read_string();
+	auto offset = read_i64();
+	if (coefficient == 0) {
+		return TDim(offset);
+	}
+	return TDim::symbol(std::move(symbol)) * TDim(coefficient) + TDim(offset);
+}
+
+TypedFact PlanReader::read_fact() {
+	TypedFact fact;
+	fact.datum_type = static_cast<DatumType>(read_u64());
+	fact.rank_known = read_bool();
+	auto rank = read_u64();
+	for (uint64_t i = 0; i < rank; i++) {
+		fact.shape.push_back(read_dim());
+	}
+	fact.konst = read_tensor();
+	if (read_bool()) {
+		std::vector<TDim> value;
+		auto len = read_u64();
+		for (uint64_t i = 0; i < len; i++) {
+			value.push_back(read_dim());
+		}
+		fact.symbolic_value = std::move(value);
+	}
+	return fact;
+}
+
+Blob PlanReader::read_data(size_t size) {
+	auto offset = read_u64();
+	if (offset > data_size_ || size > data_size_ - offset || offset % TENSOR_ALIGNMENT != 0) {
+		throw std::runtime_error("truncated or corrupt plan file");
+	}
+	return map_->slice(data_offset_ + offset, size);
+}
+
+std::shared_ptr<Tensor> PlanReader::read_tensor() {
+	auto id = read_u64();
+	if (id == 0) {
+		return nullptr;
+	}
+	if (id != NEW_ENTRY) {
+		if (id > tensors_.size()) {
+			throw std::runtime_error("truncated or corrupt plan file");
+		}
+		return tensors_[id - 1];
+	}
+	auto dt = static_cast<DatumType>(read_u64());
+	auto shape = read_shape();
+	uint64_t len = 1;
+	for (auto dim : shape) {
+		if (dim < 0) {
+			throw std::runtime_error("truncated or corrupt plan file");
+		}
+		len *= static_cast<uint64_t>(dim);
+	}
+	if (datum_type_size(dt) == 0 || len > data_size_) {
+		throw std::runtime_error("truncated or corrupt plan file");
+	}
+	auto blob = read_data(len * datum_type_size(dt));
+	auto tensor = std::make_shared<Tensor>(Tensor::from_blob(dt, std::move(shape), std::move(blob)));
+	tensors_.push_back(tensor);
+	return tensor;
+}
+
+/// Throw unless `size` bytes hold `rows` rows of the panels of `width` columns
+/// covering `n` columns, in elements of `element_size` bytes. Checked without
+/// forming the product, which corrupt dimensions would overflow.
+static void check_packed_size(uint64_t rows, uint64_t n, uint64_t width, size_t element_size, uint64_t size) {
+	if (width == 0 || element_size == 0) {
+		throw std::runtime_error("truncated or corrupt plan file");
+	}
+	auto elements = size / element_size;
+	auto panels = n / width + (n % width != 0);
+	if (panels != 0 && (width > elements / panels || rows > elements / (panels * width))) {
+		throw std::runtime_error("truncated or corrupt plan file");
+	}
+}
+
+PackedMatrixF32 PlanReader::read_packed_f32() {
+	auto k = read_u64();
+	auto n = read_u64();
+	auto width = read_u64();
+	auto dt = static_cast<DatumType>(read_u64());
+	auto size = read_u64();
+	if (dt != DatumType::F32 && dt != DatumType::F16 && dt != DatumType::BF16) {
+		throw std::runtime_error("truncated or corrupt plan file");
+	}
+	check_packed_size(k, n, width, datum_type_size(dt), size);
+	PackedMatrixF32 matrix;
+	matrix.assign(k, n, width, dt, read_data(size));
+	return matrix;
+}
+
+PackedMatrixI8 PlanReader::read_packed_i8() {
+	auto k = read_u64();
+	auto n = read_u64();
+	auto width = read_u64();
+	auto size = read_u64();
+	// pairs of rows of two int16_t, the last one padded when k is odd
+	check_packed_size(k / 2 + k % 2, n, width, 2 * sizeof(int16_t), size);
+	PackedMatrixI8 matrix;
+	matrix.assign(k, n, width, read_data(size));
+	return matrix;
+}
+
+bool SourceOp::save(PlanWriter &writer) const {
+	writer.write_string("Source");
+	return true;
+}
+
+std::shared_ptr<Op> SourceOp::load(PlanReader &reader) {
+	return std::make_shared<SourceOp>();
+}
+
+bool IdentityOp::save(PlanWriter &writer) const {
+	writer.write_string("Identity");
+	return true;
+}
+
+std::shared_ptr<Op> IdentityOp::load(PlanReader &reader) {
+	return std::make_shared<IdentityOp>();
+}
+
+bool ConstOp::save(PlanWriter &writer) const {
+	writer.write_string("Const");
+	writer.write_tensor(value);
+	return true;
+}
+
+std::shared_ptr<Op> ConstOp::load(PlanReader &reader) {
+	auto value = reader.read_tensor();
+	if (!value) {
+		throw std::runtime_error("constant without a value");
+	}
+	return std::make_shared<ConstOp>(std::move(value));
+}
+
+/// The loader of every op, by the tag its `save` writes
+static const std::unordered_map<std::string, PlanOpLoader> &plan_op_loaders() {
+	static const std::unordered_map<std::string, PlanOpLoader> loaders = {
+	    {"BatchNorm", BatchNormOp::load},
+	    {"Binary", BinaryOp::load},
+	    {"Cast", CastOp::load},
+	    {"Clip", ClipOp::load},
+	    {"Concat", ConcatOp::load},
+	    {"Const", ConstOp::load},
+	    {"Conv", ConvOp::load},
+	    {"DequantizeLinear", DequantizeLinearOp::load},
+	    {"Flatten", FlattenOp::load},
+	    {"FusedElementwise", FusedElementwiseOp::load},
+	    {"Gather", GatherOp::load},
+	    {"Gemm", GemmOp::load},
+	    {"GlobalPool", GlobalPoolOp::load},
+	    {"Identity", IdentityOp::load},
+	    {"MatMul", MatMulOp::load},
+	    {"Pool", PoolOp::load},
+	    {"QLinearConv", QLinearConvOp::load},
+	    {"QMatMul", QMatMulOp::load},
+	    {"QuantizeLinear", QuantizeLinearOp::load},
+	    {"Reshape", ReshapeOp::load},
+	    {"Shape", ShapeOp::load},
+	    {"Softmax", SoftmaxOp::load},
+	    {"Source", SourceOp::load},
+	    {"Squeeze", SqueezeOp::load},
+	    {"Unary", UnaryOp::load},
+	};
+	return loaders;
+}
+
+std::shared_ptr<Op> PlanReader::read_op() {
+	auto id = read_u64();
+	if (id != NEW_ENTRY) {
+		if (id == 0 || id > ops_.size()) {
+			throw std::runtime_error("truncated or corrupt plan file");
+		}
+		return ops_[id - 1];
+	}
+	auto tag = read_string();
+	auto &loaders = plan_op_loaders();
+	auto loader = loaders.find(tag);
+	if (loader == loaders.end()) {
+		throw std::runtime_error("unknown op " + tag);
+	}
+	auto op = loader->second(*this);
+	ops_.push_back(op);
+	return op;
+}
+
+std::shared_ptr<TypedModel> PlanReader::read_model() {
+	auto model = std::make_shared<TypedModel>();
+	auto node_count = read_u64();
+	std::vector<std::vector<OutletId>> inputs;
+	for (uint64_t i = 0; i < node_count; i++) {
+		auto name = read_string();
+		auto op = read_op();
+		// grown as they are read: corrupt counts run out of metadata instead of allocating
+		std::vector<OutletId> node_inputs;
+		auto input_count = read_u64();
+		for (uint64_t j = 0; j < input_count; j++) {
+			OutletId input;
+			input.node = read_u64();
+			input.slot = read_u64();
+			node_inputs.push_back(input);
+		}
+		std::vector<TypedFact> facts;
+		auto fact_count = read_u64();
+		for (uint64_t j = 0; j < fact_count; j++) {
+			facts.push_back(read_fact());
+		}
+		model->add_node(std::move(name), OpBox(std::move(op)), std::move(facts));
+		inputs.push_back(std::move(node_inputs));
+	}
+	// wired once every node exists, in input order so that successors come out as they were
+	for (size_t node = 0; node < inputs.size(); node++) {
+		for (size_t slot = 0; slot < inputs[node].size(); slot++) {
+			auto &input = inputs[node][slot];
+			if (input.node >= model->nodes.size() || input.slot >= model->nodes[input.node].outputs.size()) {
+				throw std::runtime_error("truncated or corrupt plan file");
+			}
+			model->add_edge(input, InletId(node, slot));
+		}
+	}
+	auto read_outlet = [&]() {
+		OutletId outlet;
+		outlet.node = read_u64();
+		outlet.slot = read_u64();
+		if (outlet.node >= model->nodes.size() || outlet.slot >= model->nodes[outlet.node].outputs.size()) {
+			throw std::runtime_error("truncated or corrupt plan file");
+		}
+		return outlet;
+	};
+	for (auto outlets : {&model->inputs, &model->outputs}) {
+		auto count = read_u64();
+		for (uint64_t i = 0; i < count; i++) {
+			outlets->push_back(read_outlet());
+		}
+	}
+	auto label_count = read_u64();
+	for (uint64_t i = 0; i < label_count; i++) {
+		auto outlet = read_outlet();
+		model->set_outlet_label(outlet, read_string());
+	}
+	auto property_count = read_u64();
+	for (uint64_t i = 0; i < property_count; i++) {
+		auto name = read_string();
+		model->properties[name] = read_tensor();
+	}
+	return model;
+}
+
+void write_plan_file(const PlanFileSink &write, const PlanFileKey &key, const TypedModel &model,
+                     const TypedModel *specialized, const std::vector<PlanFileDependency> &dependencies) {
+	PlanWriter writer;
+	writer.write_u64(dependencies.size());
+	for (auto &dependency : dependencies) {
+		writer.write_string(dependency.path);
+		writer.write_u64(dependency.size);
+		writer.write_i64(dependency.mtime);
+	}
+	writer.write_model(model);
+	writer.write_bool(specialized != nullptr);
+	if (specialized) {
+		writer.write_model(*specialized);
+	}
+	writer.finish(key, write);
+}
+
+TractResult<PlanFileModels> read_plan_file(const std::string &path, const PlanFileKey &key,
+                                           const std::string *model_dir) {
+	try {
+		PlanReader reader(path, key);
+		auto dependency_count = reader.read_u64();
+		for (uint64_t i = 0; i < dependency_count; i++) {
+			PlanFileDependency dependency;
+			dependency.path = reader.read_string();
+			dependency.size = reader.read_u64();
+			dependency.mtime = reader.read_i64();
+			// the same .onnx file next to other external data has the same key
+			auto prefix = model_dir ? *model_dir + "/" : std::string();
+			if (!model_dir || dependency.path.compare(0, prefix.size(), prefix) != 0) {
+				throw std::runtime_error("written for external data in another directory");
+			}
+			if (!(PlanFileDependency::for_file(dependency.path) == dependency)) {
+				throw std::runtime_error("external data " + dependency.path + " changed");
+			}
+		}
+		PlanFileModels models;
+		models.model = reader.read_model();
+		if (reader.read_bool()) {
+			models.specialized = reader.read_model();
+		}
+		return Ok(std::move(models));
+	} catch (std::exception &e) {
+		return Err<PlanFileModels>("Cannot read plan file " + path + ": " + e.what());
+	}
+}
+
+} // namespace duckdb_onnx
@@ -0,0 +1,64 @@
+#include "duckdb-onnx/core/profile.hpp"
+
+namespace duckdb_onnx {
+
+size_t PlanProfile::entry(const std::string &node, const std::string &op) {
+	std::lock_guard<std::mutex> guard(lock_);
+	auto key = node + '\0' + op;
+	auto it = index_.find(key);
+	if (it != index_.end()) {
+		return it->second;
+	}
+	NodeProfile profile;
+	profile.node = node;
+	profile.op = op;
+	entries_.push_back(std::move(profile));
+	index_.emplace(std::move(key), entries_.size() - 1);
+	return entries_.size() - 1;
+}
+
+void PlanProfile::record(size_t index, uint64_t nanos, uint64_t flops, uint64_t output_bytes,
+                         std::string output_shapes) {
+	std::lock_guard<std::mutex> guard(lock_);
+	auto &profile = entries_[index];
+	profile.calls++;
+	profile.nanos += nanos;
+	profile.flops += flops;
+	profile.output_bytes += output_bytes;
+	profile.output_shapes = std::move(output_shapes);
+}
+
+std::vector<NodeProfile> PlanProfile::snapshot() const {
+	std::lock_guard<std::mutex> guard(lock_);
+	std::vector<NodeProfile> result;
+	for (auto &profile : entries_) {
+		if (profile.calls > 0) {
+			result.push_back(profile);
+		}
+	}
+	return result;
+}
+
+void PlanProfile::reset() {
+	std::lock_guard<std::mutex> guard(lock_);
+	for (auto &profile : entries_) {
+		profile.calls = 0;
+		profile.nanos = 0;
+		profile.flops = 0;
+		profile.output_bytes = 0;
+		profile.output_shapes.clear();
+	}
+}
+
+std::string shape_string(const ShapeVec &shape) {
+	std::string result = "[";
+	for (size_t i = 0; i < shape.size(); i++) {
+		if (i > 0) {
+			result += ',';
+		}
+		result += std::to_string(shape[i]);
+	}
+	return result + "]";
+}
+
+} // namespace duckdb_onnx
@@ -0,0 +1,46 @@
+#include "duckdb-onnx/core/session.hpp"
+
+namespace duckdb_onnx {
+
+Tensor SessionState::output_tensor(size_t output, DatumType dt, ShapeVec shape) {
+	if (!output_buffers_ || output >= output_buffers_->size() || (*output_buffers_)[output] == SIZE_MAX) {
+		return arena.tensor(dt, std::move(shape));
+	}
+	size_t len = 1;
+	for (auto dim : shape) {
+		len *= static_cast<size_t>(dim < 0 ? 0 : dim);
+	}
+	auto size = len * datum_type_size(dt);
+	auto data = workspace_buffer((*output_buffers_)[output], size);
+	return Tensor::from_blob(dt, std::move(shape), Blob::borrow(data, size));
+}
+
+size_t SessionState::workspace_size() const {
+	size_t size = 0;
+	for (auto &buffer : buffers_) {
+		size += buffer.size();
+	}
+	return size;
+}
+
+void SessionState::init_workspace(const std::vector<size_t> &sizes) {
+	buffers_.clear();
+	for (auto size : sizes) {
+		if (size) {
+			buffers_.push_back(Blob::allocate(size));
+		} else {
+			buffers_.emplace_back();
+		}
+	}
+}
+
+char *SessionState::workspace_buffer(size_t buffer, size_t size) {
+	auto &blob = (owner_ ? owner_->buffers_ : buffers_)[buffer];
+	if (!blob.data() || blob.size() < size) {
+		// the planner guarantees that no live value uses this buffer anymore
+		blob = Blob::allocate(size);
+	}
+	return blob.data();
+}
+
+} // namespace duckdb_onnx
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "duckdb-onnx/tensor.h"
+#include <cstddef>
+#include <vector>
+
+namespace duckdb_onnx {
+
+/// Bump allocator for the tensors of one plan execution.
+///
+/// Allocations are TENSOR_ALIGNMENT aligned and are never freed one by one:
+/// `reset` releases all of them at once before the next execution. After a
+/// reset the chunks are merged into a single one sized for the largest
+/// execution so far, so a steady workload does not allocate at all.
+class TensorArena {
+public:
+	TensorArena() = default;
+	TensorArena(const TensorArena &) = delete;
+	TensorArena &operator=(const TensorArena &) = delete;
+	~TensorArena();
+
+	/// Uninitialized memory valid until the next `reset`
+	void *allocate(size_t size);
+	/// An uninitialized tensor whose storage lives in the arena
+	Tensor tensor(DatumType dt, ShapeVec shape);
+	/// Invalidate every allocation
+	void reset();
+
+	/// Position of the arena, to release scratch memory with `rewind`
+	struct Mark {
+		size_t chunk;
+		size_t offset;
+		size_t used;
+	};
+	Mark mark() const {
+		return Mark {current_, offset_, used_};
+	}
+	/// Invalidate the allocations made since `mark`, such as the scratch
+	/// buffers of an op that do not outlive its evaluation
+	void rewind(const Mark &mark) {
+		current_ = mark.chunk;
+		offset_ = mark.offset;
+		used_ = mark.used;
+	}
+
+	/// Bytes handed out since the last reset
+	size_t used() const {
+		return used_;
+	}
+	/// Bytes held by the chunks
+	size_t capacity() const;
+
+private:
+	struct Chunk {
+		char *data;
+		size_t size;
+	};
+
+	static constexpr size_t MIN_CHUNK_SIZE = 64 * 1024;
+
+	std::vector<Chunk> chunks_;
+	/// chunk currently bumped into and the offset of its free space
+	size_t current_ = 0;
+	size_t offset_ = 0;
+	size_t used_ = 0;
+};
+
+} // namespace duckdb_onnx
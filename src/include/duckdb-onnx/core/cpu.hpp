@@ -0,0 +1,20 @@
+#pragma once
+
+namespace duckdb_onnx {
+
+/// Vector instruction sets the kernels have code paths for, in increasing order.
+enum class SimdLevel {
+	Scalar,
+	Sse41,
+	/// AVX2 with FMA and F16C
+	Avx2,
+	Avx512,
+};
+
+/// Best instruction set supported by the CPU, detected once with CPUID.
+/// The DUCKDB_ONNX_SIMD environment variable (scalar, sse4, avx2 or avx512)
+/// caps it, which is how the fallbacks are tested.
+SimdLevel simd_level();
+const char *simd_level_name(SimdLevel level);
+
+} // namespace duckdb_onnx
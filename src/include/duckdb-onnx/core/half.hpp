@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+namespace duckdb_onnx {
+
+/// IEEE 754 binary16 values and bfloat16 values are stored as their bit
+/// patterns (uint16_t) in F16 and BF16 tensors; these convert them to and
+/// from float.
+
+inline float half_to_float(uint16_t half) {
+	uint32_t sign = static_cast<uint32_t>(half & 0x8000) << 16;
+	uint32_t exponent = (half >> 10) & 0x1f;
+	uint32_t mantissa = half & 0x3ff;
+	uint32_t bits;
+	if (exponent == 0x1f) {
+		// infinity or NaN
+		bits = sign | 0x7f800000 | (mantissa << 13);
+	} else if (exponent != 0) {
+		bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+	} else if (mantissa == 0) {
+		bits = sign;
+	} else {
+		// subnormal: normalize the mantissa
+		exponent = 113;
+		while (!(mantissa & 0x400)) {
+			mantissa <<= 1;
+			exponent--;
+		}
+		bits = sign | (exponent << 23) | ((mantissa & 0x3ff) << 13);
+	}
+	float result;
+	std::memcpy(&result, &bits, sizeof(result));
+	return result;
+}
+
+/// Rounds to the nearest representable value, ties to even
+inline uint16_t float_to_half(float value) {
+	uint32_t bits;
+	std::memcpy(&bits, &value, sizeof(bits));
+	auto sign = static_cast<uint16_t>((bits >> 16) & 0x8000);
+	uint32_t exponent = (bits >> 23) & 0xff;
+	uint32_t mantissa = bits & 0x7fffff;
+	if (exponent == 0xff) {
+		return sign | 0x7c00 | (mantissa ? 0x200 : 0);
+	}
+	int32_t half_exponent = static_cast<int32_t>(exponent) - 112;
+	if (half_exponent >= 0x1f) {
+		return sign | 0x7c00;
+	}
+	if (half_exponent <= 0) {
+		if (half_exponent < -10) {
+			return sign;
+		}
+		// subnormal: shift the mantissa, implicit bit included, into place
+		mantissa |= 0x800000;
+		auto shift = static_cast<uint32_t>(14 - half_exponent);
+		auto half_mantissa = mantissa >> shift;
+		auto rest = mantissa & ((1u << shift) - 1);
+		auto halfway = 1u << (shift - 1);
+		if (rest > halfway || (rest == halfway && (half_mantissa & 1))) {
+			half_mantissa++;
+		}
+		return sign | static_cast<uint16_t>(half_mantissa);
+	}
+	auto half = static_cast<uint32_t>(half_exponent << 10) | (mantissa >> 13);
+	auto rest = mantissa & 0x1fff;
+	// a carry out of the mantissa correctly bumps the exponent, up to infinity
+	if (rest > 0x1000 || (rest == 0x1000 && (half & 1))) {
+		half++;
+	}
+	return sign | static_cast<uint16_t>(half);
+}
+
+inline float bf16_to_float(uint16_t bf16) {
+	auto bits = static_cast<uint32_t>(bf16) << 16;
+	float result;
+	std::memcpy(&result, &bits, sizeof(result));
+	return result;
+}
+
+/// Rounds to the nearest representable value, ties to even
+inline uint16_t float_to_bf16(float value) {
+	uint32_t bits;
+	std::memcpy(&bits, &value, sizeof(bits));
+	if ((bits & 0x7fffffff) > 0x7f800000) {
+		// NaN: keep it quiet, as dropping the low mantissa bits could turn it into infinity
+		return static_cast<uint16_t>((bits >> 16) | 0x40);
+	}
+	// a carry out of the mantissa correctly bumps the exponent, up to infinity
+	bits += 0x7fff + ((bits >> 16) & 1);
+	return static_cast<uint16_t>(bits >> 16);
+}
+
+} // namespace duckdb_onnx
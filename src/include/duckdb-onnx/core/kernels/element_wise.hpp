@@ -0,0 +1,60 @@
+#pragma once
+
+#include "duckdb-onnx/core/cpu.hpp"
+#include "duckdb-onnx/tensor.h"
+#include <cstddef>
+
+namespace duckdb_onnx {
+
+enum class BinaryKind {
+	Add,
+	Sub,
+	Mul,
+	Div,
+	/// a > b ? a : b, so b when either is NaN, as the x86 instructions do
+	Max,
+	/// a < b ? a : b
+	Min,
+};
+
+enum class UnaryKind {
+	Relu,
+	Sigmoid,
+	Tanh,
+	Exp,
+};
+
+/// out[i] = a[i * a_step] op b[i * b_step] for i < n. Steps are 0 (a
+/// broadcast scalar) or 1, so the loop is always unit-stride. `out` may be
+/// `a` or `b`.
+using BinaryKernelF32 = void (*)(size_t n, const float *a, size_t a_step, const float *b, size_t b_step, float *out);
+/// out[i] = op(x[i]); `out` may be `x`.
+using UnaryKernelF32 = void (*)(size_t n, const float *x, float *out);
+/// out[i] = min(max(x[i], lo), hi); `out` may be `x`.
+using ClipKernelF32 = void (*)(size_t n, const float *x, float lo, float hi, float *out);
+/// out[i] = x[i] widened from the 16-bit floats of an F16 or BF16 tensor
+using WidenKernelF32 = void (*)(size_t n, const uint16_t *x, float *out);
+
+/// Kernels for the instruction set picked by `simd_level()`
+BinaryKernelF32 binary_kernel_f32(BinaryKind kind);
+UnaryKernelF32 unary_kernel_f32(UnaryKind kind);
+ClipKernelF32 clip_kernel_f32();
+/// `dt` is F16 or BF16
+WidenKernelF32 widen_kernel_f32(DatumType dt);
+
+/// Kernels for a given instruction set, falling back to a lower one the
+/// build has no code path for.
+BinaryKernelF32 binary_kernel_f32(BinaryKind kind, SimdLevel level);
+UnaryKernelF32 unary_kernel_f32(UnaryKind kind, SimdLevel level);
+ClipKernelF32 clip_kernel_f32(SimdLevel level);
+WidenKernelF32 widen_kernel_f32(DatumType dt, SimdLevel level);
+
+namespace x86 {
+/// Code paths of element_wise_x86.cpp, nullptr when not built for x86
+BinaryKernelF32 binary_kernel_f32(BinaryKind kind, SimdLevel level);
+UnaryKernelF32 unary_kernel_f32(UnaryKind kind, SimdLevel level);
+ClipKernelF32 clip_kernel_f32(SimdLevel level);
+WidenKernelF32 widen_kernel_f32(DatumType dt, SimdLevel level);
+} // namespace x86
+
+} // namespace duckdb_onnx
@@ -0,0 +1,208 @@
+#pragma once
+
+#include "duckdb-onnx/core/cpu.hpp"
+#include "duckdb-onnx/core/parallel.hpp"
+#include "duckdb-onnx/tensor.h"
+#include <algorithm>
+#include <cstddef>
+
+namespace duckdb_onnx {
+
+/// Width of the column panels a right-hand side is packed in. It is the same
+/// for every instruction set, so weights packed at load time suit whichever
+/// kernel runs.
+static constexpr size_t GEMM_NR = 16;
+/// Depth of the blocks k is split in: a packed panel of B (16KB) stays in L1
+/// while the micro-kernel streams over the rows of A.
+static constexpr size_t GEMM_KC = 256;
+/// Rows of A packed at once, rounded down to a multiple of the kernel's MR,
+/// so that the packed block of A stays in L2.
+static constexpr size_t GEMM_MC = 144;
+/// Largest number of rows a micro-kernel computes at once
+static constexpr size_t GEMM_MAX_MR = 12;
+
+/// c[i * ldc + j] = sum(a[p * MR + i] * b[p * GEMM_NR + j]) for i < rows and
+/// j < cols, p < k, added to c when `accumulate`. `a` is a packed panel of the
+/// kernel's MR rows, of which the micro-kernel reads the first `rows` (its
+/// template parameter); `b` is a packed panel of GEMM_NR columns.
+using GemmMicroKernelF32 = void (*)(size_t k, const float *a, const float *b, float *c, size_t ldc, size_t cols,
+                                   bool accumulate);
+
+/// The micro-kernels of one instruction set: `by_rows[r]` computes r rows of
+/// a panel of `mr`, for 1 <= r <= mr.
+struct GemmKernelsF32 {
+	size_t mr;
+	GemmMicroKernelF32 by_rows[GEMM_MAX_MR + 1];
+};
+
+/// Kernels for the instruction set picked by `simd_level()`
+const GemmKernelsF32 &gemm_kernels_f32();
+/// Kernels for a given instruction set, falling back to the portable ones
+/// when the build has no code path for it.
+const GemmKernelsF32 &gemm_kernels_f32(SimdLevel level);
+
+namespace x86 {
+/// Code paths of gemm_x86.cpp, nullptr when not built for x86
+const GemmKernelsF32 *gemm_kernels_f32(SimdLevel level);
+} // namespace x86
+
+/// An operand of a matrix product packed in the layout the micro-kernels
+/// read: k is split in blocks of GEMM_KC and each block in panels of `width`
+/// columns, stored one k row after the other. Columns past n are zero.
+///
+/// A right-hand side is packed in panels of GEMM_NR columns. A left-hand side
+/// packed beforehand (e.g. convolution filters) is packed transposed, in
+/// panels of the kernels' MR rows.
+///
+/// Weights of F16 or BF16 tensors are packed as they are, in half the memory,
+/// and the products widen each panel to F32 right before the micro-kernels
+/// read it, while it is in cache.
+class PackedMatrixF32 {
+public:
+	PackedMatrixF32() = default;
+	PackedMatrixF32(size_t k, size_t n, const float *b, size_t row_stride, size_t col_stride,
+	                size_t width = GEMM_NR) {
+		pack(k, n, b, row_stride, col_stride, width);
+	}
+
+	/// Pack the k x n matrix whose element (p, j) is b[p * row_stride + j * col_stride],
+	/// reusing the current storage when it is large enough.
+	void pack(size_t k, size_t n, const float *b, size_t row_stride, size_t col_stride, size_t width = GEMM_NR);
+	/// Same for the elements of `b`, an F32, F16 or BF16 tensor, starting at element `offset`
+	void pack(size_t k, size_t n, const Tensor &b, size_t offset, size_t row_stride, size_t col_stride,
+	          size_t width = GEMM_NR);
+	/// Set the dimensions and allocate F32 storage without filling it, for
+	/// callers writing the panels themselves through `panel_mut`.
+	void resize(size_t k, size_t n, size_t width = GEMM_NR) {
+		allocate(k, n, width, DatumType::F32);
+	}
+	/// Bytes of the panels of a k x n matrix of `dt` elements packed in panels of `width`
+	static size_t storage_size(size_t k, size_t n, size_t width, DatumType dt) {
+		return k * ((n + width - 1) / width) * width * datum_type_size(dt);
+	}
+
+	size_t k() const {
+		return k_;
+	}
+	size_t n() const {
+		return n_;
+	}
+	size_t width() const {
+		return width_;
+	}
+	/// F32, or the 16-bit float type of the packed elements
+	DatumType datum_type() const {
+		return datum_type_;
+	}
+	size_t panel_count() const {
+		return (n_ + width_ - 1) / width_;
+	}
+	/// Panel `j` of the k block starting at row `p0` (a multiple of GEMM_KC)
+	/// of an F32 matrix. The panels of a block are contiguous.
+	const float *panel(size_t p0, size_t j) const {
+		return reinterpret_cast<const float *>(storage_.data()) + panel_offset(p0, j);
+	}
+	float *panel_mut(size_t p0, size_t j) {
+		return const_cast<float *>(panel(p0, j));
+	}
+	/// Panels [j, j + count) of the k block starting at row `p0` as F32: the
+	/// storage itself, or the panels widened into `buffer`, which has room
+	/// for GEMM_KC * count * width floats, when they hold 16-bit floats.
+	const float *panels_f32(size_t p0, size_t j, size_t count, float *buffer) const;
+	size_t byte_len() const {
+		return storage_.size();
+	}
+	/// Bytes of heap memory held: none when the panels view a file mapping
+	size_t heap_bytes() const {
+		return storage_.is_view() ? 0 : storage_.size();
+	}
+	/// The packed panels, `byte_len()` bytes
+	const class Blob &storage() const {
+		return storage_;
+	}
+	/// Take `storage` as the panels of a k x n matrix of `dt` elements packed
+	/// in panels of `width`, such as a view of a plan file. Throws when it is
+	/// too small for these dimensions.
+	void assign(size_t k, size_t n, size_t width, DatumType dt, class Blob storage);
+
+private:
+	void allocate(size_t k, size_t n, size_t width, DatumType dt);
+	/// Offset of panel `j` of the k block starting at row `p0`, in elements
+	size_t panel_offset(size_t p0, size_t j) const {
+		return p0 * panel_count() * width_ + j * std::min(GEMM_KC, k_ - p0) * width_;
+	}
+
+	size_t k_ = 0;
+	size_t n_ = 0;
+	size_t width_ = GEMM_NR;
+	DatumType datum_type_ = DatumType::F32;
+	class Blob storage_;
+};
+
+/// Fewest multiply-adds worth a task of their own
+static constexpr size_t GEMM_MIN_TASK_WORK = 1 << 20;
+
+/// The output of an m x n product split in tiles for concurrent tasks:
+/// ranges of whole row panels of `mr` rows times ranges of the `col_panels`
+/// column panels. Rows are split first, columns only when there are fewer
+/// row panels than parts, as for a single sample through a large layer.
+/// Tiles share no output and each keeps the k order, so the result does not
+/// depend on the split.
+struct GemmTiles {
+	GemmTiles(size_t m, size_t n, size_t k, size_t col_panels, size_t mr, const TaskRunner *runner)
+	    : m(m), mr(mr), row_panels((m + mr - 1) / mr), col_panels(col_panels) {
+		auto parts = parallel_parts(runner, m * n * k, GEMM_MIN_TASK_WORK);
+		row_parts = std::min(parts, row_panels);
+		col_parts = std::min(col_panels, (parts + row_parts - 1) / row_parts);
+	}
+
+	size_t count() const {
+		return row_parts * col_parts;
+	}
+	/// Rows [row_begin, row_end) of tile `tile`, a multiple of mr apart from the last
+	size_t row_begin(size_t tile) const {
+		return tile / col_parts * row_panels / row_parts * mr;
+	}
+	size_t row_end(size_t tile) const {
+		return std::min(m, (tile / col_parts + 1) * row_panels / row_parts * mr);
+	}
+	/// Column panels [panel_begin, panel_end) of tile `tile`
+	size_t panel_begin(size_t tile) const {
+		return tile % col_parts * col_panels / col_parts;
+	}
+	size_t panel_end(size_t tile) const {
+		return (tile % col_parts + 1) * col_panels / col_parts;
+	}
+
+	/// Run `tile(i)` for every tile, concurrently when there are several
+	void run(TaskRunner *runner, const std::function<void(size_t)> &tile) const {
+		if (count() <= 1) {
+			tile(0);
+		} else {
+			runner->run(count(), tile);
+		}
+	}
+
+	size_t m;
+	size_t mr;
+	size_t row_panels;
+	size_t col_panels;
+	size_t row_parts;
+	size_t col_parts;
+};
+
+/// c = alpha * a * b, or c += alpha * a * b when `accumulate`. `a` is m x k
+/// with element (i, p) at a[i * a_row_stride + p * a_col_stride], so a
+/// transposed A is a matter of strides; `c` is m x n with rows `ldc` apart.
+/// Large products are split in tiles run concurrently on `runner`.
+void gemm_f32(const GemmKernelsF32 &kernels, size_t m, const float *a, size_t a_row_stride, size_t a_col_stride,
+              const PackedMatrixF32 &b, float *c, size_t ldc, float alpha = 1, bool accumulate = false,
+              TaskRunner *runner = nullptr);
+void gemm_f32(size_t m, const float *a, size_t a_row_stride, size_t a_col_stride, const PackedMatrixF32 &b, float *c,
+              size_t ldc, float alpha = 1, bool accumulate = false, TaskRunner *runner = nullptr);
+/// c = a * b, or c += a * b when `accumulate`, for an `a` packed transposed
+/// in panels of `kernels.mr` (a.n() being the number of rows of the product).
+void gemm_f32(const GemmKernelsF32 &kernels, const PackedMatrixF32 &a, const PackedMatrixF32 &b, float *c, size_t ldc,
+              bool accumulate = false, TaskRunner *runner = nullptr);
+
+} // namespace duckdb_onnx
@@ -0,0 +1,131 @@
+#pragma once
+
+#include "duckdb-onnx/core/cpu.hpp"
+#include "duckdb-onnx/core/kernels/gemm.hpp"
+#include "duckdb-onnx/core/parallel.hpp"
+#include "duckdb-onnx/tensor.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+namespace duckdb_onnx {
+
+// Integer matrix products of 8-bit operands with 32-bit accumulators, as run
+// by the quantized ops. Operands are packed with their zero point subtracted,
+// which leaves 9-bit values widened to 16 bits. Consecutive k rows are
+// interleaved in the panels, so that a micro-kernel step multiplies pairs of
+// 16-bit values and adds both products to a 32-bit accumulator at once
+// (pmaddwd on x86). Panels have the width and k blocks of the F32 GEMM.
+
+/// Largest number of rows an integer micro-kernel computes at once
+static constexpr size_t QGEMM_MAX_MR = 6;
+
+/// c[i * ldc + j] = sum(a[(q * MR + i) * 2 + h] * b[(q * GEMM_NR + j) * 2 + h])
+/// for i < rows, j < cols, q < pairs and h < 2, added to c when
+/// `accumulate`. `a` is a packed panel of the kernel's MR rows, `b` a packed
+/// panel of GEMM_NR columns, both holding `pairs` interleaved pairs of k rows.
+using GemmMicroKernelI8 = void (*)(size_t pairs, const int16_t *a, const int16_t *b, int32_t *c, size_t ldc,
+                                   size_t cols, bool accumulate);
+
+/// The integer micro-kernels of one instruction set: `by_rows[r]` computes r
+/// rows of a panel of `mr`, for 1 <= r <= mr.
+struct GemmKernelsI8 {
+	size_t mr;
+	GemmMicroKernelI8 by_rows[QGEMM_MAX_MR + 1];
+};
+
+/// Kernels for the instruction set picked by `simd_level()`
+const GemmKernelsI8 &gemm_kernels_i8();
+/// Kernels for a given instruction set, falling back to the portable ones
+/// when the build has no code path for it.
+const GemmKernelsI8 &gemm_kernels_i8(SimdLevel level);
+
+namespace x86 {
+/// Code paths of qgemm_x86.cpp, nullptr when not built for x86
+const GemmKernelsI8 *gemm_kernels_i8(SimdLevel level);
+} // namespace x86
+
+/// An 8-bit operand of an integer matrix product packed in the layout the
+/// micro-kernels read: k is split in blocks of GEMM_KC and each block in
+/// panels of `width` columns, holding pairs of k rows interleaved column by
+/// column. Column j is stored minus its zero point; columns past n and the
+/// odd row closing a block are zero.
+///
+/// As for PackedMatrixF32, a right-hand side is packed in panels of GEMM_NR
+/// columns and a left-hand side packed beforehand (e.g. convolution filters)
+/// is packed transposed, in panels of the kernels' MR rows.
+class PackedMatrixI8 {
+public:
+	PackedMatrixI8() = default;
+
+	/// Pack the k x n matrix whose element (p, j) is b[p * row_stride + j * col_stride] minus
+	/// zero_points[j * zero_point_stride] (a zero_point_stride of 0 for a single zero point),
+	/// reusing the current storage when it is large enough. T is uint8_t or int8_t.
+	template <typename T>
+	void pack(size_t k, size_t n, const T *b, size_t row_stride, size_t col_stride, const int32_t *zero_points,
+	          size_t zero_point_stride, size_t width = GEMM_NR);
+	/// Set the dimensions and allocate the storage without filling it, for
+	/// callers writing the panels themselves through `panel_mut`.
+	void resize(size_t k, size_t n, size_t width = GEMM_NR);
+
+	size_t k() const {
+		return k_;
+	}
+	size_t n() const {
+		return n_;
+	}
+	size_t width() const {
+		return width_;
+	}
+	size_t panel_count() const {
+		return (n_ + width_ - 1) / width_;
+	}
+	/// Pairs of k rows in the block starting at row `p0` (a multiple of GEMM_KC)
+	size_t pairs(size_t p0) const {
+		return (std::min(GEMM_KC, k_ - p0) + 1) / 2;
+	}
+	/// Panel `j` of the k block starting at row `p0`. The panels of a block are contiguous.
+	const int16_t *panel(size_t p0, size_t j) const {
+		return reinterpret_cast<const int16_t *>(storage_.data()) + p0 * panel_count() * width_ +
+		       j * pairs(p0) * 2 * width_;
+	}
+	int16_t *panel_mut(size_t p0, size_t j) {
+		return const_cast<int16_t *>(panel(p0, j));
+	}
+	size_t byte_len() const {
+		return storage_.size();
+	}
+	/// Bytes of heap memory held: none when the panels view a file mapping
+	size_t heap_bytes() const {
+		return storage_.is_view() ? 0 : storage_.size();
+	}
+	/// The packed panels, `byte_len()` bytes
+	const class Blob &storage() const {
+		return storage_;
+	}
+	/// Take `storage` as the panels of a k x n matrix packed in panels of
+	/// `width`, such as a view of a plan file. Throws when it is too small
+	/// for these dimensions.
+	void assign(size_t k, size_t n, size_t width, class Blob storage);
+
+private:
+	size_t k_ = 0;
+	size_t n_ = 0;
+	size_t width_ = GEMM_NR;
+	class Blob storage_;
+};
+
+/// c = (a - a_zero_point) * b as 32-bit integers, or c += when `accumulate`.
+/// `a` is m x k with element (i, p) at a[i * a_row_stride + p * a_col_stride];
+/// `c` is m x n with rows `ldc` apart. Large products are split in tiles run
+/// concurrently on `runner`. A is uint8_t or int8_t.
+template <typename A>
+void gemm_i8(const GemmKernelsI8 &kernels, size_t m, const A *a, size_t a_row_stride, size_t a_col_stride,
+             int32_t a_zero_point, const PackedMatrixI8 &b, int32_t *c, size_t ldc, bool accumulate = false,
+             TaskRunner *runner = nullptr);
+/// c = a * b, or c += a * b when `accumulate`, for an `a` packed transposed
+/// in panels of `kernels.mr` (a.n() being the number of rows of the product).
+void gemm_i8(const GemmKernelsI8 &kernels, const PackedMatrixI8 &a, const PackedMatrixI8 &b, int32_t *c, size_t ldc,
+             bool accumulate = false, TaskRunner *runner = nullptr);
+
+} // namespace duckdb_onnx
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace duckdb_onnx {
+
+// Reductions of a row of scores, such as the logits of a classifier, into
+// what is usually read from them: probabilities, the best class or the k
+// best classes.
+
+/// out[i] = exp(x[i] - max(x)) / sum_j exp(x[j] - max(x)) for i < n, with
+/// the element-wise kernels of `simd_level()`. `out` may be `x`.
+void softmax_f32(size_t n, const float *x, float *out);
+
+/// Index of the largest of the `n` values at `x`, the first one on ties.
+/// NaNs are only picked when every value is NaN. `n` is positive.
+size_t argmax_f32(size_t n, const float *x);
+
+/// Indices of the `k` largest of the `n` values at `x`, or of all of them
+/// when k >= n, by decreasing value, then increasing index; NaNs come last.
+std::vector<uint32_t> top_k_f32(size_t n, const float *x, size_t k);
+
+} // namespace duckdb_onnx
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "duckdb-onnx/core/model/tdim.hpp"
+#include "duckdb-onnx/tensor.h"
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace duckdb_onnx {
+
+/// Type information known about a tensor flowing through a typed model.
+struct TypedFact {
+	/// Longest integer constant whose elements are also kept as `symbolic_value`
+	static constexpr size_t MAX_SYMBOLIC_LEN = 32;
+
+	DatumType datum_type = DatumType::F32;
+	/// Dimensions, some of them possibly symbolic or unknown. Only meaningful
+	/// when `rank_known` is set.
+	std::vector<TDim> shape;
+	bool rank_known = false;
+	/// Set when the tensor is a constant of the model
+	std::shared_ptr<Tensor> konst;
+	/// Elements of an integer tensor of rank 0 or 1 computed from shapes,
+	/// such as the output of Shape and what Gather or Concat make of it
+	std::optional<std::vector<TDim>> symbolic_value;
+
+	TypedFact() = default;
+	TypedFact(DatumType dt, std::vector<TDim> dims) : datum_type(dt), shape(std::move(dims)), rank_known(true) {
+	}
+
+	/// A tensor of type `dt` whose rank is not known
+	static TypedFact unknown(DatumType dt) {
+		TypedFact fact;
+		fact.datum_type = dt;
+		return fact;
+	}
+
+	static TypedFact from_const(std::shared_ptr<Tensor> tensor) {
+		TypedFact fact(tensor->datum_type(), std::vector<TDim>(tensor->shape().begin(), tensor->shape().end()));
+		auto dt = tensor->datum_type();
+		if ((dt == DatumType::I64 || dt == DatumType::I32) && tensor->rank() <= 1 &&
+		    tensor->len() <= MAX_SYMBOLIC_LEN) {
+			std::vector<TDim> value;
+			for (size_t i = 0; i < tensor->len(); i++) {
+				value.emplace_back(dt == DatumType::I64 ? tensor->as_ptr<int64_t>()[i] : tensor->as_ptr<int32_t>()[i]);
+			}
+			fact.symbolic_value = std::move(value);
+		}
+		fact.konst = std::move(tensor);
+		return fact;
+	}
+
+	/// The datum type and shape, without the known value
+	TypedFact without_value() const {
+		TypedFact fact;
+		fact.datum_type = datum_type;
+		fact.shape = shape;
+		fact.rank_known = rank_known;
+		return fact;
+	}
+
+	/// Whether every dimension is an integer
+	bool shape_is_concrete() const {
+		if (!rank_known) {
+			return false;
+		}
+		for (auto &dim : shape) {
+			if (!dim.is_int()) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	/// The number of elements, unknown when the rank is
+	TDim len() const {
+		if (!rank_known) {
+			return TDim();
+		}
+		TDim len(1);
+		for (auto &dim : shape) {
+			len = len * dim;
+		}
+		return len;
+	}
+
+	friend std::ostream &operator<<(std::ostream &os, const TypedFact &fact) {
+		if (fact.rank_known) {
+			for (auto &dim : fact.shape) {
+				os << dim << ",";
+			}
+		} else {
+			os << "..,";
+		}
+		os << datum_type_name(fact.datum_type);
+		if (fact.konst) {
+			os << " (const)";
+		}
+		return os;
+	}
+};
+
+} // namespace duckdb_onnx
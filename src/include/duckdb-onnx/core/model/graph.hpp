@@ -4,6 +4,7 @@
 #include "duckdb-onnx/value.h"
 #include <iostream>
 #include <memory>
+#include <stdexcept>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -33,6 +34,121 @@ public:
   Graph() = default;
   Graph(const Graph &other) = default;
   Graph &operator=(const Graph &other) = default;
+
+  /// Append a node with `output_facts.size()` outputs and no wired inputs.
+  /// Returns the new node id.
+  size_t add_node(std::string name, O op, std::vector<F> output_facts) {
+    Node<F, O> node;
+    node.id = nodes.size();
+    node.name = std::move(name);
+    node.op = std::move(op);
+    for (auto &fact : output_facts) {
+      Outlet<F> outlet;
+      outlet.fact = std::move(fact);
+      node.outputs.push_back(std::move(outlet));
+    }
+    nodes.push_back(std::move(node));
+    return nodes.size() - 1;
+  }
+
+  /// Connect `outlet` to the input slot `inlet`, recording the successor.
+  void add_edge(OutletId outlet, InletId inlet) {
+    auto &source = node_checked(outlet.node);
+    if (outlet.slot >= source.outputs.size()) {
+      throw std::out_of_range("Invalid outlet for edge");
+    }
+    auto &target = node_checked(inlet.node);
+    if (target.inputs.size() <= inlet.slot) {
+      target.inputs.resize(inlet.slot + 1);
+    } else {
+      // rewiring an existing input: detach it from its previous source
+      auto previous = target.inputs[inlet.slot];
+      auto &successors = nodes[previous.node].outputs[previous.slot].successors;
+      for (auto it = successors.begin(); it != successors.end(); ++it) {
+        if (*it == inlet) {
+          successors.erase(it);
+          break;
+        }
+      }
+    }
+    target.inputs[inlet.slot] = outlet;
+    source.outputs[outlet.slot].successors.push_back(inlet);
+  }
+
+  const Node<F, O> &node(size_t id) const { return nodes.at(id); }
+  Node<F, O> &node_mut(size_t id) { return nodes.at(id); }
+
+  const F &outlet_fact(OutletId outlet) const {
+    return nodes.at(outlet.node).outputs.at(outlet.slot).fact;
+  }
+  F &outlet_fact_mut(OutletId outlet) {
+    return nodes.at(outlet.node).outputs.at(outlet.slot).fact;
+  }
+
+  /// Find a node by name, returns nullptr if absent
+  const Node<F, O> *node_by_name(const std::string &name) const {
+    for (auto &node : nodes) {
+      if (node.name == name) {
+        return &node;
+      }
+    }
+    return nullptr;
+  }
+
+  void set_outlet_label(OutletId outlet, std::string label) {
+    outlet_labels[outlet] = std::move(label);
+  }
+
+  std::string outlet_label(OutletId outlet) const {
+    auto it = outlet_labels.find(outlet);
+    return it == outlet_labels.end() ? std::string() : it->second;
+  }
+
+  /// Nodes needed to compute the model outputs, in an order where every node
+  /// comes after all of its inputs.
+  std::vector<size_t> eval_order() const { return eval_order_for(outputs); }
+
+  /// Same as `eval_order` restricted to the nodes required by `targets`.
+  std::vector<size_t> eval_order_for(const std::vector<OutletId> &targets) const {
+    std::vector<size_t> order;
+    // 0 = unvisited, 1 = on stack, 2 = done
+    std::vector<char> state(nodes.size(), 0);
+    std::vector<std::pair<size_t, size_t>> stack;
+    for (auto &target : targets) {
+      if (state.at(target.node) != 0) {
+        continue;
+      }
+      stack.emplace_back(target.node, 0);
+      state[target.node] = 1;
+      while (!stack.empty()) {
+        auto &top = stack.back();
+        auto &node = nodes[top.first];
+        if (top.second < node.inputs.size()) {
+          auto input = node.inputs[top.second++].node;
+          if (state[input] == 1) {
+            throw std::runtime_error("Cycle detected in model graph");
+          }
+          if (state[input] == 0) {
+            state[input] = 1;
+            stack.emplace_back(input, 0);
+          }
+        } else {
+          state[top.first] = 2;
+          order.push_back(top.first);
+          stack.pop_back();
+        }
+      }
+    }
+    return order;
+  }
+
+private:
+  Node<F, O> &node_checked(size_t id) {
+    if (id >= nodes.size()) {
+      throw std::out_of_range("Invalid node id");
+    }
+    return nodes[id];
+  }
 };
 
-} // namespace duckdb_onnx
\ No newline at end of file
+} // namespace duckdb_onnx
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstdint>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+namespace duckdb_onnx {
+
+/// Values of the symbols of a model, such as {"N": 32} for its batch size
+using SymbolValues = std::unordered_map<std::string, int64_t>;
+
+/// A tensor dimension as known before the model runs: an integer, an affine
+/// expression `coefficient * symbol + offset` of one named dimension (the
+/// batch size of `[N, 3, 224, 224]`, or `6 * N` once flattened), or unknown.
+/// Results that would need two symbols, or a symbol times itself, are
+/// unknown.
+class TDim {
+public:
+	/// An unknown dimension
+	TDim() = default;
+	TDim(int64_t value) : known_(true), offset_(value) {
+	}
+	static TDim symbol(std::string name) {
+		TDim dim(0);
+		dim.coefficient_ = 1;
+		dim.symbol_ = std::move(name);
+		return dim;
+	}
+
+	bool known() const {
+		return known_;
+	}
+	/// Whether the dimension is a plain integer
+	bool is_int() const {
+		return known_ && coefficient_ == 0;
+	}
+	/// The integer value; only valid when `is_int()`
+	int64_t as_int() const {
+		return offset_;
+	}
+	/// The symbol the dimension depends on, empty for integers
+	const std::string &symbol_name() const {
+		return symbol_;
+	}
+	/// The terms of `coefficient * symbol + offset`, e.g. to serialize it
+	int64_t coefficient() const {
+		return coefficient_;
+	}
+	int64_t offset() const {
+		return offset_;
+	}
+	/// The value for the given symbol values, if they determine it
+	std::optional<int64_t> eval(const SymbolValues &values) const;
+
+	TDim operator+(const TDim &other) const;
+	TDim operator-(const TDim &other) const;
+	TDim operator*(const TDim &other) const;
+	/// Exact division: unknown when the quotient is not a TDim
+	TDim operator/(const TDim &other) const;
+
+	/// Same expression; unknown dimensions are not equal to anything
+	bool operator==(const TDim &other) const {
+		return known_ && other.known_ && coefficient_ == other.coefficient_ && offset_ == other.offset_ &&
+		       symbol_ == other.symbol_;
+	}
+	bool operator!=(const TDim &other) const {
+		return !(*this == other);
+	}
+
+	friend std::ostream &operator<<(std::ostream &os, const TDim &dim);
+
+private:
+	/// `coefficient * symbol + offset`, with an empty symbol when the coefficient is 0
+	static TDim affine(int64_t coefficient, std::string symbol, int64_t offset);
+
+	bool known_ = false;
+	int64_t coefficient_ = 0;
+	std::string symbol_;
+	int64_t offset_ = 0;
+};
+
+} // namespace duckdb_onnx
@@ -0,0 +1,13 @@
+#pragma once
+
+#include "duckdb-onnx/core/model/fact.hpp"
+#include "duckdb-onnx/core/model/graph.hpp"
+#include "duckdb-onnx/core/ops/ops.h"
+
+namespace duckdb_onnx {
+
+/// A model with fully determined operations and typed outlets.
+using TypedModel = Graph<TypedFact, OpBox>;
+using TypedNode = Node<TypedFact, OpBox>;
+
+} // namespace duckdb_onnx
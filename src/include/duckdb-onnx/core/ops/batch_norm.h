@@ -0,0 +1,63 @@
+#pragma once
+
+#include "duckdb-onnx/core/ops/ops.h"
+#include "duckdb-onnx/value.h"
+
+namespace duckdb_onnx {
+
+/// ONNX BatchNormalization in inference mode over F32 [N, C, ...] inputs,
+/// from inputs X, scale, B, mean and var. Each channel is an affine map
+/// x * multiplier + offset, computed once when the statistics are constant.
+class BatchNormOp : public Op {
+public:
+	explicit BatchNormOp(float epsilon) : epsilon(epsilon) {
+	}
+
+	std::string name() const override {
+		return "BatchNormalization";
+	}
+	Validation validation() const override {
+		return Validation::Rounding;
+	}
+
+	TractResult<std::vector<TValue>> eval(const std::vector<TValue> &inputs) const override;
+	TractResult<std::vector<TValue>> eval_with_session(SessionState &session,
+	                                                   std::vector<TValue> inputs) const override;
+	TractResult<std::vector<TypedFact>> output_facts(const std::vector<const TypedFact *> &inputs) const override;
+
+	int inplace_input() const override {
+		return 0;
+	}
+
+	/// Folds constant statistics into per-channel coefficients
+	std::shared_ptr<Op> codegen(const std::vector<std::shared_ptr<Tensor>> &constants) const override;
+	size_t memory_usage() const override {
+		return coefficients ? coefficients->size() * sizeof(float) : 0;
+	}
+
+	bool same_as(const Op *other) const override {
+		auto norm = dynamic_cast<const BatchNormOp *>(other);
+		return norm && norm->epsilon == epsilon && norm->coefficients == coefficients;
+	}
+
+	bool save(PlanWriter &writer) const override;
+	static std::shared_ptr<Op> load(PlanReader &reader);
+
+	std::unique_ptr<Op> clone() const override {
+		return std::unique_ptr<Op>(new BatchNormOp(*this));
+	}
+
+	float epsilon;
+	/// Multipliers then offsets of every channel, used instead of inputs 1 to 4
+	std::shared_ptr<const std::vector<float>> coefficients;
+
+private:
+	std::vector<TValue> eval_impl(SessionState *session, std::vector<TValue> inputs) const;
+};
+
+/// Multipliers then offsets of every channel for inference-mode batch
+/// normalization with the given F32 statistics
+std::vector<float> batch_norm_coefficients(const Tensor &scale, const Tensor &bias, const Tensor &mean,
+                                           const Tensor &var, float epsilon);
+
+} // namespace duckdb_onnx
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "duckdb-onnx/core/kernels/element_wise.hpp"
+#include "duckdb-onnx/core/ops/ops.h"
+#include "duckdb-onnx/value.h"
+
+namespace duckdb_onnx {
+
+/// Element-wise arithmetic between two tensors of the same type, with numpy
+/// broadcasting. F32 runs on the SIMD kernels, other numeric types on scalar
+/// loops.
+class BinaryOp : public Op {
+public:
+	explicit BinaryOp(BinaryKind kind) : kind(kind) {
+	}
+
+	std::string name() const override;
+
+	TractResult<std::vector<TValue>> eval(const std::vector<TValue> &inputs) const override;
+	TractResult<std::vector<TValue>> eval_with_session(SessionState &session,
+	                                                   std::vector<TValue> inputs) const override;
+	TractResult<std::vector<TypedFact>> output_facts(const std::vector<const TypedFact *> &inputs) const override;
+
+	/// The result overwrites the first operand when it is exclusive and already has the output shape
+	int inplace_input() const override {
+		return 0;
+	}
+
+	bool same_as(const Op *other) const override {
+		auto binary = dynamic_cast<const BinaryOp *>(other);
+		return binary && binary->kind == kind;
+	}
+
+	bool save(PlanWriter &writer) const override;
+	static std::shared_ptr<Op> load(PlanReader &reader);
+
+	std::unique_ptr<Op> clone() const override {
+		return std::unique_ptr<Op>(new BinaryOp(*this));
+	}
+
+	BinaryKind kind;
+
+private:
+	std::vector<TValue> eval_impl(SessionState *session, std::vector<TValue> inputs) const;
+};
+
+} // namespace duckdb_onnx
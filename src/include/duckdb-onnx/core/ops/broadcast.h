@@ -0,0 +1,70 @@
+#pragma once
+
+#include "duckdb-onnx/core/model/tdim.hpp"
+#include "duckdb-onnx/tensor.h"
+
+namespace duckdb_onnx {
+
+/// Shape of the result of broadcasting `a` with `b` following the numpy
+/// rules ONNX uses. Throws when the shapes are not compatible.
+ShapeVec broadcast_shapes(const ShapeVec &a, const ShapeVec &b);
+/// `broadcast_shapes` over dimensions known before running the model. A
+/// dimension other than 1 wins over an unknown or symbolic one, which can
+/// only be 1 or equal to it for the model to run.
+std::vector<TDim> broadcast_dims(const std::vector<TDim> &a, const std::vector<TDim> &b);
+
+/// Element iteration of a broadcast binary operation.
+///
+/// Dimensions of size 1 in the output are dropped and adjacent dimensions
+/// that are contiguous for both operands are merged, so the innermost
+/// dimension is as long as possible and every operand steps through it with
+/// a stride of 1, or 0 when it is broadcast along it.
+class BinaryBroadcast {
+public:
+	BinaryBroadcast(const ShapeVec &a, const ShapeVec &b, const ShapeVec &out);
+
+	/// Call `f(out_offset, a_offset, a_step, b_offset, b_step, len)` for each
+	/// run of `len` output elements, offsets and steps counted in elements.
+	template <typename F>
+	void for_each_run(F &&f) const {
+		auto rank = dims_.size();
+		if (rank == 0) {
+			f(size_t(0), size_t(0), size_t(0), size_t(0), size_t(0), size_t(1));
+			return;
+		}
+		auto len = static_cast<size_t>(dims_[rank - 1]);
+		auto a_step = static_cast<size_t>(a_strides_[rank - 1]);
+		auto b_step = static_cast<size_t>(b_strides_[rank - 1]);
+		ShapeVec index;
+		index.resize(rank - 1, 0);
+		size_t a_offset = 0;
+		size_t b_offset = 0;
+		for (size_t out_offset = 0; out_offset < total_; out_offset += len) {
+			f(out_offset, a_offset, a_step, b_offset, b_step, len);
+			// odometer over the outer dimensions
+			for (size_t d = rank - 1; d-- > 0;) {
+				a_offset += a_strides_[d];
+				b_offset += b_strides_[d];
+				if (++index[d] < dims_[d]) {
+					break;
+				}
+				a_offset -= a_strides_[d] * dims_[d];
+				b_offset -= b_strides_[d] * dims_[d];
+				index[d] = 0;
+			}
+		}
+	}
+
+	/// Dimensions after merging, for tests and debugging
+	const ShapeVec &dims() const {
+		return dims_;
+	}
+
+private:
+	ShapeVec dims_;
+	ShapeVec a_strides_;
+	ShapeVec b_strides_;
+	size_t total_ = 1;
+};
+
+} // namespace duckdb_onnx
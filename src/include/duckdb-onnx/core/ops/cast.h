@@ -0,0 +1,55 @@
+#pragma once
+
+#include "duckdb-onnx/core/ops/ops.h"
+#include "duckdb-onnx/value.h"
+
+namespace duckdb_onnx {
+
+/// Convert every element of `input` into `output`, which has the same number
+/// of elements and the target datum type. F16 and BF16 values go through
+/// float.
+void cast_elements(const Tensor &input, Tensor &output);
+
+/// Convert a tensor to another datum type, element by element.
+class CastOp : public Op {
+public:
+	explicit CastOp(DatumType to) : to(to) {
+	}
+
+	std::string name() const override {
+		return "Cast";
+	}
+
+	TractResult<std::vector<TValue>> eval(const std::vector<TValue> &inputs) const override;
+	TractResult<std::vector<TValue>> eval_with_session(SessionState &session,
+	                                                   std::vector<TValue> inputs) const override;
+	TractResult<std::vector<TypedFact>> output_facts(const std::vector<const TypedFact *> &inputs) const override;
+
+	/// A cast to the input type returns the input
+	int inplace_input() const override {
+		return 0;
+	}
+
+	bool same_as(const Op *other) const override {
+		auto cast = dynamic_cast<const CastOp *>(other);
+		return cast && cast->to == to;
+	}
+
+	void debug_print(std::ostream &os) const override {
+		os << "Cast(" << datum_type_name(to) << ")";
+	}
+
+	bool save(PlanWriter &writer) const override;
+	static std::shared_ptr<Op> load(PlanReader &reader);
+
+	std::unique_ptr<Op> clone() const override {
+		return std::unique_ptr<Op>(new CastOp(*this));
+	}
+
+	DatumType to;
+
+private:
+	std::vector<TValue> eval_impl(SessionState *session, std::vector<TValue> inputs) const;
+};
+
+} // namespace duckdb_onnx
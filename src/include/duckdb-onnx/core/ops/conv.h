@@ -0,0 +1,71 @@
+#pragma once
+
+#include "duckdb-onnx/core/kernels/gemm.hpp"
+#include "duckdb-onnx/core/ops/fused.h"
+#include "duckdb-onnx/core/ops/ops.h"
+#include "duckdb-onnx/core/ops/patch.h"
+#include "duckdb-onnx/value.h"
+
+namespace duckdb_onnx {
+
+/// ONNX Conv over NCHW (or NCW) F32 images, with optional bias and groups.
+/// The filters may be F16 or BF16.
+/// Each group is one GEMM: its filters, packed as the left-hand side, times
+/// the input patches, gathered straight into the packed panels of the
+/// right-hand side (im2col), write the NCHW output rows in place.
+class ConvOp : public Op {
+public:
+	ConvOp(PatchSpec patch, int64_t group) : patch(std::move(patch)), group(group) {
+	}
+
+	std::string name() const override {
+		return "Conv";
+	}
+	Validation validation() const override {
+		return Validation::Rounding;
+	}
+
+	TractResult<std::vector<TValue>> eval(const std::vector<TValue> &inputs) const override;
+	TractResult<std::vector<TValue>> eval_with_session(SessionState &session,
+	                                                   std::vector<TValue> inputs) const override;
+	TractResult<std::vector<TypedFact>> output_facts(const std::vector<const TypedFact *> &inputs) const override;
+
+	/// Packs constant F32, F16 or BF16 filters
+	std::shared_ptr<Op> codegen(const std::vector<std::shared_ptr<Tensor>> &constants) const override;
+	size_t memory_usage() const override;
+	uint64_t flops(const std::vector<ShapeVec> &inputs, const std::vector<ShapeVec> &outputs) const override;
+
+	bool same_as(const Op *other) const override {
+		auto conv = dynamic_cast<const ConvOp *>(other);
+		return conv && conv->patch == patch && conv->group == group && conv->packed_filters == packed_filters &&
+		       conv->epilogue == epilogue;
+	}
+
+	void debug_print(std::ostream &os) const override {
+		os << "Op(Conv";
+		if (epilogue) {
+			os << " + " << *epilogue;
+		}
+		os << ")";
+	}
+
+	bool save(PlanWriter &writer) const override;
+	static std::shared_ptr<Op> load(PlanReader &reader);
+
+	std::unique_ptr<Op> clone() const override {
+		return std::unique_ptr<Op>(new ConvOp(*this));
+	}
+
+	PatchSpec patch;
+	int64_t group;
+	/// The filters of each group packed at load time, used instead of input 1
+	std::shared_ptr<const std::vector<PackedMatrixF32>> packed_filters;
+	/// Element-wise ops applied to each block of output rows while it is
+	/// still in cache, fused in by the optimizer
+	std::shared_ptr<const ElementwiseChain> epilogue;
+
+private:
+	std::vector<TValue> eval_impl(SessionState *session, std::vector<TValue> inputs) const;
+};
+
+} // namespace duckdb_onnx
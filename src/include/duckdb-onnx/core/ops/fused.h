@@ -0,0 +1,112 @@
+#pragma once
+
+#include "duckdb-onnx/core/kernels/element_wise.hpp"
+#include "duckdb-onnx/core/ops/ops.h"
+#include "duckdb-onnx/value.h"
+
+namespace duckdb_onnx {
+
+/// A chain of element-wise ops applied in one pass over the data, block by
+/// block so that intermediate values stay in L1. Steps are unary ops, Clip
+/// with fixed bounds and binary ops with a scalar constant operand.
+class ElementwiseChain {
+public:
+	struct Step {
+		/// The fused op, evaluated as is for other types than F32
+		std::shared_ptr<Op> op;
+		/// Constant operand of a binary step, null otherwise
+		std::shared_ptr<Tensor> operand;
+		/// Whether the constant is the left-hand operand
+		bool operand_first = false;
+	};
+
+	/// Whether `op` can join a chain, given the constant operand of a binary op
+	static bool fusible(const Op &op, const Tensor *operand);
+
+	/// Append a step, which must be `fusible`
+	void push(Step step);
+
+	const std::vector<Step> &steps() const {
+		return steps_;
+	}
+	bool empty() const {
+		return steps_.empty();
+	}
+
+	/// Whether `apply_f32` computes the chain for `input`: an F32 tensor that
+	/// no constant operand broadcasts to a higher rank
+	bool runs_f32(const Tensor &input) const;
+	/// y = chain(x) over n floats; `y` may be `x`
+	void apply_f32(size_t n, const float *x, float *y) const;
+	/// The chain evaluated op by op, for any input
+	TValue eval(TValue input) const;
+	/// The fact of the output for an input of fact `input`
+	TypedFact output_fact(const TypedFact &input) const;
+
+	bool operator==(const ElementwiseChain &other) const;
+	/// Serialization of the steps into a plan file
+	void save(PlanWriter &writer) const;
+	static ElementwiseChain load(PlanReader &reader);
+	/// The names of the steps, comma separated
+	friend std::ostream &operator<<(std::ostream &os, const ElementwiseChain &chain);
+
+private:
+	enum class StepKind { Unary, Clip, Binary };
+	struct Kernel {
+		StepKind kind;
+		UnaryKind unary;
+		BinaryKind binary;
+		float lo;
+		float hi;
+		float scalar;
+		bool scalar_first;
+		bool f32;
+	};
+
+	std::vector<Step> steps_;
+	std::vector<Kernel> kernels_;
+	size_t operand_rank_ = 0;
+};
+
+/// Element-wise ops fused at load time into one chain
+class FusedElementwiseOp : public Op {
+public:
+	explicit FusedElementwiseOp(ElementwiseChain chain) : chain(std::move(chain)) {
+	}
+
+	std::string name() const override {
+		return "FusedElementwise";
+	}
+	Validation validation() const override;
+	uint64_t flops(const std::vector<ShapeVec> &inputs, const std::vector<ShapeVec> &outputs) const override;
+
+	TractResult<std::vector<TValue>> eval(const std::vector<TValue> &inputs) const override;
+	TractResult<std::vector<TValue>> eval_with_session(SessionState &session,
+	                                                   std::vector<TValue> inputs) const override;
+	TractResult<std::vector<TypedFact>> output_facts(const std::vector<const TypedFact *> &inputs) const override;
+
+	int inplace_input() const override {
+		return 0;
+	}
+
+	bool same_as(const Op *other) const override {
+		auto fused = dynamic_cast<const FusedElementwiseOp *>(other);
+		return fused && fused->chain == chain;
+	}
+
+	void debug_print(std::ostream &os) const override;
+
+	bool save(PlanWriter &writer) const override;
+	static std::shared_ptr<Op> load(PlanReader &reader);
+
+	std::unique_ptr<Op> clone() const override {
+		return std::unique_ptr<Op>(new FusedElementwiseOp(*this));
+	}
+
+	ElementwiseChain chain;
+
+private:
+	std::vector<TValue> eval_impl(SessionState *session, std::vector<TValue> inputs) const;
+};
+
+} // namespace duckdb_onnx
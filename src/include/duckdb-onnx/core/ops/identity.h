@@ -0,0 +1,42 @@
+#pragma once
+
+#include "duckdb-onnx/core/ops/ops.h"
+#include "duckdb-onnx/value.h"
+
+namespace duckdb_onnx {
+
+/// Forwards its inputs unchanged.
+class IdentityOp : public Op {
+public:
+	std::string name() const override {
+		return "Identity";
+	}
+
+	TractResult<std::vector<TValue>> eval(const std::vector<TValue> &inputs) const override {
+		return Ok(inputs);
+	}
+	TractResult<std::vector<TypedFact>> output_facts(const std::vector<const TypedFact *> &inputs) const override {
+		std::vector<TypedFact> facts;
+		for (auto input : inputs) {
+			facts.push_back(*input);
+		}
+		return Ok(std::move(facts));
+	}
+
+	int inplace_input() const override {
+		return 0;
+	}
+
+	bool same_as(const Op *other) const override {
+		return dynamic_cast<const IdentityOp *>(other) != nullptr;
+	}
+
+	bool save(PlanWriter &writer) const override;
+	static std::shared_ptr<Op> load(PlanReader &reader);
+
+	std::unique_ptr<Op> clone() const override {
+		return std::unique_ptr<Op>(new IdentityOp(*this));
+	}
+};
+
+} // namespace duckdb_onnx
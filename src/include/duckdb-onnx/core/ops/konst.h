@@ -0,0 +1,40 @@
+#pragma once
+
+#include "duckdb-onnx/core/ops/ops.h"
+#include "duckdb-onnx/value.h"
+
+namespace duckdb_onnx {
+
+/// A constant of the model, typically an ONNX initializer.
+class ConstOp : public Op {
+public:
+	explicit ConstOp(std::shared_ptr<Tensor> value) : value(std::move(value)) {
+	}
+
+	std::string name() const override {
+		return "Const";
+	}
+
+	TractResult<std::vector<TValue>> eval(const std::vector<TValue> &inputs) const override {
+		return Ok(std::vector<TValue> {TValue::Const(value)});
+	}
+	TractResult<std::vector<TypedFact>> output_facts(const std::vector<const TypedFact *> &inputs) const override {
+		return Ok(std::vector<TypedFact> {TypedFact::from_const(value)});
+	}
+
+	bool same_as(const Op *other) const override {
+		auto konst = dynamic_cast<const ConstOp *>(other);
+		return konst && konst->value == value;
+	}
+
+	bool save(PlanWriter &writer) const override;
+	static std::shared_ptr<Op> load(PlanReader &reader);
+
+	std::unique_ptr<Op> clone() const override {
+		return std::unique_ptr<Op>(new ConstOp(*this));
+	}
+
+	std::shared_ptr<Tensor> value;
+};
+
+} // namespace duckdb_onnx
@@ -0,0 +1,130 @@
+#pragma once
+
+#include "duckdb-onnx/core/kernels/gemm.hpp"
+#include "duckdb-onnx/core/ops/fused.h"
+#include "duckdb-onnx/core/ops/ops.h"
+#include "duckdb-onnx/value.h"
+
+namespace duckdb_onnx {
+
+/// Matrix product with numpy semantics: the last two dimensions are
+/// multiplied and the leading ones broadcast, 1-D operands are promoted to
+/// matrices. F32 runs on the packed GEMM, other numeric types on a plain loop.
+/// The right-hand side of an F32 product may be F16 or BF16 weights.
+/// An optional third input is a 1-D bias added to every row, as a following
+/// Add is fused in by the optimizer.
+class MatMulOp : public Op {
+public:
+	MatMulOp() = default;
+
+	std::string name() const override {
+		return "MatMul";
+	}
+	Validation validation() const override {
+		return Validation::Rounding;
+	}
+
+	TractResult<std::vector<TValue>> eval(const std::vector<TValue> &inputs) const override;
+	TractResult<std::vector<TValue>> eval_with_session(SessionState &session,
+	                                                   std::vector<TValue> inputs) const override;
+	TractResult<std::vector<TypedFact>> output_facts(const std::vector<const TypedFact *> &inputs) const override;
+
+	/// Packs a constant F32, F16 or BF16 matrix right-hand side
+	std::shared_ptr<Op> codegen(const std::vector<std::shared_ptr<Tensor>> &constants) const override;
+	size_t memory_usage() const override {
+		return packed_b ? packed_b->heap_bytes() : 0;
+	}
+	uint64_t flops(const std::vector<ShapeVec> &inputs, const std::vector<ShapeVec> &outputs) const override;
+
+	bool same_as(const Op *other) const override {
+		auto matmul = dynamic_cast<const MatMulOp *>(other);
+		return matmul && matmul->packed_b == packed_b && matmul->epilogue == epilogue;
+	}
+
+	void debug_print(std::ostream &os) const override {
+		os << "Op(MatMul";
+		if (epilogue) {
+			os << " + " << *epilogue;
+		}
+		os << ")";
+	}
+
+	bool save(PlanWriter &writer) const override;
+	static std::shared_ptr<Op> load(PlanReader &reader);
+
+	std::unique_ptr<Op> clone() const override {
+		return std::unique_ptr<Op>(new MatMulOp(*this));
+	}
+
+	/// The right-hand side packed at load time, used instead of input 1
+	std::shared_ptr<const PackedMatrixF32> packed_b;
+	/// Element-wise ops applied to the output, fused in by the optimizer
+	std::shared_ptr<const ElementwiseChain> epilogue;
+
+private:
+	std::vector<TValue> eval_impl(SessionState *session, std::vector<TValue> inputs) const;
+};
+
+/// ONNX Gemm: alpha * A' * B' + beta * C for 2-D A and B, each optionally
+/// transposed, and an optional C broadcast to the output. B of an F32
+/// product may be F16 or BF16 weights.
+class GemmOp : public Op {
+public:
+	GemmOp(float alpha, float beta, bool trans_a, bool trans_b)
+	    : alpha(alpha), beta(beta), trans_a(trans_a), trans_b(trans_b) {
+	}
+
+	std::string name() const override {
+		return "Gemm";
+	}
+	Validation validation() const override {
+		return Validation::Rounding;
+	}
+
+	TractResult<std::vector<TValue>> eval(const std::vector<TValue> &inputs) const override;
+	TractResult<std::vector<TValue>> eval_with_session(SessionState &session,
+	                                                   std::vector<TValue> inputs) const override;
+	TractResult<std::vector<TypedFact>> output_facts(const std::vector<const TypedFact *> &inputs) const override;
+
+	/// Packs a constant F32, F16 or BF16 B
+	std::shared_ptr<Op> codegen(const std::vector<std::shared_ptr<Tensor>> &constants) const override;
+	size_t memory_usage() const override {
+		return packed_b ? packed_b->heap_bytes() : 0;
+	}
+	uint64_t flops(const std::vector<ShapeVec> &inputs, const std::vector<ShapeVec> &outputs) const override;
+
+	bool same_as(const Op *other) const override {
+		auto gemm = dynamic_cast<const GemmOp *>(other);
+		return gemm && gemm->alpha == alpha && gemm->beta == beta && gemm->trans_a == trans_a &&
+		       gemm->trans_b == trans_b && gemm->packed_b == packed_b && gemm->epilogue == epilogue;
+	}
+
+	void debug_print(std::ostream &os) const override {
+		os << "Op(Gemm";
+		if (epilogue) {
+			os << " + " << *epilogue;
+		}
+		os << ")";
+	}
+
+	bool save(PlanWriter &writer) const override;
+	static std::shared_ptr<Op> load(PlanReader &reader);
+
+	std::unique_ptr<Op> clone() const override {
+		return std::unique_ptr<Op>(new GemmOp(*this));
+	}
+
+	float alpha;
+	float beta;
+	bool trans_a;
+	bool trans_b;
+	/// B packed at load time (already transposed when `trans_b`), used instead of input 1
+	std::shared_ptr<const PackedMatrixF32> packed_b;
+	/// Element-wise ops applied to the output, fused in by the optimizer
+	std::shared_ptr<const ElementwiseChain> epilogue;
+
+private:
+	std::vector<TValue> eval_impl(SessionState *session, std::vector<TValue> inputs) const;
+};
+
+} // namespace duckdb_onnx
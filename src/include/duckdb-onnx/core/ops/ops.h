@@ -1,7 +1,10 @@
 #pragma once
 
+#include "duckdb-onnx/core/model/fact.hpp"
 #include "duckdb-onnx/error.h"
+#include "duckdb-onnx/value.h"
 #include <iostream>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -13,13 +16,31 @@ enum class Validation {
 	Accurate, // 实现必须准确
 };
 
-class TValue;
+class SessionState;
+class PlanWriter;
+class PlanReader;
 // EvalOp 基础接口类
 class EvalOp {
 public:
 	virtual ~EvalOp() = default;
 	// EvalOp 的方法...
 	virtual TractResult<std::vector<TValue>> eval(const std::vector<TValue> &inputs) const = 0;
+
+	/// Evaluation within a plan execution. Ops producing new tensors override
+	/// this to allocate them with `session.output_tensor`. Inputs used for the
+	/// last time are moved in, so they can be reused when `is_exclusive()`.
+	virtual TractResult<std::vector<TValue>> eval_with_session(SessionState &session,
+	                                                           std::vector<TValue> inputs) const {
+		return eval(inputs);
+	}
+
+	/// Input whose storage output 0 may take over, or -1. Ops returning this
+	/// input (or a view of it) and ops writing their result in place into it
+	/// when it is exclusive must declare it, so that the memory planner keeps
+	/// its buffer alive as long as the output.
+	virtual int inplace_input() const {
+		return -1;
+	}
 };
 
 // Op 基础接口类
@@ -44,6 +65,38 @@ public:
 		os << "Op(" << name() << ")";
 	}
 
+	/// Facts of the outputs given the facts of the inputs, for load-time type
+	/// and shape inference. Returns no facts when the op cannot tell, and an
+	/// error when the inputs cannot be valid for it.
+	virtual TractResult<std::vector<TypedFact>> output_facts(const std::vector<const TypedFact *> &inputs) const {
+		return Ok(std::vector<TypedFact>());
+	}
+
+	/// Load-time specialization given the constant inputs of the node
+	/// (`constants[i]` is null when input i is computed): an equivalent op
+	/// that prepared what it could from them once, such as weights packed in
+	/// the layout of its kernel, or nullptr when there is nothing to prepare.
+	virtual std::shared_ptr<Op> codegen(const std::vector<std::shared_ptr<Tensor>> &constants) const {
+		return nullptr;
+	}
+
+	/// Heap bytes held by the op itself, e.g. prepacked weights
+	virtual size_t memory_usage() const {
+		return 0;
+	}
+
+	/// Estimated arithmetic operations of one evaluation on inputs of shapes
+	/// `inputs` giving outputs of shapes `outputs`, for profiles. A
+	/// multiply-add counts as two; by default, one per output element.
+	virtual uint64_t flops(const std::vector<ShapeVec> &inputs, const std::vector<ShapeVec> &outputs) const;
+	/// Serialization into a plan file (see plan_file.hpp): writes the tag
+	/// its loader is registered under, then its attributes and prepacked
+	/// data. Returns false when the op cannot be saved, and then neither can
+	/// a model using it.
+	virtual bool save(PlanWriter &writer) const {
+		return false;
+	}
+
 	// 克隆方法（对应 DynClone trait）
 	virtual std::unique_ptr<Op> clone() const = 0;
 };
@@ -54,4 +107,60 @@ inline std::ostream &operator<<(std::ostream &os, const Op &op) {
 	return os;
 }
 
+/// Output facts of an op with a single output of the type and shape of its
+/// first input, such as the element-wise ops
+TractResult<std::vector<TypedFact>> same_as_input_facts(const Op &op, const std::vector<const TypedFact *> &inputs);
+
+/// Number of elements of a tensor of shape `shape`
+uint64_t shape_volume(const ShapeVec &shape);
+
+/// Owning handle to the operation of a graph node.
+///
+/// Copies of a graph share their operations (ops are immutable once built);
+/// `as_mut` clones the operation first when it is shared.
+class OpBox {
+public:
+	OpBox() = default;
+	OpBox(std::shared_ptr<Op> op) : op_(std::move(op)) {
+	}
+
+	const Op *get() const {
+		return op_.get();
+	}
+	const Op &operator*() const {
+		return *op_;
+	}
+	const Op *operator->() const {
+		return op_.get();
+	}
+	explicit operator bool() const {
+		return op_ != nullptr;
+	}
+
+	Op *as_mut() {
+		if (op_ && op_.use_count() > 1) {
+			op_ = std::shared_ptr<Op>(op_->clone());
+		}
+		return op_.get();
+	}
+
+	/// Downcast to a concrete op type, or nullptr
+	template <typename OpType>
+	const OpType *as() const {
+		return dynamic_cast<const OpType *>(op_.get());
+	}
+
+private:
+	std::shared_ptr<Op> op_;
+};
+
+inline std::ostream &operator<<(std::ostream &os, const OpBox &op) {
+	if (op) {
+		op->debug_print(os);
+	} else {
+		os << "Op(none)";
+	}
+	return os;
+}
+
 } // namespace duckdb_onnx
\ No newline at end of file
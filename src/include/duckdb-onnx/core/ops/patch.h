@@ -0,0 +1,76 @@
+#pragma once
+
+#include "duckdb-onnx/core/model/tdim.hpp"
+#include "duckdb-onnx/tensor.h"
+
+#include <vector>
+
+namespace duckdb_onnx {
+
+class PlanWriter;
+class PlanReader;
+
+/// How convolutions and pools pad their input (ONNX `auto_pad`)
+enum class PaddingMode {
+	/// The `pads` attribute (NOTSET)
+	Explicit,
+	/// No padding
+	Valid,
+	/// Pad so that the output has ceil(input / stride) pixels, the odd pixel at the end
+	SameUpper,
+	/// Same, the odd pixel at the beginning
+	SameLower,
+};
+
+/// Window geometry of a convolution or pool over one image, resolved for
+/// its input size. Index 0 is the height and 1 the width; 1-D operators have
+/// a height of 1.
+struct PatchGeometry {
+	int64_t input[2];
+	int64_t output[2];
+	int64_t kernel[2];
+	int64_t strides[2];
+	int64_t dilations[2];
+	int64_t pad_begin[2];
+	int64_t pad_end[2];
+
+	/// Input coordinate read along `axis` by output `o` at kernel offset `k`;
+	/// outside of [0, input) it falls in the padding.
+	int64_t input_index(size_t axis, int64_t o, int64_t k) const {
+		return o * strides[axis] - pad_begin[axis] + k * dilations[axis];
+	}
+	int64_t output_len() const {
+		return output[0] * output[1];
+	}
+};
+
+/// Window attributes shared by Conv and the pools. Empty strides, dilations
+/// and pads default to 1, 1 and 0.
+struct PatchSpec {
+	ShapeVec strides;
+	ShapeVec dilations;
+	/// Begins then ends, as in ONNX
+	ShapeVec pads;
+	PaddingMode padding = PaddingMode::Explicit;
+	bool ceil_mode = false;
+
+	/// Geometry over an input of spatial shape `input` (1 or 2 dimensions)
+	/// for a window of shape `kernel`. Throws when they do not fit.
+	PatchGeometry geometry(const ShapeVec &input, const ShapeVec &kernel) const;
+	/// Output shape `[N, channels, spatial...]` for an input of shape `input`
+	/// (`[N, C, spatial...]`) and a window of spatial shape `kernel`. Spatial
+	/// dimensions that are not integers, or whose kernel is not, are unknown.
+	std::vector<TDim> output_shape(const std::vector<TDim> &input, const TDim &channels,
+	                               const std::vector<TDim> &kernel) const;
+
+	/// Serialization into a plan file
+	void save(PlanWriter &writer) const;
+	static PatchSpec load(PlanReader &reader);
+
+	bool operator==(const PatchSpec &other) const {
+		return strides == other.strides && dilations == other.dilations && pads == other.pads &&
+		       padding == other.padding && ceil_mode == other.ceil_mode;
+	}
+};
+
+} // namespace duckdb_onnx
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "duckdb-onnx/core/ops/ops.h"
+#include "duckdb-onnx/core/ops/patch.h"
+#include "duckdb-onnx/value.h"
+
+namespace duckdb_onnx {
+
+enum class PoolKind {
+	Max,
+	Average,
+};
+
+/// ONNX MaxPool and AveragePool over NCHW (or NCW) F32 images. Windows are
+/// reduced separably, along rows then along columns, each pass running on
+/// the element-wise SIMD kernels.
+class PoolOp : public Op {
+public:
+	PoolOp(PoolKind kind, ShapeVec kernel, PatchSpec patch, bool count_include_pad = false)
+	    : kind(kind), kernel(std::move(kernel)), patch(std::move(patch)), count_include_pad(count_include_pad) {
+	}
+
+	std::string name() const override {
+		return kind == PoolKind::Max ? "MaxPool" : "AveragePool";
+	}
+	Validation validation() const override {
+		return kind == PoolKind::Max ? Validation::Accurate : Validation::Rounding;
+	}
+
+	TractResult<std::vector<TValue>> eval(const std::vector<TValue> &inputs) const override;
+	TractResult<std::vector<TValue>> eval_with_session(SessionState &session,
+	                                                   std::vector<TValue> inputs) const override;
+	TractResult<std::vector<TypedFact>> output_facts(const std::vector<const TypedFact *> &inputs) const override;
+
+	bool same_as(const Op *other) const override {
+		auto pool = dynamic_cast<const PoolOp *>(other);
+		return pool && pool->kind == kind && pool->kernel == kernel && pool->patch == patch &&
+		       pool->count_include_pad == count_include_pad;
+	}
+
+	bool save(PlanWriter &writer) const override;
+	static std::shared_ptr<Op> load(PlanReader &reader);
+
+	std::unique_ptr<Op> clone() const override {
+		return std::unique_ptr<Op>(new PoolOp(*this));
+	}
+
+	PoolKind kind;
+	ShapeVec kernel;
+	PatchSpec patch;
+	/// Average over the whole window rather than only its pixels inside the image
+	bool count_include_pad;
+
+private:
+	std::vector<TValue> eval_impl(SessionState *session, std::vector<TValue> inputs) const;
+};
+
+/// ONNX GlobalMaxPool and GlobalAveragePool: one value per channel, the
+/// spatial dimensions kept with size 1
+class GlobalPoolOp : public Op {
+public:
+	explicit GlobalPoolOp(PoolKind kind) : kind(kind) {
+	}
+
+	std::string name() const override {
+		return kind == PoolKind::Max ? "GlobalMaxPool" : "GlobalAveragePool";
+	}
+	Validation validation() const override {
+		return kind == PoolKind::Max ? Validation::Accurate : Validation::Rounding;
+	}
+
+	TractResult<std::vector<TValue>> eval(const std::vector<TValue> &inputs) const override;
+	TractResult<std::vector<TValue>> eval_with_session(SessionState &session,
+	                                                   std::vector<TValue> inputs) const override;
+	TractResult<std::vector<TypedFact>> output_facts(const std::vector<const TypedFact *> &inputs) const override;
+
+	bool same_as(const Op *other) const override {
+		auto pool = dynamic_cast<const GlobalPoolOp *>(other);
+		return pool && pool->kind == kind;
+	}
+
+	bool save(PlanWriter &writer) const override;
+	static std::shared_ptr<Op> load(PlanReader &reader);
+
+	std::unique_ptr<Op> clone() const override {
+		return std::unique_ptr<Op>(new GlobalPoolOp(*this));
+	}
+
+	PoolKind kind;
+
+private:
+	std::vector<TValue> eval_impl(SessionState *session, std::vector<TValue> inputs) const;
+};
+
+} // namespace duckdb_onnx
@@ -0,0 +1,191 @@
+#pragma once
+
+#include "duckdb-onnx/core/kernels/qgemm.hpp"
+#include "duckdb-onnx/core/ops/ops.h"
+#include "duckdb-onnx/core/ops/patch.h"
+#include "duckdb-onnx/value.h"
+
+namespace duckdb_onnx {
+
+// Linear quantization as in ONNX: a real value r is stored as the 8-bit
+// integer q = saturate(round(r / scale) + zero_point), rounding half to even,
+// and read back as (q - zero_point) * scale. Scales and zero points are
+// scalars, or 1-D along one axis for per-channel quantization.
+
+/// ONNX QuantizeLinear: F32 x, scale and optional zero point, whose type
+/// (UINT8 when absent) is the output type.
+class QuantizeLinearOp : public Op {
+public:
+	explicit QuantizeLinearOp(int64_t axis) : axis(axis) {
+	}
+
+	std::string name() const override {
+		return "QuantizeLinear";
+	}
+
+	TractResult<std::vector<TValue>> eval(const std::vector<TValue> &inputs) const override;
+	TractResult<std::vector<TValue>> eval_with_session(SessionState &session,
+	                                                   std::vector<TValue> inputs) const override;
+	TractResult<std::vector<TypedFact>> output_facts(const std::vector<const TypedFact *> &inputs) const override;
+
+	bool same_as(const Op *other) const override {
+		auto op = dynamic_cast<const QuantizeLinearOp *>(other);
+		return op && op->axis == axis;
+	}
+
+	bool save(PlanWriter &writer) const override;
+	static std::shared_ptr<Op> load(PlanReader &reader);
+
+	std::unique_ptr<Op> clone() const override {
+		return std::unique_ptr<Op>(new QuantizeLinearOp(*this));
+	}
+
+	/// Axis of per-channel scales
+	int64_t axis;
+
+private:
+	std::vector<TValue> eval_impl(SessionState *session, std::vector<TValue> inputs) const;
+};
+
+/// ONNX DequantizeLinear: UINT8, INT8 or INT32 x, scale and optional zero
+/// point, to F32.
+class DequantizeLinearOp : public Op {
+public:
+	explicit DequantizeLinearOp(int64_t axis) : axis(axis) {
+	}
+
+	std::string name() const override {
+		return "DequantizeLinear";
+	}
+
+	TractResult<std::vector<TValue>> eval(const std::vector<TValue> &inputs) const override;
+	TractResult<std::vector<TValue>> eval_with_session(SessionState &session,
+	                                                   std::vector<TValue> inputs) const override;
+	TractResult<std::vector<TypedFact>> output_facts(const std::vector<const TypedFact *> &inputs) const override;
+
+	bool same_as(const Op *other) const override {
+		auto op = dynamic_cast<const DequantizeLinearOp *>(other);
+		return op && op->axis == axis;
+	}
+
+	bool save(PlanWriter &writer) const override;
+	static std::shared_ptr<Op> load(PlanReader &reader);
+
+	std::unique_ptr<Op> clone() const override {
+		return std::unique_ptr<Op>(new DequantizeLinearOp(*this));
+	}
+
+	/// Axis of per-channel scales
+	int64_t axis;
+
+private:
+	std::vector<TValue> eval_impl(SessionState *session, std::vector<TValue> inputs) const;
+};
+
+/// Matrix product of 8-bit operands accumulated in 32 bits, on the integer
+/// GEMM: ONNX MatMulInteger (inputs A, B and optional zero points, INT32
+/// output) and QLinearMatMul (A, scale, zero point, B, scale, zero point,
+/// then the scale and zero point the output is requantized to). The zero
+/// point and scale of B may be per column.
+class QMatMulOp : public Op {
+public:
+	QMatMulOp(bool requantize, int a_zero_point_input, int b_zero_point_input)
+	    : requantize(requantize), a_zero_point_input(a_zero_point_input), b_zero_point_input(b_zero_point_input) {
+	}
+
+	std::string name() const override {
+		return requantize ? "QLinearMatMul" : "MatMulInteger";
+	}
+
+	TractResult<std::vector<TValue>> eval(const std::vector<TValue> &inputs) const override;
+	TractResult<std::vector<TValue>> eval_with_session(SessionState &session,
+	                                                   std::vector<TValue> inputs) const override;
+	TractResult<std::vector<TypedFact>> output_facts(const std::vector<const TypedFact *> &inputs) const override;
+
+	/// Packs a constant matrix B with its constant zero points
+	std::shared_ptr<Op> codegen(const std::vector<std::shared_ptr<Tensor>> &constants) const override;
+	size_t memory_usage() const override {
+		return packed_b ? packed_b->heap_bytes() : 0;
+	}
+	uint64_t flops(const std::vector<ShapeVec> &inputs, const std::vector<ShapeVec> &outputs) const override;
+
+	bool same_as(const Op *other) const override {
+		auto op = dynamic_cast<const QMatMulOp *>(other);
+		return op && op->requantize == requantize && op->a_zero_point_input == a_zero_point_input &&
+		       op->b_zero_point_input == b_zero_point_input && op->packed_b == packed_b;
+	}
+
+	void debug_print(std::ostream &os) const override {
+		os << "Op(" << name() << (packed_b ? ", packed" : "") << ")";
+	}
+
+	bool save(PlanWriter &writer) const override;
+	static std::shared_ptr<Op> load(PlanReader &reader);
+
+	std::unique_ptr<Op> clone() const override {
+		return std::unique_ptr<Op>(new QMatMulOp(*this));
+	}
+
+	/// QLinearMatMul when set, MatMulInteger otherwise
+	bool requantize;
+	/// inputs holding the zero points, -1 when omitted (zero)
+	int a_zero_point_input;
+	int b_zero_point_input;
+	/// B minus its zero points packed at load time, used instead of input B
+	std::shared_ptr<const PackedMatrixI8> packed_b;
+
+private:
+	std::vector<TValue> eval_impl(SessionState *session, std::vector<TValue> inputs) const;
+};
+
+/// ONNX QLinearConv over NCHW (or NCW) 8-bit images: x, its scale and zero
+/// point, the filters, their scale and zero point (per output channel or
+/// not), the output scale and zero point and an optional INT32 bias. Runs
+/// like ConvOp, with the patches packed minus the input zero point, so that
+/// the padding reads as zero, and the filters packed once at load time.
+class QLinearConvOp : public Op {
+public:
+	QLinearConvOp(PatchSpec patch, int64_t group) : patch(std::move(patch)), group(group) {
+	}
+
+	std::string name() const override {
+		return "QLinearConv";
+	}
+
+	TractResult<std::vector<TValue>> eval(const std::vector<TValue> &inputs) const override;
+	TractResult<std::vector<TValue>> eval_with_session(SessionState &session,
+	                                                   std::vector<TValue> inputs) const override;
+	TractResult<std::vector<TypedFact>> output_facts(const std::vector<const TypedFact *> &inputs) const override;
+
+	/// Packs constant filters with their constant zero points
+	std::shared_ptr<Op> codegen(const std::vector<std::shared_ptr<Tensor>> &constants) const override;
+	size_t memory_usage() const override;
+	uint64_t flops(const std::vector<ShapeVec> &inputs, const std::vector<ShapeVec> &outputs) const override;
+
+	bool same_as(const Op *other) const override {
+		auto conv = dynamic_cast<const QLinearConvOp *>(other);
+		return conv && conv->patch == patch && conv->group == group && conv->packed_filters == packed_filters;
+	}
+
+	void debug_print(std::ostream &os) const override {
+		os << "Op(QLinearConv" << (packed_filters ? ", packed" : "") << ")";
+	}
+
+	bool save(PlanWriter &writer) const override;
+	static std::shared_ptr<Op> load(PlanReader &reader);
+
+	std::unique_ptr<Op> clone() const override {
+		return std::unique_ptr<Op>(new QLinearConvOp(*this));
+	}
+
+	PatchSpec patch;
+	int64_t group;
+	/// The filters of each group minus their zero points, packed at load
+	/// time, used instead of input 3
+	std::shared_ptr<const std::vector<PackedMatrixI8>> packed_filters;
+
+private:
+	std::vector<TValue> eval_impl(SessionState *session, std::vector<TValue> inputs) const;
+};
+
+} // namespace duckdb_onnx
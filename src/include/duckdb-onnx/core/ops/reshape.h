@@ -0,0 +1,133 @@
+#pragma once
+
+#include "duckdb-onnx/core/ops/ops.h"
+#include "duckdb-onnx/value.h"
+
+#include <optional>
+
+namespace duckdb_onnx {
+
+/// ONNX Reshape. The target shape is input 1 (I64), or fixed for the
+/// attribute form of opsets before 5; 0 copies the input dimension (unless
+/// `allow_zero`) and -1 takes the remaining elements. The data is not copied
+/// when the input is exclusive or a constant.
+class ReshapeOp : public Op {
+public:
+	explicit ReshapeOp(bool allow_zero = false) : allow_zero(allow_zero) {
+	}
+	explicit ReshapeOp(ShapeVec shape) : shape(std::move(shape)) {
+	}
+
+	std::string name() const override {
+		return "Reshape";
+	}
+
+	TractResult<std::vector<TValue>> eval(const std::vector<TValue> &inputs) const override;
+	TractResult<std::vector<TValue>> eval_with_session(SessionState &session,
+	                                                   std::vector<TValue> inputs) const override;
+	TractResult<std::vector<TypedFact>> output_facts(const std::vector<const TypedFact *> &inputs) const override;
+
+	int inplace_input() const override {
+		return 0;
+	}
+
+	bool same_as(const Op *other) const override {
+		auto reshape = dynamic_cast<const ReshapeOp *>(other);
+		return reshape && reshape->allow_zero == allow_zero && reshape->shape == shape;
+	}
+
+	bool save(PlanWriter &writer) const override;
+	static std::shared_ptr<Op> load(PlanReader &reader);
+
+	std::unique_ptr<Op> clone() const override {
+		return std::unique_ptr<Op>(new ReshapeOp(*this));
+	}
+
+	bool allow_zero = false;
+	std::optional<ShapeVec> shape;
+
+private:
+	std::vector<TValue> eval_impl(SessionState *session, std::vector<TValue> inputs) const;
+};
+
+/// ONNX Flatten: a 2-D view whose rows are the dimensions before `axis`
+class FlattenOp : public Op {
+public:
+	explicit FlattenOp(int64_t axis) : axis(axis) {
+	}
+
+	std::string name() const override {
+		return "Flatten";
+	}
+
+	TractResult<std::vector<TValue>> eval(const std::vector<TValue> &inputs) const override;
+	TractResult<std::vector<TValue>> eval_with_session(SessionState &session,
+	                                                   std::vector<TValue> inputs) const override;
+	TractResult<std::vector<TypedFact>> output_facts(const std::vector<const TypedFact *> &inputs) const override;
+
+	int inplace_input() const override {
+		return 0;
+	}
+
+	bool same_as(const Op *other) const override {
+		auto flatten = dynamic_cast<const FlattenOp *>(other);
+		return flatten && flatten->axis == axis;
+	}
+
+	bool save(PlanWriter &writer) const override;
+	static std::shared_ptr<Op> load(PlanReader &reader);
+
+	std::unique_ptr<Op> clone() const override {
+		return std::unique_ptr<Op>(new FlattenOp(*this));
+	}
+
+	int64_t axis;
+
+private:
+	std::vector<TValue> eval_impl(SessionState *session, std::vector<TValue> inputs) const;
+};
+
+/// ONNX Squeeze and Unsqueeze: remove or insert dimensions of size 1 at
+/// `axes`, read from input 1 from opset 13. Squeeze without axes removes
+/// every dimension of size 1. Like Reshape, they avoid copying the data.
+class SqueezeOp : public Op {
+public:
+	SqueezeOp(bool unsqueeze, ShapeVec axes, bool axes_input = false)
+	    : unsqueeze(unsqueeze), axes(std::move(axes)), axes_input(axes_input) {
+	}
+
+	std::string name() const override {
+		return unsqueeze ? "Unsqueeze" : "Squeeze";
+	}
+
+	TractResult<std::vector<TValue>> eval(const std::vector<TValue> &inputs) const override;
+	TractResult<std::vector<TValue>> eval_with_session(SessionState &session,
+	                                                   std::vector<TValue> inputs) const override;
+	TractResult<std::vector<TypedFact>> output_facts(const std::vector<const TypedFact *> &inputs) const override;
+
+	int inplace_input() const override {
+		return 0;
+	}
+
+	bool same_as(const Op *other) const override {
+		auto squeeze = dynamic_cast<const SqueezeOp *>(other);
+		return squeeze && squeeze->unsqueeze == unsqueeze && squeeze->axes == axes &&
+		       squeeze->axes_input == axes_input;
+	}
+
+	bool save(PlanWriter &writer) const override;
+	static std::shared_ptr<Op> load(PlanReader &reader);
+
+	std::unique_ptr<Op> clone() const override {
+		return std::unique_ptr<Op>(new SqueezeOp(*this));
+	}
+
+	bool unsqueeze;
+	ShapeVec axes;
+	bool axes_input;
+
+private:
+	std::vector<TValue> eval_impl(SessionState *session, std::vector<TValue> inputs) const;
+};
+
+} // namespace duckdb_onnx
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "duckdb-onnx/core/ops/ops.h"
+#include "duckdb-onnx/value.h"
+
+namespace duckdb_onnx {
+
+/// ONNX Shape: the dimensions of the input from `start` to `end` (clamped,
+/// negative values counting from the end) as a 1-D I64 tensor.
+class ShapeOp : public Op {
+public:
+	ShapeOp(int64_t start = 0, int64_t end = INT64_MAX) : start(start), end(end) {
+	}
+
+	std::string name() const override {
+		return "Shape";
+	}
+
+	TractResult<std::vector<TValue>> eval(const std::vector<TValue> &inputs) const override;
+	TractResult<std::vector<TypedFact>> output_facts(const std::vector<const TypedFact *> &inputs) const override;
+
+	bool same_as(const Op *other) const override {
+		auto shape = dynamic_cast<const ShapeOp *>(other);
+		return shape && shape->start == start && shape->end == end;
+	}
+
+	bool save(PlanWriter &writer) const override;
+	static std::shared_ptr<Op> load(PlanReader &reader);
+
+	std::unique_ptr<Op> clone() const override {
+		return std::unique_ptr<Op>(new ShapeOp(*this));
+	}
+
+	/// The output for an input of shape `shape`
+	Tensor shape_of(const ShapeVec &shape) const;
+
+	int64_t start;
+	int64_t end;
+};
+
+/// ONNX Gather: the slices of the data along `axis` at the positions given
+/// by an I32 or I64 index tensor, negative indices counting from the end.
+class GatherOp : public Op {
+public:
+	explicit GatherOp(int64_t axis) : axis(axis) {
+	}
+
+	std::string name() const override {
+		return "Gather";
+	}
+
+	TractResult<std::vector<TValue>> eval(const std::vector<TValue> &inputs) const override;
+	TractResult<std::vector<TValue>> eval_with_session(SessionState &session,
+	                                                   std::vector<TValue> inputs) const override;
+	TractResult<std::vector<TypedFact>> output_facts(const std::vector<const TypedFact *> &inputs) const override;
+
+	bool same_as(const Op *other) const override {
+		auto gather = dynamic_cast<const GatherOp *>(other);
+		return gather && gather->axis == axis;
+	}
+
+	bool save(PlanWriter &writer) const override;
+	static std::shared_ptr<Op> load(PlanReader &reader);
+
+	std::unique_ptr<Op> clone() const override {
+		return std::unique_ptr<Op>(new GatherOp(*this));
+	}
+
+	int64_t axis;
+
+private:
+	std::vector<TValue> eval_impl(SessionState *session, std::vector<TValue> inputs) const;
+};
+
+/// ONNX Concat: the inputs joined along `axis`
+class ConcatOp : public Op {
+public:
+	explicit ConcatOp(int64_t axis) : axis(axis) {
+	}
+
+	std::string name() const override {
+		return "Concat";
+	}
+
+	TractResult<std::vector<TValue>> eval(const std::vector<TValue> &inputs) const override;
+	TractResult<std::vector<TValue>> eval_with_session(SessionState &session,
+	                                                   std::vector<TValue> inputs) const override;
+	TractResult<std::vector<TypedFact>> output_facts(const std::vector<const TypedFact *> &inputs) const override;
+
+	bool same_as(const Op *other) const override {
+		auto concat = dynamic_cast<const ConcatOp *>(other);
+		return concat && concat->axis == axis;
+	}
+
+	bool save(PlanWriter &writer) const override;
+	static std::shared_ptr<Op> load(PlanReader &reader);
+
+	std::unique_ptr<Op> clone() const override {
+		return std::unique_ptr<Op>(new ConcatOp(*this));
+	}
+
+	int64_t axis;
+
+private:
+	std::vector<TValue> eval_impl(SessionState *session, std::vector<TValue> inputs) const;
+};
+
+} // namespace duckdb_onnx
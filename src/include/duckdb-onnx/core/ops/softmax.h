@@ -0,0 +1,52 @@
+#pragma once
+
+#include "duckdb-onnx/core/ops/ops.h"
+#include "duckdb-onnx/value.h"
+
+namespace duckdb_onnx {
+
+/// ONNX Softmax and LogSoftmax over F32. From opset 13 they normalize along
+/// `axis` alone; before, the input is coerced to 2-D and every dimension
+/// from `axis` on is normalized together.
+class SoftmaxOp : public Op {
+public:
+	SoftmaxOp(bool log, int64_t axis, bool coerce_2d) : log(log), axis(axis), coerce_2d(coerce_2d) {
+	}
+
+	std::string name() const override {
+		return log ? "LogSoftmax" : "Softmax";
+	}
+	Validation validation() const override {
+		return Validation::Rounding;
+	}
+
+	TractResult<std::vector<TValue>> eval(const std::vector<TValue> &inputs) const override;
+	TractResult<std::vector<TValue>> eval_with_session(SessionState &session,
+	                                                   std::vector<TValue> inputs) const override;
+	TractResult<std::vector<TypedFact>> output_facts(const std::vector<const TypedFact *> &inputs) const override;
+
+	int inplace_input() const override {
+		return 0;
+	}
+
+	bool same_as(const Op *other) const override {
+		auto softmax = dynamic_cast<const SoftmaxOp *>(other);
+		return softmax && softmax->log == log && softmax->axis == axis && softmax->coerce_2d == coerce_2d;
+	}
+
+	bool save(PlanWriter &writer) const override;
+	static std::shared_ptr<Op> load(PlanReader &reader);
+
+	std::unique_ptr<Op> clone() const override {
+		return std::unique_ptr<Op>(new SoftmaxOp(*this));
+	}
+
+	bool log;
+	int64_t axis;
+	bool coerce_2d;
+
+private:
+	std::vector<TValue> eval_impl(SessionState *session, std::vector<TValue> inputs) const;
+};
+
+} // namespace duckdb_onnx
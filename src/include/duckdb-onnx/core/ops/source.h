@@ -0,0 +1,31 @@
+#pragma once
+
+#include "duckdb-onnx/core/ops/ops.h"
+#include "duckdb-onnx/value.h"
+
+namespace duckdb_onnx {
+
+/// A model input. Its value is provided by the plan, it is never evaluated.
+class SourceOp : public Op {
+public:
+	std::string name() const override {
+		return "Source";
+	}
+
+	TractResult<std::vector<TValue>> eval(const std::vector<TValue> &inputs) const override {
+		return Err<std::vector<TValue>>("Source nodes are fed by the plan and cannot be evaluated");
+	}
+
+	bool same_as(const Op *other) const override {
+		return false;
+	}
+
+	bool save(PlanWriter &writer) const override;
+	static std::shared_ptr<Op> load(PlanReader &reader);
+
+	std::unique_ptr<Op> clone() const override {
+		return std::unique_ptr<Op>(new SourceOp(*this));
+	}
+};
+
+} // namespace duckdb_onnx
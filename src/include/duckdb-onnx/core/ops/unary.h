@@ -0,0 +1,99 @@
+#pragma once
+
+#include "duckdb-onnx/core/kernels/element_wise.hpp"
+#include "duckdb-onnx/core/ops/ops.h"
+#include "duckdb-onnx/value.h"
+
+#include <limits>
+
+namespace duckdb_onnx {
+
+/// Element-wise activation or math function. F32 runs on the SIMD kernels.
+class UnaryOp : public Op {
+public:
+	explicit UnaryOp(UnaryKind kind) : kind(kind) {
+	}
+
+	std::string name() const override;
+
+	Validation validation() const override {
+		// the vectorized transcendental functions are polynomial approximations
+		return kind == UnaryKind::Relu ? Validation::Accurate : Validation::Rounding;
+	}
+
+	TractResult<std::vector<TValue>> eval(const std::vector<TValue> &inputs) const override;
+	TractResult<std::vector<TValue>> eval_with_session(SessionState &session,
+	                                                   std::vector<TValue> inputs) const override;
+	TractResult<std::vector<TypedFact>> output_facts(const std::vector<const TypedFact *> &inputs) const override;
+
+	int inplace_input() const override {
+		return 0;
+	}
+
+	bool same_as(const Op *other) const override {
+		auto unary = dynamic_cast<const UnaryOp *>(other);
+		return unary && unary->kind == kind;
+	}
+
+	bool save(PlanWriter &writer) const override;
+	static std::shared_ptr<Op> load(PlanReader &reader);
+
+	std::unique_ptr<Op> clone() const override {
+		return std::unique_ptr<Op>(new UnaryOp(*this));
+	}
+
+	UnaryKind kind;
+
+private:
+	std::vector<TValue> eval_impl(SessionState *session, std::vector<TValue> inputs) const;
+};
+
+/// Clamp every element to [min, max]. The bounds are either fixed or read
+/// from scalar inputs (ONNX Clip from opset 11).
+class ClipOp : public Op {
+public:
+	ClipOp(double min, double max, int min_input = -1, int max_input = -1)
+	    : min(min), max(max), min_input(min_input), max_input(max_input) {
+	}
+
+	std::string name() const override {
+		return "Clip";
+	}
+
+	TractResult<std::vector<TValue>> eval(const std::vector<TValue> &inputs) const override;
+	TractResult<std::vector<TValue>> eval_with_session(SessionState &session,
+	                                                   std::vector<TValue> inputs) const override;
+	TractResult<std::vector<TypedFact>> output_facts(const std::vector<const TypedFact *> &inputs) const override;
+
+	int inplace_input() const override {
+		return 0;
+	}
+
+	bool same_as(const Op *other) const override {
+		auto clip = dynamic_cast<const ClipOp *>(other);
+		return clip && clip->min == min && clip->max == max && clip->min_input == min_input &&
+		       clip->max_input == max_input;
+	}
+
+	void debug_print(std::ostream &os) const override {
+		os << "Clip(" << min << ", " << max << ")";
+	}
+
+	bool save(PlanWriter &writer) const override;
+	static std::shared_ptr<Op> load(PlanReader &reader);
+
+	std::unique_ptr<Op> clone() const override {
+		return std::unique_ptr<Op>(new ClipOp(*this));
+	}
+
+	double min;
+	double max;
+	/// inputs holding the bounds, -1 when the fixed bound applies
+	int min_input;
+	int max_input;
+
+private:
+	std::vector<TValue> eval_impl(SessionState *session, std::vector<TValue> inputs) const;
+};
+
+} // namespace duckdb_onnx
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "duckdb-onnx/core/model/typed.hpp"
+#include "duckdb-onnx/value.h"
+
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace duckdb_onnx {
+
+/// Rewrite `model` into an equivalent, cheaper graph before planning:
+/// Identity removal, constant folding, common subexpression elimination,
+/// BatchNormalization folded into the preceding Conv, MatMul + Add into a
+/// biased MatMul, element-wise chains fused into one op or into the epilogue
+/// of the Conv, MatMul or Gemm they follow, then dead nodes dropped. Node ids
+/// change; inputs, outputs and their labels are kept.
+void optimize(TypedModel &model);
+
+/// Make `outputs`, outlets of `model`, its outputs in that order and drop the
+/// nodes none of them depends on, e.g. to skip the outputs nobody reads.
+/// Inputs are kept even when unused. Node ids change.
+void select_outputs(TypedModel &model, std::vector<OutletId> outputs);
+
+/// Refine the facts of `model` with what its ops infer from the facts of
+/// their inputs, starting from the declared inputs: shapes, possibly in
+/// terms of symbols such as a batch size, and the value of small integer
+/// tensors computed from shapes. Dimensions left unknown keep their declared
+/// value. Throws when an op rejects the facts of its inputs.
+void infer_facts(TypedModel &model);
+
+/// The facts of the outputs of `model` for inputs of the facts `inputs`,
+/// such as concrete shapes, as `infer_facts` derives them from these instead
+/// of the declared input facts. The model is left unchanged. Throws when an
+/// op rejects the facts of its inputs.
+std::vector<TypedFact> infer_output_facts(const TypedModel &model, const std::vector<TypedFact> &inputs);
+
+/// The shapes of the outputs of one sample when samples of the input shapes
+/// `sample_shapes`, each with a leading dimension of 1, can run through
+/// `model` concatenated along that dimension: each input declares a free or
+/// unit leading dimension, and the facts inferred for a batch of any size
+/// give every output that size as leading dimension and fixed dimensions
+/// past it, with no op combining values across it (a Softmax or Gather over
+/// it, a product contracting it). Nothing when the facts do not show this.
+std::optional<std::vector<std::vector<int64_t>>>
+batch_output_shapes(const TypedModel &model, const std::vector<std::vector<int64_t>> &sample_shapes);
+
+/// Whether `outputs`, computed for a batch of `batch_size` samples, have
+/// that leading dimension and past it the dimensions of `sample_shapes`
+bool batch_outputs_match(const std::vector<TValue> &outputs, size_t batch_size,
+                         const std::vector<std::vector<int64_t>> &sample_shapes);
+
+/// A copy of `model`, whose facts were inferred, valid only for inputs that
+/// match its declared input facts: values computed from the input shapes
+/// become constants, Reshapes to such values become fixed Reshapes, and the
+/// shape computations left unused are dropped. Null when nothing changed.
+std::shared_ptr<TypedModel> specialize(const TypedModel &model);
+
+/// Replace each op of `model` by its load-time specialization for the
+/// constant inputs of its node (see `Op::codegen`), e.g. MatMul with its
+/// weights prepacked.
+void codegen(TypedModel &model);
+
+} // namespace duckdb_onnx
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+
+namespace duckdb_onnx {
+
+/// Runs the independent parts of an op on several threads. The engine owns
+/// no threads: the host provides the runner, e.g. one scheduling its tasks
+/// on DuckDB's TaskScheduler, so that inference shares the cores of the
+/// query instead of oversubscribing them.
+class TaskRunner {
+public:
+	virtual ~TaskRunner() = default;
+
+	/// Threads the parts of one op may run on, the calling one included
+	virtual size_t thread_count() const = 0;
+	/// Call `task(i)` for every i < count, possibly concurrently, and return
+	/// once all of them returned. The calling thread takes part, so this
+	/// never waits on tasks nobody runs. The first exception a task throws
+	/// is rethrown once the others are done.
+	virtual void run(size_t count, const std::function<void(size_t)> &task) = 0;
+};
+
+/// Number of parts to split `work` units of work in, each of at least
+/// `min_work`, for at most the threads of `runner` (1 without a runner)
+size_t parallel_parts(const TaskRunner *runner, size_t work, size_t min_work);
+
+/// Call `task(begin, end)` over consecutive ranges covering [0, count), at
+/// most `parts` of them, on `runner` when there are several
+void parallel_for(TaskRunner *runner, size_t count, size_t parts, const std::function<void(size_t, size_t)> &task);
+
+} // namespace duckdb_onnx
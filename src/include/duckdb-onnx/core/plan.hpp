@@ -0,0 +1,192 @@
+#pragma once
+
+#include "duckdb-onnx/core/model/typed.hpp"
+#include "duckdb-onnx/core/profile.hpp"
+#include "duckdb-onnx/core/session.hpp"
+#include "duckdb-onnx/error.h"
+#include "duckdb-onnx/value.h"
+#include <memory>
+#include <optional>
+#include <unordered_set>
+#include <vector>
+
+namespace duckdb_onnx {
+
+/// An execution plan for a typed model.
+///
+/// Everything that only depends on the model is resolved when the plan is
+/// built: the evaluation order, the value slot of every outlet, the constants
+/// and the point after which each intermediate value is dead. Running the
+/// plan only walks a flat array of steps.
+///
+/// The memory of intermediate values is planned statically too: a liveness
+/// analysis over the outlet successors assigns every computed outlet to a
+/// workspace buffer, and outlets whose lifetimes do not overlap share one.
+/// An op declaring an `inplace_input` gets its output in that input's buffer
+/// when the input dies at that step, so it can overwrite it in place.
+///
+/// Steps on independent branches of the model may run concurrently: the
+/// plan records which steps read the outputs of each step, and a workspace
+/// buffer is only reused by a step that depends on every reader of its
+/// previous values, so steps that may overlap never share one.
+///
+/// A plan may carry a second plan for a specialized copy of its model (see
+/// `specialize`), which runs instead whenever the inputs match the declared
+/// input facts. The generic plan remains for any other shape, such as a
+/// batch of rows fed to a model declared for one.
+class SimplePlan : public std::enable_shared_from_this<SimplePlan> {
+public:
+	/// One node evaluation
+	struct Step {
+		/// node id in the model
+		size_t node;
+		const Op *op;
+		/// value slots of the node inputs
+		std::vector<size_t> inputs;
+		/// the node outputs are stored in [outputs_begin, outputs_begin + output_count)
+		size_t outputs_begin;
+		size_t output_count;
+		/// slots whose value is not needed anymore once the step ran
+		std::vector<size_t> flush;
+		/// inputs read for the last time, moved into the op
+		std::vector<bool> move_inputs;
+		/// workspace buffer of each output, SIZE_MAX when it has none
+		std::vector<size_t> output_buffers;
+		/// steps reading an output of this one
+		std::vector<size_t> successors;
+		/// number of steps whose outputs this one reads
+		size_t predecessors = 0;
+	};
+
+	/// Build a plan computing the outputs of `model`, and one for
+	/// `specialized`, its specialization, when given.
+	static TractResult<std::shared_ptr<SimplePlan>> build(std::shared_ptr<const TypedModel> model,
+	                                                      std::shared_ptr<const TypedModel> specialized = nullptr);
+
+	/// Evaluate the model on `inputs`, given in the order of the model inputs.
+	/// Runs in a throwaway SimpleState; repeated executions should keep one.
+	TractResult<std::vector<TValue>> run(std::vector<TValue> inputs) const;
+
+	const TypedModel &model() const {
+		return *model_;
+	}
+	const std::vector<Step> &steps() const {
+		return steps_;
+	}
+	size_t input_count() const {
+		return input_slots_.size();
+	}
+	size_t output_count() const {
+		return output_slots_.size();
+	}
+	/// The plan of the specialized model, if any
+	const SimplePlan *specialized() const {
+		return specialized_.get();
+	}
+	/// The values of the model symbols for `inputs`, or nothing when their
+	/// types or shapes do not match the facts of the model inputs
+	std::optional<SymbolValues> bind_symbols(const std::vector<TValue> &inputs) const;
+	/// Heap bytes held by the model constants and the ops, counting what the
+	/// specialized plan shares with this one once (memory mapped constants
+	/// are not counted)
+	size_t memory_usage() const;
+	/// Like `memory_usage()`, leaving out the ops and constants already in
+	/// `seen` and adding this plan's to it, to count plans that share them
+	size_t memory_usage(std::unordered_set<const void *> &seen) const;
+	/// Most steps that may run at once, by the levels of the dependency graph;
+	/// 1 for a chain of steps
+	size_t width() const {
+		return width_;
+	}
+	size_t buffer_count() const {
+		return buffer_sizes_.size();
+	}
+	/// Workspace bytes known from the model facts. Buffers of outlets whose
+	/// shape depends on symbols are sized when the symbols are bound; the
+	/// others grow to the largest value they held.
+	size_t planned_workspace_size() const {
+		size_t size = 0;
+		for (auto bytes : buffer_sizes_) {
+			size += bytes;
+		}
+		return size;
+	}
+
+private:
+	friend class SimpleState;
+	SimplePlan() = default;
+
+	void add_memory_usage(std::unordered_set<const void *> &seen, size_t &usage) const;
+
+	std::shared_ptr<const TypedModel> model_;
+	std::vector<Step> steps_;
+	std::vector<size_t> input_slots_;
+	std::vector<size_t> output_slots_;
+	std::vector<std::pair<size_t, TValue>> constants_;
+	std::vector<size_t> buffer_sizes_;
+	/// Sizes of the values assigned to each buffer that depend on symbols
+	std::vector<std::vector<TDim>> buffer_dims_;
+	/// Number of steps reading each slot, SIZE_MAX for the slots that are never released
+	std::vector<size_t> slot_readers_;
+	size_t slot_count_ = 0;
+	size_t width_ = 1;
+	std::shared_ptr<const SimplePlan> specialized_;
+};
+
+/// The mutable side of a plan execution: value slots, workspace buffers and
+/// the tensor arena.
+///
+/// When the session has a runner and the model has independent branches, the
+/// steps run on its threads as soon as their inputs are ready. Each thread
+/// runs a lane with its own arena and queue of ready steps: it takes the step
+/// it made ready last, whose inputs are most likely still in cache, and steals
+/// the oldest ready step of another lane when its queue is empty.
+///
+/// A state is used by one thread at a time and is meant to be kept across
+/// executions, so that the memory of the intermediate values is reused
+/// instead of being allocated again for every batch.
+class SimpleState {
+public:
+	explicit SimpleState(std::shared_ptr<const SimplePlan> plan);
+
+	/// Evaluate the plan, or its specialized plan when `inputs` match it, on
+	/// `inputs`. Outputs may be stored in the workspace or the arena: they
+	/// stay valid until the next `run` on this state.
+	TractResult<std::vector<TValue>> run(std::vector<TValue> inputs);
+
+	const SimplePlan &plan() const {
+		return *plan_;
+	}
+	SessionState &session() {
+		return session_;
+	}
+	/// Record the evaluation of every step in `profile`, or stop recording
+	/// when it is null. Profiling adds a clock read and a shape copy per step.
+	void set_profile(std::shared_ptr<PlanProfile> profile);
+
+private:
+	/// Evaluate `step` on the session of a lane
+	TractResult<std::vector<TValue>> eval_step(const SimplePlan::Step &step, SessionState &session,
+	                                           std::vector<TValue> args);
+	/// Run the steps one after the other in the plan order
+	TractResult<std::vector<TValue>> run_steps();
+	/// Run the steps on `lanes` threads of the runner, as their inputs become ready
+	TractResult<std::vector<TValue>> run_steps_concurrently(size_t lanes);
+	/// The values of the output slots, releasing the others
+	std::vector<TValue> take_outputs();
+
+	std::shared_ptr<const SimplePlan> plan_;
+	SessionState session_;
+	/// Sessions of the lanes after the first one, which uses `session_`
+	std::vector<std::unique_ptr<SessionState>> lanes_;
+	std::vector<TValue> values_;
+	/// State of the specialized plan, created on its first run
+	std::unique_ptr<SimpleState> specialized_;
+	/// Symbols the workspace was last sized for
+	SymbolValues symbols_;
+	std::shared_ptr<PlanProfile> profile_;
+	/// Entry of each step in `profile_`
+	std::vector<size_t> profile_entries_;
+};
+
+} // namespace duckdb_onnx
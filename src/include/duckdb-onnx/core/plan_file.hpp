@@ -0,0 +1,172 @@
+#pragma once
+
+#include "duckdb-onnx/core/cpu.hpp"
+#include "duckdb-onnx/core/kernels/gemm.hpp"
+#include "duckdb-onnx/core/kernels/qgemm.hpp"
+#include "duckdb-onnx/core/model/typed.hpp"
+#include "duckdb-onnx/error.h"
+#include "duckdb-onnx/mmap.h"
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace duckdb_onnx {
+
+// A plan file (.onnxplan) holds a model as it is after loading, optimizing
+// and prepacking, so that another process can run it without parsing the
+// protobuf or packing the weights again:
+//
+// - a fixed header: magic, format version, the key of the plan and the
+//   offsets of the sections below;
+// - the metadata: the external data files the model was read with, then a
+//   flat array of nodes with their names, facts, inputs and
+//   ops, then the inputs, outputs and labels of the model, for the generic
+//   graph and its specialized copy. Ops shared by the two are written once;
+// - the data: the bytes of constant tensors and prepacked weight panels,
+//   each aligned on TENSOR_ALIGNMENT, so that a reader memory maps the file
+//   and uses them where they are.
+//
+// The step order and memory plan are rebuilt from the graphs on load: it is
+// linear in the number of nodes and keeps their invariants in one place.
+
+/// What a plan file was written for. A plan is only read back for the same
+/// model bytes on a CPU running the same kernels, since convolution filters
+/// are packed for the rows of the micro-kernels of the instruction set.
+struct PlanFileKey {
+	/// `hash_bytes` of the serialized model
+	uint64_t model_hash = 0;
+	SimdLevel simd = SimdLevel::Scalar;
+
+	/// The key of the model serialized in `data`, for this CPU
+	static PlanFileKey for_model(const void *data, size_t size);
+	/// Name of the plan file for this key in a plan directory, e.g.
+	/// "3f9c2a7d01b4e655-avx2.onnxplan"
+	std::string file_name() const;
+};
+
+/// 64-bit hash of `size` bytes, the same in every process and build
+uint64_t hash_bytes(const void *data, size_t size);
+
+/// Receives the bytes of a plan file in order, e.g. to write them to a file
+using PlanFileSink = std::function<void(const char *data, size_t size)>;
+
+/// Serializer of a model into a plan file. Ops write themselves through
+/// `Op::save`; tensors and ops are written once however many nodes share
+/// them.
+class PlanWriter {
+public:
+	void write_u64(uint64_t value);
+	void write_i64(int64_t value);
+	void write_bool(bool value);
+	void write_f32(float value);
+	void write_f64(double value);
+	void write_string(const std::string &value);
+	void write_shape(const ShapeVec &shape);
+	void write_dim(const TDim &dim);
+	void write_fact(const TypedFact &fact);
+	/// A tensor of fixed-size elements, or null
+	void write_tensor(const std::shared_ptr<Tensor> &tensor);
+	void write_packed(const PackedMatrixF32 &matrix);
+	void write_packed(const PackedMatrixI8 &matrix);
+	/// An op, through its `save`; throws for ops that cannot be saved
+	void write_op(const Op &op);
+	void write_model(const TypedModel &model);
+
+	/// Pass the bytes of the file to `write`, in order: the header for `key`,
+	/// the metadata and the data.
+	void finish(const PlanFileKey &key, const PlanFileSink &write) const;
+
+private:
+	/// Append `size` bytes to the data section; returns their offset
+	uint64_t write_data(const void *data, size_t size);
+
+	std::string metadata_;
+	std::string data_;
+	std::unordered_map<const Tensor *, uint64_t> tensors_;
+	std::unordered_map<const Op *, uint64_t> ops_;
+};
+
+/// Deserializer of a plan file, mirroring `PlanWriter`. Tensors and packed
+/// weights are views of the memory mapped file. Every read throws on a
+/// truncated or inconsistent file.
+class PlanReader {
+public:
+	/// Map the file at `path` and check its header against `key`
+	PlanReader(const std::string &path, const PlanFileKey &key);
+
+	uint64_t read_u64();
+	int64_t read_i64();
+	bool read_bool();
+	float read_f32();
+	double read_f64();
+	std::string read_string();
+	ShapeVec read_shape();
+	TDim read_dim();
+	TypedFact read_fact();
+	std::shared_ptr<Tensor> read_tensor();
+	PackedMatrixF32 read_packed_f32();
+	PackedMatrixI8 read_packed_i8();
+	std::shared_ptr<Op> read_op();
+	std::shared_ptr<TypedModel> read_model();
+
+private:
+	const char *take(size_t size);
+	Blob read_data(size_t size);
+
+	std::shared_ptr<MemoryMap> map_;
+	size_t position_ = 0;
+	size_t metadata_end_ = 0;
+	size_t data_offset_ = 0;
+	size_t data_size_ = 0;
+	std::vector<std::shared_ptr<Tensor>> tensors_;
+	std::vector<std::shared_ptr<Op>> ops_;
+};
+
+/// Reads the op whose `save` wrote the given tag
+using PlanOpLoader = std::shared_ptr<Op> (*)(PlanReader &reader);
+
+/// An external data file a model was read with, as it was when its plan was
+/// written. The key only covers the bytes of the .onnx file: a plan is not
+/// used once one of its dependencies changed or is in another directory.
+struct PlanFileDependency {
+	/// As the parser resolved it: the model directory, '/', then the location
+	std::string path;
+	uint64_t size = 0;
+	/// Modification time, in ticks of the file clock
+	int64_t mtime = 0;
+
+	/// The file at `path` as it is now; throws when it cannot be examined
+	static PlanFileDependency for_file(const std::string &path);
+	bool operator==(const PlanFileDependency &other) const {
+		return path == other.path && size == other.size && mtime == other.mtime;
+	}
+};
+
+/// Serialize `model` and `specialized`, its specialization if any, as they
+/// are planned by `SimplePlan::build`, with the external data files they were
+/// read from, into the plan file whose bytes are passed to `write`. The file
+/// itself is left to the caller, which should write it under a temporary
+/// name and rename it so that a reader never maps a partial plan. Throws
+/// when an op cannot be saved.
+void write_plan_file(const PlanFileSink &write, const PlanFileKey &key, const TypedModel &model,
+                     const TypedModel *specialized, const std::vector<PlanFileDependency> &dependencies);
+
+/// The models of a plan file
+struct PlanFileModels {
+	std::shared_ptr<TypedModel> model;
+	/// Null when the model had no specialization
+	std::shared_ptr<TypedModel> specialized;
+};
+
+/// Read the plan file `path` for a model whose external data is resolved
+/// relative to `model_dir`, null when it has none. Fails when the plan is
+/// missing, corrupt, was written for another key (a different model,
+/// instruction set or build), or when its external data files are not in
+/// `model_dir` or changed since.
+TractResult<PlanFileModels> read_plan_file(const std::string &path, const PlanFileKey &key,
+                                           const std::string *model_dir = nullptr);
+
+} // namespace duckdb_onnx
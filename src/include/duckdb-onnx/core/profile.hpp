@@ -0,0 +1,53 @@
+#pragma once
+
+#include "duckdb-onnx/tensor.h"
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace duckdb_onnx {
+
+/// What the evaluations of one node of a model added up to
+struct NodeProfile {
+	/// Name of the node
+	std::string node;
+	/// Name of its op
+	std::string op;
+	uint64_t calls = 0;
+	/// Wall time spent evaluating the node
+	uint64_t nanos = 0;
+	/// Estimated arithmetic operations, see `Op::flops`
+	uint64_t flops = 0;
+	/// Bytes of the tensors the node produced
+	uint64_t output_bytes = 0;
+	/// Shapes of the outputs of the last evaluation, e.g. "[64,10]"
+	std::string output_shapes;
+};
+
+/// Per-node statistics of the executions of a model, recorded by the states
+/// running it, possibly at the same time. Entries are keyed by node name and
+/// op, so that the generic and specialized plans of a model, or copies of it
+/// computing fewer outputs, add up to the same entries.
+class PlanProfile {
+public:
+	/// Index of the entry of node `node` running `op`, created on first use
+	size_t entry(const std::string &node, const std::string &op);
+	/// Add one evaluation to entry `index`
+	void record(size_t index, uint64_t nanos, uint64_t flops, uint64_t output_bytes, std::string output_shapes);
+	/// The entries that recorded an evaluation, in the order they were created
+	std::vector<NodeProfile> snapshot() const;
+	/// Set all statistics back to zero
+	void reset();
+
+private:
+	mutable std::mutex lock_;
+	std::vector<NodeProfile> entries_;
+	std::unordered_map<std::string, size_t> index_;
+};
+
+/// `shape` as "[2,3]", "[]" for a scalar
+std::string shape_string(const ShapeVec &shape);
+
+} // namespace duckdb_onnx
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "duckdb-onnx/core/arena.hpp"
+#include "duckdb-onnx/core/parallel.hpp"
+#include <cstdint>
+#include <vector>
+
+namespace duckdb_onnx {
+
+/// Mutable state shared by the ops during one execution of a plan.
+class SessionState {
+public:
+	/// Scratch storage, reset before every execution
+	TensorArena arena;
+	/// Runs the parallel parts of the ops; without one they run on the
+	/// calling thread
+	TaskRunner *runner = nullptr;
+
+	/// An uninitialized tensor for output `output` of the running node. It is
+	/// stored in the workspace buffer the memory planner assigned to that
+	/// outlet, or in the arena when the outlet has none.
+	Tensor output_tensor(size_t output, DatumType dt, ShapeVec shape);
+
+	/// Bytes held by the workspace buffers
+	size_t workspace_size() const;
+
+private:
+	friend class SimpleState;
+
+	/// Allocate the workspace buffers with their planned sizes
+	void init_workspace(const std::vector<size_t> &sizes);
+	/// Buffer `buffer`, grown to at least `size` bytes. Its previous content is lost.
+	char *workspace_buffer(size_t buffer, size_t size);
+
+	std::vector<class Blob> buffers_;
+	/// session holding the workspace buffers, when this one runs a lane of a
+	/// concurrent execution
+	SessionState *owner_ = nullptr;
+	/// buffers of the outputs of the running node, SIZE_MAX when not planned
+	const std::vector<size_t> *output_buffers_ = nullptr;
+};
+
+/// Storage for output `output` of an op: planned by the session when the op
+/// runs within a plan, on the heap otherwise.
+inline Tensor output_tensor(SessionState *session, size_t output, DatumType dt, ShapeVec shape) {
+	if (session) {
+		return session->output_tensor(output, dt, std::move(shape));
+	}
+	return Tensor::uninitialized(dt, std::move(shape));
+}
+
+} // namespace duckdb_onnx
@@ -0,0 +1,50 @@
+#pragma once
+#include "tensor.h"
+#include <memory>
+#include <string>
+
+namespace duckdb_onnx {
+
+/// A read-only memory mapping of a whole file.
+///
+/// Pages come from the OS page cache, so every connection and process
+/// mapping the same file shares them. The mapping follows the file: writing
+/// to it in place changes the bytes seen through the mapping, and reading
+/// past the end of a file truncated since faults (SIGBUS). Files that may be
+/// in use should be replaced by writing a new file and renaming it over the
+/// old one, which leaves existing mappings on the old contents.
+class MemoryMap : public std::enable_shared_from_this<MemoryMap> {
+public:
+	/// Map `path` read-only; throws on failure
+	static std::shared_ptr<MemoryMap> open(const std::string &path);
+	~MemoryMap();
+
+	MemoryMap(const MemoryMap &) = delete;
+	MemoryMap &operator=(const MemoryMap &) = delete;
+
+	const char *data() const {
+		return data_;
+	}
+	size_t size() const {
+		return size_;
+	}
+	const std::string &path() const {
+		return path_;
+	}
+
+	/// A blob viewing `length` bytes at `offset`, keeping the mapping alive
+	class Blob slice(size_t offset, size_t length) const;
+
+private:
+	MemoryMap() = default;
+
+	std::string path_;
+	char *data_ = nullptr;
+	size_t size_ = 0;
+#ifdef _WIN32
+	void *file_handle_ = nullptr;
+	void *mapping_handle_ = nullptr;
+#endif
+};
+
+} // namespace duckdb_onnx
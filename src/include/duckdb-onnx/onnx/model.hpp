@@ -1,17 +1,20 @@
 #pragma once
 
 #include "duckdb-onnx/core/common.hpp"
+#include "duckdb-onnx/core/model/typed.hpp"
+#include "duckdb-onnx/error.h"
+#include "duckdb-onnx/mmap.h"
 #include "onnx.proto3.pb.h"
+#include <functional>
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <string>
 #include <unordered_map>
 
 namespace duckdb_onnx {
-namespace pb {
-class ModelProto;
-class GraphProto;
-class NodeProto;
-} // namespace pb
+/// Protobuf messages generated from onnx.proto3 (package `onnx`).
+namespace pb = ::onnx;
 
 class Onnx;
 class ParsingContext {
@@ -21,6 +24,10 @@ public:
 	const pb::ModelProto *model {};
 	std::vector<const pb::GraphProto *> parent_graphs;
 	std::optional<std::string> model_dir;
+	/// Operator set version imported for each domain ("" is the default ONNX domain)
+	std::unordered_map<std::string, int64_t> opset_versions;
+	/// raw_data of initializers that was left in the model file mapping, by initializer name
+	const std::unordered_map<std::string, class Blob> *raw_data_views {};
 
 	ParsingContext() = default;
 	ParsingContext(int64_t version, const Onnx *fw, const pb::ModelProto *m, std::vector<const pb::GraphProto *> graphs,
@@ -30,28 +37,82 @@ public:
 	    : onnx_operator_set_version(version), framework(fw), model(m), parent_graphs(std::move(graphs)),
 	      model_dir(dir ? std::optional<std::string>(*dir) : std::nullopt) {
 	}
+
+	int64_t opset_version(const std::string &domain) const {
+		auto it = opset_versions.find(domain);
+		return it == opset_versions.end() ? onnx_operator_set_version : it->second;
+	}
 };
 
+/// Provides the bytes of tensors stored outside of the model file.
 class ModelDataResolver {
 public:
 	virtual ~ModelDataResolver() = default;
+
+	/// Read-only view of `length` bytes of `path` starting at `offset`;
+	/// a `length` of SIZE_MAX reads up to the end of the file.
+	virtual class Blob read_bytes_from_path(const std::string &path, size_t offset, size_t length) const = 0;
+};
+
+/// Maps external data files read-only instead of copying them to the heap.
+/// Each file is mapped once per resolver and stays mapped while a tensor uses it.
+class MmapDataResolver : public ModelDataResolver {
+public:
+	class Blob read_bytes_from_path(const std::string &path, size_t offset, size_t length) const override;
+	/// The paths of the files read so far, sorted
+	std::vector<std::string> paths() const;
+
+private:
+	mutable std::mutex lock;
+	mutable std::unordered_map<std::string, std::shared_ptr<MemoryMap>> maps;
+};
+
+/// raw_data fields at least this large are read from the model file mapping
+/// instead of being parsed into the protobuf message.
+static constexpr size_t MMAP_RAW_DATA_THRESHOLD = 4096;
+
+/// Re-encode the model stored in `map` without the raw_data of its large
+/// initializers. The removed fields are returned in `views` as blobs viewing
+/// the mapping, keyed by initializer name.
+std::string strip_large_raw_data(const MemoryMap &map, std::unordered_map<std::string, class Blob> &views);
+
+/// Builds the operation of a node. Builders report errors by throwing.
+using OpBuilder = std::function<std::shared_ptr<Op>(const ParsingContext &, const pb::NodeProto &)>;
+
+/// Op builders keyed by domain and op type. Each op type may have several
+/// builders, the one with the highest `since_version` not above the model's
+/// opset is used.
+class OnnxOpRegister {
+public:
+	OnnxOpRegister() = default;
+
+	void insert(const std::string &op_type, OpBuilder builder, int64_t since_version = 1,
+	            const std::string &domain = "");
+	const OpBuilder *find(const std::string &domain, const std::string &op_type, int64_t opset) const;
+
+private:
+	static std::string key(const std::string &domain, const std::string &op_type);
+
+	std::unordered_map<std::string, std::vector<std::pair<int64_t, OpBuilder>>> op_builders {};
 };
 
-// using OpBuilder = std::function<
-//     std::pair<std::unique_ptr<InferenceOp>, std::vector<std::string>>(
-//         const ParsingContext *, const pb::NodeProto *)>;
+/// Register the builders of every supported ONNX operator.
+void register_all_ops(OnnxOpRegister &reg);
 
-// typedef std::unordered_map<std::string, OpBuilder> OnnxOpRegister;
+DatumType datum_type_from_onnx(int32_t elem_type);
+/// Convert an initializer or a constant attribute to a tensor.
+std::shared_ptr<Tensor> tensor_from_proto(const ParsingContext &ctx, const pb::TensorProto &proto);
 
 class Onnx {
 public:
-	// OnnxOpRegister op_register;
+	OnnxOpRegister op_register;
 	bool use_output_shapes;
 	bool ignore_output_types;
 	std::shared_ptr<ModelDataResolver> provider;
 
 	// 构造函数
-	Onnx() : use_output_shapes(false), ignore_output_types(false) {
+	Onnx() : use_output_shapes(false), ignore_output_types(false), provider(std::make_shared<MmapDataResolver>()) {
+		register_all_ops(op_register);
 	}
 
 	// 复制构造函数 (对应 Rust 中的 Clone trait)
@@ -59,26 +120,35 @@ public:
 
 	// 复制赋值运算符
 	Onnx &operator=(const Onnx &other) = default;
-};
 
-// using OpBuilder = std::function<
-//     std::pair<std::unique_ptr<InferenceOp>, std::vector<std::string>>(
-//         const ParsingContext *, const pb::NodeProto *)>;
-
-// class OnnxOpRegister {
-// public:
-//   std::unordered_map<std::string, OpBuilder> op_builders{};
-//   OnnxOpRegister() = default;
-//   void Register(const std::string& op_name, const OpBuilder& builder) {
-//     op_builders[op_name] = builder;
-//   }
-//   static OpBuilder* Find(const std::string& op_name) {
-//     auto it = op_builders.find(op_name);
-//     if (it != op_builders.end()) {
-//       return &(it->second);
-//     }
-//     return nullptr;
-//   }
-// };
+	/// Parse the protobuf model stored at `path`.
+	TractResult<std::shared_ptr<pb::ModelProto>> proto_model_for_path(const std::string &path) const;
+	/// Parse the protobuf model held in the `size` bytes at `data`.
+	TractResult<std::shared_ptr<pb::ModelProto>> proto_model_for_bytes(const char *data, size_t size) const;
+
+	/// Translate a protobuf model to a typed model whose nodes are stored in
+	/// evaluation order, with every edge wired. External data is resolved
+	/// relative to `model_dir`.
+	TractResult<TypedModel>
+	model_for_proto_model(const pb::ModelProto &proto, const std::string *model_dir = nullptr,
+	                      const std::unordered_map<std::string, class Blob> *raw_data_views = nullptr) const;
+
+	/// Parse and translate the model stored at `path`. The file is mapped and
+	/// large initializers keep pointing into the mapping.
+	TractResult<TypedModel> model_for_path(const std::string &path) const;
+	/// The directory the external data of the model file at `path` is
+	/// resolved against
+	static std::string model_dir_for_path(const std::string &path);
+
+	/// Parse and translate a model held in the `size` bytes at `data`, such as
+	/// a BLOB being registered; the model does not point into them. External
+	/// data is resolved relative to `model_dir`; without one, models with
+	/// external data are rejected.
+	TractResult<TypedModel> model_for_bytes(const char *data, size_t size,
+	                                        const std::string *model_dir = nullptr) const;
+
+private:
+	TypedModel parse_graph(const ParsingContext &ctx, const pb::GraphProto &graph) const;
+};
 
 } // namespace duckdb_onnx
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "duckdb-onnx/core/ops/patch.h"
+#include "duckdb-onnx/onnx/model.hpp"
+#include <string>
+#include <vector>
+
+namespace duckdb_onnx {
+
+/// Attribute `name` of `node`, nullptr when absent
+const pb::AttributeProto *find_attribute(const pb::NodeProto &node, const std::string &name);
+int64_t get_attr_int(const pb::NodeProto &node, const std::string &name, int64_t default_value);
+float get_attr_float(const pb::NodeProto &node, const std::string &name, float default_value);
+std::string get_attr_string(const pb::NodeProto &node, const std::string &name, const std::string &default_value);
+/// Empty when absent
+std::vector<int64_t> get_attr_ints(const pb::NodeProto &node, const std::string &name);
+/// Throws when absent
+int64_t require_attr_int(const pb::NodeProto &node, const std::string &name);
+
+/// Index among the wired inputs of the input at `position` in the node, -1
+/// when that optional input is omitted. Empty input names are not wired, so
+/// the inputs following an omitted one shift down.
+int optional_input_index(const pb::NodeProto &node, size_t position);
+/// Window attributes of Conv, QLinearConv and the pools
+PatchSpec patch_spec(const pb::NodeProto &node);
+
+/// Element-wise arithmetic, Max/Min, activations, Clip, MatMul, Gemm and Cast
+void register_math_ops(OnnxOpRegister &reg);
+/// Conv, pooling, BatchNormalization, Softmax and LogSoftmax
+void register_nn_ops(OnnxOpRegister &reg);
+/// Constant, Reshape, Flatten, Squeeze, Unsqueeze, Shape, Gather and Concat
+void register_array_ops(OnnxOpRegister &reg);
+/// QuantizeLinear, DequantizeLinear, MatMulInteger, QLinearMatMul and QLinearConv
+void register_quant_ops(OnnxOpRegister &reg);
+
+} // namespace duckdb_onnx
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "duckdb-onnx/onnx/model.hpp"
+
+#include <limits>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace duckdb_onnx {
+
+/// Smallest and largest finite values a tensor took during calibration
+struct TensorRange {
+	float min = std::numeric_limits<float>::infinity();
+	float max = -std::numeric_limits<float>::infinity();
+
+	/// Widen the range to the finite values among `len` elements of `data`
+	void update(const float *data, size_t len);
+	bool empty() const {
+		return min > max;
+	}
+};
+
+/// Post-training static quantization of an ONNX model, to the QOperator
+/// format: MatMul nodes with a constant 2-D F32 right-hand side and Conv
+/// nodes with constant filters become QLinearMatMul and QLinearConv nodes,
+/// preceded by a QuantizeLinear of their input and followed by a
+/// DequantizeLinear of their output, so that the rest of the model keeps
+/// reading F32.
+///
+/// Activations are quantized to UINT8 over the range observed during
+/// calibration, widened to include zero. Weights are quantized to symmetric
+/// INT8, per column of a MatMul and per filter of a Conv, whose bias becomes
+/// INT32 at the scale of the products it is added to.
+class ModelQuantizer {
+public:
+	/// `model` is `proto` translated by `framework`, which tells the constant
+	/// weights apart, including those computed from initializers (e.g. a
+	/// reshaped one).
+	ModelQuantizer(const Onnx &framework, const pb::ModelProto &proto, const TypedModel &model);
+
+	/// Names of the F32 tensors whose range calibration must observe: the
+	/// inputs and outputs of the nodes to quantize
+	const std::vector<std::string> &calibration_tensors() const {
+		return tensors_;
+	}
+
+	/// A copy of the model with its nodes quantized for the observed
+	/// `ranges`, keyed by the names of `calibration_tensors`; nodes whose
+	/// tensors were never observed are kept as they are. The weights and
+	/// nodes left unused are dropped, and the default opset is raised to 10
+	/// when it is older, which throws when that changes the meaning of one of
+	/// the remaining nodes. `quantized` is set to the number of quantized
+	/// nodes.
+	pb::ModelProto quantize(const std::unordered_map<std::string, TensorRange> &ranges, size_t &quantized) const;
+
+private:
+	struct Candidate {
+		/// index of the node in the graph
+		int node;
+		std::shared_ptr<Tensor> weights;
+		/// Conv bias, null when absent
+		std::shared_ptr<Tensor> bias;
+	};
+
+	const Onnx &framework_;
+	const pb::ModelProto &proto_;
+	std::vector<Candidate> candidates_;
+	std::vector<std::string> tensors_;
+};
+
+} // namespace duckdb_onnx
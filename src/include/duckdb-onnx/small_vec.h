@@ -0,0 +1,215 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <initializer_list>
+#include <iterator>
+#include <ostream>
+#include <type_traits>
+#include <vector>
+
+namespace duckdb_onnx {
+
+/// A vector storing up to `N` elements inline, only spilling to the heap
+/// beyond that. Restricted to trivially copyable types (shapes, strides).
+template <typename T, size_t N>
+class SmallVec {
+	static_assert(std::is_trivially_copyable<T>::value, "SmallVec only holds trivially copyable types");
+
+public:
+	using value_type = T;
+	using iterator = T *;
+	using const_iterator = const T *;
+
+	SmallVec() = default;
+	SmallVec(std::initializer_list<T> values) {
+		assign(values.begin(), values.end());
+	}
+	template <typename It, typename = typename std::iterator_traits<It>::iterator_category>
+	SmallVec(It first, It last) {
+		assign(first, last);
+	}
+	SmallVec(const std::vector<T> &values) {
+		assign(values.begin(), values.end());
+	}
+	SmallVec(const SmallVec &other) {
+		assign(other.begin(), other.end());
+	}
+	SmallVec(SmallVec &&other) noexcept {
+		if (other.heap_) {
+			heap_ = other.heap_;
+			capacity_ = other.capacity_;
+			size_ = other.size_;
+			other.heap_ = nullptr;
+			other.capacity_ = N;
+			other.size_ = 0;
+		} else {
+			assign(other.begin(), other.end());
+		}
+	}
+	SmallVec &operator=(const SmallVec &other) {
+		if (this != &other) {
+			assign(other.begin(), other.end());
+		}
+		return *this;
+	}
+	SmallVec &operator=(SmallVec &&other) noexcept {
+		if (this != &other) {
+			if (other.heap_) {
+				delete[] heap_;
+				heap_ = other.heap_;
+				capacity_ = other.capacity_;
+				size_ = other.size_;
+				other.heap_ = nullptr;
+				other.capacity_ = N;
+				other.size_ = 0;
+			} else {
+				assign(other.begin(), other.end());
+			}
+		}
+		return *this;
+	}
+	~SmallVec() {
+		delete[] heap_;
+	}
+
+	template <typename It>
+	void assign(It first, It last) {
+		size_ = 0;
+		reserve(static_cast<size_t>(std::distance(first, last)));
+		for (; first != last; ++first) {
+			data()[size_++] = static_cast<T>(*first);
+		}
+	}
+
+	T *data() {
+		return heap_ ? heap_ : inline_;
+	}
+	const T *data() const {
+		return heap_ ? heap_ : inline_;
+	}
+	size_t size() const {
+		return size_;
+	}
+	bool empty() const {
+		return size_ == 0;
+	}
+	/// Whether the elements are stored inline
+	bool is_inline() const {
+		return heap_ == nullptr;
+	}
+
+	iterator begin() {
+		return data();
+	}
+	iterator end() {
+		return data() + size_;
+	}
+	const_iterator begin() const {
+		return data();
+	}
+	const_iterator end() const {
+		return data() + size_;
+	}
+
+	T &operator[](size_t i) {
+		return data()[i];
+	}
+	const T &operator[](size_t i) const {
+		return data()[i];
+	}
+	T &front() {
+		return data()[0];
+	}
+	const T &front() const {
+		return data()[0];
+	}
+	T &back() {
+		return data()[size_ - 1];
+	}
+	const T &back() const {
+		return data()[size_ - 1];
+	}
+
+	void reserve(size_t capacity) {
+		if (capacity <= capacity_) {
+			return;
+		}
+		auto heap = new T[capacity];
+		std::memcpy(heap, data(), size_ * sizeof(T));
+		delete[] heap_;
+		heap_ = heap;
+		capacity_ = capacity;
+	}
+	void push_back(T value) {
+		if (size_ == capacity_) {
+			reserve(capacity_ * 2);
+		}
+		data()[size_++] = value;
+	}
+	void pop_back() {
+		size_--;
+	}
+	void resize(size_t size, T value = T()) {
+		reserve(size);
+		for (size_t i = size_; i < size; i++) {
+			data()[i] = value;
+		}
+		size_ = size;
+	}
+	void clear() {
+		size_ = 0;
+	}
+	iterator insert(const_iterator pos, T value) {
+		auto index = static_cast<size_t>(pos - begin());
+		push_back(value);
+		std::rotate(begin() + index, end() - 1, end());
+		return begin() + index;
+	}
+	template <typename It, typename = typename std::iterator_traits<It>::iterator_category>
+	iterator insert(const_iterator pos, It first, It last) {
+		auto index = static_cast<size_t>(pos - begin());
+		auto count = static_cast<size_t>(std::distance(first, last));
+		reserve(size_ + count);
+		std::copy_backward(begin() + index, end(), end() + count);
+		std::copy(first, last, begin() + index);
+		size_ += count;
+		return begin() + index;
+	}
+	iterator erase(const_iterator pos) {
+		auto index = static_cast<size_t>(pos - begin());
+		std::copy(begin() + index + 1, end(), begin() + index);
+		size_--;
+		return begin() + index;
+	}
+
+	std::vector<T> to_vec() const {
+		return std::vector<T>(begin(), end());
+	}
+
+	bool operator==(const SmallVec &other) const {
+		return size_ == other.size_ && std::equal(begin(), end(), other.begin());
+	}
+	bool operator!=(const SmallVec &other) const {
+		return !(*this == other);
+	}
+	bool operator<(const SmallVec &other) const {
+		return std::lexicographical_compare(begin(), end(), other.begin(), other.end());
+	}
+
+	friend std::ostream &operator<<(std::ostream &os, const SmallVec &vec) {
+		os << "[";
+		for (size_t i = 0; i < vec.size(); i++) {
+			os << (i ? "," : "") << vec[i];
+		}
+		return os << "]";
+	}
+
+private:
+	T inline_[N];
+	T *heap_ = nullptr;
+	size_t size_ = 0;
+	size_t capacity_ = N;
+};
+
+} // namespace duckdb_onnx
@@ -1,7 +1,14 @@
 #pragma once
+#include "duckdb-onnx/small_vec.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
 #include <vector>
 namespace duckdb_onnx {
-enum DatumType {
+enum class DatumType {
 	Bool,
 	U8,
 	U16,
@@ -12,6 +19,8 @@ enum DatumType {
 	I32,
 	I64,
 	F16,
+	/// bfloat16: the upper 16 bits of an F32
+	BF16,
 	F32,
 	F64,
 	TDim,
@@ -19,15 +28,222 @@ enum DatumType {
 	String,
 };
 
+/// Size in bytes of one element of the given type (0 for types without a fixed size)
+size_t datum_type_size(DatumType dt);
+const char *datum_type_name(DatumType dt);
+
+template <typename T>
+struct DatumTypeOf;
+template <>
+struct DatumTypeOf<bool> {
+	static constexpr DatumType value = DatumType::Bool;
+};
+template <>
+struct DatumTypeOf<uint8_t> {
+	static constexpr DatumType value = DatumType::U8;
+};
+template <>
+struct DatumTypeOf<uint16_t> {
+	static constexpr DatumType value = DatumType::U16;
+};
+template <>
+struct DatumTypeOf<uint32_t> {
+	static constexpr DatumType value = DatumType::U32;
+};
+template <>
+struct DatumTypeOf<uint64_t> {
+	static constexpr DatumType value = DatumType::U64;
+};
+template <>
+struct DatumTypeOf<int8_t> {
+	static constexpr DatumType value = DatumType::I8;
+};
+template <>
+struct DatumTypeOf<int16_t> {
+	static constexpr DatumType value = DatumType::I16;
+};
+template <>
+struct DatumTypeOf<int32_t> {
+	static constexpr DatumType value = DatumType::I32;
+};
+template <>
+struct DatumTypeOf<int64_t> {
+	static constexpr DatumType value = DatumType::I64;
+};
+template <>
+struct DatumTypeOf<float> {
+	static constexpr DatumType value = DatumType::F32;
+};
+template <>
+struct DatumTypeOf<double> {
+	static constexpr DatumType value = DatumType::F64;
+};
+
+template <typename T>
+struct TypeTag {
+	using type = T;
+};
+
+/// Call `f(TypeTag<T>())` with the C++ type of a numeric datum type.
+template <typename F>
+auto dispatch_numbers(DatumType dt, F &&f) -> decltype(f(TypeTag<float>())) {
+	switch (dt) {
+	case DatumType::U8:
+		return f(TypeTag<uint8_t>());
+	case DatumType::U16:
+		return f(TypeTag<uint16_t>());
+	case DatumType::U32:
+		return f(TypeTag<uint32_t>());
+	case DatumType::U64:
+		return f(TypeTag<uint64_t>());
+	case DatumType::I8:
+		return f(TypeTag<int8_t>());
+	case DatumType::I16:
+		return f(TypeTag<int16_t>());
+	case DatumType::I32:
+		return f(TypeTag<int32_t>());
+	case DatumType::I64:
+		return f(TypeTag<int64_t>());
+	case DatumType::F32:
+		return f(TypeTag<float>());
+	case DatumType::F64:
+		return f(TypeTag<double>());
+	default:
+		throw std::runtime_error(std::string("Unsupported datum type ") + datum_type_name(dt));
+	}
+}
+
+/// Same as `dispatch_numbers`, bool included
+template <typename F>
+auto dispatch_copy(DatumType dt, F &&f) -> decltype(f(TypeTag<float>())) {
+	if (dt == DatumType::Bool) {
+		return f(TypeTag<bool>());
+	}
+	return dispatch_numbers(dt, std::forward<F>(f));
+}
+
+/// Alignment of every buffer allocated for tensor data, wide enough for AVX-512 loads.
+static constexpr size_t TENSOR_ALIGNMENT = 64;
+
+/// Allocate `size` bytes aligned on TENSOR_ALIGNMENT; release with `aligned_free`.
+void *aligned_malloc(size_t size);
+void aligned_free(void *ptr);
+
+/// Shapes and strides are stored inline up to rank 6.
+using ShapeVec = SmallVec<int64_t, 6>;
+
+/// Untyped tensor storage.
+///
+/// A blob either owns its buffer, views read-only memory kept alive by an
+/// owner (e.g. a file mapping), or borrows memory that somebody else keeps
+/// alive (e.g. a DuckDB vector for the duration of a function call). Copies
+/// share the underlying buffer.
 class Blob {
-	char *data;
+public:
+	Blob() = default;
+
+	/// Allocate an owned, uninitialized buffer aligned on TENSOR_ALIGNMENT
+	static Blob allocate(size_t size);
+	/// Wrap memory owned by the caller, which must outlive every copy of the blob
+	static Blob borrow(void *data, size_t size);
+	/// View read-only memory that `owner` keeps alive
+	static Blob view(std::shared_ptr<const void> owner, const void *data, size_t size);
+
+	char *data() const {
+		return data_;
+	}
+	size_t size() const {
+		return size_;
+	}
+	bool is_borrowed() const {
+		return data_ && !owner_;
+	}
+	/// True for views of read-only memory such as file mappings, which are not heap memory
+	bool is_view() const {
+		return is_view_;
+	}
+
+private:
+	char *data_ = nullptr;
+	size_t size_ = 0;
+	bool is_view_ = false;
+	std::shared_ptr<const void> owner_;
 };
 
 class Tensor {
-	DatumType dt;
-	std::vector<int> shape;
-	std::vector<int> strides;
-	int len;
+public:
+	Tensor() = default;
+
+	/// Allocate a tensor whose content is left uninitialized
+	static Tensor uninitialized(DatumType dt, ShapeVec shape);
+	/// Allocate a zero-filled tensor
+	static Tensor zero(DatumType dt, ShapeVec shape);
+	/// A tensor viewing `data` without copying it; the caller keeps the memory alive
+	static Tensor borrowed(DatumType dt, ShapeVec shape, void *data);
+	/// A tensor over an existing blob
+	static Tensor from_blob(DatumType dt, ShapeVec shape, class Blob blob);
+
+	template <typename T>
+	static Tensor from_vec(ShapeVec shape, const std::vector<T> &values) {
+		auto tensor = uninitialized(DatumTypeOf<T>::value, std::move(shape));
+		std::copy(values.begin(), values.end(), tensor.template as_ptr_mut<T>());
+		return tensor;
+	}
+
+	DatumType datum_type() const {
+		return dt;
+	}
+	const ShapeVec &shape() const {
+		return shape_;
+	}
+	const ShapeVec &strides() const {
+		return strides_;
+	}
+	size_t rank() const {
+		return shape_.size();
+	}
+	/// Number of elements
+	size_t len() const {
+		return len_;
+	}
+	size_t byte_len() const {
+		return len_ * datum_type_size(dt);
+	}
+	bool is_borrowed() const {
+		return data.is_borrowed();
+	}
+	const class Blob &blob() const {
+		return data;
+	}
+
+	/// Change the shape without touching the data; the element count must not change
+	void set_shape(ShapeVec shape);
+
+	template <typename T>
+	const T *as_ptr() const {
+		check_datum_type(DatumTypeOf<T>::value);
+		return reinterpret_cast<const T *>(data.data());
+	}
+	template <typename T>
+	T *as_ptr_mut() {
+		check_datum_type(DatumTypeOf<T>::value);
+		return reinterpret_cast<T *>(data.data());
+	}
+	const void *raw_data() const {
+		return data.data();
+	}
+	void *raw_data_mut() {
+		return data.data();
+	}
+
+private:
+	void check_datum_type(DatumType expected) const;
+	void compute_strides();
+
+	DatumType dt = DatumType::F32;
+	ShapeVec shape_;
+	ShapeVec strides_;
+	size_t len_ = 0;
 	class Blob data;
 };
 } // namespace duckdb_onnx
@@ -13,6 +13,25 @@ public:
 	TValue &operator=(TValue &&other) = default;
 	~TValue() = default;
 
+	/// A value produced during evaluation, exclusively owned until shared
+	static TValue Var(std::shared_ptr<Tensor> tensor) {
+		TValue value;
+		value.tensor_ = std::move(tensor);
+		value.is_var_ = true;
+		return value;
+	}
+	static TValue Var(Tensor tensor) {
+		return Var(std::make_shared<Tensor>(std::move(tensor)));
+	}
+
+	/// A value shared with the model (e.g. an initializer), never modified in place
+	static TValue Const(std::shared_ptr<Tensor> tensor) {
+		TValue value;
+		value.tensor_ = std::move(tensor);
+		value.is_var_ = false;
+		return value;
+	}
+
 	bool is_exclusive() const {
 		if (is_var_) {
 			return tensor_.use_count() == 1;
@@ -20,6 +39,11 @@ public:
 		return false;
 	}
 
+	/// The tensor, when it can be modified in place because nobody else sees it
+	Tensor *as_mut() {
+		return is_exclusive() ? tensor_.get() : nullptr;
+	}
+
 	const std::shared_ptr<Tensor> *as_arc_tensor() const {
 		if (!is_var_) {
 			return &tensor_;
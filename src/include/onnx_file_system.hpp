@@ -0,0 +1,20 @@
+#pragma once
+
+#include "duckdb/common/common.hpp"
+
+namespace duckdb {
+
+class ClientContext;
+
+//! Whether `enable_external_access` allows the extension to read and write files: models, their external data,
+//! plan files and quantized copies are all external to the database
+bool OnnxExternalAccessEnabled(ClientContext &context);
+//! Throws a PermissionException when `enable_external_access` is disabled; `what` prefixes the message, e.g. the name
+//! of the function
+void OnnxCheckExternalAccess(ClientContext &context, const string &what);
+//! The bytes of the file at `path`, read through DuckDB's file system so that any path it can open works
+string OnnxReadFile(ClientContext &context, const string &path);
+//! Replace the file at `path` with the `size` bytes at `data`, written through DuckDB's file system
+void OnnxWriteFile(ClientContext &context, const string &path, const char *data, idx_t size);
+
+} // namespace duckdb
@@ -0,0 +1,19 @@
+#pragma once
+
+#include "duckdb/function/table_function.hpp"
+
+namespace duckdb {
+
+//! onnx_infer(table, model, batch_size := n, outputs := [...]): streams the rows of a table through a model.
+//! Rows are gathered across input chunks into batches of `batch_size`, and come out with the model outputs appended
+//! to their columns, named after the outputs. An output whose shape is fixed past the batch dimension becomes a T[n]
+//! column of its element type, others become T[] lists. `outputs` selects the outputs to compute and return; the
+//! inputs of a model with several of them are read from the columns named after them.
+class OnnxInferFunction : public TableFunction {
+public:
+	static constexpr idx_t DEFAULT_BATCH_SIZE = 256;
+
+	OnnxInferFunction();
+};
+
+} // namespace duckdb
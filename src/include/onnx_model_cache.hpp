@@ -0,0 +1,146 @@
+#pragma once
+
+#include "duckdb-onnx/core/common.hpp"
+#include "duckdb-onnx/core/plan.hpp"
+#include "duckdb-onnx/onnx/model.hpp"
+#include "duckdb/common/mutex.hpp"
+#include "duckdb/function/table_function.hpp"
+#include "duckdb/storage/object_cache.hpp"
+
+#include <atomic>
+#include <functional>
+#include <list>
+
+namespace duckdb {
+
+//! A loaded model, shared by every query that references the same file or registered name
+struct OnnxModel {
+	//! Canonical path of the model file, or the name the model is registered under
+	string path;
+	//! The execution plan, built once when the model is loaded
+	std::shared_ptr<duckdb_onnx::SimplePlan> plan;
+	//! Per-node statistics recorded while `onnx_profiling` is enabled, shared with the variants of the model
+	std::shared_ptr<duckdb_onnx::PlanProfile> profile = std::make_shared<duckdb_onnx::PlanProfile>();
+	//! The plan file the model was mapped from, empty when it was compiled from its ONNX bytes
+	string plan_file;
+
+	//! Datum type of input `index`, F32 when the model has no such input
+	duckdb_onnx::DatumType InputType(idx_t index) const;
+	//! Datum type of output `index`, F32 when the model has no such output
+	duckdb_onnx::DatumType OutputType(idx_t index) const;
+	//! Name of input `index`
+	string InputName(idx_t index) const;
+	//! Name of output `index`: its ONNX name, or "output<index>" for an unnamed one
+	string OutputName(idx_t index) const;
+	//! Index of the input named `name` (case-insensitive), DConstants::INVALID_INDEX when there is none
+	idx_t InputIndex(const string &name) const;
+	//! Approximate number of bytes kept alive by this model and the variants planned from it, counted when the model
+	//! is planned and again each time a variant is
+	idx_t MemoryUsage() const {
+		return memory_usage;
+	}
+
+	//! Optimizes `graph`, prepacks its weights and plans it; `path` names the model in error messages
+	static shared_ptr<OnnxModel> Compile(duckdb_onnx::TypedModel graph, const string &path);
+	//! The model serialized in `bytes`, compiled like `Compile` from the graph `parse` reads with the given parser.
+	//! When `onnx_plan_directory` is set, a plan file written there for the same bytes on a CPU of the same
+	//! instruction set is mapped instead, and a model compiled from scratch has its plan written there for the next
+	//! process. `model_dir` is the directory its external data is resolved against, empty when it has none: a plan
+	//! is only mapped while the external data files the parser read are still there, unchanged.
+	static shared_ptr<OnnxModel> Load(ClientContext &context, const char *bytes, idx_t size, const string &path,
+	                                  const string &model_dir,
+	                                  const std::function<duckdb_onnx::TypedModel(const duckdb_onnx::Onnx &)> &parse);
+
+	//! This model restricted to the outputs named `outputs`, in that order, with the nodes none of them depends on
+	//! pruned. Variants are planned on first use and kept with the model, whose prepacked weights they share. Throws
+	//! for an unknown output name.
+	shared_ptr<OnnxModel> WithOutputs(const vector<string> &outputs);
+
+private:
+	//! Sets `memory_usage` by walking the plans of this model and its variants
+	void CountMemoryUsage();
+	//! Same, with `variants_lock` already held
+	void CountMemoryUsageLocked();
+
+	mutable mutex variants_lock;
+	//! Variants by output names, joined with '\0'
+	unordered_map<string, shared_ptr<OnnxModel>> variants;
+	std::atomic<idx_t> memory_usage {0};
+};
+
+//! Statistics about a model path that went through the cache
+struct OnnxModelCacheInfo {
+	string path;
+	bool cached = false;
+	idx_t file_size = 0;
+	idx_t hits = 0;
+	idx_t misses = 0;
+	double load_time_ms = 0;
+	idx_t resident_bytes = 0;
+	//! The plan file the cached model was mapped from, empty when it was compiled
+	string plan_file;
+};
+
+//! Database-wide cache of loaded ONNX models.
+//! Entries are keyed by canonical path and invalidated when the file's mtime or size changes. When the resident size
+//! exceeds `onnx_model_cache_limit` the least recently used models are evicted; queries that still hold an evicted
+//! model keep it alive until they finish.
+class OnnxModelCache : public ObjectCacheEntry {
+public:
+	static constexpr const char *CACHE_KEY = "onnx_model_cache";
+	static constexpr const char *LIMIT_SETTING = "onnx_model_cache_limit";
+	static constexpr const char *DEFAULT_LIMIT = "1GB";
+	static constexpr const char *PLAN_DIRECTORY_SETTING = "onnx_plan_directory";
+
+	static string ObjectType() {
+		return "onnx_model_cache";
+	}
+	string GetObjectType() override {
+		return ObjectType();
+	}
+
+	static OnnxModelCache &Get(ClientContext &context);
+
+	//! Returns the model stored at `path`, loading it if it is not cached or the file changed on disk
+	shared_ptr<OnnxModel> GetModel(ClientContext &context, const string &path);
+	//! Snapshot of the per-path statistics
+	vector<OnnxModelCacheInfo> GetInfo();
+
+private:
+	struct Entry {
+		string path;
+		int64_t mtime;
+		idx_t file_size;
+		idx_t resident_bytes;
+		shared_ptr<OnnxModel> model;
+	};
+
+	//! Drops `load_lock`, the load lock of `key`, once the load that took it is over: threads still waiting on it
+	//! hold their own reference. Requires `lock` to be held.
+	void ReleaseLoadLock(const string &key, const shared_ptr<mutex> &load_lock);
+	//! Takes the resident size of `entry` from its model, which grows as variants of it are planned. Requires `lock`
+	//! to be held.
+	void UpdateResidentBytes(Entry &entry);
+	//! Drop least recently used entries until the resident size fits in `limit`, always keeping the MRU entry.
+	//! Requires `lock` to be held.
+	void EvictUntil(idx_t limit);
+	static idx_t GetLimit(ClientContext &context);
+
+	mutex lock;
+	//! Per path being loaded, serializes its loads so that concurrent misses on the same model only parse it once,
+	//! while models at other paths load meanwhile
+	unordered_map<string, shared_ptr<mutex>> load_locks;
+	//! Most recently used entry first
+	std::list<Entry> lru;
+	unordered_map<string, std::list<Entry>::iterator> entries;
+	unordered_map<string, OnnxModelCacheInfo> info;
+	idx_t resident_bytes = 0;
+};
+
+//! onnx_model_cache(): lists the models that went through the cache
+class OnnxModelCacheFunction : public TableFunction {
+public:
+	OnnxModelCacheFunction();
+};
+
+} // namespace duckdb
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "onnx_model_cache.hpp"
+#include "duckdb/common/case_insensitive_map.hpp"
+#include "duckdb/common/mutex.hpp"
+#include "duckdb/function/scalar_function.hpp"
+#include "duckdb/function/table_function.hpp"
+#include "duckdb/storage/object_cache.hpp"
+
+namespace duckdb {
+
+//! Statistics about a registered model
+struct OnnxRegisteredModelInfo {
+	string name;
+	//! The file the model was read from, empty when it was registered from a BLOB
+	string source;
+	idx_t model_bytes = 0;
+	idx_t inputs = 0;
+	idx_t outputs = 0;
+	double load_time_ms = 0;
+	idx_t resident_bytes = 0;
+	//! The plan file the model was mapped from, empty when it was compiled
+	string plan_file;
+};
+
+//! Database-wide registry of models referenced by name instead of by path.
+//! A model is parsed, optimized and planned once when it is registered, and every connection then shares the
+//! compiled model; only its size is kept of the serialized model. Registering a name again replaces its model, while
+//! queries that hold the previous one keep it alive until they finish. The registry lives as long as the database
+//! instance.
+class OnnxModelRegistry : public ObjectCacheEntry {
+public:
+	static constexpr const char *CACHE_KEY = "onnx_model_registry";
+
+	static string ObjectType() {
+		return "onnx_model_registry";
+	}
+	string GetObjectType() override {
+		return ObjectType();
+	}
+
+	static OnnxModelRegistry &Get(ClientContext &context);
+
+	//! Compile the model serialized in the `size` bytes at `bytes` (see `OnnxModel::Load`) and register it as `name`,
+	//! read from `source` if any. Models with external data are rejected.
+	void Register(ClientContext &context, const string &name, const char *bytes, idx_t size,
+	              const string &source = string());
+	//! Compile the model file at `path` and register it as `name`. A local file is mapped rather than read, and its
+	//! large initializers are used where they are in the mapping; external data is resolved relative to its
+	//! directory. A remote file is read through DuckDB's file system and registered like a BLOB.
+	void RegisterFile(ClientContext &context, const string &name, const string &path);
+	//! Remove `name` from the registry; returns whether it was registered
+	bool Unregister(const string &name);
+	//! The model registered as `name`, nullptr when there is none
+	shared_ptr<OnnxModel> Find(const string &name);
+	//! Snapshot of the registered models, by name
+	vector<OnnxRegisteredModelInfo> GetInfo();
+
+private:
+	struct Entry {
+		idx_t model_bytes;
+		string source;
+		double load_time_ms;
+		shared_ptr<OnnxModel> model;
+	};
+
+	void Add(const string &name, Entry entry);
+
+	mutex lock;
+	case_insensitive_map_t<Entry> entries;
+};
+
+//! The model an onnx function refers to: the model registered as `name_or_path`, else the model file at that path
+shared_ptr<OnnxModel> OnnxGetModel(ClientContext &context, const string &name_or_path);
+
+//! onnx_register_model(name, model): registers the model given as a BLOB, or read from the file at a path, under
+//! `name`; returns the name. onnx_unregister_model(name) removes it and returns whether it was registered.
+struct OnnxRegisterModelFunction {
+	static ScalarFunctionSet GetFunctions();
+	static ScalarFunction GetUnregisterFunction();
+};
+
+//! onnx_models(): lists the registered models
+class OnnxModelsFunction : public TableFunction {
+public:
+	OnnxModelsFunction();
+};
+
+} // namespace duckdb
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "duckdb/function/table_function.hpp"
+
+namespace duckdb {
+
+//! onnx_profile(model_path): per-node statistics of the executions of a cached model.
+//! While `onnx_profiling` is enabled, onnx() and onnx_infer record, for every node they evaluate, the number of calls,
+//! the wall time, an estimate of the arithmetic operations, the bytes of the produced tensors and the last output
+//! shapes. The statistics are aggregated over all the queries and threads using the model and are dropped when the
+//! model is reloaded; `reset := true` sets them back to zero after returning them.
+class OnnxProfileFunction : public TableFunction {
+public:
+	static constexpr const char *SETTING = "onnx_profiling";
+
+	OnnxProfileFunction();
+
+	//! Whether the inferences started by `context` are profiled
+	static bool Enabled(ClientContext &context);
+};
+
+} // namespace duckdb
@@ -0,0 +1,18 @@
+#pragma once
+
+#include "duckdb/function/table_function.hpp"
+
+namespace duckdb {
+
+//! onnx_quantize(model_path, calibration_query, out_path): post-training static quantization of a model.
+//! The rows of the calibration query, whose first list or array column holds one model input per row, run through
+//! the model to observe the range of the activations; the model is then written to `out_path` with its MatMul and
+//! Conv nodes quantized to 8 bits (see duckdb_onnx::ModelQuantizer). The query runs on a connection of its own, so
+//! it does not see the uncommitted changes or the temporary tables of the calling one. Returns one row with the
+//! written path, the number of calibration rows and the number of quantized nodes.
+class OnnxQuantizeFunction : public TableFunction {
+public:
+	OnnxQuantizeFunction();
+};
+
+} // namespace duckdb
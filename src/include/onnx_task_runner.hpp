@@ -0,0 +1,35 @@
+#pragma once
+
+#include "duckdb-onnx/core/parallel.hpp"
+#include "duckdb/common/common.hpp"
+#include "duckdb/common/mutex.hpp"
+#include "duckdb/parallel/task_scheduler.hpp"
+
+namespace duckdb {
+
+class ClientContext;
+
+//! Runs the parallel parts of ONNX ops as tasks of DuckDB's TaskScheduler, so that inference shares the database's
+//! worker threads instead of starting its own.
+class OnnxTaskRunner : public duckdb_onnx::TaskRunner {
+public:
+	static constexpr const char *THREADS_SETTING = "onnx_threads";
+
+	//! `max_threads` caps the threads of one inference; 0 uses all of the scheduler's
+	OnnxTaskRunner(ClientContext &context, idx_t max_threads);
+
+	//! The `onnx_threads` setting of the context
+	static idx_t GetMaxThreads(ClientContext &context);
+
+	size_t thread_count() const override;
+	void run(size_t count, const std::function<void(size_t)> &task) override;
+
+private:
+	TaskScheduler &scheduler;
+	//! Serializes the use of `token` by runs started concurrently, e.g. by ops of independent branches
+	mutex lock;
+	unique_ptr<ProducerToken> token;
+	idx_t threads;
+};
+
+} // namespace duckdb
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "duckdb-onnx/tensor.h"
+#include "duckdb/common/types.hpp"
+#include "duckdb/common/types/vector.hpp"
+
+namespace duckdb {
+
+//! The DuckDB type of the elements of a tensor of datum type `dt`. DuckDB has no half precision type: F16 and BF16
+//! elements are widened to FLOAT. Throws for types with no DuckDB counterpart.
+LogicalType OnnxElementType(duckdb_onnx::DatumType dt);
+//! The datum type of tensors read from elements of `type`, false when `type` is not a plain number or BOOLEAN
+bool OnnxDatumType(const LogicalType &type, duckdb_onnx::DatumType &result);
+//! `tensor` with its elements converted to `dt`; a tensor sharing its buffer when it already has that type
+duckdb_onnx::Tensor OnnxConvertTensor(const duckdb_onnx::Tensor &tensor, duckdb_onnx::DatumType dt);
+
+//! Reads the tensors held in a LIST or fixed-size ARRAY vector. The child vector is flattened so that input tensors
+//! can borrow its elements in place.
+class OnnxTensorReader {
+public:
+	OnnxTensorReader(Vector &vector, idx_t count);
+
+	//! Whether the row holds a tensor
+	bool RowIsValid(idx_t row) const {
+		return format.validity.RowIsValid(format.sel->get_index(row));
+	}
+	//! The elements of the row's tensor in the child vector
+	list_entry_t GetEntry(idx_t row) const {
+		auto index = format.sel->get_index(row);
+		return lists ? lists[index] : list_entry_t(index * array_size, array_size);
+	}
+	//! Throws when the elements contain a NULL
+	void CheckValid(const list_entry_t &entry, const char *function) const;
+	//! The address of element `offset` of the child vector
+	data_ptr_t GetData(idx_t offset) const {
+		return child_data + offset * element_size;
+	}
+	//! The tensors of `rows` concatenated as one tensor of shape `shape`. Rows stored one after the other in the child
+	//! vector are borrowed in place, other rows are copied.
+	duckdb_onnx::Tensor BatchTensor(const vector<idx_t> &rows, duckdb_onnx::ShapeVec shape) const;
+
+	duckdb_onnx::DatumType datum_type;
+
+private:
+	UnifiedVectorFormat format;
+	//! The list entries, null for an ARRAY vector
+	const list_entry_t *lists = nullptr;
+	idx_t array_size = 0;
+	data_ptr_t child_data;
+	idx_t element_size;
+	ValidityMask *child_validity;
+};
+
+} // namespace duckdb
@@ -0,0 +1,94 @@
+#include "duckdb-onnx/mmap.h"
+
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace duckdb_onnx {
+
+std::shared_ptr<MemoryMap> MemoryMap::open(const std::string &path) {
+	std::shared_ptr<MemoryMap> map(new MemoryMap());
+	map->path_ = path;
+#ifdef _WIN32
+	auto file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+	                        FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		throw std::runtime_error("Could not open " + path);
+	}
+	map->file_handle_ = file;
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size)) {
+		throw std::runtime_error("Could not get the size of " + path);
+	}
+	map->size_ = static_cast<size_t>(size.QuadPart);
+	if (map->size_ == 0) {
+		return map;
+	}
+	auto mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!mapping) {
+		throw std::runtime_error("Could not map " + path);
+	}
+	map->mapping_handle_ = mapping;
+	map->data_ = static_cast<char *>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+	if (!map->data_) {
+		throw std::runtime_error("Could not map " + path);
+	}
+#else
+	int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0) {
+		throw std::runtime_error("Could not open " + path);
+	}
+	struct stat st;
+	if (fstat(fd, &st) != 0) {
+		::close(fd);
+		throw std::runtime_error("Could not get the size of " + path);
+	}
+	map->size_ = static_cast<size_t>(st.st_size);
+	if (map->size_ > 0) {
+		void *data = mmap(nullptr, map->size_, PROT_READ, MAP_SHARED, fd, 0);
+		if (data == MAP_FAILED) {
+			::close(fd);
+			throw std::runtime_error("Could not map " + path);
+		}
+		map->data_ = static_cast<char *>(data);
+	}
+	// the mapping stays valid after the descriptor is closed
+	::close(fd);
+#endif
+	return map;
+}
+
+MemoryMap::~MemoryMap() {
+#ifdef _WIN32
+	if (data_) {
+		UnmapViewOfFile(data_);
+	}
+	if (mapping_handle_) {
+		CloseHandle(mapping_handle_);
+	}
+	if (file_handle_) {
+		CloseHandle(file_handle_);
+	}
+#else
+	if (data_) {
+		munmap(data_, size_);
+	}
+#endif
+}
+
+class Blob MemoryMap::slice(size_t offset, size_t length) const {
+	if (offset > size_ || length > size_ - offset) {
+		throw std::runtime_error("Range [" + std::to_string(offset) + ", +" + std::to_string(length) +
+		                         ") is out of the bounds of " + path_);
+	}
+	return Blob::view(shared_from_this(), data_ + offset, length);
+}
+
+} // namespace duckdb_onnx
@@ -0,0 +1,206 @@
+#include "duckdb-onnx/onnx/model.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+
+namespace duckdb_onnx {
+
+class Blob MmapDataResolver::read_bytes_from_path(const std::string &path, size_t offset, size_t length) const {
+	std::shared_ptr<MemoryMap> map;
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		auto &entry = maps[path];
+		if (!entry) {
+			entry = MemoryMap::open(path);
+		}
+		map = entry;
+	}
+	if (length == SIZE_MAX) {
+		if (offset > map->size()) {
+			throw std::runtime_error("Offset " + std::to_string(offset) + " is past the end of " + path);
+		}
+		length = map->size() - offset;
+	}
+	return map->slice(offset, length);
+}
+
+std::vector<std::string> MmapDataResolver::paths() const {
+	std::vector<std::string> result;
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		for (auto &entry : maps) {
+			result.push_back(entry.first);
+		}
+	}
+	std::sort(result.begin(), result.end());
+	return result;
+}
+
+// Minimal protobuf wire format handling, enough to walk
+// ModelProto.graph (7) -> GraphProto.initializer (5) -> TensorProto.raw_data (9)
+// without materializing the bytes we want to keep in the mapping.
+namespace {
+
+constexpr uint32_t MODEL_GRAPH_FIELD = 7;
+constexpr uint32_t GRAPH_INITIALIZER_FIELD = 5;
+constexpr uint32_t TENSOR_NAME_FIELD = 8;
+constexpr uint32_t TENSOR_RAW_DATA_FIELD = 9;
+constexpr uint32_t WIRE_VARINT = 0;
+constexpr uint32_t WIRE_FIXED64 = 1;
+constexpr uint32_t WIRE_LEN = 2;
+constexpr uint32_t WIRE_FIXED32 = 5;
+
+struct WireField {
+	uint32_t number;
+	uint32_t wire_type;
+	/// the whole field, tag included
+	size_t begin;
+	size_t end;
+	/// payload of length-delimited fields
+	size_t payload_begin;
+};
+
+class WireReader {
+public:
+	WireReader(const char *data, size_t begin, size_t end) : data(data), pos(begin), end(end) {
+	}
+
+	bool done() const {
+		return pos >= end;
+	}
+
+	WireField next() {
+		WireField field;
+		field.begin = pos;
+		auto tag = read_varint();
+		field.number = static_cast<uint32_t>(tag >> 3);
+		field.wire_type = static_cast<uint32_t>(tag & 7);
+		switch (field.wire_type) {
+		case WIRE_VARINT:
+			read_varint();
+			break;
+		case WIRE_FIXED64:
+			skip(8);
+			break;
+		case WIRE_FIXED32:
+			skip(4);
+			break;
+		case WIRE_LEN: {
+			auto length = read_varint();
+			field.payload_begin = pos;
+			skip(length);
+			break;
+		}
+		default:
+			throw std::runtime_error("Unsupported protobuf wire type in ONNX model");
+		}
+		field.end = pos;
+		return field;
+	}
+
+private:
+	uint64_t read_varint() {
+		uint64_t result = 0;
+		for (int shift = 0; shift < 64; shift += 7) {
+			if (pos >= end) {
+				throw std::runtime_error("Truncated ONNX model");
+			}
+			auto byte = static_cast<uint8_t>(data[pos++]);
+			result |= static_cast<uint64_t>(byte & 0x7f) << shift;
+			if (!(byte & 0x80)) {
+				return result;
+			}
+		}
+		throw std::runtime_error("Malformed varint in ONNX model");
+	}
+
+	void skip(uint64_t count) {
+		if (count > end - pos) {
+			throw std::runtime_error("Truncated ONNX model");
+		}
+		pos += count;
+	}
+
+	const char *data;
+	size_t pos;
+	size_t end;
+};
+
+void write_varint(std::string &out, uint64_t value) {
+	while (value >= 0x80) {
+		out.push_back(static_cast<char>((value & 0x7f) | 0x80));
+		value >>= 7;
+	}
+	out.push_back(static_cast<char>(value));
+}
+
+void write_len_field(std::string &out, uint32_t number, const std::string &payload) {
+	write_varint(out, (static_cast<uint64_t>(number) << 3) | WIRE_LEN);
+	write_varint(out, payload.size());
+	out += payload;
+}
+
+std::string strip_tensor(const MemoryMap &map, size_t begin, size_t end,
+                         std::unordered_map<std::string, class Blob> &views) {
+	std::string name;
+	const WireField *raw_data = nullptr;
+	std::vector<WireField> fields;
+	WireReader reader(map.data(), begin, end);
+	while (!reader.done()) {
+		fields.push_back(reader.next());
+	}
+	for (auto &field : fields) {
+		if (field.wire_type != WIRE_LEN) {
+			continue;
+		}
+		if (field.number == TENSOR_NAME_FIELD) {
+			name.assign(map.data() + field.payload_begin, field.end - field.payload_begin);
+		} else if (field.number == TENSOR_RAW_DATA_FIELD) {
+			raw_data = &field;
+		}
+	}
+	bool strip = raw_data && !name.empty() && raw_data->end - raw_data->payload_begin >= MMAP_RAW_DATA_THRESHOLD;
+	std::string out;
+	for (auto &field : fields) {
+		if (strip && &field == raw_data) {
+			views[name] = map.slice(field.payload_begin, field.end - field.payload_begin);
+			continue;
+		}
+		out.append(map.data() + field.begin, field.end - field.begin);
+	}
+	return out;
+}
+
+std::string strip_graph(const MemoryMap &map, size_t begin, size_t end,
+                        std::unordered_map<std::string, class Blob> &views) {
+	std::string out;
+	WireReader reader(map.data(), begin, end);
+	while (!reader.done()) {
+		auto field = reader.next();
+		if (field.number == GRAPH_INITIALIZER_FIELD && field.wire_type == WIRE_LEN) {
+			write_len_field(out, field.number, strip_tensor(map, field.payload_begin, field.end, views));
+		} else {
+			out.append(map.data() + field.begin, field.end - field.begin);
+		}
+	}
+	return out;
+}
+
+} // namespace
+
+std::string strip_large_raw_data(const MemoryMap &map, std::unordered_map<std::string, class Blob> &views) {
+	std::string out;
+	WireReader reader(map.data(), 0, map.size());
+	while (!reader.done()) {
+		auto field = reader.next();
+		if (field.number == MODEL_GRAPH_FIELD && field.wire_type == WIRE_LEN) {
+			write_len_field(out, field.number, strip_graph(map, field.payload_begin, field.end, views));
+		} else {
+			out.append(map.data() + field.begin, field.end - field.begin);
+		}
+	}
+	return out;
+}
+
+} // namespace duckdb_onnx
@@ -1,4 +1,457 @@
-
 #include "duckdb-onnx/onnx/model.hpp"
 
-namespace duckdb_onnx {}
\ No newline at end of file
+#include "duckdb-onnx/core/ops/konst.h"
+#include "duckdb-onnx/core/ops/source.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <queue>
+#include <unordered_set>
+
+namespace duckdb_onnx {
+
+std::string OnnxOpRegister::key(const std::string &domain, const std::string &op_type) {
+	// "ai.onnx" is the explicit name of the default domain
+	return (domain == "ai.onnx" ? std::string() : domain) + "::" + op_type;
+}
+
+void OnnxOpRegister::insert(const std::string &op_type, OpBuilder builder, int64_t since_version,
+                            const std::string &domain) {
+	auto &builders = op_builders[key(domain, op_type)];
+	builders.emplace_back(since_version, std::move(builder));
+	std::sort(builders.begin(), builders.end(),
+	          [](const std::pair<int64_t, OpBuilder> &a, const std::pair<int64_t, OpBuilder> &b) {
+		          return a.first < b.first;
+	          });
+}
+
+const OpBuilder *OnnxOpRegister::find(const std::string &domain, const std::string &op_type, int64_t opset) const {
+	auto it = op_builders.find(key(domain, op_type));
+	if (it == op_builders.end()) {
+		return nullptr;
+	}
+	const OpBuilder *found = nullptr;
+	for (auto &entry : it->second) {
+		if (entry.first <= opset || !found) {
+			found = &entry.second;
+		}
+	}
+	return found;
+}
+
+DatumType datum_type_from_onnx(int32_t elem_type) {
+	switch (elem_type) {
+	case pb::TensorProto_DataType_FLOAT:
+		return DatumType::F32;
+	case pb::TensorProto_DataType_UINT8:
+		return DatumType::U8;
+	case pb::TensorProto_DataType_INT8:
+		return DatumType::I8;
+	case pb::TensorProto_DataType_UINT16:
+		return DatumType::U16;
+	case pb::TensorProto_DataType_INT16:
+		return DatumType::I16;
+	case pb::TensorProto_DataType_INT32:
+		return DatumType::I32;
+	case pb::TensorProto_DataType_INT64:
+		return DatumType::I64;
+	case pb::TensorProto_DataType_STRING:
+		return DatumType::String;
+	case pb::TensorProto_DataType_BOOL:
+		return DatumType::Bool;
+	case pb::TensorProto_DataType_FLOAT16:
+		return DatumType::F16;
+	case pb::TensorProto_DataType_BFLOAT16:
+		return DatumType::BF16;
+	case pb::TensorProto_DataType_DOUBLE:
+		return DatumType::F64;
+	case pb::TensorProto_DataType_UINT32:
+		return DatumType::U32;
+	case pb::TensorProto_DataType_UINT64:
+		return DatumType::U64;
+	default:
+		throw std::runtime_error("Unsupported ONNX tensor element type " + std::to_string(elem_type));
+	}
+}
+
+template <typename T, typename S>
+static void copy_typed_data(Tensor &tensor, const S &source) {
+	if (static_cast<size_t>(source.size()) != tensor.len()) {
+		throw std::runtime_error("Tensor data does not match its shape");
+	}
+	auto target = static_cast<T *>(tensor.raw_data_mut());
+	for (int i = 0; i < source.size(); i++) {
+		target[i] = static_cast<T>(source.Get(i));
+	}
+}
+
+/// A tensor over bytes that stay where they are (file mapping) when they are
+/// suitably aligned for the element type, a heap copy otherwise.
+static std::shared_ptr<Tensor> tensor_from_bytes(const pb::TensorProto &proto, DatumType dt,
+                                                 std::vector<int64_t> shape, class Blob bytes) {
+	size_t byte_len = datum_type_size(dt);
+	for (auto dim : shape) {
+		byte_len *= static_cast<size_t>(dim);
+	}
+	if (bytes.size() != byte_len) {
+		throw std::runtime_error("Data of tensor " + proto.name() + " does not match its shape");
+	}
+	if (reinterpret_cast<uintptr_t>(bytes.data()) % datum_type_size(dt) == 0) {
+		return std::make_shared<Tensor>(Tensor::from_blob(dt, std::move(shape), std::move(bytes)));
+	}
+	auto tensor = std::make_shared<Tensor>(Tensor::uninitialized(dt, std::move(shape)));
+	std::memcpy(tensor->raw_data_mut(), bytes.data(), byte_len);
+	return tensor;
+}
+
+/// Whether the external data `location` stays in the model directory: a
+/// relative path without ".." components, so that a model cannot have any
+/// file of the host read as a tensor
+static bool is_contained_location(const std::string &location) {
+	if (location[0] == '/' || location[0] == '\\' || (location.size() > 1 && location[1] == ':')) {
+		return false;
+	}
+	size_t begin = 0;
+	while (begin <= location.size()) {
+		auto end = location.find_first_of("/\\", begin);
+		if (end == std::string::npos) {
+			end = location.size();
+		}
+		if (location.compare(begin, end - begin, "..") == 0) {
+			return false;
+		}
+		begin = end + 1;
+	}
+	return true;
+}
+
+static class Blob read_external_data(const ParsingContext &ctx, const pb::TensorProto &proto) {
+	std::string location;
+	size_t offset = 0;
+	size_t length = SIZE_MAX;
+	for (auto &entry : proto.external_data()) {
+		if (entry.key() == "location") {
+			location = entry.value();
+		} else if (entry.key() == "offset") {
+			offset = std::stoull(entry.value());
+		} else if (entry.key() == "length") {
+			length = std::stoull(entry.value());
+		}
+	}
+	if (location.empty()) {
+		throw std::runtime_error("Tensor " + proto.name() + " has external data without a location");
+	}
+	if (!is_contained_location(location)) {
+		throw std::runtime_error("Tensor " + proto.name() + " has external data outside of the model directory: " +
+		                         location);
+	}
+	if (!ctx.model_dir) {
+		throw std::runtime_error("Tensor " + proto.name() + " uses external data but the model directory is unknown");
+	}
+	if (!ctx.framework || !ctx.framework->provider) {
+		throw std::runtime_error("No data resolver to load external data of tensor " + proto.name());
+	}
+	return ctx.framework->provider->read_bytes_from_path(*ctx.model_dir + "/" + location, offset, length);
+}
+
+std::shared_ptr<Tensor> tensor_from_proto(const ParsingContext &ctx, const pb::TensorProto &proto) {
+	auto dt = datum_type_from_onnx(proto.data_type());
+	if (dt == DatumType::String) {
+		throw std::runtime_error("String tensors are not supported (" + proto.name() + ")");
+	}
+	std::vector<int64_t> shape(proto.dims().begin(), proto.dims().end());
+	if (proto.data_location() == pb::TensorProto_DataLocation_EXTERNAL) {
+		return tensor_from_bytes(proto, dt, std::move(shape), read_external_data(ctx, proto));
+	}
+	if (ctx.raw_data_views && proto.raw_data().empty()) {
+		auto view = ctx.raw_data_views->find(proto.name());
+		if (view != ctx.raw_data_views->end()) {
+			return tensor_from_bytes(proto, dt, std::move(shape), view->second);
+		}
+	}
+	auto tensor = std::make_shared<Tensor>(Tensor::uninitialized(dt, shape));
+	if (!proto.raw_data().empty()) {
+		if (proto.raw_data().size() != tensor->byte_len()) {
+			throw std::runtime_error("Raw data of tensor " + proto.name() + " does not match its shape");
+		}
+		std::memcpy(tensor->raw_data_mut(), proto.raw_data().data(), tensor->byte_len());
+		return tensor;
+	}
+	switch (dt) {
+	case DatumType::F32:
+		copy_typed_data<float>(*tensor, proto.float_data());
+		break;
+	case DatumType::F64:
+		copy_typed_data<double>(*tensor, proto.double_data());
+		break;
+	case DatumType::I64:
+		copy_typed_data<int64_t>(*tensor, proto.int64_data());
+		break;
+	case DatumType::U32:
+	case DatumType::U64:
+		if (dt == DatumType::U32) {
+			copy_typed_data<uint32_t>(*tensor, proto.uint64_data());
+		} else {
+			copy_typed_data<uint64_t>(*tensor, proto.uint64_data());
+		}
+		break;
+	case DatumType::I32:
+		copy_typed_data<int32_t>(*tensor, proto.int32_data());
+		break;
+	case DatumType::I16:
+		copy_typed_data<int16_t>(*tensor, proto.int32_data());
+		break;
+	case DatumType::I8:
+		copy_typed_data<int8_t>(*tensor, proto.int32_data());
+		break;
+	case DatumType::U16:
+	case DatumType::F16:
+	case DatumType::BF16:
+		// float16 and bfloat16 values are stored as their bit patterns in int32_data
+		copy_typed_data<uint16_t>(*tensor, proto.int32_data());
+		break;
+	case DatumType::U8:
+		copy_typed_data<uint8_t>(*tensor, proto.int32_data());
+		break;
+	case DatumType::Bool:
+		copy_typed_data<uint8_t>(*tensor, proto.int32_data());
+		break;
+	default:
+		throw std::runtime_error("Unsupported initializer type for " + proto.name());
+	}
+	return tensor;
+}
+
+static TypedFact fact_from_value_info(const pb::ValueInfoProto &info) {
+	TypedFact fact;
+	if (!info.type().has_tensor_type()) {
+		return fact;
+	}
+	auto &tensor_type = info.type().tensor_type();
+	if (tensor_type.elem_type() != pb::TensorProto_DataType_UNDEFINED) {
+		fact.datum_type = datum_type_from_onnx(tensor_type.elem_type());
+	}
+	if (tensor_type.has_shape()) {
+		fact.rank_known = true;
+		for (auto &dim : tensor_type.shape().dim()) {
+			// named dimensions such as a batch size become symbols, anonymous ones are unknown
+			if (dim.value_case() == pb::TensorShapeProto_Dimension::kDimValue) {
+				fact.shape.emplace_back(dim.dim_value());
+			} else if (dim.value_case() == pb::TensorShapeProto_Dimension::kDimParam && !dim.dim_param().empty()) {
+				fact.shape.push_back(TDim::symbol(dim.dim_param()));
+			} else {
+				fact.shape.emplace_back();
+			}
+		}
+	}
+	return fact;
+}
+
+TractResult<std::shared_ptr<pb::ModelProto>> Onnx::proto_model_for_path(const std::string &path) const {
+	std::ifstream input(path, std::ios::in | std::ios::binary);
+	if (!input) {
+		return Err<std::shared_ptr<pb::ModelProto>>("Could not open ONNX model file: " + path);
+	}
+	auto proto = std::make_shared<pb::ModelProto>();
+	if (!proto->ParseFromIstream(&input)) {
+		return Err<std::shared_ptr<pb::ModelProto>>("Failed to parse ONNX model file: " + path);
+	}
+	return Ok(std::move(proto));
+}
+
+TractResult<std::shared_ptr<pb::ModelProto>> Onnx::proto_model_for_bytes(const char *data, size_t size) const {
+	auto proto = std::make_shared<pb::ModelProto>();
+	if (size > static_cast<size_t>(std::numeric_limits<int>::max()) ||
+	    !proto->ParseFromArray(data, static_cast<int>(size))) {
+		return Err<std::shared_ptr<pb::ModelProto>>("Failed to parse ONNX model from " + std::to_string(size) +
+		                                            " bytes");
+	}
+	return Ok(std::move(proto));
+}
+
+TractResult<TypedModel>
+Onnx::model_for_proto_model(const pb::ModelProto &proto, const std::string *model_dir,
+                            const std::unordered_map<std::string, class Blob> *raw_data_views) const {
+	return try_catch([&]() {
+		ParsingContext ctx(0, this, &proto, {}, model_dir);
+		ctx.raw_data_views = raw_data_views;
+		for (auto &opset : proto.opset_import()) {
+			auto domain = opset.domain() == "ai.onnx" ? std::string() : opset.domain();
+			ctx.opset_versions[domain] = opset.version();
+			if (domain.empty()) {
+				ctx.onnx_operator_set_version = opset.version();
+			}
+		}
+		if (proto.opset_import_size() == 0) {
+			// models without opset_import predate opsets and follow version 1
+			ctx.onnx_operator_set_version = 1;
+		}
+		return parse_graph(ctx, proto.graph());
+	});
+}
+
+TractResult<TypedModel> Onnx::model_for_path(const std::string &path) const {
+	std::shared_ptr<MemoryMap> map;
+	std::unordered_map<std::string, class Blob> raw_data_views;
+	pb::ModelProto proto;
+	try {
+		map = MemoryMap::open(path);
+		// large weights are left in the mapping, only the rest of the model is parsed into protobuf messages
+		auto stripped = strip_large_raw_data(*map, raw_data_views);
+		if (!proto.ParseFromString(stripped)) {
+			return Err<TypedModel>("Failed to parse ONNX model file: " + path);
+		}
+	} catch (std::exception &e) {
+		return Err<TypedModel>("Could not read ONNX model file " + path + ": " + e.what());
+	}
+	auto model_dir = model_dir_for_path(path);
+	return model_for_proto_model(proto, &model_dir, &raw_data_views);
+}
+
+std::string Onnx::model_dir_for_path(const std::string &path) {
+	auto slash = path.find_last_of("/\\");
+	return slash == std::string::npos ? std::string(".") : path.substr(0, slash);
+}
+
+TractResult<TypedModel> Onnx::model_for_bytes(const char *data, size_t size, const std::string *model_dir) const {
+	auto proto = proto_model_for_bytes(data, size);
+	if (proto.is_err()) {
+		return Err<TypedModel>(proto.error().what());
+	}
+	return model_for_proto_model(*proto.value(), model_dir);
+}
+
+TypedModel Onnx::parse_graph(const ParsingContext &ctx, const pb::GraphProto &graph) const {
+	TypedModel model;
+	// name of every tensor produced so far -> the outlet producing it
+	std::unordered_map<std::string, OutletId> outlets;
+
+	std::unordered_map<std::string, const pb::ValueInfoProto *> value_infos;
+	for (auto &info : graph.value_info()) {
+		value_infos[info.name()] = &info;
+	}
+	for (auto &info : graph.output()) {
+		value_infos[info.name()] = &info;
+	}
+
+	std::unordered_set<std::string> initializer_names;
+	for (auto &initializer : graph.initializer()) {
+		initializer_names.insert(initializer.name());
+	}
+	for (auto &input : graph.input()) {
+		// before IR v4 initializers are also listed as graph inputs
+		if (initializer_names.count(input.name())) {
+			continue;
+		}
+		auto id = model.add_node(input.name(), OpBox(std::make_shared<SourceOp>()), {fact_from_value_info(input)});
+		OutletId outlet(id, 0);
+		model.inputs.push_back(outlet);
+		model.set_outlet_label(outlet, input.name());
+		outlets[input.name()] = outlet;
+	}
+	for (auto &initializer : graph.initializer()) {
+		auto value = tensor_from_proto(ctx, initializer);
+		auto id = model.add_node(initializer.name(), OpBox(std::make_shared<ConstOp>(value)),
+		                         {TypedFact::from_const(value)});
+		OutletId outlet(id, 0);
+		model.set_outlet_label(outlet, initializer.name());
+		outlets[initializer.name()] = outlet;
+	}
+
+	// Kahn's algorithm over the proto nodes: ONNX requires topologically sorted
+	// nodes but exporters do not always comply. Ties keep the file order.
+	auto node_count = static_cast<size_t>(graph.node_size());
+	std::vector<size_t> missing_inputs(node_count, 0);
+	std::unordered_map<std::string, std::vector<size_t>> consumers;
+	std::priority_queue<size_t, std::vector<size_t>, std::greater<size_t>> ready;
+	for (size_t i = 0; i < node_count; i++) {
+		std::unordered_set<std::string> waiting;
+		for (auto &input : graph.node(i).input()) {
+			if (!input.empty() && !outlets.count(input) && waiting.insert(input).second) {
+				consumers[input].push_back(i);
+			}
+		}
+		missing_inputs[i] = waiting.size();
+		if (waiting.empty()) {
+			ready.push(i);
+		}
+	}
+
+	size_t built = 0;
+	while (!ready.empty()) {
+		auto index = ready.top();
+		ready.pop();
+		auto &proto_node = graph.node(index);
+		auto name = proto_node.name().empty() ? proto_node.op_type() + "_" + std::to_string(index) : proto_node.name();
+
+		auto builder = op_register.find(proto_node.domain(), proto_node.op_type(),
+		                                ctx.opset_version(proto_node.domain() == "ai.onnx" ? "" : proto_node.domain()));
+		if (!builder) {
+			throw std::runtime_error("Unsupported ONNX operator " +
+			                         (proto_node.domain().empty() ? "" : proto_node.domain() + ".") +
+			                         proto_node.op_type() + " (node " + name + ")");
+		}
+		std::shared_ptr<Op> op;
+		try {
+			op = (*builder)(ctx, proto_node);
+		} catch (std::exception &e) {
+			throw std::runtime_error("Failed to build node " + name + " (" + proto_node.op_type() + "): " + e.what());
+		}
+
+		std::vector<TypedFact> facts;
+		for (auto &output : proto_node.output()) {
+			auto info = value_infos.find(output);
+			facts.push_back(info == value_infos.end() ? TypedFact() : fact_from_value_info(*info->second));
+		}
+		auto id = model.add_node(name, OpBox(std::move(op)), std::move(facts));
+
+		size_t slot = 0;
+		for (auto &input : proto_node.input()) {
+			// empty names stand for omitted optional inputs; builders interpret positions themselves
+			if (input.empty()) {
+				continue;
+			}
+			model.add_edge(outlets.at(input), InletId(id, slot++));
+		}
+		for (int i = 0; i < proto_node.output_size(); i++) {
+			auto &output = proto_node.output(i);
+			if (output.empty()) {
+				continue;
+			}
+			OutletId outlet(id, static_cast<size_t>(i));
+			model.set_outlet_label(outlet, output);
+			outlets[output] = outlet;
+			auto waiting = consumers.find(output);
+			if (waiting != consumers.end()) {
+				for (auto consumer : waiting->second) {
+					if (--missing_inputs[consumer] == 0) {
+						ready.push(consumer);
+					}
+				}
+				consumers.erase(waiting);
+			}
+		}
+		built++;
+	}
+	if (built != node_count) {
+		for (auto &waiting : consumers) {
+			auto &node = graph.node(static_cast<int>(waiting.second.front()));
+			throw std::runtime_error("Input " + waiting.first + " of node " + node.name() +
+			                         " is never produced (or the graph has a cycle)");
+		}
+	}
+
+	for (auto &output : graph.output()) {
+		auto it = outlets.find(output.name());
+		if (it == outlets.end()) {
+			throw std::runtime_error("Model output " + output.name() + " is never produced");
+		}
+		model.outputs.push_back(it->second);
+	}
+	return model;
+}
+
+} // namespace duckdb_onnx
@@ -0,0 +1,71 @@
+#include "duckdb-onnx/onnx/ops.hpp"
+
+#include "duckdb-onnx/core/ops/identity.h"
+
+#include <stdexcept>
+
+namespace duckdb_onnx {
+
+const pb::AttributeProto *find_attribute(const pb::NodeProto &node, const std::string &name) {
+	for (auto &attr : node.attribute()) {
+		if (attr.name() == name) {
+			return &attr;
+		}
+	}
+	return nullptr;
+}
+
+int64_t get_attr_int(const pb::NodeProto &node, const std::string &name, int64_t default_value) {
+	auto attr = find_attribute(node, name);
+	return attr ? attr->i() : default_value;
+}
+
+float get_attr_float(const pb::NodeProto &node, const std::string &name, float default_value) {
+	auto attr = find_attribute(node, name);
+	return attr ? attr->f() : default_value;
+}
+
+std::string get_attr_string(const pb::NodeProto &node, const std::string &name, const std::string &default_value) {
+	auto attr = find_attribute(node, name);
+	return attr ? attr->s() : default_value;
+}
+
+std::vector<int64_t> get_attr_ints(const pb::NodeProto &node, const std::string &name) {
+	auto attr = find_attribute(node, name);
+	if (!attr) {
+		return {};
+	}
+	return std::vector<int64_t>(attr->ints().begin(), attr->ints().end());
+}
+
+int64_t require_attr_int(const pb::NodeProto &node, const std::string &name) {
+	auto attr = find_attribute(node, name);
+	if (!attr) {
+		throw std::runtime_error(node.op_type() + " node " + node.name() + " requires attribute " + name);
+	}
+	return attr->i();
+}
+
+int optional_input_index(const pb::NodeProto &node, size_t position) {
+	if (position >= static_cast<size_t>(node.input_size()) || node.input(position).empty()) {
+		return -1;
+	}
+	int index = 0;
+	for (size_t i = 0; i < position; i++) {
+		if (!node.input(i).empty()) {
+			index++;
+		}
+	}
+	return index;
+}
+
+void register_all_ops(OnnxOpRegister &reg) {
+	reg.insert("Identity",
+	           [](const ParsingContext &, const pb::NodeProto &) { return std::make_shared<IdentityOp>(); });
+	register_math_ops(reg);
+	register_nn_ops(reg);
+	register_array_ops(reg);
+	register_quant_ops(reg);
+}
+
+} // namespace duckdb_onnx
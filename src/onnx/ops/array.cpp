@@ -0,0 +1,71 @@
+#include "duckdb-onnx/core/ops/konst.h"
+#include "duckdb-onnx/core/ops/reshape.h"
+#include "duckdb-onnx/core/ops/shape.h"
+#include "duckdb-onnx/onnx/ops.hpp"
+
+namespace duckdb_onnx {
+
+/// Value of an ONNX Constant node
+static std::shared_ptr<Tensor> constant_value(const ParsingContext &ctx, const pb::NodeProto &node) {
+	if (auto attr = find_attribute(node, "value")) {
+		return tensor_from_proto(ctx, attr->t());
+	}
+	if (auto attr = find_attribute(node, "value_float")) {
+		return std::make_shared<Tensor>(Tensor::from_vec<float>({}, {attr->f()}));
+	}
+	if (auto attr = find_attribute(node, "value_int")) {
+		return std::make_shared<Tensor>(Tensor::from_vec<int64_t>({}, {attr->i()}));
+	}
+	if (auto attr = find_attribute(node, "value_floats")) {
+		std::vector<float> values(attr->floats().begin(), attr->floats().end());
+		return std::make_shared<Tensor>(Tensor::from_vec<float>({int64_t(values.size())}, values));
+	}
+	if (auto attr = find_attribute(node, "value_ints")) {
+		std::vector<int64_t> values(attr->ints().begin(), attr->ints().end());
+		return std::make_shared<Tensor>(Tensor::from_vec<int64_t>({int64_t(values.size())}, values));
+	}
+	throw std::runtime_error("Constant node " + node.name() + " has no supported value attribute");
+}
+
+static OpBuilder squeeze(bool unsqueeze, bool axes_input) {
+	return [=](const ParsingContext &, const pb::NodeProto &node) -> std::shared_ptr<Op> {
+		return std::make_shared<SqueezeOp>(unsqueeze, ShapeVec(get_attr_ints(node, "axes")), axes_input);
+	};
+}
+
+void register_array_ops(OnnxOpRegister &reg) {
+	reg.insert("Constant", [](const ParsingContext &ctx, const pb::NodeProto &node) -> std::shared_ptr<Op> {
+		return std::make_shared<ConstOp>(constant_value(ctx, node));
+	});
+
+	reg.insert("Reshape", [](const ParsingContext &, const pb::NodeProto &node) -> std::shared_ptr<Op> {
+		return std::make_shared<ReshapeOp>(ShapeVec(get_attr_ints(node, "shape")));
+	});
+	// from opset 5 the shape is an input
+	reg.insert(
+	    "Reshape",
+	    [](const ParsingContext &, const pb::NodeProto &node) -> std::shared_ptr<Op> {
+		    return std::make_shared<ReshapeOp>(get_attr_int(node, "allowzero", 0) != 0);
+	    },
+	    5);
+	reg.insert("Flatten", [](const ParsingContext &, const pb::NodeProto &node) -> std::shared_ptr<Op> {
+		return std::make_shared<FlattenOp>(get_attr_int(node, "axis", 1));
+	});
+	// from opset 13 the axes are an input
+	reg.insert("Squeeze", squeeze(false, false));
+	reg.insert("Squeeze", squeeze(false, true), 13);
+	reg.insert("Unsqueeze", squeeze(true, false));
+	reg.insert("Unsqueeze", squeeze(true, true), 13);
+
+	reg.insert("Shape", [](const ParsingContext &, const pb::NodeProto &node) -> std::shared_ptr<Op> {
+		return std::make_shared<ShapeOp>(get_attr_int(node, "start", 0), get_attr_int(node, "end", INT64_MAX));
+	});
+	reg.insert("Gather", [](const ParsingContext &, const pb::NodeProto &node) -> std::shared_ptr<Op> {
+		return std::make_shared<GatherOp>(get_attr_int(node, "axis", 0));
+	});
+	reg.insert("Concat", [](const ParsingContext &, const pb::NodeProto &node) -> std::shared_ptr<Op> {
+		return std::make_shared<ConcatOp>(get_attr_int(node, "axis", 1));
+	});
+}
+
+} // namespace duckdb_onnx
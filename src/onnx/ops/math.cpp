@@ -0,0 +1,78 @@
+#include "duckdb-onnx/core/ops/binary.h"
+#include "duckdb-onnx/core/ops/cast.h"
+#include "duckdb-onnx/core/ops/matmul.h"
+#include "duckdb-onnx/core/ops/unary.h"
+#include "duckdb-onnx/onnx/ops.hpp"
+
+#include <limits>
+
+namespace duckdb_onnx {
+
+static OpBuilder binary(BinaryKind kind) {
+	return [kind](const ParsingContext &, const pb::NodeProto &node) -> std::shared_ptr<Op> {
+		// before opset 7, broadcasting had to be requested and could align on any axis
+		if (get_attr_int(node, "broadcast", 0) != 0 && find_attribute(node, "axis")) {
+			throw std::runtime_error(node.op_type() + " node " + node.name() +
+			                         ": legacy axis broadcasting is not supported");
+		}
+		return std::make_shared<BinaryOp>(kind);
+	};
+}
+
+/// Max and Min are variadic; only their two-operand form is supported
+static OpBuilder pairwise(BinaryKind kind) {
+	return [kind](const ParsingContext &, const pb::NodeProto &node) -> std::shared_ptr<Op> {
+		if (node.input_size() != 2) {
+			throw std::runtime_error(node.op_type() + " is only supported with 2 inputs");
+		}
+		return std::make_shared<BinaryOp>(kind);
+	};
+}
+
+static OpBuilder unary(UnaryKind kind) {
+	return [kind](const ParsingContext &, const pb::NodeProto &) -> std::shared_ptr<Op> {
+		return std::make_shared<UnaryOp>(kind);
+	};
+}
+
+void register_math_ops(OnnxOpRegister &reg) {
+	reg.insert("Add", binary(BinaryKind::Add));
+	reg.insert("Sub", binary(BinaryKind::Sub));
+	reg.insert("Mul", binary(BinaryKind::Mul));
+	reg.insert("Div", binary(BinaryKind::Div));
+	reg.insert("Max", pairwise(BinaryKind::Max));
+	reg.insert("Min", pairwise(BinaryKind::Min));
+
+	reg.insert("Relu", unary(UnaryKind::Relu));
+	reg.insert("Sigmoid", unary(UnaryKind::Sigmoid));
+	reg.insert("Tanh", unary(UnaryKind::Tanh));
+	reg.insert("Exp", unary(UnaryKind::Exp));
+
+	reg.insert("Clip", [](const ParsingContext &, const pb::NodeProto &node) -> std::shared_ptr<Op> {
+		return std::make_shared<ClipOp>(get_attr_float(node, "min", std::numeric_limits<float>::lowest()),
+		                                get_attr_float(node, "max", std::numeric_limits<float>::max()));
+	});
+	// from opset 11 the bounds are optional inputs
+	reg.insert(
+	    "Clip",
+	    [](const ParsingContext &, const pb::NodeProto &node) -> std::shared_ptr<Op> {
+		    return std::make_shared<ClipOp>(-std::numeric_limits<double>::infinity(),
+		                                    std::numeric_limits<double>::infinity(), optional_input_index(node, 1),
+		                                    optional_input_index(node, 2));
+	    },
+	    11);
+
+	reg.insert("MatMul", [](const ParsingContext &, const pb::NodeProto &) -> std::shared_ptr<Op> {
+		return std::make_shared<MatMulOp>();
+	});
+	reg.insert("Gemm", [](const ParsingContext &, const pb::NodeProto &node) -> std::shared_ptr<Op> {
+		return std::make_shared<GemmOp>(get_attr_float(node, "alpha", 1.0f), get_attr_float(node, "beta", 1.0f),
+		                                get_attr_int(node, "transA", 0) != 0, get_attr_int(node, "transB", 0) != 0);
+	});
+
+	reg.insert("Cast", [](const ParsingContext &, const pb::NodeProto &node) -> std::shared_ptr<Op> {
+		return std::make_shared<CastOp>(datum_type_from_onnx(static_cast<int32_t>(require_attr_int(node, "to"))));
+	});
+}
+
+} // namespace duckdb_onnx
@@ -0,0 +1,76 @@
+#include "duckdb-onnx/core/ops/batch_norm.h"
+#include "duckdb-onnx/core/ops/conv.h"
+#include "duckdb-onnx/core/ops/pool.h"
+#include "duckdb-onnx/core/ops/softmax.h"
+#include "duckdb-onnx/onnx/ops.hpp"
+
+namespace duckdb_onnx {
+
+PatchSpec patch_spec(const pb::NodeProto &node) {
+	PatchSpec patch;
+	patch.strides = get_attr_ints(node, "strides");
+	patch.dilations = get_attr_ints(node, "dilations");
+	patch.pads = get_attr_ints(node, "pads");
+	patch.ceil_mode = get_attr_int(node, "ceil_mode", 0) != 0;
+	auto auto_pad = get_attr_string(node, "auto_pad", "NOTSET");
+	if (auto_pad == "NOTSET" || auto_pad.empty()) {
+		patch.padding = PaddingMode::Explicit;
+	} else if (auto_pad == "VALID") {
+		patch.padding = PaddingMode::Valid;
+	} else if (auto_pad == "SAME_UPPER") {
+		patch.padding = PaddingMode::SameUpper;
+	} else if (auto_pad == "SAME_LOWER") {
+		patch.padding = PaddingMode::SameLower;
+	} else {
+		throw std::runtime_error(node.op_type() + " node " + node.name() + ": unknown auto_pad " + auto_pad);
+	}
+	return patch;
+}
+
+static OpBuilder pool(PoolKind kind) {
+	return [kind](const ParsingContext &, const pb::NodeProto &node) -> std::shared_ptr<Op> {
+		if (node.output_size() > 1 && !node.output(1).empty()) {
+			throw std::runtime_error(node.op_type() + " node " + node.name() + ": the Indices output is not supported");
+		}
+		auto kernel = get_attr_ints(node, "kernel_shape");
+		if (kernel.empty()) {
+			throw std::runtime_error(node.op_type() + " node " + node.name() + " requires attribute kernel_shape");
+		}
+		return std::make_shared<PoolOp>(kind, kernel, patch_spec(node),
+		                                get_attr_int(node, "count_include_pad", 0) != 0);
+	};
+}
+
+static OpBuilder softmax(bool log, int64_t default_axis, bool coerce_2d) {
+	return [=](const ParsingContext &, const pb::NodeProto &node) -> std::shared_ptr<Op> {
+		return std::make_shared<SoftmaxOp>(log, get_attr_int(node, "axis", default_axis), coerce_2d);
+	};
+}
+
+void register_nn_ops(OnnxOpRegister &reg) {
+	reg.insert("Conv", [](const ParsingContext &, const pb::NodeProto &node) -> std::shared_ptr<Op> {
+		return std::make_shared<ConvOp>(patch_spec(node), get_attr_int(node, "group", 1));
+	});
+	reg.insert("MaxPool", pool(PoolKind::Max));
+	reg.insert("AveragePool", pool(PoolKind::Average));
+	reg.insert("GlobalMaxPool", [](const ParsingContext &, const pb::NodeProto &) -> std::shared_ptr<Op> {
+		return std::make_shared<GlobalPoolOp>(PoolKind::Max);
+	});
+	reg.insert("GlobalAveragePool", [](const ParsingContext &, const pb::NodeProto &) -> std::shared_ptr<Op> {
+		return std::make_shared<GlobalPoolOp>(PoolKind::Average);
+	});
+
+	reg.insert("BatchNormalization", [](const ParsingContext &, const pb::NodeProto &node) -> std::shared_ptr<Op> {
+		if (get_attr_int(node, "training_mode", 0) != 0 || node.output_size() > 1) {
+			throw std::runtime_error("BatchNormalization node " + node.name() + ": training mode is not supported");
+		}
+		return std::make_shared<BatchNormOp>(get_attr_float(node, "epsilon", 1e-5f));
+	});
+
+	reg.insert("Softmax", softmax(false, 1, true));
+	reg.insert("Softmax", softmax(false, -1, false), 13);
+	reg.insert("LogSoftmax", softmax(true, 1, true));
+	reg.insert("LogSoftmax", softmax(true, -1, false), 13);
+}
+
+} // namespace duckdb_onnx
@@ -0,0 +1,40 @@
+#include "duckdb-onnx/core/ops/quant.h"
+#include "duckdb-onnx/onnx/ops.hpp"
+
+namespace duckdb_onnx {
+
+void register_quant_ops(OnnxOpRegister &reg) {
+	// per-axis scales came with opset 13, before which the attribute is absent and scales are scalars
+	reg.insert(
+	    "QuantizeLinear",
+	    [](const ParsingContext &, const pb::NodeProto &node) -> std::shared_ptr<Op> {
+		    return std::make_shared<QuantizeLinearOp>(get_attr_int(node, "axis", 1));
+	    },
+	    10);
+	reg.insert(
+	    "DequantizeLinear",
+	    [](const ParsingContext &, const pb::NodeProto &node) -> std::shared_ptr<Op> {
+		    return std::make_shared<DequantizeLinearOp>(get_attr_int(node, "axis", 1));
+	    },
+	    10);
+	reg.insert(
+	    "MatMulInteger",
+	    [](const ParsingContext &, const pb::NodeProto &node) -> std::shared_ptr<Op> {
+		    return std::make_shared<QMatMulOp>(false, optional_input_index(node, 2), optional_input_index(node, 3));
+	    },
+	    10);
+	reg.insert(
+	    "QLinearMatMul",
+	    [](const ParsingContext &, const pb::NodeProto &) -> std::shared_ptr<Op> {
+		    return std::make_shared<QMatMulOp>(true, 2, 5);
+	    },
+	    10);
+	reg.insert(
+	    "QLinearConv",
+	    [](const ParsingContext &, const pb::NodeProto &node) -> std::shared_ptr<Op> {
+		    return std::make_shared<QLinearConvOp>(patch_spec(node), get_attr_int(node, "group", 1));
+	    },
+	    10);
+}
+
+} // namespace duckdb_onnx
@@ -0,0 +1,418 @@
+#include "duckdb-onnx/onnx/quantize.hpp"
+
+#include "duckdb-onnx/core/ops/konst.h"
+#include "duckdb-onnx/core/ops/source.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <unordered_set>
+
+namespace duckdb_onnx {
+
+/// Opset introducing the quantized operators
+static constexpr int64_t QUANTIZATION_OPSET = 10;
+/// IR version of the models of that opset
+static constexpr int64_t QUANTIZATION_IR_VERSION = 5;
+
+void TensorRange::update(const float *data, size_t len) {
+	for (size_t i = 0; i < len; i++) {
+		auto value = data[i];
+		if (std::isfinite(value)) {
+			min = std::min(min, value);
+			max = std::max(max, value);
+		}
+	}
+}
+
+/// The values of the outlets of `model` that do not depend on its inputs
+static std::unordered_map<OutletId, std::shared_ptr<Tensor>> constant_values(const TypedModel &model) {
+	std::unordered_map<OutletId, std::shared_ptr<Tensor>> values;
+	for (auto id : model.eval_order()) {
+		auto &node = model.nodes[id];
+		if (auto konst = node.op.as<ConstOp>()) {
+			values[OutletId(id, 0)] = konst->value;
+			continue;
+		}
+		if (node.inputs.empty() || node.op.as<SourceOp>() || node.op->validation() == Validation::Random) {
+			continue;
+		}
+		std::vector<TValue> inputs;
+		for (auto &input : node.inputs) {
+			auto value = values.find(input);
+			if (value == values.end()) {
+				break;
+			}
+			inputs.push_back(TValue::Const(value->second));
+		}
+		if (inputs.size() != node.inputs.size()) {
+			continue;
+		}
+		auto outputs = node.op->eval(inputs);
+		if (outputs.is_err()) {
+			continue;
+		}
+		auto results = outputs.value_move();
+		for (size_t slot = 0; slot < results.size(); slot++) {
+			values[OutletId(id, slot)] = results[slot].tensor_;
+		}
+	}
+	return values;
+}
+
+ModelQuantizer::ModelQuantizer(const Onnx &framework, const pb::ModelProto &proto, const TypedModel &model)
+    : framework_(framework), proto_(proto) {
+	std::unordered_map<std::string, OutletId> outlets;
+	for (auto &label : model.outlet_labels) {
+		outlets.emplace(label.second, label.first);
+	}
+	auto constants = constant_values(model);
+	// the value of tensor `name` when it is a constant, else null
+	auto constant = [&](const std::string &name) -> std::shared_ptr<Tensor> {
+		auto outlet = outlets.find(name);
+		if (outlet == outlets.end()) {
+			return nullptr;
+		}
+		auto value = constants.find(outlet->second);
+		return value == constants.end() ? nullptr : value->second;
+	};
+	// whether tensor `name` is an F32 value computed from the model inputs
+	auto is_activation = [&](const std::string &name) {
+		auto outlet = outlets.find(name);
+		return outlet != outlets.end() && !constants.count(outlet->second) &&
+		       model.outlet_fact(outlet->second).datum_type == DatumType::F32;
+	};
+
+	auto &graph = proto.graph();
+	for (int i = 0; i < graph.node_size(); i++) {
+		auto &node = graph.node(i);
+		bool onnx_domain = node.domain().empty() || node.domain() == "ai.onnx";
+		if (!onnx_domain || node.input_size() < 2 || node.output_size() != 1 || !is_activation(node.input(0)) ||
+		    !is_activation(node.output(0))) {
+			continue;
+		}
+		Candidate candidate {i, constant(node.input(1)), nullptr};
+		auto &weights = candidate.weights;
+		if (!weights || weights->datum_type() != DatumType::F32) {
+			continue;
+		}
+		if (node.op_type() == "MatMul") {
+			if (weights->rank() != 2) {
+				continue;
+			}
+		} else if (node.op_type() == "Conv") {
+			if ((weights->rank() != 3 && weights->rank() != 4) || weights->shape()[0] == 0) {
+				continue;
+			}
+			if (node.input_size() > 2 && !node.input(2).empty()) {
+				candidate.bias = constant(node.input(2));
+				auto &bias = candidate.bias;
+				if (!bias || bias->datum_type() != DatumType::F32 ||
+				    bias->len() != static_cast<size_t>(weights->shape()[0])) {
+					continue;
+				}
+			}
+		} else {
+			continue;
+		}
+		candidates_.push_back(std::move(candidate));
+		for (auto &name : {node.input(0), node.output(0)}) {
+			if (std::find(tensors_.begin(), tensors_.end(), name) == tensors_.end()) {
+				tensors_.push_back(name);
+			}
+		}
+	}
+}
+
+/// Scale and zero point mapping `range`, widened to include zero so that it
+/// is exact (as the padding of a Conv), onto [0, 255]
+static std::pair<float, uint8_t> activation_quantization(const TensorRange &range) {
+	auto min = std::min(range.min, 0.0f);
+	auto max = std::max(range.max, 0.0f);
+	auto scale = (max - min) / 255.0f;
+	if (!(scale > 0.0f) || !std::isfinite(scale)) {
+		scale = 1.0f;
+	}
+	auto zero_point = std::min(std::max(std::nearbyint(-min / scale), 0.0f), 255.0f);
+	return {scale, static_cast<uint8_t>(zero_point)};
+}
+
+/// Quantize the `count` groups of `len` weights `stride` apart that start
+/// `group_stride` apart to symmetric INT8 with one scale per group
+static std::vector<float> quantize_weights(const float *weights, size_t count, size_t group_stride, size_t len,
+                                           size_t stride, int8_t *quantized) {
+	std::vector<float> scales(count);
+	for (size_t g = 0; g < count; g++) {
+		auto values = weights + g * group_stride;
+		float max = 0.0f;
+		for (size_t i = 0; i < len; i++) {
+			max = std::max(max, std::fabs(values[i * stride]));
+		}
+		auto scale = max > 0.0f && std::isfinite(max) ? max / 127.0f : 1.0f;
+		for (size_t i = 0; i < len; i++) {
+			auto q = std::nearbyint(values[i * stride] / scale);
+			quantized[g * group_stride + i * stride] = static_cast<int8_t>(std::min(std::max(q, -127.0f), 127.0f));
+		}
+		scales[g] = scale;
+	}
+	return scales;
+}
+
+static void add_initializer(pb::GraphProto &graph, const std::string &name, pb::TensorProto_DataType type,
+                            const std::vector<int64_t> &dims, const void *data, size_t bytes) {
+	auto tensor = graph.add_initializer();
+	tensor->set_name(name);
+	tensor->set_data_type(type);
+	for (auto dim : dims) {
+		tensor->add_dims(dim);
+	}
+	tensor->set_raw_data(data, bytes);
+}
+
+static pb::NodeProto &add_node(google::protobuf::RepeatedPtrField<pb::NodeProto> &nodes, const std::string &op_type,
+                               const std::string &name, const std::vector<std::string> &inputs,
+                               const std::string &output) {
+	auto &node = *nodes.Add();
+	node.set_op_type(op_type);
+	node.set_name(name);
+	for (auto &input : inputs) {
+		node.add_input(input);
+	}
+	node.add_output(output);
+	return node;
+}
+
+/// Add the names of the tensors `node` reads, in its subgraphs too, to `names`
+static void add_read_tensors(const pb::NodeProto &node, std::unordered_set<std::string> &names) {
+	names.insert(node.input().begin(), node.input().end());
+	for (auto &attr : node.attribute()) {
+		if (attr.has_g()) {
+			for (auto &inner : attr.g().node()) {
+				add_read_tensors(inner, names);
+			}
+		}
+		for (auto &subgraph : attr.graphs()) {
+			for (auto &inner : subgraph.node()) {
+				add_read_tensors(inner, names);
+			}
+		}
+	}
+}
+
+/// Drop the nodes and the initializers the outputs of `graph` do not depend on
+static void remove_unused(pb::GraphProto &graph) {
+	std::unordered_set<std::string> needed;
+	for (auto &output : graph.output()) {
+		needed.insert(output.name());
+	}
+	std::vector<bool> live(static_cast<size_t>(graph.node_size()), false);
+	// nodes are usually sorted, which makes one backward pass enough
+	for (bool changed = true; changed;) {
+		changed = false;
+		for (int i = graph.node_size(); i-- > 0;) {
+			auto &node = graph.node(i);
+			if (live[static_cast<size_t>(i)] ||
+			    std::none_of(node.output().begin(), node.output().end(),
+			                 [&](const std::string &output) { return needed.count(output) > 0; })) {
+				continue;
+			}
+			live[static_cast<size_t>(i)] = true;
+			changed = true;
+			add_read_tensors(node, needed);
+		}
+	}
+	google::protobuf::RepeatedPtrField<pb::NodeProto> nodes;
+	for (int i = 0; i < graph.node_size(); i++) {
+		if (live[static_cast<size_t>(i)]) {
+			*nodes.Add() = graph.node(i);
+		}
+	}
+	graph.mutable_node()->Swap(&nodes);
+
+	std::unordered_set<std::string> dropped;
+	google::protobuf::RepeatedPtrField<pb::TensorProto> initializers;
+	for (auto &initializer : graph.initializer()) {
+		if (needed.count(initializer.name())) {
+			*initializers.Add() = initializer;
+		} else {
+			dropped.insert(initializer.name());
+		}
+	}
+	graph.mutable_initializer()->Swap(&initializers);
+	// older models also list their initializers among the graph inputs
+	google::protobuf::RepeatedPtrField<pb::ValueInfoProto> inputs;
+	for (auto &input : graph.input()) {
+		if (!dropped.count(input.name())) {
+			*inputs.Add() = input;
+		}
+	}
+	graph.mutable_input()->Swap(&inputs);
+}
+
+pb::ModelProto ModelQuantizer::quantize(const std::unordered_map<std::string, TensorRange> &ranges,
+                                        size_t &quantized) const {
+	pb::ModelProto model = proto_;
+	auto &graph = *model.mutable_graph();
+	quantized = 0;
+
+	// every name in use, which the added tensors and nodes must not clash with
+	std::unordered_set<std::string> names;
+	for (auto &node : graph.node()) {
+		names.insert(node.name());
+		names.insert(node.input().begin(), node.input().end());
+		names.insert(node.output().begin(), node.output().end());
+	}
+	for (auto &initializer : graph.initializer()) {
+		names.insert(initializer.name());
+	}
+	for (auto &input : graph.input()) {
+		names.insert(input.name());
+	}
+	auto unique_name = [&](const std::string &base) {
+		auto name = base;
+		for (int i = 1; !names.insert(name).second; i++) {
+			name = base + "_" + std::to_string(i);
+		}
+		return name;
+	};
+
+	// the UINT8 counterpart of an activation, its scale and zero point
+	struct QuantizedTensor {
+		std::string value;
+		std::string scale;
+		std::string zero_point;
+		float scale_value;
+	};
+	std::unordered_map<std::string, QuantizedTensor> activations;
+	auto quantized_tensor = [&](const std::string &name) -> QuantizedTensor & {
+		auto it = activations.find(name);
+		if (it != activations.end()) {
+			return it->second;
+		}
+		auto params = activation_quantization(ranges.at(name));
+		QuantizedTensor tensor {"", unique_name(name + "_scale"), unique_name(name + "_zero_point"), params.first};
+		add_initializer(graph, tensor.scale, pb::TensorProto_DataType_FLOAT, {}, &params.first, sizeof(float));
+		add_initializer(graph, tensor.zero_point, pb::TensorProto_DataType_UINT8, {}, &params.second, 1);
+		return activations.emplace(name, std::move(tensor)).first->second;
+	};
+	auto observed = [&](const std::string &name) {
+		auto range = ranges.find(name);
+		return range != ranges.end() && !range->second.empty();
+	};
+
+	std::unordered_map<int, const Candidate *> by_node;
+	for (auto &candidate : candidates_) {
+		by_node[candidate.node] = &candidate;
+	}
+	google::protobuf::RepeatedPtrField<pb::NodeProto> nodes;
+	for (int i = 0; i < graph.node_size(); i++) {
+		auto &node = graph.node(i);
+		auto found = by_node.find(i);
+		if (found == by_node.end() || !observed(node.input(0)) || !observed(node.output(0))) {
+			*nodes.Add() = node;
+			continue;
+		}
+		auto &candidate = *found->second;
+		auto &input = quantized_tensor(node.input(0));
+		if (input.value.empty()) {
+			// the input is quantized once for all its quantized readers, unless a quantized node produced it
+			input.value = unique_name(node.input(0) + "_quantized");
+			add_node(nodes, "QuantizeLinear", unique_name(input.value), {node.input(0), input.scale, input.zero_point},
+			         input.value);
+		}
+		auto &output = quantized_tensor(node.output(0));
+		output.value = unique_name(node.output(0) + "_quantized");
+
+		auto &weights = *candidate.weights;
+		auto weights_name = node.input(1);
+		std::vector<int64_t> dims(weights.shape().begin(), weights.shape().end());
+		std::vector<int8_t> values(weights.len());
+		std::vector<float> scales;
+		bool conv = node.op_type() == "Conv";
+		if (conv) {
+			// one scale per filter
+			auto filters = static_cast<size_t>(dims[0]);
+			auto len = weights.len() / filters;
+			scales = quantize_weights(weights.as_ptr<float>(), filters, len, len, 1, values.data());
+		} else {
+			// one scale per column
+			auto rows = static_cast<size_t>(dims[0]);
+			auto cols = static_cast<size_t>(dims[1]);
+			scales = quantize_weights(weights.as_ptr<float>(), cols, 1, rows, cols, values.data());
+		}
+		auto count = static_cast<int64_t>(scales.size());
+		std::vector<int8_t> zero_points(scales.size(), 0);
+		auto quantized_weights = unique_name(weights_name + "_quantized");
+		auto weights_scale = unique_name(weights_name + "_scale");
+		auto weights_zero_point = unique_name(weights_name + "_zero_point");
+		add_initializer(graph, quantized_weights, pb::TensorProto_DataType_INT8, dims, values.data(), values.size());
+		add_initializer(graph, weights_scale, pb::TensorProto_DataType_FLOAT, {count}, scales.data(),
+		                scales.size() * sizeof(float));
+		add_initializer(graph, weights_zero_point, pb::TensorProto_DataType_INT8, {count}, zero_points.data(),
+		                zero_points.size());
+
+		std::vector<std::string> inputs {input.value,       input.scale,  input.zero_point,
+		                                 quantized_weights, weights_scale, weights_zero_point,
+		                                 output.scale,      output.zero_point};
+		if (candidate.bias) {
+			// added to the products, at their scale
+			auto bias = candidate.bias->as_ptr<float>();
+			std::vector<int32_t> bias_values(scales.size());
+			for (size_t c = 0; c < scales.size(); c++) {
+				auto value = std::nearbyint(static_cast<double>(bias[c]) / (double(input.scale_value) * scales[c]));
+				value = std::min(std::max(value, double(std::numeric_limits<int32_t>::lowest())),
+				                 double(std::numeric_limits<int32_t>::max()));
+				bias_values[c] = static_cast<int32_t>(value);
+			}
+			auto bias_name = unique_name(node.input(2) + "_quantized");
+			add_initializer(graph, bias_name, pb::TensorProto_DataType_INT32, {count}, bias_values.data(),
+			                bias_values.size() * sizeof(int32_t));
+			inputs.push_back(bias_name);
+		}
+		auto &qnode = add_node(nodes, conv ? "QLinearConv" : "QLinearMatMul",
+		                       unique_name((node.name().empty() ? node.op_type() : node.name()) + "_quantized"),
+		                       inputs, output.value);
+		if (conv) {
+			*qnode.mutable_attribute() = node.attribute();
+		}
+		add_node(nodes, "DequantizeLinear", unique_name(node.output(0) + "_dequantize"),
+		         {output.value, output.scale, output.zero_point}, node.output(0));
+		quantized++;
+	}
+	graph.mutable_node()->Swap(&nodes);
+	if (quantized == 0) {
+		return proto_;
+	}
+	remove_unused(graph);
+
+	// the quantized operators need opset 10, which must not change the meaning of the other nodes
+	pb::OperatorSetIdProto *default_opset = nullptr;
+	for (auto &opset : *model.mutable_opset_import()) {
+		if (opset.domain().empty() || opset.domain() == "ai.onnx") {
+			default_opset = &opset;
+		}
+	}
+	if (!default_opset) {
+		default_opset = model.add_opset_import();
+		default_opset->set_version(QUANTIZATION_OPSET);
+	}
+	auto version = default_opset->version();
+	if (version < QUANTIZATION_OPSET) {
+		for (auto &node : graph.node()) {
+			if (!node.domain().empty() && node.domain() != "ai.onnx") {
+				continue;
+			}
+			auto before = framework_.op_register.find("", node.op_type(), version);
+			if (before && before != framework_.op_register.find("", node.op_type(), QUANTIZATION_OPSET)) {
+				throw std::runtime_error("Quantizing needs opset " + std::to_string(QUANTIZATION_OPSET) +
+				                         ", which changes the meaning of " + node.op_type() + " from opset " +
+				                         std::to_string(version));
+			}
+		}
+		default_opset->set_version(QUANTIZATION_OPSET);
+	}
+	model.set_ir_version(std::max<int64_t>(model.ir_version(), QUANTIZATION_IR_VERSION));
+	return model;
+}
+
+} // namespace duckdb_onnx
@@ -1,122 +1,909 @@
 #define DUCKDB_EXTENSION_MAIN
 
-#include <filesystem>
 #include "onnx_extension.hpp"
+#include "onnx_infer.hpp"
+#include "onnx_model_cache.hpp"
+#include "onnx_model_registry.hpp"
+#include "onnx_profile.hpp"
+#include "onnx_quantize.hpp"
+#include "onnx_task_runner.hpp"
+#include "onnx_types.hpp"
+#include "duckdb-onnx/core/kernels/reduce.hpp"
+#include "duckdb-onnx/core/optim.hpp"
+#include "duckdb-onnx/value.h"
 #include "duckdb.hpp"
 #include "duckdb/common/exception.hpp"
+#include "duckdb/common/map.hpp"
 #include "duckdb/common/string_util.hpp"
+#include "duckdb/common/unordered_map.hpp"
+#include "duckdb/execution/expression_executor.hpp"
+#include "duckdb/execution/expression_executor_state.hpp"
 #include "duckdb/function/scalar_function.hpp"
+#include "duckdb/main/config.hpp"
 #include "duckdb/main/extension_util.hpp"
+#include "duckdb/planner/expression/bound_function_expression.hpp"
 #include <duckdb/parser/parsed_data/create_scalar_function_info.hpp>
 
 namespace duckdb {
 
-struct Tensor {
-	std::vector<int64_t> shape;
-	std::vector<float> values;
+using duckdb_onnx::DatumType;
+using duckdb_onnx::ShapeVec;
+using duckdb_onnx::SimpleState;
+using duckdb_onnx::TValue;
+
+//! Rows of a chunk that share a model and the per-sample shapes of their input tensors
+struct OnnxBatch {
+	shared_ptr<OnnxModel> model;
+	//! For each input of the model, the index of the tensor argument feeding it
+	vector<idx_t> feeds;
+	//! The shape of each tensor argument
+	vector<vector<int64_t>> shapes;
+	vector<idx_t> rows;
+};
+
+//! Per-thread execution states of the models used by an onnx() call. Keeping them across chunks lets every batch
+//! reuse the tensor arena of the previous one.
+struct OnnxLocalState : public FunctionLocalState {
+	explicit OnnxLocalState(ClientContext &context)
+	    : runner(context, OnnxTaskRunner::GetMaxThreads(context)), profiling(OnnxProfileFunction::Enabled(context)) {
+	}
+
+	SimpleState &GetState(const shared_ptr<OnnxModel> &model) {
+		auto &entry = states[model.get()];
+		if (!entry.second) {
+			// hold on to the model so that an evicted model's address cannot be reused by another one
+			entry.first = model;
+			entry.second = make_uniq<SimpleState>(model->plan);
+			entry.second->session().runner = &runner;
+			if (profiling) {
+				entry.second->set_profile(model->profile);
+			}
+		}
+		return *entry.second;
+	}
+
+	//! The shapes of the outputs of one row when the rows of `batch` can run through its model as one batch, as the
+	//! facts of the model show, or nothing. Decided once per thread, model and shapes; `GetState` holds the model.
+	std::optional<vector<vector<int64_t>>> &GetBatchShapes(const OnnxBatch &batch) {
+		auto key = make_pair(batch.model.get(), batch.shapes);
+		auto entry = batch_shapes.find(key);
+		if (entry == batch_shapes.end()) {
+			vector<vector<int64_t>> input_shapes;
+			for (auto feed : batch.feeds) {
+				input_shapes.push_back(batch.shapes[feed]);
+			}
+			auto row_shapes = duckdb_onnx::batch_output_shapes(batch.model->plan->model(), input_shapes);
+			entry = batch_shapes.emplace(std::move(key), std::move(row_shapes)).first;
+		}
+		return entry->second;
+	}
+
+	//! Splits the large ops of this thread's inferences across the scheduler's threads
+	OnnxTaskRunner runner;
+	bool profiling;
+	unordered_map<OnnxModel *, pair<shared_ptr<OnnxModel>, unique_ptr<SimpleState>>> states;
+	map<pair<OnnxModel *, vector<vector<int64_t>>>, std::optional<vector<vector<int64_t>>>> batch_shapes;
+};
+
+static unique_ptr<FunctionLocalState> OnnxInitLocalState(ExpressionState &state, const BoundFunctionExpression &,
+                                                         FunctionData *) {
+	return make_uniq<OnnxLocalState>(state.GetContext());
+}
+
+//! The returned tensors live in the state's arena until its next run
+vector<TValue> run_onnx_model(const OnnxModel &model, SimpleState &state, vector<TValue> input_tensors) {
+	auto result = state.run(std::move(input_tensors));
+	if (result.is_err()) {
+		throw InvalidInputException("ONNX model %s: %s", model.path, result.error().what());
+	}
+	return result.value_move();
+}
+
+//! What a call returns for the values of the selected output: the tensor itself for onnx(), or their reduction
+//! for onnx_argmax(), onnx_topk() and onnx_softmax()
+enum class OnnxReduction : uint8_t { NONE = 0, ARGMAX = 1, TOP_K = 2, SOFTMAX = 3 };
+
+//! The inputs and outputs of an onnx() call, fixed when it is bound
+struct OnnxBindData : public FunctionData {
+	//! Names of the tensor arguments when they are keyed by ONNX input name, empty for a single tensor argument
+	vector<string> input_names;
+	//! Type of the elements of each tensor argument, converted to the model's input type when it differs
+	vector<DatumType> input_types;
+	//! Names of the selected outputs, empty for the model's first output
+	vector<string> output_names;
+	//! Whether the result is a STRUCT of tensors keyed by output name rather than a single tensor
+	bool named_outputs = false;
+	//! Type of the elements of each returned tensor, which the model outputs are converted to
+	vector<DatumType> output_types;
+	//! Number of values of each returned tensor when the model and input shapes fix it, in which case its values are
+	//! a fixed-size array; 0 for a list
+	vector<idx_t> output_sizes;
+	//! The model of a constant model argument, resolved and restricted to the returned outputs when the call is
+	//! bound; null when the model is looked up per row
+	shared_ptr<OnnxModel> model;
+	//! For `model`, the index of the tensor argument feeding each of its inputs
+	vector<idx_t> feeds;
+	//! The reduction applied to the values of the output, which are then read as FLOAT
+	OnnxReduction reduction = OnnxReduction::NONE;
+	//! Number of scores returned by onnx_topk()
+	idx_t k = 0;
+
+	unique_ptr<FunctionData> Copy() const override {
+		return make_uniq<OnnxBindData>(*this);
+	}
+	bool Equals(const FunctionData &other_p) const override {
+		auto &other = other_p.Cast<OnnxBindData>();
+		return input_names == other.input_names && input_types == other.input_types &&
+		       output_names == other.output_names && named_outputs == other.named_outputs &&
+		       output_types == other.output_types && output_sizes == other.output_sizes && model == other.model &&
+		       reduction == other.reduction && k == other.k;
+	}
 };
 
-void run_onnx_model_and_extract_results(const string &path, vector<Tensor> input_tensors, Value &struct_val_list) {
-	// check path exist
-	if (!std::filesystem::exists(path)) {
-		throw std::runtime_error(std::string("ONNX model file not found: ") + path);
+//! `tensor`, a STRUCT vector whose children are read row by row: flattened when it is a dictionary, as happens after
+//! filters and joins, since the children of a dictionary STRUCT are those of its dictionary
+static Vector &FlattenStruct(Vector &tensor, idx_t count) {
+	if (tensor.GetVectorType() == VectorType::DICTIONARY_VECTOR) {
+		tensor.Flatten(count);
+	}
+	return tensor;
+}
+
+//! Reads the tensors of a STRUCT(shape INTEGER[], value T[]) argument. The values are borrowed by the input tensors.
+class OnnxTensorArgument {
+public:
+	OnnxTensorArgument(Vector &tensor, idx_t count)
+	    : values(*StructVector::GetEntries(FlattenStruct(tensor, count))[1], count) {
+		tensor.ToUnifiedFormat(count, format);
+		auto &shape_vector = *StructVector::GetEntries(tensor)[0];
+		shape_vector.ToUnifiedFormat(count, shape_format);
+		shape_lists = UnifiedVectorFormat::GetData<list_entry_t>(shape_format);
+		shape_data = FlatVector::GetData<int32_t>(ListVector::GetEntry(shape_vector));
+	}
+
+	//! Whether the row holds a tensor
+	bool RowIsValid(idx_t row) const {
+		return format.validity.RowIsValid(format.sel->get_index(row)) &&
+		       shape_format.validity.RowIsValid(shape_format.sel->get_index(row)) && values.RowIsValid(row);
+	}
+	//! The shape of the row's tensor, after checking that its values match it
+	vector<int64_t> GetShape(idx_t row) const {
+		auto list = shape_lists[shape_format.sel->get_index(row)];
+		vector<int64_t> shape;
+		idx_t element_count = 1;
+		for (idx_t child_idx = list.offset; child_idx < list.offset + list.length; child_idx++) {
+			shape.push_back(shape_data[child_idx]);
+			element_count *= NumericCast<idx_t>(MaxValue<int64_t>(shape_data[child_idx], 0));
+		}
+		auto entry = values.GetEntry(row);
+		if (entry.length != element_count) {
+			throw InvalidInputException("onnx: tensor has %d values but its shape requires %d", entry.length,
+			                            element_count);
+		}
+		values.CheckValid(entry, "onnx");
+		return shape;
+	}
+
+	OnnxTensorReader values;
+
+private:
+	UnifiedVectorFormat format;
+	UnifiedVectorFormat shape_format;
+	const list_entry_t *shape_lists;
+	const int32_t *shape_data;
+};
+
+//! Writes tensors straight into the child storage of the result: a STRUCT(shape INTEGER[], value T[] or T[n]) vector,
+//! or a STRUCT of them keyed by output name
+class OnnxResultWriter {
+public:
+	OnnxResultWriter(Vector &result, bool named_outputs) : result(result) {
+		if (named_outputs) {
+			for (auto &child : StructVector::GetEntries(result)) {
+				tensors.emplace_back(*child);
+			}
+		} else {
+			tensors.emplace_back(result);
+		}
+	}
+
+	//! Append `count` elements of `values`, which has the element type of result tensor `tensor`, starting at
+	//! element `first`
+	void Append(idx_t tensor, idx_t row, const ShapeVec &shape, const duckdb_onnx::Tensor &values, idx_t first,
+	            idx_t count) {
+		auto &shape_vector = tensors[tensor].shape_vector;
+		auto shape_offset = ListVector::GetListSize(shape_vector);
+		ListVector::Reserve(shape_vector, shape_offset + shape.size());
+		auto shape_data = FlatVector::GetData<int32_t>(ListVector::GetEntry(shape_vector));
+		for (idx_t i = 0; i < shape.size(); i++) {
+			shape_data[shape_offset + i] = NumericCast<int32_t>(shape[i]);
+		}
+		FlatVector::GetData<list_entry_t>(shape_vector)[row] = list_entry_t(shape_offset, shape.size());
+		ListVector::SetListSize(shape_vector, shape_offset + shape.size());
+
+		auto &value_vector = tensors[tensor].value_vector;
+		auto element_size = tensors[tensor].element_size;
+		auto source = static_cast<const_data_ptr_t>(values.raw_data()) + first * element_size;
+		auto array_size = tensors[tensor].array_size;
+		if (array_size) {
+			if (count != array_size) {
+				throw InvalidInputException("onnx: the model returned %llu values for a tensor bound to %llu", count,
+				                            array_size);
+			}
+			auto value_data = FlatVector::GetData(ArrayVector::GetEntry(value_vector));
+			memcpy(value_data + row * array_size * element_size, source, count * element_size);
+			return;
+		}
+		auto value_offset = ListVector::GetListSize(value_vector);
+		ListVector::Reserve(value_vector, value_offset + count);
+		auto value_data = FlatVector::GetData(ListVector::GetEntry(value_vector));
+		memcpy(value_data + value_offset * element_size, source, count * element_size);
+		FlatVector::GetData<list_entry_t>(value_vector)[row] = list_entry_t(value_offset, count);
+		ListVector::SetListSize(value_vector, value_offset + count);
+	}
+
+	void SetNull(idx_t row) {
+		for (auto &tensor : tensors) {
+			FlatVector::GetData<list_entry_t>(tensor.shape_vector)[row] = list_entry_t(0, 0);
+			if (!tensor.array_size) {
+				FlatVector::GetData<list_entry_t>(tensor.value_vector)[row] = list_entry_t(0, 0);
+			}
+			FlatVector::SetNull(tensor.vector, row, true);
+		}
+		FlatVector::SetNull(result, row, true);
+	}
+
+	idx_t TensorCount() const {
+		return tensors.size();
+	}
+
+private:
+	struct TensorVectors {
+		explicit TensorVectors(Vector &vector)
+		    : vector(vector), shape_vector(*StructVector::GetEntries(vector)[0]),
+		      value_vector(*StructVector::GetEntries(vector)[1]) {
+			auto &value_type = value_vector.GetType();
+			if (value_type.id() == LogicalTypeId::ARRAY) {
+				array_size = ArrayType::GetSize(value_type);
+				element_size = GetTypeIdSize(ArrayType::GetChildType(value_type).InternalType());
+			} else {
+				element_size = GetTypeIdSize(ListType::GetChildType(value_type).InternalType());
+			}
+		}
+
+		Vector &vector;
+		Vector &shape_vector;
+		Vector &value_vector;
+		idx_t element_size;
+		//! Number of values of a fixed-size array of values, 0 for a list
+		idx_t array_size = 0;
 	};
 
-	/// now only support 1 input tensor
-	Tensor duckdb_input_tensor = input_tensors[0];
+	Vector &result;
+	vector<TensorVectors> tensors;
+};
+
+//! Writes the reduction of the values of each row's tensor instead of the tensor: the index of the largest value as
+//! an INTEGER, the k largest values as a LIST of STRUCT(idx INTEGER, score FLOAT), or the softmax of the values as
+//! FLOAT[] or FLOAT[n]. Indexes count from 0 in the values of the tensor.
+class OnnxReductionWriter {
+public:
+	OnnxReductionWriter(Vector &result, const OnnxBindData &bind)
+	    : result(result), reduction(bind.reduction), k(bind.k) {
+	}
+
+	//! Append the reduction of `count` FLOAT values of `values`, starting at element `first`
+	void Append(idx_t tensor, idx_t row, const ShapeVec &shape, const duckdb_onnx::Tensor &values, idx_t first,
+	            idx_t count) {
+		auto scores = static_cast<const float *>(values.raw_data()) + first;
+		switch (reduction) {
+		case OnnxReduction::ARGMAX:
+			if (count == 0) {
+				FlatVector::SetNull(result, row, true);
+				return;
+			}
+			FlatVector::GetData<int32_t>(result)[row] = NumericCast<int32_t>(duckdb_onnx::argmax_f32(count, scores));
+			return;
+		case OnnxReduction::TOP_K: {
+			auto indexes = duckdb_onnx::top_k_f32(count, scores, k);
+			auto offset = ListVector::GetListSize(result);
+			ListVector::Reserve(result, offset + indexes.size());
+			auto &entries = StructVector::GetEntries(ListVector::GetEntry(result));
+			auto index_data = FlatVector::GetData<int32_t>(*entries[0]);
+			auto score_data = FlatVector::GetData<float>(*entries[1]);
+			for (idx_t i = 0; i < indexes.size(); i++) {
+				index_data[offset + i] = NumericCast<int32_t>(indexes[i]);
+				score_data[offset + i] = scores[indexes[i]];
+			}
+			FlatVector::GetData<list_entry_t>(result)[row] = list_entry_t(offset, indexes.size());
+			ListVector::SetListSize(result, offset + indexes.size());
+			return;
+		}
+		case OnnxReduction::SOFTMAX: {
+			if (result.GetType().id() == LogicalTypeId::ARRAY) {
+				auto array_size = ArrayType::GetSize(result.GetType());
+				if (count != array_size) {
+					throw InvalidInputException("onnx: the model returned %llu values for a tensor bound to %llu",
+					                            count, array_size);
+				}
+				duckdb_onnx::softmax_f32(count, scores,
+				                         FlatVector::GetData<float>(ArrayVector::GetEntry(result)) + row * count);
+				return;
+			}
+			auto offset = ListVector::GetListSize(result);
+			ListVector::Reserve(result, offset + count);
+			duckdb_onnx::softmax_f32(count, scores, FlatVector::GetData<float>(ListVector::GetEntry(result)) + offset);
+			FlatVector::GetData<list_entry_t>(result)[row] = list_entry_t(offset, count);
+			ListVector::SetListSize(result, offset + count);
+			return;
+		}
+		default:
+			throw InternalException("onnx: unexpected reduction");
+		}
+	}
+
+	void SetNull(idx_t row) {
+		if (result.GetType().id() == LogicalTypeId::LIST) {
+			FlatVector::GetData<list_entry_t>(result)[row] = list_entry_t(0, 0);
+		}
+		FlatVector::SetNull(result, row, true);
+	}
+
+	idx_t TensorCount() const {
+		return 1;
+	}
+
+private:
+	Vector &result;
+	OnnxReduction reduction;
+	idx_t k;
+};
+
+//! The tensors of `rows`, all of shape `shape` with a leading dimension of 1, concatenated along it as one tensor
+static duckdb_onnx::Tensor BatchTensors(const vector<int64_t> &shape, const vector<idx_t> &rows,
+                                        const OnnxTensorReader &values) {
+	ShapeVec batch_shape;
+	batch_shape.push_back(NumericCast<int64_t>(rows.size()));
+	batch_shape.insert(batch_shape.end(), shape.begin() + 1, shape.end());
+	return values.BatchTensor(rows, std::move(batch_shape));
 }
 
-inline void OnnxScalarFun(DataChunk &args, ExpressionState &state, Vector &result) {
-	auto count = args.size();
+//! Run all rows of a batch through the model in a single execution, concatenated along their leading dimension of 1.
+//! `row_shapes` are the shapes of the outputs of one row, which the facts of the model derived for such a batch.
+//! Returns false when the outputs do not have these shapes past the batch dimension, in which case the rows have to
+//! be evaluated one by one.
+template <class WRITER>
+static bool RunBatched(OnnxBatch &batch, SimpleState &state, const vector<unique_ptr<OnnxTensorArgument>> &tensors,
+                       const vector<DatumType> &output_types, const vector<vector<int64_t>> &row_shapes,
+                       WRITER &writer) {
+	auto batch_size = batch.rows.size();
+	vector<TValue> inputs;
+	for (idx_t i = 0; i < batch.feeds.size(); i++) {
+		auto input = BatchTensors(batch.shapes[batch.feeds[i]], batch.rows, tensors[batch.feeds[i]]->values);
+		inputs.push_back(TValue::Var(OnnxConvertTensor(input, batch.model->InputType(i))));
+	}
 
-	auto &str_vector = args.data[0];
-	const auto path = str_vector.GetValue(0).ToString();
+	auto outputs = run_onnx_model(*batch.model, state, std::move(inputs));
+	if (outputs.empty()) {
+		for (auto row : batch.rows) {
+			writer.SetNull(row);
+		}
+		return true;
+	}
+	if (!duckdb_onnx::batch_outputs_match(outputs, batch_size, row_shapes)) {
+		return false;
+	}
+	for (idx_t t = 0; t < writer.TensorCount(); t++) {
+		auto output = OnnxConvertTensor(*outputs[t], output_types[t]);
+		ShapeVec row_shape(row_shapes[t].begin(), row_shapes[t].end());
+		auto row_size = output.len() / batch_size;
+		for (idx_t i = 0; i < batch_size; i++) {
+			writer.Append(t, batch.rows[i], row_shape, output, i * row_size, row_size);
+		}
+	}
+	return true;
+}
+
+template <class WRITER>
+static void RunSingle(const OnnxBatch &batch, SimpleState &state, const vector<unique_ptr<OnnxTensorArgument>> &tensors,
+                      const vector<DatumType> &output_types, idx_t row, WRITER &writer) {
+	vector<TValue> inputs;
+	for (idx_t i = 0; i < batch.feeds.size(); i++) {
+		auto &values = tensors[batch.feeds[i]]->values;
+		auto input = duckdb_onnx::Tensor::borrowed(values.datum_type, batch.shapes[batch.feeds[i]],
+		                                           values.GetData(values.GetEntry(row).offset));
+		inputs.push_back(TValue::Var(OnnxConvertTensor(input, batch.model->InputType(i))));
+	}
+	auto outputs = run_onnx_model(*batch.model, state, std::move(inputs));
+	if (outputs.empty()) {
+		writer.SetNull(row);
+		return;
+	}
+	for (idx_t t = 0; t < writer.TensorCount(); t++) {
+		auto output = OnnxConvertTensor(*outputs[t], output_types[t]);
+		writer.Append(t, row, output.shape(), output, 0, output.len());
+	}
+}
 
-	auto &struct_vector = args.data[1]; // { shape: int[], value: float[]}
+//! The model registered as or stored at `path`, restricted to the outputs an onnx() call returns, and in `feeds` the
+//! index of the tensor argument feeding each of its inputs
+static shared_ptr<OnnxModel> GetCallModel(ClientContext &context, const string &path, const OnnxBindData &bind,
+                                          vector<idx_t> &feeds) {
+	auto model = OnnxGetModel(context, path);
+	auto &graph = model->plan->model();
+	feeds.clear();
+	if (bind.input_names.empty()) {
+		if (graph.inputs.size() != 1) {
+			throw InvalidInputException("onnx: model %s has %llu inputs, pass a STRUCT of tensors keyed by input name",
+			                            model->path, graph.inputs.size());
+		}
+		feeds.push_back(0);
+	} else {
+		feeds.resize(graph.inputs.size(), DConstants::INVALID_INDEX);
+		for (idx_t i = 0; i < bind.input_names.size(); i++) {
+			auto index = model->InputIndex(bind.input_names[i]);
+			if (index == DConstants::INVALID_INDEX) {
+				throw InvalidInputException("onnx: model %s has no input named \"%s\"", model->path,
+				                            bind.input_names[i]);
+			}
+			feeds[index] = i;
+		}
+		for (idx_t i = 0; i < feeds.size(); i++) {
+			if (feeds[i] == DConstants::INVALID_INDEX) {
+				throw InvalidInputException("onnx: no tensor given for input \"%s\" of model %s", model->InputName(i),
+				                            model->path);
+			}
+		}
+	}
+	// only the returned outputs are computed
+	if (!bind.output_names.empty()) {
+		return model->WithOutputs(bind.output_names);
+	}
+	if (graph.outputs.size() > 1) {
+		return model->WithOutputs({model->OutputName(0)});
+	}
+	return model;
+}
 
-	auto &struct_child = StructVector::GetEntries(struct_vector);
+//! Runs the rows of `args` through their model and hands the returned tensors to `writer`
+template <class WRITER>
+static void OnnxExecute(DataChunk &args, ExpressionState &state, const OnnxBindData &bind, WRITER &writer) {
+	auto count = args.size();
 
-	UnifiedVectorFormat lhs_data;
-	UnifiedVectorFormat rhs_data;
-	// shape
-	Vector &shape_list_vec_ref = *struct_child[0];
-	shape_list_vec_ref.ToUnifiedFormat(count, lhs_data);
+	auto &str_vector = args.data[0];
+	UnifiedVectorFormat path_data;
+	str_vector.ToUnifiedFormat(count, path_data);
+	auto paths = UnifiedVectorFormat::GetData<string_t>(path_data);
 
-	auto *shape_list_data = reinterpret_cast<list_entry_t *>(FlatVector::GetData(shape_list_vec_ref));
-	Vector &shape_list_child_vec = ListVector::GetEntry(shape_list_vec_ref);
-	auto *shape_child_data = reinterpret_cast<int32_t *>(duckdb::FlatVector::GetData(shape_list_child_vec));
+	// a constant model was resolved when the call was bound, others once per distinct path instead of once per row
+	auto model = bind.model;
+	auto feeds = bind.feeds;
+	string_t model_path;
 
-	// value
-	Vector &value_list_vec_ref = *struct_child[1];
-	value_list_vec_ref.ToUnifiedFormat(count, rhs_data);
-	auto *value_list_data = reinterpret_cast<list_entry_t *>(FlatVector::GetData(value_list_vec_ref));
-	Vector &value_list_child_vec = ListVector::GetEntry(value_list_vec_ref);
+	// the tensor argument { shape: int[], value: T[] or T[n] }, or a STRUCT of them keyed by input name
+	auto &tensor_vector = FlattenStruct(args.data[1], count);
+	UnifiedVectorFormat tensor_data;
+	tensor_vector.ToUnifiedFormat(count, tensor_data);
+	vector<unique_ptr<OnnxTensorArgument>> tensors;
+	if (bind.input_names.empty()) {
+		tensors.push_back(make_uniq<OnnxTensorArgument>(tensor_vector, count));
+	} else {
+		for (auto &child : StructVector::GetEntries(tensor_vector)) {
+			tensors.push_back(make_uniq<OnnxTensorArgument>(*child, count));
+		}
+	}
 
-	// run
+	// group the rows by model and per-sample shapes so that each group runs through the model once
+	vector<OnnxBatch> batches;
+	map<pair<OnnxModel *, vector<vector<int64_t>>>, idx_t> batch_index;
 	for (idx_t row = 0; row < count; row++) {
-		auto lhs_list_index = lhs_data.sel->get_index(row);
-		auto rhs_list_index = rhs_data.sel->get_index(row);
-
-		if (!lhs_data.validity.RowIsValid(lhs_list_index) || !rhs_data.validity.RowIsValid(rhs_list_index)) {
-			FlatVector::SetNull(result, row, true);
+		auto path_index = path_data.sel->get_index(row);
+		bool valid = path_data.validity.RowIsValid(path_index) &&
+		             tensor_data.validity.RowIsValid(tensor_data.sel->get_index(row));
+		for (idx_t i = 0; i < tensors.size() && valid; i++) {
+			valid = tensors[i]->RowIsValid(row);
+		}
+		if (!valid) {
+			writer.SetNull(row);
 			continue;
 		}
+		if (!bind.model && (!model || paths[path_index] != model_path)) {
+			model = GetCallModel(state.GetContext(), paths[path_index].GetString(), bind, feeds);
+			model_path = paths[path_index];
+		}
 
-		vector<int64_t> shape_std_vec = std::vector<int64_t>();
-		list_entry_t list = shape_list_data[lhs_list_index];
-		for (idx_t child_idx = list.offset; child_idx < list.offset + list.length; child_idx++) {
-			shape_std_vec.push_back(shape_child_data[child_idx]);
+		vector<vector<int64_t>> shapes;
+		for (auto &tensor : tensors) {
+			shapes.push_back(tensor->GetShape(row));
 		}
 
-		vector<float> value_std_vec = std::vector<float>();
-		list = value_list_data[rhs_list_index];
-		for (idx_t child_idx = list.offset; child_idx < list.offset + list.length; child_idx++) {
-			value_std_vec.push_back(value_list_child_vec.GetValue(child_idx).GetValue<float>());
+		auto key = make_pair(model.get(), shapes);
+		auto batch_entry = batch_index.find(key);
+		if (batch_entry == batch_index.end()) {
+			batch_entry = batch_index.emplace(std::move(key), batches.size()).first;
+			batches.push_back(OnnxBatch {model, feeds, std::move(shapes), {}});
 		}
+		batches[batch_entry->second].rows.push_back(row);
+	}
 
-		vector<Tensor> onnx_inputs;
-		onnx_inputs.emplace_back(Tensor {shape_std_vec, value_std_vec});
+	auto &local_state = ExecuteFunctionState::GetFunctionState(state)->Cast<OnnxLocalState>();
+	for (auto &batch : batches) {
+		auto &model_state = local_state.GetState(batch.model);
+		if (batch.rows.size() > 1) {
+			auto &row_shapes = local_state.GetBatchShapes(batch);
+			if (row_shapes) {
+				if (RunBatched(batch, model_state, tensors, bind.output_types, *row_shapes, writer)) {
+					continue;
+				}
+				// the outputs of the batch contradict the facts of the model: run these shapes row by row from now on
+				row_shapes.reset();
+			}
+		}
+		for (auto row : batch.rows) {
+			RunSingle(batch, model_state, tensors, bind.output_types, row, writer);
+		}
+	}
+}
+
+inline void OnnxScalarFun(DataChunk &args, ExpressionState &state, Vector &result) {
+	auto &bind = state.expr.Cast<BoundFunctionExpression>().bind_info->Cast<OnnxBindData>();
+	if (bind.reduction == OnnxReduction::NONE) {
+		OnnxResultWriter writer(result, bind.named_outputs);
+		OnnxExecute(args, state, bind, writer);
+	} else {
+		OnnxReductionWriter writer(result, bind);
+		OnnxExecute(args, state, bind, writer);
+	}
+}
 
-		Value struct_val_list;
-		try {
-			run_onnx_model_and_extract_results(path, onnx_inputs, struct_val_list);
-		} catch (...) {
-			throw std::runtime_error("Unknown error occurred.");
+static LogicalType OnnxTensorType(const LogicalType &value_type) {
+	child_list_t<LogicalType> children;
+	children.push_back(make_pair("shape", LogicalType::LIST(LogicalType::INTEGER)));
+	children.push_back(make_pair("value", value_type));
+	return LogicalType::STRUCT(std::move(children));
+}
+
+//! The type the values of a tensor argument of type `tensor_type` are read as, and in `input_type` its element type
+static LogicalType OnnxValueType(const LogicalType &tensor_type, DatumType &input_type) {
+	// values whose type has an ONNX counterpart are read in place, from a list or a fixed-size array; other numbers,
+	// such as DECIMAL literals, are read as FLOAT
+	input_type = DatumType::F32;
+	auto &children = StructType::GetChildTypes(tensor_type);
+	if (children.size() == 2) {
+		auto &given = children[1].second;
+		if (given.id() == LogicalTypeId::LIST || given.id() == LogicalTypeId::ARRAY) {
+			bool is_array = given.id() == LogicalTypeId::ARRAY;
+			auto &element_type = is_array ? ArrayType::GetChildType(given) : ListType::GetChildType(given);
+			if (!OnnxDatumType(element_type, input_type)) {
+				input_type = DatumType::F32;
+			}
+			auto read_type = OnnxElementType(input_type);
+			return is_array ? LogicalType::ARRAY(read_type, ArrayType::GetSize(given)) : LogicalType::LIST(read_type);
 		}
+	}
+	return LogicalType::LIST(LogicalType::FLOAT);
+}
 
-		result.SetValue(row, struct_val_list);
-		result.SetVectorType(VectorType::CONSTANT_VECTOR);
+//! Appends to `shapes` the shape held by `shape`, the shape field of a tensor; false when it is NULL or not a list
+static bool OnnxShapeValue(const Value &shape, vector<vector<int64_t>> &shapes) {
+	if (shape.IsNull() || shape.type().id() != LogicalTypeId::LIST) {
+		return false;
+	}
+	shapes.emplace_back();
+	for (auto &dim : ListValue::GetChildren(shape)) {
+		if (dim.IsNull() || dim.GetValue<int64_t>() < 0) {
+			return false;
+		}
+		shapes.back().push_back(dim.GetValue<int64_t>());
 	}
+	return true;
 }
 
-unique_ptr<FunctionData> OnnxBindFunction(ClientContext &, ScalarFunction &bound_function,
-                                          vector<unique_ptr<Expression>> &arguments) {
-	switch (arguments[1]->return_type.id()) {
+//! Appends to `shapes` the shapes of the tensors of argument `argument` when they are the same in every row: those of
+//! a constant, or the constant shape fields of STRUCTs built in the query such as {'shape': [1, 3], 'value': x}
+static bool OnnxConstantShapes(ClientContext &context, Expression &argument, bool named_inputs,
+                               vector<vector<int64_t>> &shapes) {
+	if (argument.IsFoldable()) {
+		auto value = ExpressionExecutor::EvaluateScalar(context, argument);
+		if (value.IsNull()) {
+			return false;
+		}
+		if (!named_inputs) {
+			return OnnxShapeValue(StructValue::GetChildren(value)[0], shapes);
+		}
+		for (auto &tensor : StructValue::GetChildren(value)) {
+			if (tensor.IsNull() || !OnnxShapeValue(StructValue::GetChildren(tensor)[0], shapes)) {
+				return false;
+			}
+		}
+		return true;
+	}
+	if (argument.GetExpressionClass() != ExpressionClass::BOUND_FUNCTION) {
+		return false;
+	}
+	auto &pack = argument.Cast<BoundFunctionExpression>();
+	if (pack.function.name != "struct_pack" || pack.children.empty()) {
+		return false;
+	}
+	if (named_inputs) {
+		for (auto &tensor : pack.children) {
+			if (!OnnxConstantShapes(context, *tensor, false, shapes)) {
+				return false;
+			}
+		}
+		return true;
+	}
+	return pack.children[0]->IsFoldable() &&
+	       OnnxShapeValue(ExpressionExecutor::EvaluateScalar(context, *pack.children[0]), shapes);
+}
+
+//! Checks that the bound model accepts tensors of the shapes `shapes`, one per tensor argument, and fixes the number
+//! of values of the outputs whose shape follows from them
+static void OnnxBindOutputSizes(OnnxBindData &bind, const vector<vector<int64_t>> &shapes) {
+	auto &model = *bind.model;
+	std::vector<duckdb_onnx::TypedFact> inputs;
+	for (idx_t i = 0; i < bind.feeds.size(); i++) {
+		auto &shape = shapes[bind.feeds[i]];
+		inputs.emplace_back(model.InputType(i), std::vector<duckdb_onnx::TDim>(shape.begin(), shape.end()));
+	}
+	std::vector<duckdb_onnx::TypedFact> outputs;
+	try {
+		outputs = duckdb_onnx::infer_output_facts(model.plan->model(), inputs);
+	} catch (std::exception &ex) {
+		throw BinderException("onnx: model %s does not accept tensors of these shapes: %s", model.path, ex.what());
+	}
+	for (idx_t i = 0; i < bind.output_sizes.size() && i < outputs.size(); i++) {
+		if (!outputs[i].shape_is_concrete()) {
+			continue;
+		}
+		idx_t size = 1;
+		for (auto &dim : outputs[i].shape) {
+			size *= NumericCast<idx_t>(dim.as_int());
+		}
+		if (size > 0 && size <= ArrayType::MAX_ARRAY_SIZE) {
+			bind.output_sizes[i] = size;
+		}
+	}
+}
+
+//! The type of a returned tensor of elements `element_type`, whose values are an array of `size` values, or a list
+//! when `size` is 0
+static LogicalType OnnxResultType(const LogicalType &element_type, idx_t size) {
+	return OnnxTensorType(size ? LogicalType::ARRAY(element_type, size) : LogicalType::LIST(element_type));
+}
+
+//! Binds the model and tensor arguments shared by onnx() and its variants, and the output names when argument
+//! `outputs_index` is given. The bound types of the arguments in between are their own.
+static unique_ptr<OnnxBindData> OnnxBindCall(ClientContext &context, ScalarFunction &bound_function,
+                                             vector<unique_ptr<Expression>> &arguments, idx_t outputs_index) {
+	auto &tensor_type = arguments[1]->return_type;
+	switch (tensor_type.id()) {
 	case LogicalTypeId::UNKNOWN:
 		throw ParameterNotResolvedException();
-	case LogicalTypeId::LIST:
+	case LogicalTypeId::STRUCT:
+		break;
+	default:
+		throw NotImplementedException("%s(string, struct) requires a STRUCT(shape INTEGER[], value T[]), or a STRUCT "
+		                              "of them keyed by input name, as parameter",
+		                              bound_function.name);
+	}
+	auto result = make_uniq<OnnxBindData>();
+	// a STRUCT whose fields are all STRUCTs holds one tensor per model input, keyed by input name
+	auto &children = StructType::GetChildTypes(tensor_type);
+	bool named_inputs = !children.empty();
+	for (auto &child : children) {
+		named_inputs = named_inputs && child.second.id() == LogicalTypeId::STRUCT;
+	}
+	LogicalType bound_tensor_type;
+	// the type of the values of each tensor argument
+	vector<LogicalType> value_types;
+	if (named_inputs) {
+		child_list_t<LogicalType> bound_children;
+		for (auto &child : children) {
+			DatumType input_type;
+			value_types.push_back(OnnxValueType(child.second, input_type));
+			result->input_names.push_back(child.first);
+			result->input_types.push_back(input_type);
+			bound_children.push_back(make_pair(child.first, OnnxTensorType(value_types.back())));
+		}
+		bound_tensor_type = LogicalType::STRUCT(std::move(bound_children));
+	} else {
+		DatumType input_type;
+		value_types.push_back(OnnxValueType(tensor_type, input_type));
+		bound_tensor_type = OnnxTensorType(value_types.back());
+		result->input_types.push_back(input_type);
+	}
+
+	// the outputs to return: a name for a single tensor, a list of names for a STRUCT of tensors keyed by name
+	LogicalType outputs_type;
+	if (arguments.size() > outputs_index) {
+		auto &outputs_argument = *arguments[outputs_index];
+		if (outputs_argument.return_type.id() == LogicalTypeId::UNKNOWN) {
+			throw ParameterNotResolvedException();
+		}
+		if (!outputs_argument.IsFoldable()) {
+			throw BinderException("onnx: the output names must be constant");
+		}
+		auto outputs = ExpressionExecutor::EvaluateScalar(context, outputs_argument);
+		if (outputs.IsNull()) {
+			throw BinderException("onnx: the output names must not be NULL");
+		}
+		if (outputs.type().id() == LogicalTypeId::LIST) {
+			result->named_outputs = true;
+			for (auto &name : ListValue::GetChildren(outputs)) {
+				if (name.IsNull()) {
+					throw BinderException("onnx: the output names must not be NULL");
+				}
+				auto output_name = name.ToString();
+				for (auto &selected : result->output_names) {
+					if (StringUtil::CIEquals(selected, output_name)) {
+						throw BinderException("onnx: output \"%s\" is selected twice", output_name);
+					}
+				}
+				result->output_names.push_back(std::move(output_name));
+			}
+			if (result->output_names.empty()) {
+				throw BinderException("onnx: the list of output names is empty");
+			}
+			outputs_type = LogicalType::LIST(LogicalType::VARCHAR);
+		} else {
+			result->output_names.push_back(outputs.ToString());
+			outputs_type = LogicalType::VARCHAR;
+		}
+	}
+
+	// a constant model is resolved here, once per query: the result has the element types of its outputs and, when
+	// the input shapes are constant too, they are checked against the model and fix the number of returned values
+	idx_t output_count = result->named_outputs ? result->output_names.size() : 1;
+	result->output_types.assign(output_count, DatumType::F32);
+	result->output_sizes.assign(output_count, 0);
+	if (arguments[0]->IsFoldable()) {
+		auto path = ExpressionExecutor::EvaluateScalar(context, *arguments[0]);
+		if (!path.IsNull()) {
+			result->model = GetCallModel(context, path.ToString(), *result, result->feeds);
+			for (idx_t i = 0; i < output_count; i++) {
+				OnnxDatumType(OnnxElementType(result->model->OutputType(i)), result->output_types[i]);
+			}
+			vector<vector<int64_t>> shapes;
+			if (OnnxConstantShapes(context, *arguments[1], named_inputs, shapes)) {
+				for (idx_t i = 0; i < value_types.size(); i++) {
+					idx_t element_count = 1;
+					for (auto dim : shapes[i]) {
+						element_count *= NumericCast<idx_t>(dim);
+					}
+					if (value_types[i].id() == LogicalTypeId::ARRAY &&
+					    ArrayType::GetSize(value_types[i]) != element_count) {
+						throw BinderException("onnx: tensor has %llu values but its shape requires %llu",
+						                      ArrayType::GetSize(value_types[i]), element_count);
+					}
+				}
+				OnnxBindOutputSizes(*result, shapes);
+			}
+		}
+	}
+	bound_function.arguments = {LogicalType::VARCHAR, bound_tensor_type};
+	for (idx_t i = 2; i < arguments.size(); i++) {
+		bound_function.arguments.push_back(i == outputs_index ? outputs_type : arguments[i]->return_type);
+	}
+	return result;
+}
+
+unique_ptr<FunctionData> OnnxBindFunction(ClientContext &context, ScalarFunction &bound_function,
+                                          vector<unique_ptr<Expression>> &arguments) {
+	if (arguments.size() != 2 && arguments.size() != 3) {
+		throw BinderException("onnx(model, tensor[, outputs]) expects two or three arguments");
+	}
+	auto result = OnnxBindCall(context, bound_function, arguments, 2);
+	auto output_count = result->output_types.size();
+	if (result->named_outputs) {
+		child_list_t<LogicalType> tensors;
+		for (idx_t i = 0; i < output_count; i++) {
+			auto element_type = OnnxElementType(result->output_types[i]);
+			auto tensor_type = OnnxResultType(element_type, result->output_sizes[i]);
+			tensors.push_back(make_pair(result->output_names[i], std::move(tensor_type)));
+		}
+		bound_function.return_type = LogicalType::STRUCT(std::move(tensors));
+	} else {
+		bound_function.return_type = OnnxResultType(OnnxElementType(result->output_types[0]), result->output_sizes[0]);
+	}
+	return std::move(result);
+}
+
+//! onnx_argmax(model, tensor[, output]), onnx_topk(model, tensor, k[, output]) and onnx_softmax(model, tensor[,
+//! output]): the reduction of the values of one output of the model, read as FLOAT
+template <OnnxReduction REDUCTION>
+static unique_ptr<FunctionData> OnnxReductionBind(ClientContext &context, ScalarFunction &bound_function,
+                                                  vector<unique_ptr<Expression>> &arguments) {
+	auto &name = bound_function.name;
+	idx_t outputs_index = REDUCTION == OnnxReduction::TOP_K ? 3 : 2;
+	if (arguments.size() != outputs_index && arguments.size() != outputs_index + 1) {
+		throw BinderException("%s(model, tensor%s[, output]) expects %llu or %llu arguments", name,
+		                      REDUCTION == OnnxReduction::TOP_K ? ", k" : "", outputs_index, outputs_index + 1);
+	}
+	auto result = OnnxBindCall(context, bound_function, arguments, outputs_index);
+	if (result->named_outputs) {
+		throw BinderException("%s: select a single output by its name", name);
+	}
+	result->reduction = REDUCTION;
+	result->output_types = {DatumType::F32};
+
+	switch (REDUCTION) {
+	case OnnxReduction::ARGMAX:
+		bound_function.return_type = LogicalType::INTEGER;
+		break;
+	case OnnxReduction::TOP_K: {
+		auto &k_argument = *arguments[2];
+		if (k_argument.return_type.id() == LogicalTypeId::UNKNOWN) {
+			throw ParameterNotResolvedException();
+		}
+		if (!k_argument.IsFoldable()) {
+			throw BinderException("%s: k must be constant", name);
+		}
+		auto k = ExpressionExecutor::EvaluateScalar(context, k_argument);
+		if (k.IsNull() || k.GetValue<int64_t>() < 1) {
+			throw BinderException("%s: k must be a positive integer", name);
+		}
+		result->k = NumericCast<idx_t>(k.GetValue<int64_t>());
+		bound_function.arguments[2] = LogicalType::BIGINT;
+		child_list_t<LogicalType> score;
+		score.push_back(make_pair("idx", LogicalType::INTEGER));
+		score.push_back(make_pair("score", LogicalType::FLOAT));
+		bound_function.return_type = LogicalType::LIST(LogicalType::STRUCT(std::move(score)));
+		break;
+	}
+	case OnnxReduction::SOFTMAX: {
+		auto size = result->output_sizes[0];
+		bound_function.return_type =
+		    size ? LogicalType::ARRAY(LogicalType::FLOAT, size) : LogicalType::LIST(LogicalType::FLOAT);
 		break;
+	}
 	default:
-		throw NotImplementedException("onnx(string, list) requires a list as parameter");
+		throw InternalException("onnx: unexpected reduction");
 	}
-	bound_function.arguments[1] = arguments[1]->return_type;
-	bound_function.return_type = arguments[1]->return_type;
-	return nullptr;
+	return std::move(result);
 }
 
 static void LoadInternal(DatabaseInstance &instance) {
-	// Register a scalar function
-	auto int_list_type = LogicalType::LIST(LogicalType::INTEGER);
-	auto float_list_type = LogicalType::LIST(LogicalType::FLOAT);
-	child_list_t<LogicalType> struct_list_type_list;
-	struct_list_type_list.push_back(make_pair("shape", int_list_type));
-	struct_list_type_list.push_back(make_pair("value", float_list_type));
-	auto struct_list_type = LogicalType::STRUCT(struct_list_type_list);
+	// Register a scalar function; its tensor and result types are fixed when it is bound
+	auto struct_list_type = OnnxTensorType(LogicalType::LIST(LogicalType::FLOAT));
 
-	auto onnx_scalar_function = duckdb::ScalarFunction("onnx", {}, struct_list_type, OnnxScalarFun, nullptr, nullptr,
-	                                                   nullptr, nullptr, duckdb::LogicalType::ANY);
+	auto onnx_scalar_function = duckdb::ScalarFunction("onnx", {}, struct_list_type, OnnxScalarFun, OnnxBindFunction,
+	                                                   nullptr, nullptr, OnnxInitLocalState, duckdb::LogicalType::ANY);
 
 	ExtensionUtil::RegisterFunction(instance, onnx_scalar_function);
+	// the same inference, returning a reduction of the values of one output instead of the tensor
+	ExtensionUtil::RegisterFunction(instance, ScalarFunction("onnx_argmax", {}, LogicalType::INTEGER, OnnxScalarFun,
+	                                                         OnnxReductionBind<OnnxReduction::ARGMAX>, nullptr, nullptr,
+	                                                         OnnxInitLocalState, LogicalType::ANY));
+	ExtensionUtil::RegisterFunction(instance, ScalarFunction("onnx_topk", {}, LogicalType::ANY, OnnxScalarFun,
+	                                                         OnnxReductionBind<OnnxReduction::TOP_K>, nullptr, nullptr,
+	                                                         OnnxInitLocalState, LogicalType::ANY));
+	ExtensionUtil::RegisterFunction(instance, ScalarFunction("onnx_softmax", {}, LogicalType::ANY, OnnxScalarFun,
+	                                                         OnnxReductionBind<OnnxReduction::SOFTMAX>, nullptr,
+	                                                         nullptr, OnnxInitLocalState, LogicalType::ANY));
+	ExtensionUtil::RegisterFunction(instance, OnnxModelCacheFunction());
+	ExtensionUtil::RegisterFunction(instance, OnnxInferFunction());
+	ExtensionUtil::RegisterFunction(instance, OnnxQuantizeFunction());
+	ExtensionUtil::RegisterFunction(instance, OnnxProfileFunction());
+	ExtensionUtil::RegisterFunction(instance, OnnxRegisterModelFunction::GetFunctions());
+	ExtensionUtil::RegisterFunction(instance, OnnxRegisterModelFunction::GetUnregisterFunction());
+	ExtensionUtil::RegisterFunction(instance, OnnxModelsFunction());
+
+	auto &config = DBConfig::GetConfig(instance);
+	config.AddExtensionOption(OnnxModelCache::LIMIT_SETTING,
+	                          "Maximum memory used by cached ONNX models (e.g. 1GB); least recently used models are "
+	                          "evicted first",
+	                          LogicalType::VARCHAR, Value(OnnxModelCache::DEFAULT_LIMIT));
+	config.AddExtensionOption(OnnxModelCache::PLAN_DIRECTORY_SETTING,
+	                          "Directory of compiled ONNX plans (.onnxplan): models are mapped from the plan written "
+	                          "for their bytes and CPU instead of being parsed and prepacked again (empty: disabled)",
+	                          LogicalType::VARCHAR, Value(""));
+	config.AddExtensionOption(OnnxTaskRunner::THREADS_SETTING,
+	                          "Maximum number of threads one ONNX inference may use (0: all of DuckDB's threads)",
+	                          LogicalType::BIGINT, Value::BIGINT(0));
+	config.AddExtensionOption(OnnxProfileFunction::SETTING,
+	                          "Record per-node statistics of ONNX inferences, returned by onnx_profile(model_path)",
+	                          LogicalType::BOOLEAN, Value::BOOLEAN(false));
 }
 
 void OnnxExtension::Load(DuckDB &db) {
@@ -0,0 +1,37 @@
+#include "onnx_file_system.hpp"
+
+#include "duckdb/common/exception.hpp"
+#include "duckdb/common/file_system.hpp"
+#include "duckdb/main/client_context.hpp"
+#include "duckdb/main/config.hpp"
+
+namespace duckdb {
+
+bool OnnxExternalAccessEnabled(ClientContext &context) {
+	return DBConfig::GetConfig(context).options.enable_external_access;
+}
+
+void OnnxCheckExternalAccess(ClientContext &context, const string &what) {
+	if (!OnnxExternalAccessEnabled(context)) {
+		throw PermissionException("%s: access to model files is disabled through configuration", what);
+	}
+}
+
+string OnnxReadFile(ClientContext &context, const string &path) {
+	auto &fs = FileSystem::GetFileSystem(context);
+	auto handle = fs.OpenFile(path, FileFlags::FILE_FLAGS_READ);
+	auto size = NumericCast<idx_t>(handle->GetFileSize());
+	string bytes(size, '\0');
+	handle->Read(&bytes[0], size);
+	return bytes;
+}
+
+void OnnxWriteFile(ClientContext &context, const string &path, const char *data, idx_t size) {
+	auto &fs = FileSystem::GetFileSystem(context);
+	auto handle = fs.OpenFile(path, FileFlags::FILE_FLAGS_WRITE | FileFlags::FILE_FLAGS_FILE_CREATE_NEW);
+	handle->Write(const_cast<char *>(data), size);
+	handle->Sync();
+	handle->Close();
+}
+
+} // namespace duckdb
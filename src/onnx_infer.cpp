@@ -0,0 +1,419 @@
+#include "onnx_infer.hpp"
+
+#include "onnx_model_cache.hpp"
+#include "onnx_model_registry.hpp"
+#include "onnx_profile.hpp"
+#include "onnx_task_runner.hpp"
+#include "onnx_types.hpp"
+#include "duckdb-onnx/core/optim.hpp"
+#include "duckdb/common/string_util.hpp"
+#include "duckdb/common/vector_operations/vector_operations.hpp"
+#include "duckdb/execution/execution_context.hpp"
+#include "duckdb/main/client_context.hpp"
+
+namespace duckdb {
+
+using duckdb_onnx::DatumType;
+using duckdb_onnx::ShapeVec;
+using duckdb_onnx::SimpleState;
+using duckdb_onnx::TValue;
+
+//! A model input and the column its tensors are read from
+struct OnnxInferInput {
+	//! Index of the column holding the tensor of each row
+	idx_t column;
+	//! The type the column is read as: itself when its elements have an ONNX counterpart, else FLOAT elements
+	LogicalType tensor_type;
+	//! Shape of the tensor of one row, without the batch dimension
+	ShapeVec sample_shape;
+	idx_t sample_len;
+};
+
+struct OnnxInferBindData : public TableFunctionData {
+	shared_ptr<OnnxModel> model;
+	vector<LogicalType> input_types;
+	//! The columns feeding the model inputs, in the order of the model inputs
+	vector<OnnxInferInput> inputs;
+	//! Element types of the output columns, which the model outputs are converted to
+	vector<DatumType> output_types;
+	//! The shapes of the outputs of one row when the facts of the model show that rows can run as one batch
+	std::optional<vector<vector<int64_t>>> batch_shapes;
+	idx_t batch_size = OnnxInferFunction::DEFAULT_BATCH_SIZE;
+};
+
+struct OnnxInferLocalState : public LocalTableFunctionState {
+	OnnxInferLocalState(ClientContext &context, const OnnxInferBindData &bind)
+	    : runner(context, OnnxTaskRunner::GetMaxThreads(context)), state(bind.model->plan),
+	      batched(bind.batch_shapes.has_value()) {
+		state.session().runner = &runner;
+		if (OnnxProfileFunction::Enabled(context)) {
+			state.set_profile(bind.model->profile);
+		}
+		pending.Initialize(Allocator::Get(context), bind.input_types);
+	}
+
+	OnnxTaskRunner runner;
+	SimpleState state;
+	//! Rows waiting for the batch to fill up
+	DataChunk pending;
+	//! Rows of the current input chunk already moved to `pending`
+	idx_t consumed = 0;
+	//! Whether pending rows run as one batch; cleared when the outputs of a batch contradict the facts of the model
+	bool batched;
+};
+
+static bool IsTensorColumn(const LogicalType &type) {
+	if (type.id() == LogicalTypeId::LIST) {
+		return ListType::GetChildType(type).IsNumeric();
+	}
+	return type.id() == LogicalTypeId::ARRAY && ArrayType::GetChildType(type).IsNumeric();
+}
+
+//! Check that column `column` can feed input `index` of `model`, one tensor per row
+static OnnxInferInput BindInput(const OnnxModel &model, idx_t index, TableFunctionBindInput &input, idx_t column) {
+	auto &table_types = input.input_table_types;
+	auto &table_names = input.input_table_names;
+	auto &column_type = table_types[column];
+	if (!IsTensorColumn(column_type)) {
+		throw BinderException("onnx_infer: column \"%s\" must be a list or an array of numbers, got %s",
+		                      table_names[column], column_type.ToString());
+	}
+	OnnxInferInput result;
+	result.column = column;
+	bool is_array = column_type.id() == LogicalTypeId::ARRAY;
+	DatumType element_type;
+	if (OnnxDatumType(is_array ? ArrayType::GetChildType(column_type) : ListType::GetChildType(column_type),
+	                  element_type)) {
+		result.tensor_type = column_type;
+	} else {
+		result.tensor_type = is_array ? LogicalType::ARRAY(LogicalType::FLOAT, ArrayType::GetSize(column_type))
+		                              : LogicalType::LIST(LogicalType::FLOAT);
+	}
+
+	auto &graph = model.plan->model();
+	auto &model_path = model.path;
+	auto &fact = graph.outlet_fact(graph.inputs[index]);
+	auto fact_name = model.InputName(index);
+	// rows are converted to the input's type, which needs a DuckDB counterpart
+	OnnxElementType(fact.datum_type);
+	// rows are stacked along the first dimension, which must be free or 1
+	if (!fact.rank_known || fact.shape.empty() || (fact.shape[0].is_int() && fact.shape[0].as_int() != 1)) {
+		throw BinderException("onnx_infer: input %s of model %s has no batch dimension", fact_name, model_path);
+	}
+	result.sample_len = 1;
+	for (idx_t axis = 1; axis < fact.shape.size(); axis++) {
+		if (!fact.shape[axis].is_int()) {
+			throw BinderException("onnx_infer: dimension %llu of input %s of model %s is not fixed, use onnx() for "
+			                      "tensors of varying shapes",
+			                      axis, fact_name, model_path);
+		}
+		result.sample_shape.push_back(fact.shape[axis].as_int());
+		result.sample_len *= NumericCast<idx_t>(fact.shape[axis].as_int());
+	}
+	if (is_array && ArrayType::GetSize(column_type) != result.sample_len) {
+		throw BinderException("onnx_infer: column \"%s\" holds arrays of %llu values but input %s of model %s "
+		                      "needs %llu",
+		                      table_names[column], ArrayType::GetSize(column_type), fact_name, model_path,
+		                      result.sample_len);
+	}
+	return result;
+}
+
+static unique_ptr<FunctionData> OnnxInferBind(ClientContext &context, TableFunctionBindInput &input,
+                                              vector<LogicalType> &return_types, vector<string> &names) {
+	// the model path is the last positional argument, after the table
+	auto &path = input.inputs.back();
+	if (path.IsNull()) {
+		throw BinderException("onnx_infer: the model path must not be NULL");
+	}
+	auto result = make_uniq<OnnxInferBindData>();
+	result->model = OnnxGetModel(context, StringValue::Get(path));
+
+	string input_name;
+	for (auto &param : input.named_parameters) {
+		if (param.first == "batch_size") {
+			auto batch_size = param.second.GetValue<int64_t>();
+			if (batch_size < 1 || batch_size > NumericCast<int64_t>(STANDARD_VECTOR_SIZE)) {
+				throw BinderException("onnx_infer: batch_size must be between 1 and %llu", STANDARD_VECTOR_SIZE);
+			}
+			result->batch_size = NumericCast<idx_t>(batch_size);
+		} else if (param.first == "input") {
+			input_name = StringValue::Get(param.second);
+		} else if (param.first == "outputs") {
+			// only the selected outputs are computed and returned
+			if (param.second.IsNull() || ListValue::GetChildren(param.second).empty()) {
+				throw BinderException("onnx_infer: outputs must list at least one output name");
+			}
+			vector<string> outputs;
+			for (auto &name : ListValue::GetChildren(param.second)) {
+				if (name.IsNull()) {
+					throw BinderException("onnx_infer: the output names must not be NULL");
+				}
+				outputs.push_back(StringValue::Get(name));
+			}
+			result->model = result->model->WithOutputs(outputs);
+		}
+	}
+
+	auto &model = *result->model;
+	auto &graph = model.plan->model();
+	auto &table_types = input.input_table_types;
+	auto &table_names = input.input_table_names;
+	if (graph.inputs.size() == 1) {
+		// the input column: the one named by `input`, or the first list of numbers
+		auto column = DConstants::INVALID_INDEX;
+		for (idx_t col = 0; col < table_types.size(); col++) {
+			if (input_name.empty() ? IsTensorColumn(table_types[col])
+			                       : StringUtil::CIEquals(table_names[col], input_name)) {
+				column = col;
+				break;
+			}
+		}
+		if (column == DConstants::INVALID_INDEX) {
+			if (!input_name.empty()) {
+				throw BinderException("onnx_infer: the input table has no column \"%s\"", input_name);
+			}
+			throw BinderException("onnx_infer: the input table needs a list column holding the model input, e.g. "
+			                      "FLOAT[] or FLOAT[n]");
+		}
+		result->inputs.push_back(BindInput(model, 0, input, column));
+	} else {
+		// each input is read from the column of the same name
+		if (graph.inputs.empty() || !input_name.empty()) {
+			throw BinderException("onnx_infer: model %s has %llu inputs, which are read from the columns named "
+			                      "after them",
+			                      model.path, graph.inputs.size());
+		}
+		for (idx_t i = 0; i < graph.inputs.size(); i++) {
+			auto name = model.InputName(i);
+			auto column = DConstants::INVALID_INDEX;
+			for (idx_t col = 0; col < table_names.size() && column == DConstants::INVALID_INDEX; col++) {
+				if (StringUtil::CIEquals(table_names[col], name)) {
+					column = col;
+				}
+			}
+			if (column == DConstants::INVALID_INDEX) {
+				throw BinderException("onnx_infer: the input table has no column \"%s\" for that input of model %s",
+				                      name, model.path);
+			}
+			result->inputs.push_back(BindInput(model, i, input, column));
+		}
+	}
+	result->input_types = table_types;
+	vector<vector<int64_t>> sample_shapes;
+	for (auto &bound_input : result->inputs) {
+		sample_shapes.emplace_back(1, 1);
+		sample_shapes.back().insert(sample_shapes.back().end(), bound_input.sample_shape.begin(),
+		                            bound_input.sample_shape.end());
+	}
+	result->batch_shapes = duckdb_onnx::batch_output_shapes(graph, sample_shapes);
+
+	names = table_names;
+	return_types = table_types;
+	for (idx_t i = 0; i < graph.outputs.size(); i++) {
+		names.push_back(model.OutputName(i));
+		// outputs whose shape past the batch dimension is fixed become fixed-size arrays
+		auto &output_fact = graph.outlet_fact(graph.outputs[i]);
+		auto element_type = OnnxElementType(output_fact.datum_type);
+		DatumType output_type;
+		OnnxDatumType(element_type, output_type);
+		result->output_types.push_back(output_type);
+		bool fixed = output_fact.rank_known && !output_fact.shape.empty() &&
+		             (!output_fact.shape[0].is_int() || output_fact.shape[0].as_int() == 1);
+		idx_t row_len = 1;
+		for (idx_t axis = 1; fixed && axis < output_fact.shape.size(); axis++) {
+			fixed = output_fact.shape[axis].is_int();
+			row_len *= fixed ? NumericCast<idx_t>(output_fact.shape[axis].as_int()) : 0;
+		}
+		if (fixed && row_len > 0 && row_len <= ArrayType::MAX_ARRAY_SIZE) {
+			return_types.push_back(LogicalType::ARRAY(element_type, row_len));
+		} else {
+			return_types.push_back(LogicalType::LIST(element_type));
+		}
+	}
+	return std::move(result);
+}
+
+static unique_ptr<LocalTableFunctionState> OnnxInferInitLocal(ExecutionContext &context, TableFunctionInitInput &input,
+                                                               GlobalTableFunctionState *) {
+	auto &bind = input.bind_data->Cast<OnnxInferBindData>();
+	return make_uniq<OnnxInferLocalState>(context.client, bind);
+}
+
+//! Write `count` elements of `values`, which has the column's element type, starting at element `first` as the
+//! entry of `row` in a LIST or ARRAY output column
+static void WriteOutput(Vector &column, idx_t row, const duckdb_onnx::Tensor &values, idx_t first, idx_t count) {
+	auto element_size = duckdb_onnx::datum_type_size(values.datum_type());
+	auto source = static_cast<const_data_ptr_t>(values.raw_data()) + first * element_size;
+	if (column.GetType().id() == LogicalTypeId::ARRAY) {
+		auto array_size = ArrayType::GetSize(column.GetType());
+		if (count != array_size) {
+			throw InvalidInputException("onnx_infer: the model returned %llu values for a row, expected %llu", count,
+			                            array_size);
+		}
+		memcpy(FlatVector::GetData(ArrayVector::GetEntry(column)) + row * array_size * element_size, source,
+		       count * element_size);
+		return;
+	}
+	auto offset = ListVector::GetListSize(column);
+	ListVector::Reserve(column, offset + count);
+	memcpy(FlatVector::GetData(ListVector::GetEntry(column)) + offset * element_size, source, count * element_size);
+	FlatVector::GetData<list_entry_t>(column)[row] = list_entry_t(offset, count);
+	ListVector::SetListSize(column, offset + count);
+}
+
+//! The outputs of one run, which live in the state's arena until its next run
+static vector<TValue> RunModel(const OnnxModel &model, SimpleState &state, const vector<duckdb_onnx::Tensor> &inputs) {
+	vector<TValue> values;
+	for (idx_t i = 0; i < inputs.size(); i++) {
+		values.push_back(TValue::Var(OnnxConvertTensor(inputs[i], model.InputType(i))));
+	}
+	auto result = state.run(std::move(values));
+	if (result.is_err()) {
+		throw InvalidInputException("ONNX model %s: %s", model.path, result.error().what());
+	}
+	return result.value_move();
+}
+
+//! Run the pending rows through the model and write them to `output` with the model outputs
+static void RunPending(ClientContext &context, const OnnxInferBindData &bind, OnnxInferLocalState &local,
+                       DataChunk &output) {
+	auto &pending = local.pending;
+	auto count = pending.size();
+	auto columns = pending.ColumnCount();
+	for (idx_t col = 0; col < columns; col++) {
+		VectorOperations::Copy(pending.data[col], output.data[col], count, 0, 0);
+	}
+	output.SetCardinality(count);
+
+	// the input columns are read in place unless their elements have to be cast to FLOAT
+	vector<unique_ptr<Vector>> cast_values;
+	vector<unique_ptr<OnnxTensorReader>> values;
+	for (auto &input : bind.inputs) {
+		auto &column = pending.data[input.column];
+		cast_values.push_back(make_uniq<Vector>(input.tensor_type, count));
+		if (column.GetType() != input.tensor_type) {
+			VectorOperations::Cast(context, column, *cast_values.back(), count);
+		} else {
+			cast_values.back()->Reference(column);
+		}
+		values.push_back(make_uniq<OnnxTensorReader>(*cast_values.back(), count));
+	}
+
+	// rows without an input tensor get NULL outputs
+	vector<idx_t> rows;
+	for (idx_t row = 0; row < count; row++) {
+		bool valid = true;
+		for (auto &reader : values) {
+			valid = valid && reader->RowIsValid(row);
+		}
+		if (!valid) {
+			for (idx_t col = columns; col < output.ColumnCount(); col++) {
+				if (output.data[col].GetType().id() == LogicalTypeId::LIST) {
+					FlatVector::GetData<list_entry_t>(output.data[col])[row] = list_entry_t(0, 0);
+				}
+				FlatVector::SetNull(output.data[col], row, true);
+			}
+			continue;
+		}
+		for (idx_t i = 0; i < bind.inputs.size(); i++) {
+			auto entry = values[i]->GetEntry(row);
+			if (entry.length != bind.inputs[i].sample_len) {
+				throw InvalidInputException("onnx_infer: row has %llu values but the model input needs %llu",
+				                            entry.length, bind.inputs[i].sample_len);
+			}
+			values[i]->CheckValid(entry, "onnx_infer");
+		}
+		rows.push_back(row);
+	}
+	if (rows.empty()) {
+		return;
+	}
+
+	auto &model = *bind.model;
+	if (local.batched && rows.size() > 1) {
+		vector<duckdb_onnx::Tensor> inputs;
+		for (idx_t i = 0; i < bind.inputs.size(); i++) {
+			ShapeVec shape {NumericCast<int64_t>(rows.size())};
+			shape.insert(shape.end(), bind.inputs[i].sample_shape.begin(), bind.inputs[i].sample_shape.end());
+			inputs.push_back(values[i]->BatchTensor(rows, std::move(shape)));
+		}
+		auto outputs = RunModel(model, local.state, inputs);
+		if (duckdb_onnx::batch_outputs_match(outputs, rows.size(), *bind.batch_shapes)) {
+			for (idx_t i = 0; i < outputs.size(); i++) {
+				auto result = OnnxConvertTensor(*outputs[i], bind.output_types[i]);
+				auto row_len = result.len() / rows.size();
+				for (idx_t r = 0; r < rows.size(); r++) {
+					WriteOutput(output.data[columns + i], rows[r], result, r * row_len, row_len);
+				}
+			}
+			return;
+		}
+		// the outputs contradict the facts of the model: run the rows of this query one by one from now on
+		local.batched = false;
+	}
+	for (auto row : rows) {
+		vector<duckdb_onnx::Tensor> inputs;
+		for (idx_t i = 0; i < bind.inputs.size(); i++) {
+			auto &reader = *values[i];
+			ShapeVec shape {1};
+			shape.insert(shape.end(), bind.inputs[i].sample_shape.begin(), bind.inputs[i].sample_shape.end());
+			inputs.push_back(
+			    duckdb_onnx::Tensor::borrowed(reader.datum_type, shape, reader.GetData(reader.GetEntry(row).offset)));
+		}
+		auto outputs = RunModel(model, local.state, inputs);
+		for (idx_t i = 0; i < outputs.size(); i++) {
+			auto result = OnnxConvertTensor(*outputs[i], bind.output_types[i]);
+			WriteOutput(output.data[columns + i], row, result, 0, result.len());
+		}
+	}
+}
+
+static OperatorResultType OnnxInferExecute(ExecutionContext &context, TableFunctionInput &data, DataChunk &input,
+                                           DataChunk &output) {
+	auto &bind = data.bind_data->Cast<OnnxInferBindData>();
+	auto &local = data.local_state->Cast<OnnxInferLocalState>();
+	auto &pending = local.pending;
+	auto take = MinValue(bind.batch_size - pending.size(), input.size() - local.consumed);
+	if (take > 0) {
+		SelectionVector sel(take);
+		for (idx_t i = 0; i < take; i++) {
+			sel.set_index(i, local.consumed + i);
+		}
+		pending.Append(input, false, &sel, take);
+		local.consumed += take;
+	}
+	if (pending.size() == bind.batch_size) {
+		RunPending(context.client, bind, local, output);
+		pending.Reset();
+		if (local.consumed < input.size()) {
+			return OperatorResultType::HAVE_MORE_OUTPUT;
+		}
+	}
+	local.consumed = 0;
+	return OperatorResultType::NEED_MORE_INPUT;
+}
+
+static OperatorFinalizeResultType OnnxInferFinal(ExecutionContext &context, TableFunctionInput &data,
+                                                 DataChunk &output) {
+	auto &bind = data.bind_data->Cast<OnnxInferBindData>();
+	auto &local = data.local_state->Cast<OnnxInferLocalState>();
+	// the last, partial batch
+	if (local.pending.size() > 0) {
+		RunPending(context.client, bind, local, output);
+		local.pending.Reset();
+	}
+	return OperatorFinalizeResultType::FINISHED;
+}
+
+OnnxInferFunction::OnnxInferFunction()
+    : TableFunction("onnx_infer", {LogicalType::TABLE, LogicalType::VARCHAR}, nullptr, OnnxInferBind, nullptr,
+                    OnnxInferInitLocal) {
+	in_out_function = OnnxInferExecute;
+	in_out_function_final = OnnxInferFinal;
+	named_parameters["batch_size"] = LogicalType::BIGINT;
+	named_parameters["input"] = LogicalType::VARCHAR;
+	named_parameters["outputs"] = LogicalType::LIST(LogicalType::VARCHAR);
+}
+
+} // namespace duckdb
@@ -0,0 +1,462 @@
+#include "onnx_model_cache.hpp"
+
+#include "onnx_file_system.hpp"
+#include "duckdb-onnx/core/optim.hpp"
+#include "duckdb-onnx/core/plan_file.hpp"
+#include "duckdb-onnx/mmap.h"
+#include "duckdb/common/file_system.hpp"
+#include "duckdb/common/string_util.hpp"
+#include "duckdb/main/client_context.hpp"
+#include "duckdb/main/config.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <thread>
+#include <unordered_set>
+
+namespace duckdb {
+
+duckdb_onnx::DatumType OnnxModel::InputType(idx_t index) const {
+	auto &model = plan->model();
+	return index < model.inputs.size() ? model.outlet_fact(model.inputs[index]).datum_type
+	                                   : duckdb_onnx::DatumType::F32;
+}
+
+duckdb_onnx::DatumType OnnxModel::OutputType(idx_t index) const {
+	auto &model = plan->model();
+	return index < model.outputs.size() ? model.outlet_fact(model.outputs[index]).datum_type
+	                                    : duckdb_onnx::DatumType::F32;
+}
+
+string OnnxModel::InputName(idx_t index) const {
+	auto &model = plan->model();
+	return model.outlet_label(model.inputs[index]);
+}
+
+string OnnxModel::OutputName(idx_t index) const {
+	auto &model = plan->model();
+	auto name = model.outlet_label(model.outputs[index]);
+	return name.empty() ? "output" + std::to_string(index) : name;
+}
+
+idx_t OnnxModel::InputIndex(const string &name) const {
+	auto &model = plan->model();
+	for (idx_t i = 0; i < model.inputs.size(); i++) {
+		if (StringUtil::CIEquals(model.outlet_label(model.inputs[i]), name)) {
+			return i;
+		}
+	}
+	return DConstants::INVALID_INDEX;
+}
+
+void OnnxModel::CountMemoryUsage() {
+	lock_guard<mutex> guard(variants_lock);
+	CountMemoryUsageLocked();
+}
+
+void OnnxModel::CountMemoryUsageLocked() {
+	idx_t usage = sizeof(OnnxModel) + path.size();
+	// the variants share the prepacked ops and the constants of this plan: those are counted once
+	std::unordered_set<const void *> seen;
+	if (plan) {
+		usage += plan->memory_usage(seen);
+	}
+	for (auto &variant : variants) {
+		usage += sizeof(OnnxModel) + variant.first.size();
+		if (variant.second->plan) {
+			usage += variant.second->plan->memory_usage(seen);
+		}
+	}
+	memory_usage = usage;
+}
+
+//! The plan of `graph`, optimized and prepacked, and of its copy specialized for the declared input shapes
+static std::shared_ptr<duckdb_onnx::SimplePlan> PlanModel(std::shared_ptr<duckdb_onnx::TypedModel> graph,
+                                                          const string &path) {
+	// the specialized copy shares the prepacked ops of the generic graph
+	std::shared_ptr<duckdb_onnx::TypedModel> specialized;
+	try {
+		duckdb_onnx::infer_facts(*graph);
+		specialized = duckdb_onnx::specialize(*graph);
+	} catch (std::exception &) {
+		// facts are only used to plan ahead: such a model runs on the generic plan alone
+		specialized = nullptr;
+	}
+	if (specialized) {
+		duckdb_onnx::codegen(*specialized);
+	}
+	auto plan = duckdb_onnx::SimplePlan::build(std::move(graph), specialized);
+	if (plan.is_err()) {
+		throw InvalidInputException("Failed to plan ONNX model %s: %s", path, plan.error().what());
+	}
+	return plan.value_move();
+}
+
+shared_ptr<OnnxModel> OnnxModel::Compile(duckdb_onnx::TypedModel graph, const string &path) {
+	auto shared_graph = std::make_shared<duckdb_onnx::TypedModel>(std::move(graph));
+	// the graph is simplified and its weights prepacked here, once per load
+	duckdb_onnx::optimize(*shared_graph);
+	duckdb_onnx::codegen(*shared_graph);
+	auto model = make_shared_ptr<OnnxModel>();
+	model->path = path;
+	model->plan = PlanModel(std::move(shared_graph), path);
+	model->CountMemoryUsage();
+	return model;
+}
+
+//! The directory set by `onnx_plan_directory`, empty when plan files are not used: plans are memory mapped, so only
+//! a local directory is used, and only while `enable_external_access` is on
+static string GetPlanDirectory(ClientContext &context) {
+	Value directory;
+	if (!context.TryGetCurrentSetting(OnnxModelCache::PLAN_DIRECTORY_SETTING, directory) || directory.IsNull()) {
+		return string();
+	}
+	auto result = directory.ToString();
+	if (!OnnxExternalAccessEnabled(context) || FileSystem::IsRemoteFile(result)) {
+		return string();
+	}
+	return result;
+}
+
+//! Create `directory` and its missing parents through DuckDB's file system
+static void CreateDirectories(FileSystem &fs, const string &directory) {
+	if (directory.empty() || fs.DirectoryExists(directory)) {
+		return;
+	}
+	auto separator = directory.find_last_of("/\\");
+	if (separator != string::npos && separator > 0) {
+		CreateDirectories(fs, directory.substr(0, separator));
+	}
+	fs.CreateDirectory(directory);
+}
+
+//! Write the plan of `model` to `plan_path` through DuckDB's file system. It is written under a temporary name and
+//! moved once complete, so that a concurrent load never maps a partial plan.
+static void WritePlanFile(ClientContext &context, const string &directory, const string &plan_path,
+                          const duckdb_onnx::PlanFileKey &key, const OnnxModel &model,
+                          const vector<duckdb_onnx::PlanFileDependency> &dependencies) {
+	auto &fs = FileSystem::GetFileSystem(context);
+	CreateDirectories(fs, directory);
+	auto stamp = std::chrono::steady_clock::now().time_since_epoch().count();
+	auto temp = plan_path + ".tmp" + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + "-" +
+	            std::to_string(stamp);
+	auto handle = fs.OpenFile(temp, FileFlags::FILE_FLAGS_WRITE | FileFlags::FILE_FLAGS_FILE_CREATE_NEW);
+	try {
+		auto specialized = model.plan->specialized();
+		duckdb_onnx::write_plan_file(
+		    [&](const char *data, size_t size) { handle->Write(const_cast<char *>(data), size); }, key,
+		    model.plan->model(), specialized ? &specialized->model() : nullptr, dependencies);
+		handle->Sync();
+		handle->Close();
+		fs.MoveFile(temp, plan_path);
+	} catch (std::exception &) {
+		handle.reset();
+		try {
+			fs.RemoveFile(temp);
+		} catch (std::exception &) {
+			// the original error is the one worth reporting
+		}
+		throw;
+	}
+}
+
+shared_ptr<OnnxModel> OnnxModel::Load(ClientContext &context, const char *bytes, idx_t size, const string &path,
+                                      const string &model_dir,
+                                      const std::function<duckdb_onnx::TypedModel(const duckdb_onnx::Onnx &)> &parse) {
+	duckdb_onnx::Onnx onnx;
+	// records the external data files the model is read with, which its plan depends on
+	auto resolver = std::make_shared<duckdb_onnx::MmapDataResolver>();
+	onnx.provider = resolver;
+	auto directory = GetPlanDirectory(context);
+	if (directory.empty()) {
+		return Compile(parse(onnx), path);
+	}
+	auto key = duckdb_onnx::PlanFileKey::for_model(bytes, size);
+	auto plan_path = FileSystem::GetFileSystem(context).JoinPath(directory, key.file_name());
+	auto saved = duckdb_onnx::read_plan_file(plan_path, key, model_dir.empty() ? nullptr : &model_dir);
+	if (saved.is_ok()) {
+		auto models = saved.value_move();
+		auto plan = duckdb_onnx::SimplePlan::build(std::move(models.model), std::move(models.specialized));
+		if (plan.is_ok()) {
+			auto model = make_shared_ptr<OnnxModel>();
+			model->path = path;
+			model->plan = plan.value_move();
+			model->plan_file = plan_path;
+			model->CountMemoryUsage();
+			return model;
+		}
+	}
+	// no plan yet, or one this build cannot use: compile the model and (re)write its plan
+	auto model = Compile(parse(onnx), path);
+	try {
+		vector<duckdb_onnx::PlanFileDependency> dependencies;
+		for (auto &file : resolver->paths()) {
+			dependencies.push_back(duckdb_onnx::PlanFileDependency::for_file(file));
+		}
+		WritePlanFile(context, directory, plan_path, key, *model, dependencies);
+	} catch (std::exception &) {
+		// plans are only a shortcut: a model whose plan cannot be saved is compiled on every load
+	}
+	return model;
+}
+
+shared_ptr<OnnxModel> OnnxModel::WithOutputs(const vector<string> &outputs) {
+	auto key = StringUtil::Join(outputs, string(1, '\0'));
+	lock_guard<mutex> guard(variants_lock);
+	auto entry = variants.find(key);
+	if (entry != variants.end()) {
+		return entry->second;
+	}
+	auto &model = plan->model();
+	vector<duckdb_onnx::OutletId> selected;
+	for (auto &name : outputs) {
+		idx_t index = 0;
+		while (index < model.outputs.size() && !StringUtil::CIEquals(OutputName(index), name)) {
+			index++;
+		}
+		if (index == model.outputs.size()) {
+			vector<string> names;
+			for (idx_t i = 0; i < model.outputs.size(); i++) {
+				names.push_back(OutputName(i));
+			}
+			throw InvalidInputException("ONNX model %s has no output named \"%s\", its outputs are: %s", path, name,
+			                            StringUtil::Join(names, ", "));
+		}
+		selected.push_back(model.outputs[index]);
+	}
+	// a copy of the optimized graph: its ops, with their prepacked weights, are shared
+	auto graph = std::make_shared<duckdb_onnx::TypedModel>(model);
+	duckdb_onnx::select_outputs(*graph, std::move(selected));
+	for (idx_t i = 0; i < outputs.size(); i++) {
+		// unnamed outputs keep the name they were selected by
+		if (graph->outlet_label(graph->outputs[i]).empty()) {
+			graph->set_outlet_label(graph->outputs[i], outputs[i]);
+		}
+	}
+	auto result = make_shared_ptr<OnnxModel>();
+	result->path = path;
+	result->plan = PlanModel(std::move(graph), path);
+	result->profile = profile;
+	result->CountMemoryUsage();
+	variants.emplace(key, result);
+	// the cache picks the new size up on the next lookup of this model
+	CountMemoryUsageLocked();
+	return result;
+}
+
+OnnxModelCache &OnnxModelCache::Get(ClientContext &context) {
+	return *ObjectCache::GetObjectCache(context).GetOrCreate<OnnxModelCache>(CACHE_KEY);
+}
+
+idx_t OnnxModelCache::GetLimit(ClientContext &context) {
+	Value limit;
+	if (context.TryGetCurrentSetting(LIMIT_SETTING, limit) && !limit.IsNull()) {
+		return DBConfig::ParseMemoryLimit(limit.ToString());
+	}
+	return DBConfig::ParseMemoryLimit(DEFAULT_LIMIT);
+}
+
+shared_ptr<OnnxModel> OnnxModelCache::GetModel(ClientContext &context, const string &path) {
+	OnnxCheckExternalAccess(context, "ONNX model " + path);
+	if (FileSystem::IsRemoteFile(path)) {
+		throw InvalidInputException("ONNX model %s: model files are memory mapped and must be local, register a "
+		                            "remote model with onnx_register_model instead",
+		                            path);
+	}
+	std::error_code ec;
+	auto canonical = std::filesystem::canonical(path, ec);
+	if (ec) {
+		throw IOException("ONNX model file not found: %s", path);
+	}
+	auto mtime = std::filesystem::last_write_time(canonical, ec);
+	if (ec) {
+		throw IOException("Could not stat ONNX model file %s: %s", path, ec.message());
+	}
+	auto file_size = std::filesystem::file_size(canonical, ec);
+	if (ec) {
+		throw IOException("Could not stat ONNX model file %s: %s", path, ec.message());
+	}
+	auto key = canonical.string();
+	auto mtime_count = static_cast<int64_t>(mtime.time_since_epoch().count());
+
+	auto limit = GetLimit(context);
+	shared_ptr<mutex> load_lock;
+	{
+		lock_guard<mutex> guard(lock);
+		auto it = entries.find(key);
+		if (it != entries.end() && it->second->mtime == mtime_count && it->second->file_size == file_size) {
+			lru.splice(lru.begin(), lru, it->second);
+			info[key].hits++;
+			auto model = it->second->model;
+			if (it->second->resident_bytes != model->MemoryUsage()) {
+				// variants were planned since it was counted
+				UpdateResidentBytes(*it->second);
+				EvictUntil(limit);
+			}
+			return model;
+		}
+		auto &path_lock = load_locks[key];
+		if (!path_lock) {
+			path_lock = make_shared_ptr<mutex>();
+		}
+		load_lock = path_lock;
+	}
+
+	lock_guard<mutex> load_guard(*load_lock);
+	{
+		// another thread may have loaded the model while we waited for the load lock of its path
+		lock_guard<mutex> guard(lock);
+		auto it = entries.find(key);
+		if (it != entries.end() && it->second->mtime == mtime_count && it->second->file_size == file_size) {
+			lru.splice(lru.begin(), lru, it->second);
+			info[key].hits++;
+			ReleaseLoadLock(key, load_lock);
+			return it->second->model;
+		}
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	shared_ptr<OnnxModel> model;
+	try {
+		std::shared_ptr<duckdb_onnx::MemoryMap> file;
+		try {
+			// mapped rather than read: its bytes are only hashed, when plan files are used
+			file = duckdb_onnx::MemoryMap::open(key);
+		} catch (std::exception &e) {
+			throw IOException("Could not open ONNX model file %s: %s", path, e.what());
+		}
+		auto model_dir = duckdb_onnx::Onnx::model_dir_for_path(key);
+		auto parse = [&](const duckdb_onnx::Onnx &onnx) {
+			auto typed_model = onnx.model_for_path(key);
+			if (typed_model.is_err()) {
+				throw InvalidInputException("Failed to load ONNX model %s: %s", path, typed_model.error().what());
+			}
+			return typed_model.value_move();
+		};
+		model = OnnxModel::Load(context, file->data(), file->size(), key, model_dir, parse);
+	} catch (std::exception &) {
+		lock_guard<mutex> guard(lock);
+		ReleaseLoadLock(key, load_lock);
+		throw;
+	}
+	auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	auto model_bytes = model->MemoryUsage();
+
+	lock_guard<mutex> guard(lock);
+	ReleaseLoadLock(key, load_lock);
+	auto existing = entries.find(key);
+	if (existing != entries.end()) {
+		resident_bytes -= existing->second->resident_bytes;
+		lru.erase(existing->second);
+		entries.erase(existing);
+	}
+	lru.push_front(Entry {key, mtime_count, file_size, model_bytes, model});
+	entries[key] = lru.begin();
+	resident_bytes += model_bytes;
+
+	auto &path_info = info[key];
+	path_info.path = key;
+	path_info.file_size = file_size;
+	path_info.misses++;
+	path_info.load_time_ms = elapsed;
+	path_info.plan_file = model->plan_file;
+	EvictUntil(limit);
+	return model;
+}
+
+void OnnxModelCache::ReleaseLoadLock(const string &key, const shared_ptr<mutex> &load_lock) {
+	auto it = load_locks.find(key);
+	if (it != load_locks.end() && it->second == load_lock) {
+		load_locks.erase(it);
+	}
+}
+
+void OnnxModelCache::UpdateResidentBytes(Entry &entry) {
+	auto usage = entry.model->MemoryUsage();
+	resident_bytes = resident_bytes - entry.resident_bytes + usage;
+	entry.resident_bytes = usage;
+}
+
+void OnnxModelCache::EvictUntil(idx_t limit) {
+	while (resident_bytes > limit && lru.size() > 1) {
+		auto &victim = lru.back();
+		resident_bytes -= victim.resident_bytes;
+		entries.erase(victim.path);
+		lru.pop_back();
+	}
+}
+
+vector<OnnxModelCacheInfo> OnnxModelCache::GetInfo() {
+	lock_guard<mutex> guard(lock);
+	for (auto &entry : lru) {
+		UpdateResidentBytes(entry);
+	}
+	vector<OnnxModelCacheInfo> result;
+	for (auto &entry : info) {
+		auto path_info = entry.second;
+		auto it = entries.find(entry.first);
+		path_info.cached = it != entries.end();
+		path_info.resident_bytes = path_info.cached ? it->second->resident_bytes : 0;
+		result.push_back(std::move(path_info));
+	}
+	std::sort(result.begin(), result.end(),
+	          [](const OnnxModelCacheInfo &a, const OnnxModelCacheInfo &b) { return a.path < b.path; });
+	return result;
+}
+
+struct OnnxModelCacheState : public GlobalTableFunctionState {
+	vector<OnnxModelCacheInfo> entries;
+	idx_t offset = 0;
+};
+
+static unique_ptr<FunctionData> OnnxModelCacheBind(ClientContext &context, TableFunctionBindInput &input,
+                                                   vector<LogicalType> &return_types, vector<string> &names) {
+	names.emplace_back("path");
+	return_types.emplace_back(LogicalType::VARCHAR);
+	names.emplace_back("cached");
+	return_types.emplace_back(LogicalType::BOOLEAN);
+	names.emplace_back("file_size");
+	return_types.emplace_back(LogicalType::UBIGINT);
+	names.emplace_back("hits");
+	return_types.emplace_back(LogicalType::UBIGINT);
+	names.emplace_back("misses");
+	return_types.emplace_back(LogicalType::UBIGINT);
+	names.emplace_back("load_time_ms");
+	return_types.emplace_back(LogicalType::DOUBLE);
+	names.emplace_back("resident_bytes");
+	return_types.emplace_back(LogicalType::UBIGINT);
+	names.emplace_back("plan_file");
+	return_types.emplace_back(LogicalType::VARCHAR);
+	return nullptr;
+}
+
+static unique_ptr<GlobalTableFunctionState> OnnxModelCacheInit(ClientContext &context, TableFunctionInitInput &input) {
+	auto state = make_uniq<OnnxModelCacheState>();
+	state->entries = OnnxModelCache::Get(context).GetInfo();
+	return std::move(state);
+}
+
+static void OnnxModelCacheScan(ClientContext &context, TableFunctionInput &data_p, DataChunk &output) {
+	auto &state = data_p.global_state->Cast<OnnxModelCacheState>();
+	idx_t count = 0;
+	while (state.offset < state.entries.size() && count < STANDARD_VECTOR_SIZE) {
+		auto &entry = state.entries[state.offset++];
+		output.SetValue(0, count, Value(entry.path));
+		output.SetValue(1, count, Value::BOOLEAN(entry.cached));
+		output.SetValue(2, count, Value::UBIGINT(entry.file_size));
+		output.SetValue(3, count, Value::UBIGINT(entry.hits));
+		output.SetValue(4, count, Value::UBIGINT(entry.misses));
+		output.SetValue(5, count, Value::DOUBLE(entry.load_time_ms));
+		output.SetValue(6, count, Value::UBIGINT(entry.resident_bytes));
+		output.SetValue(7, count, entry.plan_file.empty() ? Value() : Value(entry.plan_file));
+		count++;
+	}
+	output.SetCardinality(count);
+}
+
+OnnxModelCacheFunction::OnnxModelCacheFunction()
+    : TableFunction("onnx_model_cache", {}, OnnxModelCacheScan, OnnxModelCacheBind, OnnxModelCacheInit) {
+}
+
+} // namespace duckdb
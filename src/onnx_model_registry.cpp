@@ -0,0 +1,216 @@
+#include "onnx_model_registry.hpp"
+
+#include "onnx_file_system.hpp"
+#include "duckdb-onnx/mmap.h"
+#include "duckdb/common/file_system.hpp"
+#include "duckdb/common/vector_operations/binary_executor.hpp"
+#include "duckdb/common/vector_operations/unary_executor.hpp"
+#include "duckdb/main/client_context.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+namespace duckdb {
+
+OnnxModelRegistry &OnnxModelRegistry::Get(ClientContext &context) {
+	return *ObjectCache::GetObjectCache(context).GetOrCreate<OnnxModelRegistry>(CACHE_KEY);
+}
+
+// models are compiled outside of the lock: lookups of the other models go on meanwhile
+
+void OnnxModelRegistry::Register(ClientContext &context, const string &name, const char *bytes, idx_t size,
+                                 const string &source) {
+	auto start = std::chrono::steady_clock::now();
+	auto model = OnnxModel::Load(context, bytes, size, name, string(), [&](const duckdb_onnx::Onnx &onnx) {
+		auto typed_model = onnx.model_for_bytes(bytes, size);
+		if (typed_model.is_err()) {
+			throw InvalidInputException("onnx_register_model: failed to load model %s: %s", name,
+			                            typed_model.error().what());
+		}
+		return typed_model.value_move();
+	});
+	auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	Add(name, Entry {size, source, elapsed, std::move(model)});
+}
+
+void OnnxModelRegistry::RegisterFile(ClientContext &context, const string &name, const string &path) {
+	OnnxCheckExternalAccess(context, "onnx_register_model");
+	if (FileSystem::IsRemoteFile(path)) {
+		// cannot be mapped: read through DuckDB's file system, e.g. httpfs, and kept only until it is compiled
+		auto bytes = OnnxReadFile(context, path);
+		Register(context, name, bytes.data(), bytes.size(), path);
+		return;
+	}
+	auto start = std::chrono::steady_clock::now();
+	std::shared_ptr<duckdb_onnx::MemoryMap> file;
+	try {
+		// mapped rather than read: its bytes are only hashed, when plan files are used
+		file = duckdb_onnx::MemoryMap::open(path);
+	} catch (std::exception &e) {
+		throw IOException("onnx_register_model: could not open ONNX model file %s: %s", path, e.what());
+	}
+	auto model_dir = duckdb_onnx::Onnx::model_dir_for_path(path);
+	auto parse = [&](const duckdb_onnx::Onnx &onnx) {
+		auto typed_model = onnx.model_for_path(path);
+		if (typed_model.is_err()) {
+			throw InvalidInputException("onnx_register_model: failed to load model %s: %s", name,
+			                            typed_model.error().what());
+		}
+		return typed_model.value_move();
+	};
+	auto model = OnnxModel::Load(context, file->data(), file->size(), name, model_dir, parse);
+	auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	Add(name, Entry {file->size(), path, elapsed, std::move(model)});
+}
+
+void OnnxModelRegistry::Add(const string &name, Entry entry) {
+	lock_guard<mutex> guard(lock);
+	entries[name] = std::move(entry);
+}
+
+bool OnnxModelRegistry::Unregister(const string &name) {
+	lock_guard<mutex> guard(lock);
+	return entries.erase(name) > 0;
+}
+
+shared_ptr<OnnxModel> OnnxModelRegistry::Find(const string &name) {
+	lock_guard<mutex> guard(lock);
+	auto entry = entries.find(name);
+	return entry == entries.end() ? nullptr : entry->second.model;
+}
+
+vector<OnnxRegisteredModelInfo> OnnxModelRegistry::GetInfo() {
+	lock_guard<mutex> guard(lock);
+	vector<OnnxRegisteredModelInfo> result;
+	for (auto &entry : entries) {
+		OnnxRegisteredModelInfo info;
+		info.name = entry.first;
+		info.source = entry.second.source;
+		info.model_bytes = entry.second.model_bytes;
+		info.inputs = entry.second.model->plan->model().inputs.size();
+		info.outputs = entry.second.model->plan->model().outputs.size();
+		info.load_time_ms = entry.second.load_time_ms;
+		info.resident_bytes = entry.second.model->MemoryUsage();
+		info.plan_file = entry.second.model->plan_file;
+		result.push_back(std::move(info));
+	}
+	std::sort(result.begin(), result.end(),
+	          [](const OnnxRegisteredModelInfo &a, const OnnxRegisteredModelInfo &b) { return a.name < b.name; });
+	return result;
+}
+
+shared_ptr<OnnxModel> OnnxGetModel(ClientContext &context, const string &name_or_path) {
+	auto model = OnnxModelRegistry::Get(context).Find(name_or_path);
+	if (model) {
+		return model;
+	}
+	return OnnxModelCache::Get(context).GetModel(context, name_or_path);
+}
+
+static string CheckModelName(string_t name) {
+	auto result = name.GetString();
+	if (result.empty()) {
+		throw InvalidInputException("onnx_register_model: the model name must not be empty");
+	}
+	return result;
+}
+
+static void OnnxRegisterBlobFun(DataChunk &args, ExpressionState &state, Vector &result) {
+	auto &context = state.GetContext();
+	auto &registry = OnnxModelRegistry::Get(context);
+	BinaryExecutor::Execute<string_t, string_t, string_t>(
+	    args.data[0], args.data[1], result, args.size(), [&](string_t name, string_t model) {
+		    registry.Register(context, CheckModelName(name), model.GetData(), model.GetSize());
+		    return StringVector::AddString(result, name);
+	    });
+}
+
+static void OnnxRegisterPathFun(DataChunk &args, ExpressionState &state, Vector &result) {
+	auto &context = state.GetContext();
+	auto &registry = OnnxModelRegistry::Get(context);
+	BinaryExecutor::Execute<string_t, string_t, string_t>(
+	    args.data[0], args.data[1], result, args.size(), [&](string_t name, string_t path) {
+		    registry.RegisterFile(context, CheckModelName(name), path.GetString());
+		    return StringVector::AddString(result, name);
+	    });
+}
+
+static void OnnxUnregisterFun(DataChunk &args, ExpressionState &state, Vector &result) {
+	auto &registry = OnnxModelRegistry::Get(state.GetContext());
+	UnaryExecutor::Execute<string_t, bool>(args.data[0], result, args.size(),
+	                                       [&](string_t name) { return registry.Unregister(name.GetString()); });
+}
+
+ScalarFunctionSet OnnxRegisterModelFunction::GetFunctions() {
+	ScalarFunctionSet set("onnx_register_model");
+	ScalarFunction from_blob({LogicalType::VARCHAR, LogicalType::BLOB}, LogicalType::VARCHAR, OnnxRegisterBlobFun);
+	ScalarFunction from_path({LogicalType::VARCHAR, LogicalType::VARCHAR}, LogicalType::VARCHAR, OnnxRegisterPathFun);
+	// registering has a side effect: it must run once per row and never be folded or reordered
+	from_blob.stability = FunctionStability::VOLATILE;
+	from_path.stability = FunctionStability::VOLATILE;
+	set.AddFunction(from_blob);
+	set.AddFunction(from_path);
+	return set;
+}
+
+ScalarFunction OnnxRegisterModelFunction::GetUnregisterFunction() {
+	ScalarFunction function("onnx_unregister_model", {LogicalType::VARCHAR}, LogicalType::BOOLEAN, OnnxUnregisterFun);
+	function.stability = FunctionStability::VOLATILE;
+	return function;
+}
+
+struct OnnxModelsState : public GlobalTableFunctionState {
+	vector<OnnxRegisteredModelInfo> entries;
+	idx_t offset = 0;
+};
+
+static unique_ptr<FunctionData> OnnxModelsBind(ClientContext &context, TableFunctionBindInput &input,
+                                               vector<LogicalType> &return_types, vector<string> &names) {
+	names.emplace_back("name");
+	return_types.emplace_back(LogicalType::VARCHAR);
+	names.emplace_back("source");
+	return_types.emplace_back(LogicalType::VARCHAR);
+	names.emplace_back("model_bytes");
+	return_types.emplace_back(LogicalType::UBIGINT);
+	names.emplace_back("inputs");
+	return_types.emplace_back(LogicalType::UBIGINT);
+	names.emplace_back("outputs");
+	return_types.emplace_back(LogicalType::UBIGINT);
+	names.emplace_back("load_time_ms");
+	return_types.emplace_back(LogicalType::DOUBLE);
+	names.emplace_back("resident_bytes");
+	return_types.emplace_back(LogicalType::UBIGINT);
+	names.emplace_back("plan_file");
+	return_types.emplace_back(LogicalType::VARCHAR);
+	return nullptr;
+}
+
+static unique_ptr<GlobalTableFunctionState> OnnxModelsInit(ClientContext &context, TableFunctionInitInput &input) {
+	auto state = make_uniq<OnnxModelsState>();
+	state->entries = OnnxModelRegistry::Get(context).GetInfo();
+	return std::move(state);
+}
+
+static void OnnxModelsScan(ClientContext &context, TableFunctionInput &data_p, DataChunk &output) {
+	auto &state = data_p.global_state->Cast<OnnxModelsState>();
+	idx_t count = 0;
+	while (state.offset < state.entries.size() && count < STANDARD_VECTOR_SIZE) {
+		auto &entry = state.entries[state.offset++];
+		output.SetValue(0, count, Value(entry.name));
+		output.SetValue(1, count, entry.source.empty() ? Value() : Value(entry.source));
+		output.SetValue(2, count, Value::UBIGINT(entry.model_bytes));
+		output.SetValue(3, count, Value::UBIGINT(entry.inputs));
+		output.SetValue(4, count, Value::UBIGINT(entry.outputs));
+		output.SetValue(5, count, Value::DOUBLE(entry.load_time_ms));
+		output.SetValue(6, count, Value::UBIGINT(entry.resident_bytes));
+		output.SetValue(7, count, entry.plan_file.empty() ? Value() : Value(entry.plan_file));
+		count++;
+	}
+	output.SetCardinality(count);
+}
+
+OnnxModelsFunction::OnnxModelsFunction()
+    : TableFunction("onnx_models", {}, OnnxModelsScan, OnnxModelsBind, OnnxModelsInit) {
+}
+
+} // namespace duckdb
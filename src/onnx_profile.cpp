@@ -0,0 +1,86 @@
+#include "onnx_profile.hpp"
+
+#include "onnx_model_cache.hpp"
+#include "onnx_model_registry.hpp"
+#include "duckdb/main/client_context.hpp"
+
+namespace duckdb {
+
+struct OnnxProfileBindData : public TableFunctionData {
+	string model_path;
+	bool reset = false;
+};
+
+struct OnnxProfileState : public GlobalTableFunctionState {
+	vector<duckdb_onnx::NodeProfile> entries;
+	idx_t offset = 0;
+};
+
+bool OnnxProfileFunction::Enabled(ClientContext &context) {
+	Value enabled;
+	return context.TryGetCurrentSetting(SETTING, enabled) && !enabled.IsNull() && BooleanValue::Get(enabled);
+}
+
+static unique_ptr<FunctionData> OnnxProfileBind(ClientContext &context, TableFunctionBindInput &input,
+                                                vector<LogicalType> &return_types, vector<string> &names) {
+	if (input.inputs[0].IsNull()) {
+		throw BinderException("onnx_profile: the model path must not be NULL");
+	}
+	auto result = make_uniq<OnnxProfileBindData>();
+	result->model_path = StringValue::Get(input.inputs[0]);
+	for (auto &param : input.named_parameters) {
+		if (param.first == "reset") {
+			result->reset = !param.second.IsNull() && BooleanValue::Get(param.second);
+		}
+	}
+	names.emplace_back("node");
+	return_types.emplace_back(LogicalType::VARCHAR);
+	names.emplace_back("op");
+	return_types.emplace_back(LogicalType::VARCHAR);
+	names.emplace_back("calls");
+	return_types.emplace_back(LogicalType::UBIGINT);
+	names.emplace_back("time_ms");
+	return_types.emplace_back(LogicalType::DOUBLE);
+	names.emplace_back("flops");
+	return_types.emplace_back(LogicalType::UBIGINT);
+	names.emplace_back("output_bytes");
+	return_types.emplace_back(LogicalType::UBIGINT);
+	names.emplace_back("output_shapes");
+	return_types.emplace_back(LogicalType::VARCHAR);
+	return std::move(result);
+}
+
+static unique_ptr<GlobalTableFunctionState> OnnxProfileInit(ClientContext &context, TableFunctionInitInput &input) {
+	auto &bind = input.bind_data->Cast<OnnxProfileBindData>();
+	auto model = OnnxGetModel(context, bind.model_path);
+	auto state = make_uniq<OnnxProfileState>();
+	state->entries = model->profile->snapshot();
+	if (bind.reset) {
+		model->profile->reset();
+	}
+	return std::move(state);
+}
+
+static void OnnxProfileScan(ClientContext &context, TableFunctionInput &data_p, DataChunk &output) {
+	auto &state = data_p.global_state->Cast<OnnxProfileState>();
+	idx_t count = 0;
+	while (state.offset < state.entries.size() && count < STANDARD_VECTOR_SIZE) {
+		auto &entry = state.entries[state.offset++];
+		output.SetValue(0, count, Value(entry.node));
+		output.SetValue(1, count, Value(entry.op));
+		output.SetValue(2, count, Value::UBIGINT(entry.calls));
+		output.SetValue(3, count, Value::DOUBLE(static_cast<double>(entry.nanos) / 1e6));
+		output.SetValue(4, count, Value::UBIGINT(entry.flops));
+		output.SetValue(5, count, Value::UBIGINT(entry.output_bytes));
+		output.SetValue(6, count, Value(entry.output_shapes));
+		count++;
+	}
+	output.SetCardinality(count);
+}
+
+OnnxProfileFunction::OnnxProfileFunction()
+    : TableFunction("onnx_profile", {LogicalType::VARCHAR}, OnnxProfileScan, OnnxProfileBind, OnnxProfileInit) {
+	named_parameters["reset"] = LogicalType::BOOLEAN;
+}
+
+} // namespace duckdb
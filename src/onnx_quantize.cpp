@@ -0,0 +1,305 @@
+#include "onnx_quantize.hpp"
+
+#include "onnx_file_system.hpp"
+#include "onnx_task_runner.hpp"
+#include "onnx_types.hpp"
+#include "duckdb-onnx/core/optim.hpp"
+#include "duckdb-onnx/core/plan.hpp"
+#include "duckdb-onnx/onnx/quantize.hpp"
+#include "duckdb/common/vector_operations/vector_operations.hpp"
+#include "duckdb/main/client_context.hpp"
+#include "duckdb/main/connection.hpp"
+
+namespace duckdb {
+
+using duckdb_onnx::DatumType;
+using duckdb_onnx::ShapeVec;
+using duckdb_onnx::SimpleState;
+using duckdb_onnx::TValue;
+
+struct OnnxQuantizeBindData : public TableFunctionData {
+	string model_path;
+	string calibration_query;
+	string out_path;
+};
+
+struct OnnxQuantizeState : public GlobalTableFunctionState {
+	bool done = false;
+};
+
+//! Runs a model whose outputs are the tensors to calibrate over rows of inputs, recording the range of each output
+class OnnxCalibration {
+public:
+	OnnxCalibration(ClientContext &context, const string &path, const duckdb_onnx::TypedModel &model,
+	                const vector<string> &tensors)
+	    : path(path), runner(context, OnnxTaskRunner::GetMaxThreads(context)), ranges(tensors.size()) {
+		if (model.inputs.size() != 1) {
+			throw InvalidInputException("onnx_quantize: model %s has %llu inputs, only models with one input are "
+			                            "supported",
+			                            path, model.inputs.size());
+		}
+		auto &fact = model.outlet_fact(model.inputs[0]);
+		auto input_name = model.outlet_label(model.inputs[0]);
+		// rows are stacked along the first dimension, which must be free or 1
+		if (!fact.rank_known || fact.shape.empty() || (fact.shape[0].is_int() && fact.shape[0].as_int() != 1)) {
+			throw InvalidInputException("onnx_quantize: input %s of model %s has no batch dimension", input_name,
+			                            path);
+		}
+		for (idx_t axis = 1; axis < fact.shape.size(); axis++) {
+			if (!fact.shape[axis].is_int()) {
+				throw InvalidInputException("onnx_quantize: dimension %llu of input %s of model %s is not fixed", axis,
+				                            input_name, path);
+			}
+			sample_shape.push_back(fact.shape[axis].as_int());
+			sample_len *= NumericCast<idx_t>(fact.shape[axis].as_int());
+		}
+		input_type = fact.datum_type;
+
+		// the model, computing the tensors to calibrate instead of its outputs
+		auto calibrated = std::make_shared<duckdb_onnx::TypedModel>(model);
+		unordered_map<string, duckdb_onnx::OutletId> outlets;
+		for (auto &label : model.outlet_labels) {
+			outlets.emplace(label.second, label.first);
+		}
+		calibrated->outputs.clear();
+		for (auto &name : tensors) {
+			calibrated->outputs.push_back(outlets.at(name));
+		}
+		duckdb_onnx::optimize(*calibrated);
+		duckdb_onnx::codegen(*calibrated);
+		vector<vector<int64_t>> sample_shapes(1, vector<int64_t>(1, 1));
+		sample_shapes[0].insert(sample_shapes[0].end(), sample_shape.begin(), sample_shape.end());
+		try {
+			duckdb_onnx::infer_facts(*calibrated);
+			batch_shapes = duckdb_onnx::batch_output_shapes(*calibrated, sample_shapes);
+		} catch (std::exception &) {
+			// facts are only used to decide whether rows can be batched
+		}
+		auto plan = duckdb_onnx::SimplePlan::build(calibrated);
+		if (plan.is_err()) {
+			throw InvalidInputException("onnx_quantize: failed to plan ONNX model %s: %s", path, plan.error().what());
+		}
+		state = make_uniq<SimpleState>(plan.value());
+		state->session().runner = &runner;
+	}
+
+	//! Run the model over the `count` rows of `column`, a LIST or ARRAY vector of numbers
+	void Observe(ClientContext &context, Vector &column, idx_t count) {
+		auto &type = column.GetType();
+		bool is_array = type.id() == LogicalTypeId::ARRAY;
+		auto &child_type = is_array ? ArrayType::GetChildType(type) : ListType::GetChildType(type);
+		// elements without an ONNX counterpart, e.g. DECIMAL, are read as FLOAT
+		auto tensor_type = type;
+		DatumType element_type;
+		if (!OnnxDatumType(child_type, element_type)) {
+			tensor_type = is_array ? LogicalType::ARRAY(LogicalType::FLOAT, ArrayType::GetSize(type))
+			                       : LogicalType::LIST(LogicalType::FLOAT);
+		}
+		Vector cast_values(tensor_type, count);
+		if (tensor_type != type) {
+			VectorOperations::Cast(context, column, cast_values, count);
+		} else {
+			cast_values.Reference(column);
+		}
+		OnnxTensorReader values(cast_values, count);
+
+		vector<idx_t> samples;
+		for (idx_t row = 0; row < count; row++) {
+			if (!values.RowIsValid(row)) {
+				continue;
+			}
+			auto entry = values.GetEntry(row);
+			if (entry.length != sample_len) {
+				throw InvalidInputException("onnx_quantize: calibration row has %llu values but the input of model %s "
+				                            "needs %llu",
+				                            entry.length, path, sample_len);
+			}
+			values.CheckValid(entry, "onnx_quantize");
+			samples.push_back(entry.offset);
+		}
+		if (samples.empty()) {
+			return;
+		}
+		rows += samples.size();
+		auto sample_bytes = sample_len * duckdb_onnx::datum_type_size(values.datum_type);
+		if (batch_shapes && samples.size() > 1) {
+			ShapeVec shape {NumericCast<int64_t>(samples.size())};
+			shape.insert(shape.end(), sample_shape.begin(), sample_shape.end());
+			auto input = duckdb_onnx::Tensor::uninitialized(values.datum_type, shape);
+			auto target = static_cast<data_ptr_t>(input.raw_data_mut());
+			for (auto offset : samples) {
+				memcpy(target, values.GetData(offset), sample_bytes);
+				target += sample_bytes;
+			}
+			if (Run(input, samples.size())) {
+				return;
+			}
+			// the outputs contradict the facts of the model: rows run one by one from now on
+			batch_shapes.reset();
+		}
+		ShapeVec shape {1};
+		shape.insert(shape.end(), sample_shape.begin(), sample_shape.end());
+		for (auto offset : samples) {
+			Run(duckdb_onnx::Tensor::borrowed(values.datum_type, shape, values.GetData(offset)), 1);
+		}
+	}
+
+	//! The ranges observed so far, by tensor name
+	std::unordered_map<string, duckdb_onnx::TensorRange> Ranges(const vector<string> &tensors) const {
+		std::unordered_map<string, duckdb_onnx::TensorRange> result;
+		for (idx_t i = 0; i < tensors.size(); i++) {
+			result.emplace(tensors[i], ranges[i]);
+		}
+		return result;
+	}
+
+	idx_t rows = 0;
+
+private:
+	//! Run `input`, holding `batch_size` rows, and record the ranges of its outputs. Returns false, recording
+	//! nothing, when the outputs of a batch do not have the shapes the facts of the model derived for it.
+	bool Run(const duckdb_onnx::Tensor &input, idx_t batch_size) {
+		auto result = state->run({TValue::Var(OnnxConvertTensor(input, input_type))});
+		if (result.is_err()) {
+			throw InvalidInputException("onnx_quantize: ONNX model %s: %s", path, result.error().what());
+		}
+		auto &outputs = result.value();
+		if (batch_size > 1 && !duckdb_onnx::batch_outputs_match(outputs, batch_size, *batch_shapes)) {
+			return false;
+		}
+		for (idx_t i = 0; i < outputs.size(); i++) {
+			auto &output = *outputs[i];
+			if (output.datum_type() == DatumType::F32) {
+				ranges[i].update(output.as_ptr<float>(), output.len());
+			}
+		}
+		return true;
+	}
+
+	string path;
+	OnnxTaskRunner runner;
+	unique_ptr<SimpleState> state;
+	vector<duckdb_onnx::TensorRange> ranges;
+	ShapeVec sample_shape;
+	idx_t sample_len = 1;
+	DatumType input_type;
+	//! The shapes of the outputs of one row when the facts of the model show that rows can run as one batch
+	std::optional<vector<vector<int64_t>>> batch_shapes;
+};
+
+static unique_ptr<FunctionData> OnnxQuantizeBind(ClientContext &context, TableFunctionBindInput &input,
+                                                 vector<LogicalType> &return_types, vector<string> &names) {
+	for (auto &value : input.inputs) {
+		if (value.IsNull()) {
+			throw BinderException("onnx_quantize: arguments must not be NULL");
+		}
+	}
+	OnnxCheckExternalAccess(context, "onnx_quantize");
+	auto result = make_uniq<OnnxQuantizeBindData>();
+	result->model_path = StringValue::Get(input.inputs[0]);
+	result->calibration_query = StringValue::Get(input.inputs[1]);
+	result->out_path = StringValue::Get(input.inputs[2]);
+	names.emplace_back("path");
+	return_types.emplace_back(LogicalType::VARCHAR);
+	names.emplace_back("calibration_rows");
+	return_types.emplace_back(LogicalType::UBIGINT);
+	names.emplace_back("quantized_nodes");
+	return_types.emplace_back(LogicalType::UBIGINT);
+	return std::move(result);
+}
+
+static unique_ptr<GlobalTableFunctionState> OnnxQuantizeInit(ClientContext &context, TableFunctionInitInput &input) {
+	return make_uniq<OnnxQuantizeState>();
+}
+
+static void OnnxQuantizeScan(ClientContext &context, TableFunctionInput &data, DataChunk &output) {
+	auto &state = data.global_state->Cast<OnnxQuantizeState>();
+	if (state.done) {
+		return;
+	}
+	state.done = true;
+	auto &bind = data.bind_data->Cast<OnnxQuantizeBindData>();
+	auto &path = bind.model_path;
+
+	duckdb_onnx::Onnx onnx;
+	auto bytes = OnnxReadFile(context, path);
+	auto proto = onnx.proto_model_for_bytes(bytes.data(), bytes.size());
+	if (proto.is_err()) {
+		throw InvalidInputException("onnx_quantize: failed to load ONNX model %s: %s", path, proto.error().what());
+	}
+	auto model_dir = duckdb_onnx::Onnx::model_dir_for_path(path);
+	auto model = onnx.model_for_proto_model(*proto.value(), &model_dir);
+	if (model.is_err()) {
+		throw InvalidInputException("onnx_quantize: failed to load ONNX model %s: %s", path, model.error().what());
+	}
+	duckdb_onnx::ModelQuantizer quantizer(onnx, *proto.value(), model.value());
+	auto &tensors = quantizer.calibration_tensors();
+	if (tensors.empty()) {
+		throw InvalidInputException("onnx_quantize: model %s has no MatMul or Conv node with constant weights", path);
+	}
+	OnnxCalibration calibration(context, path, model.value(), tensors);
+
+	// a connection of its own, so that the query streams while the model runs: it does not see the uncommitted
+	// changes of the current transaction
+	Connection connection(*context.db);
+	auto result = connection.SendQuery(bind.calibration_query);
+	if (result->HasError()) {
+		if (!context.transaction.IsAutoCommit()) {
+			throw InvalidInputException("onnx_quantize: calibration query failed: %s (the calibration query runs "
+			                            "outside of the current transaction and does not see its uncommitted "
+			                            "changes)",
+			                            result->GetError());
+		}
+		throw InvalidInputException("onnx_quantize: calibration query failed: %s", result->GetError());
+	}
+	// the model input: the first column holding lists or arrays of numbers
+	idx_t column = DConstants::INVALID_INDEX;
+	for (idx_t col = 0; col < result->types.size() && column == DConstants::INVALID_INDEX; col++) {
+		auto &type = result->types[col];
+		if ((type.id() == LogicalTypeId::LIST && ListType::GetChildType(type).IsNumeric()) ||
+		    (type.id() == LogicalTypeId::ARRAY && ArrayType::GetChildType(type).IsNumeric())) {
+			column = col;
+		}
+	}
+	if (column == DConstants::INVALID_INDEX) {
+		throw InvalidInputException("onnx_quantize: the calibration query must return a list column holding the "
+		                            "model input, e.g. FLOAT[] or FLOAT[n]");
+	}
+	while (auto chunk = result->Fetch()) {
+		if (chunk->size() == 0) {
+			break;
+		}
+		calibration.Observe(context, chunk->data[column], chunk->size());
+	}
+	if (result->HasError()) {
+		throw InvalidInputException("onnx_quantize: calibration query failed: %s", result->GetError());
+	}
+	if (calibration.rows == 0) {
+		throw InvalidInputException("onnx_quantize: the calibration query returned no rows");
+	}
+
+	size_t quantized_nodes;
+	duckdb_onnx::pb::ModelProto quantized;
+	try {
+		quantized = quantizer.quantize(calibration.Ranges(tensors), quantized_nodes);
+	} catch (std::exception &e) {
+		throw InvalidInputException("onnx_quantize: model %s: %s", path, e.what());
+	}
+	string serialized;
+	if (!quantized.SerializeToString(&serialized)) {
+		throw InvalidInputException("onnx_quantize: quantized model %s cannot be serialized", bind.out_path);
+	}
+	OnnxWriteFile(context, bind.out_path, serialized.data(), serialized.size());
+
+	output.SetValue(0, 0, Value(bind.out_path));
+	output.SetValue(1, 0, Value::UBIGINT(calibration.rows));
+	output.SetValue(2, 0, Value::UBIGINT(quantized_nodes));
+	output.SetCardinality(1);
+}
+
+OnnxQuantizeFunction::OnnxQuantizeFunction()
+    : TableFunction("onnx_quantize", {LogicalType::VARCHAR, LogicalType::VARCHAR, LogicalType::VARCHAR},
+                    OnnxQuantizeScan, OnnxQuantizeBind, OnnxQuantizeInit) {
+}
+
+} // namespace duckdb
@@ -0,0 +1,116 @@
+#include "onnx_task_runner.hpp"
+
+#include "duckdb/common/mutex.hpp"
+#include "duckdb/main/client_context.hpp"
+#include "duckdb/parallel/task.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+
+namespace duckdb {
+
+namespace {
+
+//! State of one run() shared with its helper tasks, which may outlive it
+struct OnnxRunState {
+	explicit OnnxRunState(size_t count, const std::function<void(size_t)> &task) : count(count), task(&task) {
+	}
+
+	//! Claim and run parts until none is left
+	void Work() {
+		while (true) {
+			auto part = next.fetch_add(1);
+			if (part >= count) {
+				// `task` may be gone already: never touch it once the parts are exhausted
+				return;
+			}
+			try {
+				(*task)(part);
+			} catch (...) {
+				lock_guard<mutex> guard(lock);
+				if (!error) {
+					error = std::current_exception();
+				}
+			}
+			lock_guard<mutex> guard(lock);
+			if (++finished == count) {
+				done.notify_all();
+			}
+		}
+	}
+
+	const size_t count;
+	const std::function<void(size_t)> *task;
+	std::atomic<size_t> next {0};
+	mutex lock;
+	std::condition_variable done;
+	size_t finished = 0;
+	std::exception_ptr error;
+};
+
+class OnnxHelperTask : public Task {
+public:
+	explicit OnnxHelperTask(shared_ptr<OnnxRunState> state) : state(std::move(state)) {
+	}
+
+	TaskExecutionResult Execute(TaskExecutionMode) override {
+		state->Work();
+		return TaskExecutionResult::TASK_FINISHED;
+	}
+
+private:
+	shared_ptr<OnnxRunState> state;
+};
+
+} // namespace
+
+OnnxTaskRunner::OnnxTaskRunner(ClientContext &context, idx_t max_threads)
+    : scheduler(TaskScheduler::GetScheduler(context)), token(scheduler.CreateProducer()) {
+	threads = MaxValue<idx_t>(1, NumericCast<idx_t>(scheduler.NumberOfThreads()));
+	if (max_threads > 0) {
+		threads = MinValue(threads, max_threads);
+	}
+}
+
+idx_t OnnxTaskRunner::GetMaxThreads(ClientContext &context) {
+	Value threads;
+	if (context.TryGetCurrentSetting(THREADS_SETTING, threads) && !threads.IsNull()) {
+		auto value = threads.GetValue<int64_t>();
+		if (value < 0) {
+			throw InvalidInputException("%s must be at least 0, got %lld", THREADS_SETTING, value);
+		}
+		return NumericCast<idx_t>(value);
+	}
+	return 0;
+}
+
+size_t OnnxTaskRunner::thread_count() const {
+	return threads;
+}
+
+void OnnxTaskRunner::run(size_t count, const std::function<void(size_t)> &task) {
+	auto helpers = MinValue<idx_t>(threads, count) - 1;
+	if (helpers == 0) {
+		for (size_t part = 0; part < count; part++) {
+			task(part);
+		}
+		return;
+	}
+	auto state = make_shared_ptr<OnnxRunState>(count, task);
+	{
+		lock_guard<mutex> guard(lock);
+		for (idx_t i = 0; i < helpers; i++) {
+			scheduler.ScheduleTask(*token, make_shared_ptr<OnnxHelperTask>(state));
+		}
+	}
+	// work along instead of blocking: the parts a busy scheduler never gets to all run here
+	state->Work();
+	unique_lock<mutex> guard(state->lock);
+	state->done.wait(guard, [&] { return state->finished == count; });
+	if (state->error) {
+		std::rethrow_exception(state->error);
+	}
+}
+
+} // namespace duckdb
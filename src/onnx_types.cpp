@@ -0,0 +1,144 @@
+#include "onnx_types.hpp"
+
+#include "duckdb-onnx/core/ops/cast.h"
+#include "duckdb/common/exception.hpp"
+
+namespace duckdb {
+
+using duckdb_onnx::DatumType;
+
+LogicalType OnnxElementType(DatumType dt) {
+	switch (dt) {
+	case DatumType::Bool:
+		return LogicalType::BOOLEAN;
+	case DatumType::U8:
+		return LogicalType::UTINYINT;
+	case DatumType::U16:
+		return LogicalType::USMALLINT;
+	case DatumType::U32:
+		return LogicalType::UINTEGER;
+	case DatumType::U64:
+		return LogicalType::UBIGINT;
+	case DatumType::I8:
+		return LogicalType::TINYINT;
+	case DatumType::I16:
+		return LogicalType::SMALLINT;
+	case DatumType::I32:
+		return LogicalType::INTEGER;
+	case DatumType::I64:
+		return LogicalType::BIGINT;
+	case DatumType::F16:
+	case DatumType::BF16:
+	case DatumType::F32:
+		return LogicalType::FLOAT;
+	case DatumType::F64:
+		return LogicalType::DOUBLE;
+	default:
+		throw NotImplementedException("ONNX tensors of type %s are not supported", duckdb_onnx::datum_type_name(dt));
+	}
+}
+
+bool OnnxDatumType(const LogicalType &type, DatumType &result) {
+	switch (type.id()) {
+	case LogicalTypeId::BOOLEAN:
+		result = DatumType::Bool;
+		return true;
+	case LogicalTypeId::UTINYINT:
+		result = DatumType::U8;
+		return true;
+	case LogicalTypeId::USMALLINT:
+		result = DatumType::U16;
+		return true;
+	case LogicalTypeId::UINTEGER:
+		result = DatumType::U32;
+		return true;
+	case LogicalTypeId::UBIGINT:
+		result = DatumType::U64;
+		return true;
+	case LogicalTypeId::TINYINT:
+		result = DatumType::I8;
+		return true;
+	case LogicalTypeId::SMALLINT:
+		result = DatumType::I16;
+		return true;
+	case LogicalTypeId::INTEGER:
+		result = DatumType::I32;
+		return true;
+	case LogicalTypeId::BIGINT:
+		result = DatumType::I64;
+		return true;
+	case LogicalTypeId::FLOAT:
+		result = DatumType::F32;
+		return true;
+	case LogicalTypeId::DOUBLE:
+		result = DatumType::F64;
+		return true;
+	default:
+		return false;
+	}
+}
+
+duckdb_onnx::Tensor OnnxConvertTensor(const duckdb_onnx::Tensor &tensor, DatumType dt) {
+	if (tensor.datum_type() == dt) {
+		return tensor;
+	}
+	auto result = duckdb_onnx::Tensor::uninitialized(dt, tensor.shape());
+	duckdb_onnx::cast_elements(tensor, result);
+	return result;
+}
+
+OnnxTensorReader::OnnxTensorReader(Vector &vector, idx_t count) {
+	vector.ToUnifiedFormat(count, format);
+	idx_t child_count;
+	Vector *child;
+	if (vector.GetType().id() == LogicalTypeId::ARRAY) {
+		array_size = ArrayType::GetSize(vector.GetType());
+		child = &ArrayVector::GetEntry(vector);
+		child_count = ArrayVector::GetTotalSize(vector);
+	} else {
+		lists = UnifiedVectorFormat::GetData<list_entry_t>(format);
+		child = &ListVector::GetEntry(vector);
+		child_count = ListVector::GetListSize(vector);
+	}
+	if (!OnnxDatumType(child->GetType(), datum_type)) {
+		throw InternalException("onnx: tensor elements of type %s cannot be read", child->GetType().ToString());
+	}
+	child->Flatten(child_count);
+	child_data = FlatVector::GetData(*child);
+	element_size = duckdb_onnx::datum_type_size(datum_type);
+	child_validity = &FlatVector::Validity(*child);
+}
+
+void OnnxTensorReader::CheckValid(const list_entry_t &entry, const char *function) const {
+	if (child_validity->AllValid()) {
+		return;
+	}
+	for (idx_t i = entry.offset; i < entry.offset + entry.length; i++) {
+		if (!child_validity->RowIsValid(i)) {
+			throw InvalidInputException("%s: tensor values must not contain NULL", function);
+		}
+	}
+}
+
+duckdb_onnx::Tensor OnnxTensorReader::BatchTensor(const vector<idx_t> &rows, duckdb_onnx::ShapeVec shape) const {
+	// rows appended one after the other share one contiguous run of the child vector: borrow it as is
+	bool contiguous = true;
+	for (idx_t i = 1; i < rows.size() && contiguous; i++) {
+		auto prev = GetEntry(rows[i - 1]);
+		auto next = GetEntry(rows[i]);
+		contiguous = prev.offset + prev.length == next.offset;
+	}
+	if (contiguous && !rows.empty()) {
+		return duckdb_onnx::Tensor::borrowed(datum_type, std::move(shape), GetData(GetEntry(rows[0]).offset));
+	}
+	auto input = duckdb_onnx::Tensor::uninitialized(datum_type, std::move(shape));
+	auto target = static_cast<data_ptr_t>(input.raw_data_mut());
+	for (auto row : rows) {
+		auto entry = GetEntry(row);
+		memcpy(target, GetData(entry.offset), entry.length * element_size);
+		target += entry.length * element_size;
+	}
+	return input;
+}
+
+} // namespace duckdb
@@ -0,0 +1,194 @@
+#include "duckdb-onnx/tensor.h"
+
+#include <cstdlib>
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <string>
+
+namespace duckdb_onnx {
+
+size_t datum_type_size(DatumType dt) {
+	switch (dt) {
+	case DatumType::Bool:
+	case DatumType::U8:
+	case DatumType::I8:
+		return 1;
+	case DatumType::U16:
+	case DatumType::I16:
+	case DatumType::F16:
+	case DatumType::BF16:
+		return 2;
+	case DatumType::U32:
+	case DatumType::I32:
+	case DatumType::F32:
+		return 4;
+	case DatumType::U64:
+	case DatumType::I64:
+	case DatumType::F64:
+	case DatumType::TDim:
+		return 8;
+	default:
+		return 0;
+	}
+}
+
+const char *datum_type_name(DatumType dt) {
+	switch (dt) {
+	case DatumType::Bool:
+		return "bool";
+	case DatumType::U8:
+		return "u8";
+	case DatumType::U16:
+		return "u16";
+	case DatumType::U32:
+		return "u32";
+	case DatumType::U64:
+		return "u64";
+	case DatumType::I8:
+		return "i8";
+	case DatumType::I16:
+		return "i16";
+	case DatumType::I32:
+		return "i32";
+	case DatumType::I64:
+		return "i64";
+	case DatumType::F16:
+		return "f16";
+	case DatumType::BF16:
+		return "bf16";
+	case DatumType::F32:
+		return "f32";
+	case DatumType::F64:
+		return "f64";
+	case DatumType::TDim:
+		return "tdim";
+	case DatumType::Blob:
+		return "blob";
+	case DatumType::String:
+		return "string";
+	}
+	return "unknown";
+}
+
+void *aligned_malloc(size_t size) {
+	// round up so that the size is a multiple of the alignment, as aligned_alloc requires
+	size = (size + TENSOR_ALIGNMENT - 1) / TENSOR_ALIGNMENT * TENSOR_ALIGNMENT;
+	if (size == 0) {
+		size = TENSOR_ALIGNMENT;
+	}
+#ifdef _WIN32
+	auto ptr = _aligned_malloc(size, TENSOR_ALIGNMENT);
+#else
+	void *ptr = nullptr;
+	if (posix_memalign(&ptr, TENSOR_ALIGNMENT, size) != 0) {
+		ptr = nullptr;
+	}
+#endif
+	if (!ptr) {
+		throw std::bad_alloc();
+	}
+	return ptr;
+}
+
+void aligned_free(void *ptr) {
+#ifdef _WIN32
+	_aligned_free(ptr);
+#else
+	free(ptr);
+#endif
+}
+
+class Blob Blob::allocate(size_t size) {
+	class Blob blob;
+	std::shared_ptr<char> buffer(static_cast<char *>(aligned_malloc(size)), aligned_free);
+	blob.data_ = buffer.get();
+	blob.size_ = size;
+	blob.owner_ = std::move(buffer);
+	return blob;
+}
+
+class Blob Blob::borrow(void *data, size_t size) {
+	class Blob blob;
+	blob.data_ = static_cast<char *>(data);
+	blob.size_ = size;
+	return blob;
+}
+
+class Blob Blob::view(std::shared_ptr<const void> owner, const void *data, size_t size) {
+	class Blob blob;
+	blob.data_ = const_cast<char *>(static_cast<const char *>(data));
+	blob.size_ = size;
+	blob.is_view_ = true;
+	blob.owner_ = std::move(owner);
+	return blob;
+}
+
+static size_t element_count(const ShapeVec &shape) {
+	size_t len = 1;
+	for (auto dim : shape) {
+		if (dim < 0) {
+			throw std::runtime_error("Negative dimension in tensor shape");
+		}
+		len *= static_cast<size_t>(dim);
+	}
+	return len;
+}
+
+Tensor Tensor::from_blob(DatumType dt, ShapeVec shape, class Blob blob) {
+	Tensor tensor;
+	tensor.dt = dt;
+	tensor.shape_ = std::move(shape);
+	tensor.len_ = element_count(tensor.shape_);
+	if (blob.size() < tensor.byte_len()) {
+		throw std::runtime_error("Tensor storage is smaller than its shape requires");
+	}
+	tensor.data = std::move(blob);
+	tensor.compute_strides();
+	return tensor;
+}
+
+Tensor Tensor::uninitialized(DatumType dt, ShapeVec shape) {
+	auto size = element_count(shape) * datum_type_size(dt);
+	return from_blob(dt, std::move(shape), Blob::allocate(size));
+}
+
+Tensor Tensor::zero(DatumType dt, ShapeVec shape) {
+	auto tensor = uninitialized(dt, std::move(shape));
+	std::memset(tensor.raw_data_mut(), 0, tensor.byte_len());
+	return tensor;
+}
+
+Tensor Tensor::borrowed(DatumType dt, ShapeVec shape, void *data) {
+	auto size = element_count(shape) * datum_type_size(dt);
+	return from_blob(dt, std::move(shape), Blob::borrow(data, size));
+}
+
+void Tensor::set_shape(ShapeVec shape) {
+	if (element_count(shape) != len_) {
+		throw std::runtime_error("Cannot reshape tensor: element count mismatch");
+	}
+	shape_ = std::move(shape);
+	compute_strides();
+}
+
+void Tensor::check_datum_type(DatumType expected) const {
+	if (dt != expected) {
+		throw std::runtime_error(std::string("Tensor datum type is ") + datum_type_name(dt) + ", expected " +
+		                         datum_type_name(expected));
+	}
+}
+
+void Tensor::compute_strides() {
+	strides_.resize(shape_.size());
+	int64_t stride = 1;
+	for (size_t i = shape_.size(); i-- > 0;) {
+		strides_[i] = stride;
+		stride *= shape_[i];
+	}
+}
+
+} // namespace duckdb_onnx
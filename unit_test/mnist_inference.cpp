@@ -79,12 +79,14 @@ int main() {
 		int32_t *child_data_1 = (int32_t *)duckdb_vector_get_data(list_child_1);
 		uint64_t *child_validity_1 = duckdb_vector_get_validity(list_child_1);
 
-		duckdb_list_entry *list_data_2 = (duckdb_list_entry *)duckdb_vector_get_data(col2_vector);
-		uint64_t *list_validity_2 = duckdb_vector_get_validity(col2_vector);
-		// get the child column of the list
-		duckdb_vector list_child_2 = duckdb_list_vector_get_child(col2_vector);
-		float *child_data_2 = (float *)duckdb_vector_get_data(list_child_2);
-		uint64_t *child_validity_2 = duckdb_vector_get_validity(list_child_2);
+		// the model's output shape is fixed: the values are a FLOAT[10] array
+		duckdb_logical_type array_type = duckdb_vector_get_column_type(col2_vector);
+		idx_t array_size = duckdb_array_type_array_size(array_type);
+		duckdb_destroy_logical_type(&array_type);
+		// get the child column of the array
+		duckdb_vector array_child_2 = duckdb_array_vector_get_child(col2_vector);
+		float *child_data_2 = (float *)duckdb_vector_get_data(array_child_2);
+		uint64_t *child_validity_2 = duckdb_vector_get_validity(array_child_2);
 
 		for (idx_t row = 0; row < row_count; row++) {
 			if (!duckdb_validity_row_is_valid(list_validity_1, row)) {
@@ -108,10 +110,9 @@ int main() {
 			}
 			printf("]\n");
 
-			duckdb_list_entry list2 = list_data_2[row];
 			printf("[");
-			for (idx_t child_idx = list2.offset; child_idx < list2.offset + list2.length; child_idx++) {
-				if (child_idx > list2.offset) {
+			for (idx_t child_idx = row * array_size; child_idx < (row + 1) * array_size; child_idx++) {
+				if (child_idx > row * array_size) {
 					printf(", ");
 				}
 				if (!duckdb_validity_row_is_valid(child_validity_2, child_idx)) {